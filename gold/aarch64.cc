@@ -2309,10 +2309,6 @@ AArch64_relobj<size, big_endian>::scan_sections_for_stubs(
 					       shnum * shdr_size,
 					       true, true);
 
-  // To speed up processing, we set up hash tables for fast lookup of
-  // input offsets to output addresses.
-  this->initialize_input_to_output_maps();
-
   const Relobj::Output_sections& out_sections(this->output_sections());
 
   Relocate_info<size, big_endian> relinfo;
@@ -2820,6 +2816,7 @@ class Target_aarch64 : public Sized_target<size, big_endian>
   typedef Target_aarch64<size, big_endian> This;
   typedef Output_data_reloc<elfcpp::SHT_RELA, true, size, big_endian>
       Reloc_section;
+  typedef Output_data_relr<size, big_endian> Relr_section;
   typedef Relocate_info<size, big_endian> The_relocate_info;
   typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
   typedef AArch64_relobj<size, big_endian> The_aarch64_relobj;
@@ -2841,7 +2838,8 @@ class Target_aarch64 : public Sized_target<size, big_endian>
     : Sized_target<size, big_endian>(info),
       got_(NULL), plt_(NULL), got_plt_(NULL), got_irelative_(NULL),
       got_tlsdesc_(NULL), global_offset_table_(NULL), rela_dyn_(NULL),
-      rela_irelative_(NULL), copy_relocs_(elfcpp::R_AARCH64_COPY),
+      rela_irelative_(NULL), relr_dyn_(NULL),
+      copy_relocs_(elfcpp::R_AARCH64_COPY),
       got_mod_index_offset_(-1U),
       tlsdesc_reloc_info_(), tls_base_symbol_defined_(false),
       stub_tables_(), stub_group_size_(0), aarch64_input_section_map_()
@@ -3109,10 +3107,20 @@ class Target_aarch64 : public Sized_target<size, big_endian>
   do_may_relax() const
   { return !parameters->options().relocatable(); }
 
-  // Relaxation hook.  This is where we do stub generation.
+  // Relaxation hook.  This is where we do stub generation, and
+  // compute the size of .relr.dyn.
   virtual bool
   do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*);
 
+  // Return whether relative relocs are packed into .relr.dyn.
+  virtual bool
+  do_packs_relative_relocs() const
+  {
+    return (parameters->options().pack_relative_relocs()
+	    && parameters->options().output_is_position_independent()
+	    && !parameters->incremental());
+  }
+
   void
   group_sections(Layout* layout,
 		 section_size_type group_size,
@@ -3378,6 +3386,24 @@ class Target_aarch64 : public Sized_target<size, big_endian>
   Reloc_section*
   rela_irelative_section(Layout*);
 
+  // Get the section for packed relative relocs, creating it if
+  // necessary.
+  Relr_section*
+  relr_dyn_section(Layout*);
+
+  // If relative relocs are packed, and an R_AARCH64_RELATIVE reloc
+  // for the word at ADDRESS in OD can be, add it to .relr.dyn and
+  // return true.  Otherwise the caller must add it to .rela.dyn.
+  bool
+  add_packed_relative(Layout*, Output_data* od, Address address);
+
+  // Likewise for the word at ADDRESS in section SHNDX of OBJECT.  OD
+  // is the output section.
+  bool
+  add_packed_relative(Layout*, Output_data* od,
+		      Sized_relobj_file<size, big_endian>* object,
+		      unsigned int shndx, Address address);
+
   // Add a potential copy relocation.
   void
   copy_reloc(Symbol_table* symtab, Layout* layout,
@@ -3442,6 +3468,8 @@ class Target_aarch64 : public Sized_target<size, big_endian>
   Reloc_section* rela_dyn_;
   // The section to use for IRELATIVE relocs.
   Reloc_section* rela_irelative_;
+  // The section for packed relative relocs.
+  Relr_section* relr_dyn_;
   // Relocs saved to avoid a COPY reloc.
   Copy_relocs<elfcpp::SHT_RELA, size, big_endian> copy_relocs_;
   // Offset of the GOT entry for the TLS module index.
@@ -3685,6 +3713,55 @@ Target_aarch64<size, big_endian>::rela_dyn_section(Layout* layout)
   return this->rela_dyn_;
 }
 
+// Get the section for packed relative relocs, creating it if
+// necessary.
+
+template<int size, bool big_endian>
+typename Target_aarch64<size, big_endian>::Relr_section*
+Target_aarch64<size, big_endian>::relr_dyn_section(Layout* layout)
+{
+  if (this->relr_dyn_ == NULL)
+    {
+      gold_assert(layout != NULL);
+      this->relr_dyn_ = new Relr_section();
+      layout->add_output_section_data(".relr.dyn", elfcpp::SHT_RELR,
+				      elfcpp::SHF_ALLOC, this->relr_dyn_,
+				      ORDER_DYNAMIC_RELOCS, false);
+    }
+  return this->relr_dyn_;
+}
+
+// Add an R_AARCH64_RELATIVE reloc to .relr.dyn if we can.
+
+template<int size, bool big_endian>
+bool
+Target_aarch64<size, big_endian>::add_packed_relative(Layout* layout,
+						      Output_data* od,
+						      Address address)
+{
+  if (!this->do_packs_relative_relocs()
+      || !Relr_section::can_pack(od, address))
+    return false;
+  this->relr_dyn_section(layout)->add(od, address);
+  return true;
+}
+
+template<int size, bool big_endian>
+bool
+Target_aarch64<size, big_endian>::add_packed_relative(
+    Layout* layout,
+    Output_data* od,
+    Sized_relobj_file<size, big_endian>* object,
+    unsigned int shndx,
+    Address address)
+{
+  if (!this->do_packs_relative_relocs()
+      || !Relr_section::can_pack(object, shndx, address))
+    return false;
+  this->relr_dyn_section(layout)->add(od, object, shndx, address);
+  return true;
+}
+
 // Get the section to use for IRELATIVE relocs, creating it if
 // necessary.  These go in .rela.dyn, but only after all other dynamic
 // relocations.  They need to follow the other dynamic relocations so
@@ -5622,8 +5699,13 @@ Target_aarch64<size, big_endian>::do_relax(
 	}
     }
 
+  // Recompute .relr.dyn for the new addresses.  It only grows, so
+  // this converges.
+  bool relr_changed = (this->relr_dyn_ != NULL
+		       && this->relr_dyn_->update_entries());
+
   // Do not continue relaxation.
-  bool continue_relaxation = any_stub_table_changed;
+  bool continue_relaxation = any_stub_table_changed || relr_changed;
   if (!continue_relaxation)
     for (Stub_table_iterator sp = this->stub_tables_.begin();
 	 (sp != this->stub_tables_.end());
@@ -6040,6 +6122,10 @@ Target_aarch64<size, big_endian>::Scan::local(
       // reloction, so that the dynamic loader can relocate it.
       if (parameters->options().output_is_position_independent())
 	{
+	  if (!is_ifunc
+	      && target->add_packed_relative(layout, output_section, object,
+					     data_shndx, rela.get_r_offset()))
+	    break;
 	  Reloc_section* rela_dyn = target->rela_dyn_section(layout);
 	  rela_dyn->add_local_relative(object, r_sym,
 				       elfcpp::R_AARCH64_RELATIVE,
@@ -6070,15 +6156,20 @@ Target_aarch64<size, big_endian>::Scan::local(
 	else
 	  is_new = got->add_local(object, r_sym, GOT_TYPE_STANDARD);
 	if (is_new && parameters->options().output_is_position_independent())
-	  target->rela_dyn_section(layout)->
-	    add_local_relative(object,
-			       r_sym,
-			       elfcpp::R_AARCH64_RELATIVE,
-			       got,
-			       object->local_got_offset(r_sym,
-							GOT_TYPE_STANDARD),
-			       0,
-			       false);
+	  {
+	    unsigned int got_offset =
+	      object->local_got_offset(r_sym, GOT_TYPE_STANDARD);
+	    if (is_ifunc || !target->add_packed_relative(layout, got,
+							 got_offset))
+	      target->rela_dyn_section(layout)->
+		add_local_relative(object,
+				   r_sym,
+				   elfcpp::R_AARCH64_RELATIVE,
+				   got,
+				   got_offset,
+				   0,
+				   false);
+	  }
       }
       break;
 
@@ -6351,15 +6442,21 @@ Target_aarch64<size, big_endian>::Scan::global(
 	    else if (r_type == elfcpp::R_AARCH64_ABS64
 		     && gsym->can_use_relative_reloc(false))
 	      {
-		Reloc_section* rela_dyn = target->rela_dyn_section(layout);
-		rela_dyn->add_global_relative(gsym,
-					      elfcpp::R_AARCH64_RELATIVE,
-					      output_section,
-					      object,
-					      data_shndx,
-					      rela.get_r_offset(),
-					      rela.get_r_addend(),
-					      false);
+		if (gsym->type() == elfcpp::STT_GNU_IFUNC
+		    || !target->add_packed_relative(layout, output_section,
+						    object, data_shndx,
+						    rela.get_r_offset()))
+		  {
+		    Reloc_section* rela_dyn = target->rela_dyn_section(layout);
+		    rela_dyn->add_global_relative(gsym,
+						  elfcpp::R_AARCH64_RELATIVE,
+						  output_section,
+						  object,
+						  data_shndx,
+						  rela.get_r_offset(),
+						  rela.get_r_addend(),
+						  false);
+		  }
 	      }
 	    else
 	      {
@@ -6487,12 +6584,15 @@ Target_aarch64<size, big_endian>::Scan::global(
 		  }
 		if (is_new)
 		  {
-		    rela_dyn->add_global_relative(
-			gsym, elfcpp::R_AARCH64_RELATIVE,
-			got,
-			gsym->got_offset(GOT_TYPE_STANDARD),
-			0,
-			false);
+		    unsigned int got_off = gsym->got_offset(GOT_TYPE_STANDARD);
+		    if (gsym->type() == elfcpp::STT_GNU_IFUNC
+			|| !target->add_packed_relative(layout, got, got_off))
+		      rela_dyn->add_global_relative(
+			  gsym, elfcpp::R_AARCH64_RELATIVE,
+			  got,
+			  got_off,
+			  0,
+			  false);
 		  }
 	      }
 	  }
@@ -6835,6 +6935,7 @@ Target_aarch64<size, big_endian>::do_finalize_sections(
 				  : this->plt_->rela_plt());
   layout->add_target_dynamic_tags(false, this->got_plt_, rel_plt,
 				  this->rela_dyn_, true, false);
+  layout->add_relr_dynamic_tags(this->relr_dyn_);
 
   // Emit any relocs we saved in an attempt to avoid generating COPY
   // relocs.
@@ -706,7 +706,8 @@ Archive::get_elf_object_for_member(off_t off, bool* punconfigured)
 	= parameters->options().plugins()->claim_file(input_file,
 						      memoff,
 						      memsize,
-						      obj);
+						      obj,
+						      NULL);
       if (plugin_obj != NULL)
         {
           // The input file was claimed by a plugin, and its symbols
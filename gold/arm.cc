@@ -6387,10 +6387,6 @@ Arm_relobj<big_endian>::scan_sections_for_stubs(
 					       shnum * shdr_size,
 					       true, true);
 
-  // To speed up processing, we set up hash tables for fast lookup of
-  // input offsets to output addresses.
-  this->initialize_input_to_output_maps();
-
   const Relobj::Output_sections& out_sections(this->output_sections());
 
   Relocate_info<32, big_endian> relinfo;
@@ -6469,10 +6465,6 @@ Arm_relobj<big_endian>::scan_sections_for_stubs(
 						     arm_target);
 	}
     }
-
-  // After we've done the relocations, we release the hash tables,
-  // since we no longer need them.
-  this->free_input_to_output_maps();
 }
 
 // Count the local symbols.  The ARM backend needs to know if a symbol
@@ -0,0 +1,330 @@
+// call-graph.cc -- order functions using a call graph profile
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include "elfcpp.h"
+#include "symtab.h"
+#include "object.h"
+#include "token.h"
+#include "call-graph.h"
+
+namespace gold
+{
+
+// Class Call_graph_ordering.
+
+// Read the call graph profile from FILENAME.  Blank lines and lines
+// starting with '#' are ignored.
+
+void
+Call_graph_ordering::read_profile(const char* filename)
+{
+  std::ifstream in;
+  in.open(filename);
+  if (!in)
+    gold_fatal(_("unable to open --call-graph-ordering-file file %s: %s"),
+	       filename, strerror(errno));
+
+  std::string line;
+  unsigned int lineno = 0;
+  while (std::getline(in, line))
+    {
+      ++lineno;
+      if (!line.empty() && line[line.length() - 1] == '\r')   // Windows
+	line.resize(line.length() - 1);
+      if (line.empty() || line[0] == '#')
+	continue;
+
+      std::istringstream fields(line);
+      std::string caller;
+      std::string callee;
+      uint64_t count;
+      std::string extra;
+      if (!(fields >> caller >> callee >> count) || (fields >> extra))
+	{
+	  gold_error(_("%s:%u: expected CALLER CALLEE COUNT"),
+		     filename, lineno);
+	  continue;
+	}
+      if (count > 0)
+	this->edges_.push_back(Edge(caller, callee, count));
+    }
+}
+
+// Map each function named in the profile to the input section which
+// defines it.  Global functions are found in the symbol table.  For
+// other names, such as static functions, we look for a section
+// named .text.NAME, as created by -ffunction-sections.  We only
+// return sections which are executable and which are included in the
+// link.
+
+void
+Call_graph_ordering::find_sections(
+    const Task* task,
+    Symbol_table* symtab,
+    const Input_objects* input_objects,
+    std::map<std::string, Section_id>* sections)
+{
+  std::set<std::string> unresolved;
+  for (std::vector<Edge>::const_iterator p = this->edges_.begin();
+       p != this->edges_.end();
+       ++p)
+    {
+      const std::string* names[2] = { &p->caller, &p->callee };
+      for (int i = 0; i < 2; ++i)
+	{
+	  const std::string& name(*names[i]);
+	  if (sections->find(name) != sections->end()
+	      || unresolved.find(name) != unresolved.end())
+	    continue;
+
+	  Symbol* sym = symtab->lookup(name.c_str());
+	  if (sym != NULL && sym->is_forwarder())
+	    sym = symtab->resolve_forwards(sym);
+
+	  bool is_ordinary;
+	  unsigned int shndx;
+	  if (sym == NULL
+	      || sym->source() != Symbol::FROM_OBJECT
+	      || sym->object()->is_dynamic()
+	      || sym->object()->pluginobj() != NULL
+	      || !sym->is_defined()
+	      || (shndx = sym->shndx(&is_ordinary)) == elfcpp::SHN_UNDEF
+	      || !is_ordinary)
+	    {
+	      unresolved.insert(name);
+	      continue;
+	    }
+
+	  Relobj* relobj = static_cast<Relobj*>(sym->object());
+	  if (relobj->output_section(shndx) == NULL)
+	    continue;
+	  Task_lock_obj<Object> tlo(task, relobj);
+	  if ((relobj->section_flags(shndx) & elfcpp::SHF_EXECINSTR) != 0)
+	    (*sections)[name] = Section_id(relobj, shndx);
+	}
+    }
+
+  if (unresolved.empty())
+    return;
+
+  static const char text_prefix[] = ".text.";
+  const size_t text_prefix_len = sizeof text_prefix - 1;
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      Relobj* relobj = *p;
+      if (relobj->is_dynamic() || relobj->pluginobj() != NULL)
+	continue;
+      Task_lock_obj<Object> tlo(task, relobj);
+      unsigned int shnum = relobj->shnum();
+      for (unsigned int shndx = 1; shndx < shnum; ++shndx)
+	{
+	  if (relobj->output_section(shndx) == NULL
+	      || (relobj->section_flags(shndx) & elfcpp::SHF_EXECINSTR) == 0)
+	    continue;
+	  std::string name(relobj->section_name(shndx));
+	  if (name.compare(0, text_prefix_len, text_prefix) != 0)
+	    continue;
+	  name.erase(0, text_prefix_len);
+	  std::set<std::string>::iterator q = unresolved.find(name);
+	  if (q == unresolved.end())
+	    continue;
+	  // If several objects define a static function with this
+	  // name we can't tell which one the profile means, so we
+	  // just use the first one.
+	  (*sections)[name] = Section_id(relobj, shndx);
+	  unresolved.erase(q);
+	}
+    }
+}
+
+// Merge the clusters.  We visit the sections in order of decreasing
+// density, and append each cluster to the cluster of the section
+// which calls its first section most often, unless the resulting
+// cluster would be too large or too much less dense.  Set *ORDER to
+// the indexes of the remaining clusters in order of decreasing
+// density.
+
+void
+Call_graph_ordering::merge_clusters(std::vector<Cluster>* clusters,
+				    std::vector<unsigned int>* order)
+{
+  // Don't build clusters larger than this, since a cluster is meant
+  // to fit in a few pages.
+  const uint64_t max_cluster_size = 1024 * 1024;
+  // Don't merge clusters if the density would drop below the density
+  // of the predecessor divided by this.
+  const double max_density_degradation = 8.0;
+
+  const unsigned int count = clusters->size();
+
+  // Sort by decreasing density.  Ties keep the order in which the
+  // sections first appeared in the profile, so that the result does
+  // not depend on anything but the profile and the input files.
+  std::vector<std::pair<double, unsigned int> > sorted;
+  sorted.reserve(count);
+  for (unsigned int i = 0; i < count; ++i)
+    sorted.push_back(std::make_pair(-(*clusters)[i].density(), i));
+  std::stable_sort(sorted.begin(), sorted.end());
+
+  // The cluster holding each section.
+  std::vector<unsigned int> node_cluster(count);
+  for (unsigned int i = 0; i < count; ++i)
+    node_cluster[i] = i;
+
+  for (unsigned int i = 0; i < count; ++i)
+    {
+      // NODE has not yet been merged into another cluster, as only
+      // the cluster being visited is ever merged away.
+      unsigned int node = sorted[i].second;
+      Cluster* c = &(*clusters)[node];
+
+      // Don't merge if the call from the best predecessor is only a
+      // small part of the calls to this section.
+      if (c->best_pred == -1U
+	  || c->best_pred_weight * 10 <= c->initial_weight)
+	continue;
+
+      unsigned int pred = node_cluster[c->best_pred];
+      if (pred == node)
+	continue;
+      Cluster* pc = &(*clusters)[pred];
+      if (c->size + pc->size > max_cluster_size)
+	continue;
+
+      double new_density = (static_cast<double>(pc->weight + c->weight)
+			    / (pc->size + c->size));
+      if (new_density < pc->density() / max_density_degradation)
+	continue;
+
+      for (std::vector<unsigned int>::const_iterator p = c->nodes.begin();
+	   p != c->nodes.end();
+	   ++p)
+	node_cluster[*p] = pred;
+      pc->nodes.insert(pc->nodes.end(), c->nodes.begin(), c->nodes.end());
+      pc->size += c->size;
+      pc->weight += c->weight;
+      c->nodes.clear();
+      c->size = 0;
+      c->weight = 0;
+    }
+
+  sorted.clear();
+  for (unsigned int i = 0; i < count; ++i)
+    if (!(*clusters)[i].nodes.empty())
+      sorted.push_back(std::make_pair(-(*clusters)[i].density(), i));
+  std::stable_sort(sorted.begin(), sorted.end());
+
+  order->clear();
+  order->reserve(sorted.size());
+  for (unsigned int i = 0; i < sorted.size(); ++i)
+    order->push_back(sorted[i].second);
+}
+
+// Compute the order of the sections named in the profile.
+
+unsigned int
+Call_graph_ordering::compute_order(const Task* task,
+				   Symbol_table* symtab,
+				   const Input_objects* input_objects,
+				   std::map<Section_id, unsigned int>* order)
+{
+  std::map<std::string, Section_id> sections;
+  this->find_sections(task, symtab, input_objects, &sections);
+
+  // Create a cluster for each section, in the order in which the
+  // sections first appear in the profile.
+  std::vector<Cluster> clusters;
+  std::map<Section_id, unsigned int> nodes;
+  std::vector<Section_id> node_sections;
+  for (std::vector<Edge>::const_iterator p = this->edges_.begin();
+       p != this->edges_.end();
+       ++p)
+    {
+      std::map<std::string, Section_id>::const_iterator pfrom =
+	sections.find(p->caller);
+      std::map<std::string, Section_id>::const_iterator pto =
+	sections.find(p->callee);
+      if (pfrom == sections.end() || pto == sections.end())
+	continue;
+
+      unsigned int ends[2];
+      const Section_id* ids[2] = { &pfrom->second, &pto->second };
+      for (int i = 0; i < 2; ++i)
+	{
+	  std::pair<std::map<Section_id, unsigned int>::iterator, bool> ins =
+	    nodes.insert(std::make_pair(*ids[i], clusters.size()));
+	  if (ins.second)
+	    {
+	      Relobj* relobj = ids[i]->first;
+	      Task_lock_obj<Object> tlo(task, relobj);
+	      clusters.push_back(Cluster(clusters.size(),
+					 relobj->section_size(ids[i]->second)));
+	      node_sections.push_back(*ids[i]);
+	    }
+	  ends[i] = ins.first->second;
+	}
+
+      Cluster* to = &clusters[ends[1]];
+      to->weight += p->count;
+      if (ends[0] == ends[1])
+	continue;
+      if (to->best_pred == -1U || to->best_pred_weight < p->count)
+	{
+	  to->best_pred = ends[0];
+	  to->best_pred_weight = p->count;
+	}
+    }
+
+  for (std::vector<Cluster>::iterator p = clusters.begin();
+       p != clusters.end();
+       ++p)
+    p->initial_weight = p->weight;
+
+  std::vector<unsigned int> cluster_order;
+  this->merge_clusters(&clusters, &cluster_order);
+
+  unsigned int position = 0;
+  for (std::vector<unsigned int>::const_iterator p = cluster_order.begin();
+       p != cluster_order.end();
+       ++p)
+    {
+      const std::vector<unsigned int>& cnodes(clusters[*p].nodes);
+      for (std::vector<unsigned int>::const_iterator q = cnodes.begin();
+	   q != cnodes.end();
+	   ++q)
+	(*order)[node_sections[*q]] = ++position;
+    }
+
+  return position;
+}
+
+} // End namespace gold.
@@ -0,0 +1,134 @@
+// call-graph.h -- order functions using a call graph profile  -*- C++ -*-
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#ifndef GOLD_CALL_GRAPH_H
+#define GOLD_CALL_GRAPH_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "object.h"
+
+namespace gold
+{
+
+class Task;
+class Symbol_table;
+class Input_objects;
+
+// A call graph profile, read from the file named by the
+// --call-graph-ordering-file option.  Each line of the file is an
+// edge of the call graph, giving the names of the caller and callee
+// functions and the number of times the call was seen:
+//   CALLER CALLEE COUNT
+// Such a profile is easily produced from perf or gprof output.  We
+// use it to compute an order for the executable input sections which
+// keeps hot functions together, and places functions which call each
+// other frequently next to each other.  This is the C3 heuristic
+// described by Ottoni and Maher in "Optimizing Function Placement for
+// Large-Scale Data-Center Applications" (CGO 2017), which refines the
+// Pettis-Hansen algorithm.
+
+class Call_graph_ordering
+{
+ public:
+  Call_graph_ordering()
+    : edges_()
+  { }
+
+  // Read the profile from FILENAME.
+  void
+  read_profile(const char* filename);
+
+  // Compute the order of the input sections holding the functions
+  // named in the profile.  Set (*ORDER)[ID] to the position of the
+  // section ID, starting at 1.  Sections not named in the profile
+  // are not added to *ORDER.  Return the number of sections which
+  // were given a position.
+  unsigned int
+  compute_order(const Task*, Symbol_table*, const Input_objects*,
+		std::map<Section_id, unsigned int>* order);
+
+ private:
+  // An edge in the call graph, as read from the profile.
+  struct Edge
+  {
+    Edge(const std::string& acaller, const std::string& acallee,
+	 uint64_t acount)
+      : caller(acaller), callee(acallee), count(acount)
+    { }
+
+    std::string caller;
+    std::string callee;
+    uint64_t count;
+  };
+
+  // A cluster of sections which will be placed together.  Each
+  // input section named in the profile starts in a cluster of its
+  // own.
+  struct Cluster
+  {
+    Cluster(unsigned int node, uint64_t asize)
+      : nodes(1, node), size(asize), weight(0), initial_weight(0),
+	best_pred(-1U), best_pred_weight(0)
+    { }
+
+    // The density of the cluster: samples per byte of code.
+    double
+    density() const
+    {
+      if (this->size == 0)
+	return 0;
+      return static_cast<double>(this->weight) / this->size;
+    }
+
+    // The sections in the cluster, in the order they will be placed.
+    std::vector<unsigned int> nodes;
+    // The total size of the sections in the cluster.
+    uint64_t size;
+    // The total number of calls to the sections in the cluster.
+    uint64_t weight;
+    // The number of calls to the first section of the cluster.
+    uint64_t initial_weight;
+    // The section which calls the first section most often, or -1U.
+    unsigned int best_pred;
+    // The number of calls from BEST_PRED.
+    uint64_t best_pred_weight;
+  };
+
+  // Map each function name in the profile to the input section which
+  // defines it.
+  void
+  find_sections(const Task*, Symbol_table*, const Input_objects*,
+		std::map<std::string, Section_id>*);
+
+  // Merge the clusters, and return the order of the clusters.
+  void
+  merge_clusters(std::vector<Cluster>*, std::vector<unsigned int>*);
+
+  // The edges read from the profile.
+  std::vector<Edge> edges_;
+};
+
+} // End namespace gold.
+
+#endif // !defined(GOLD_CALL_GRAPH_H)
@@ -25,6 +25,7 @@
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 #include <map>
 #include <string>
 #include <vector>
@@ -32,6 +33,8 @@
 #include "object.h"
 #include "archive.h"
 #include "symtab.h"
+#include "gold-threads.h"
+#include "mapfile.h"
 #include "cref.h"
 
 namespace gold
@@ -66,7 +69,7 @@ class Cref_inputs
 
   // Print a cross reference table.
   void
-  print_cref(const Symbol_table*, FILE*) const;
+  print_cref(const Symbol_table*, FILE*, bool is_json) const;
 
  private:
   // A list of input objects.
@@ -98,7 +101,22 @@ class Cref_inputs
     operator()(const Symbol*, const Symbol*) const;
   };
 
-  typedef std::map<const Symbol*, Objects*, Cref_table_compare> Cref_table;
+  // The table is built using a hash table, and then sorted.
+  typedef std::pair<const Symbol*, Objects*> Cref_entry;
+  typedef std::vector<Cref_entry> Cref_table;
+  typedef Unordered_map<const Symbol*, Objects*> Cref_map;
+
+  // Sort the entries of the cross reference table.
+  class Cref_entry_compare
+  {
+  public:
+    bool
+    operator()(const Cref_entry& e1, const Cref_entry& e2) const
+    { return Cref_table_compare()(e1.first, e2.first); }
+  };
+
+  // Format entries of the cross reference table on several threads.
+  class Cref_printer;
 
   // Report symbol counts for a list of Objects.
   void
@@ -110,7 +128,11 @@ class Cref_inputs
 
   // Gather cross reference information.
   void
-  gather_cref(const Objects*, Cref_table*) const;
+  gather_cref(const Objects*, Cref_map*) const;
+
+  // Format the entry for one symbol in the cross reference table.
+  static void
+  format_cref_entry(const Cref_entry*, bool is_json, std::string*);
 
   // List of input objects.
   Objects objects_;
@@ -245,7 +267,7 @@ Cref_inputs::Cref_table_compare::operator()(const Symbol* s1,
 // Gather cross reference information from a list of inputs.
 
 void
-Cref_inputs::gather_cref(const Objects* objects, Cref_table* table) const
+Cref_inputs::gather_cref(const Objects* objects, Cref_map* table) const
 {
   for (Objects::const_iterator po = objects->begin();
        po != objects->end();
@@ -262,9 +284,9 @@ Cref_inputs::gather_cref(const Objects* objects, Cref_table* table) const
 	  if (sym == NULL)
 	    continue;
 	  Objects* const onull = NULL;
-	  std::pair<Cref_table::iterator, bool> ins =
+	  std::pair<Cref_map::iterator, bool> ins =
 	    table->insert(std::make_pair(sym, onull));
-	  Cref_table::iterator pc = ins.first;
+	  Cref_map::iterator pc = ins.first;
 	  if (ins.second)
 	    pc->second = new Objects();
 	  if (sym->source() == Symbol::FROM_OBJECT
@@ -281,52 +303,138 @@ Cref_inputs::gather_cref(const Objects* objects, Cref_table* table) const
 
 static const size_t filecol = 50;
 
-// Print a cross reference table.
+// Format the cross reference table entry for one symbol, appending it
+// to *OUT.  A JSON entry is an object preceded by a comma.
 
 void
-Cref_inputs::print_cref(const Symbol_table*, FILE* f) const
+Cref_inputs::format_cref_entry(const Cref_entry* entry, bool is_json,
+			       std::string* out)
 {
-  Cref_table table;
-  this->gather_cref(&this->objects_, &table);
-  for (Archives::const_iterator p = this->archives_.begin();
-       p != this->archives_.end();
-       ++p)
-    this->gather_cref(p->second.objects, &table);
+  // If all the objects are dynamic, skip this symbol.
+  const Symbol* sym = entry->first;
+  const Objects* objects = entry->second;
+  Objects::const_iterator po;
+  for (po = objects->begin(); po != objects->end(); ++po)
+    if (!(*po)->is_dynamic())
+      break;
+  if (po == objects->end())
+    return;
+
+  std::string s = sym->demangled_name();
+  if (sym->version() != NULL)
+    {
+      s += '@';
+      if (sym->is_default())
+	s += '@';
+      s += sym->version();
+    }
 
-  for (Cref_table::const_iterator pc = table.begin();
-       pc != table.end();
-       ++pc)
+  if (is_json)
     {
-      // If all the objects are dynamic, skip this symbol.
-      const Symbol* sym = pc->first;
-      const Objects* objects = pc->second;
-      Objects::const_iterator po;
+      *out += ",{\"symbol\":";
+      Mapfile::append_json_string(s.c_str(), out);
+      *out += ",\"files\":[";
       for (po = objects->begin(); po != objects->end(); ++po)
-	if (!(*po)->is_dynamic())
-	  break;
-      if (po == objects->end())
-	continue;
-
-      std::string s = sym->demangled_name();
-      if (sym->version() != NULL)
 	{
-	  s += '@';
-	  if (sym->is_default())
-	    s += '@';
-	  s += sym->version();
+	  if (po != objects->begin())
+	    *out += ',';
+	  Mapfile::append_json_string((*po)->name().c_str(), out);
 	}
+      *out += "]}";
+      return;
+    }
 
-      fputs(s.c_str(), f);
+  *out += s;
 
-      size_t len = s.length();
+  size_t len = s.length();
 
-      for (po = objects->begin(); po != objects->end(); ++po)
+  for (po = objects->begin(); po != objects->end(); ++po)
+    {
+      size_t n = len < filecol ? filecol - len : 1;
+      out->append(n, ' ');
+      *out += (*po)->name();
+      *out += '\n';
+      len = 0;
+    }
+}
+
+// Format a range of cross reference table entries into a string.  The
+// demangling and formatting are the expensive part of printing the
+// table, so we do them on several threads.
+
+class Cref_inputs::Cref_printer : public Parallel_work
+{
+ public:
+  Cref_printer(const Cref_entry* entries, size_t count, size_t piece_size,
+	       bool is_json, std::vector<std::string>* outputs)
+    : entries_(entries), count_(count), piece_size_(piece_size),
+      is_json_(is_json), outputs_(outputs)
+  { }
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    size_t start = piece * this->piece_size_;
+    size_t end = std::min(start + this->piece_size_, this->count_);
+    std::string* out = &(*this->outputs_)[piece];
+    for (size_t i = start; i < end; ++i)
+      Cref_inputs::format_cref_entry(&this->entries_[i], this->is_json_,
+				     out);
+  }
+
+ private:
+  const Cref_entry* entries_;
+  size_t count_;
+  size_t piece_size_;
+  bool is_json_;
+  std::vector<std::string>* outputs_;
+};
+
+// Print a cross reference table.
+
+void
+Cref_inputs::print_cref(const Symbol_table*, FILE* f, bool is_json) const
+{
+  Cref_map map;
+  this->gather_cref(&this->objects_, &map);
+  for (Archives::const_iterator p = this->archives_.begin();
+       p != this->archives_.end();
+       ++p)
+    this->gather_cref(p->second.objects, &map);
+
+  Cref_table table(map.begin(), map.end());
+  parallel_sort(table.begin(), table.end(), Cref_entry_compare());
+
+  // Format the table a batch of pieces at a time, to limit the memory
+  // we use.
+  const size_t piece_size = 1024;
+  // JSON entries all start with a comma, which we drop from the
+  // first one.
+  const size_t batch_size = piece_size * 4 * Parallel_work::thread_count();
+  bool first = true;
+  for (size_t start = 0; start < table.size(); start += batch_size)
+    {
+      size_t count = std::min(batch_size, table.size() - start);
+      size_t pieces = (count + piece_size - 1) / piece_size;
+      std::vector<std::string> outputs(pieces);
+      Cref_printer printer(&table[start], count, piece_size, is_json,
+			   &outputs);
+      printer.run(pieces);
+      for (size_t i = 0; i < pieces; ++i)
 	{
-	  int n = len < filecol ? filecol - len : 1;
-	  fprintf(f, "%*c%s\n", n, ' ', (*po)->name().c_str());
-	  len = 0;
+	  size_t skip = 0;
+	  if (is_json && first && !outputs[i].empty())
+	    {
+	      skip = 1;
+	      first = false;
+	    }
+	  fwrite(outputs[i].data() + skip, 1, outputs[i].size() - skip, f);
 	}
     }
+
+  for (Cref_table::iterator p = table.begin(); p != table.end(); ++p)
+    delete p->second;
 }
 
 // Class Cref.
@@ -393,15 +501,18 @@ Cref::print_symbol_counts(const Symbol_table* symtab) const
 // Print a cross reference table.
 
 void
-Cref::print_cref(const Symbol_table* symtab, FILE* f) const
+Cref::print_cref(const Symbol_table* symtab, FILE* f, bool is_json) const
 {
-  fprintf(f, _("\nCross Reference Table\n\n"));
-  const char* msg = _("Symbol");
-  int len = filecol - strlen(msg);
-  fprintf(f, "%s%*c%s\n", msg, len, ' ', _("File"));
+  if (!is_json)
+    {
+      fprintf(f, _("\nCross Reference Table\n\n"));
+      const char* msg = _("Symbol");
+      int len = filecol - strlen(msg);
+      fprintf(f, "%s%*c%s\n", msg, len, ' ', _("File"));
+    }
 
   if (parameters->options().cref() && this->inputs_ != NULL)
-    this->inputs_->print_cref(symtab, f);
+    this->inputs_->print_cref(symtab, f, is_json);
 }
 
 } // End namespace gold.
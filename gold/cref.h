@@ -63,9 +63,10 @@ class Cref
   void
   print_symbol_counts(const Symbol_table*) const;
 
-  // Print a cross reference table.
+  // Print a cross reference table.  If IS_JSON, print the elements
+  // of a JSON array rather than text.
   void
-  print_cref(const Symbol_table*, FILE*) const;
+  print_cref(const Symbol_table*, FILE*, bool is_json) const;
 
  private:
   void
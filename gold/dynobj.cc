@@ -29,6 +29,7 @@
 #include "parameters.h"
 #include "script.h"
 #include "symtab.h"
+#include "gold-threads.h"
 #include "dynobj.h"
 
 namespace gold
@@ -850,6 +851,193 @@ Sized_dynobj<size, big_endian>::do_get_global_symbol_counts(
   *used = count;
 }
 
+namespace
+{
+
+// Compute the hash codes of the dynamic symbols.  A shared library
+// can export hundreds of thousands of symbols, so the symbols are
+// split into pieces which may be hashed on different threads.
+
+class Dynsym_hasher : public Parallel_work
+{
+ public:
+  typedef uint32_t (*Hash_function)(const char*);
+
+  Dynsym_hasher(const std::vector<Symbol*>& syms, Hash_function hashfn,
+		std::vector<uint32_t>* hashvals)
+    : syms_(syms), hashfn_(hashfn), hashvals_(hashvals)
+  { }
+
+  // Set *HASHVALS to the hash codes of SYMS.
+  void
+  hash()
+  {
+    unsigned int count = this->syms_.size();
+    this->hashvals_->resize(count);
+    this->run((count + piece_size - 1) / piece_size);
+  }
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    unsigned int start = piece * piece_size;
+    unsigned int end = std::min(start + piece_size,
+				static_cast<unsigned int>(this->syms_.size()));
+    for (unsigned int i = start; i < end; ++i)
+      (*this->hashvals_)[i] = this->hashfn_(this->syms_[i]->name());
+  }
+
+ private:
+  // The number of symbols to hash in each piece.
+  static const unsigned int piece_size = 8192;
+
+  const std::vector<Symbol*>& syms_;
+  Hash_function hashfn_;
+  std::vector<uint32_t>* hashvals_;
+};
+
+// Compute the cost of candidate bucket counts for a hash table, for
+// use with --hash-bucket-search.  Each piece evaluates one candidate.
+// This is the weight function used by the old GNU linker: the sum of
+// the squares of the chain lengths, which favors many short chains
+// over a few long ones, scaled by a penalty for the number of pages
+// the table occupies.
+
+class Bucket_count_cost : public Parallel_work
+{
+ public:
+  Bucket_count_cost(const std::vector<uint32_t>& hashcodes,
+		    unsigned int entry_size, bool for_gnu_hash_table,
+		    const std::vector<unsigned int>& candidates,
+		    std::vector<uint64_t>* costs)
+    : hashcodes_(hashcodes), entry_size_(entry_size),
+      for_gnu_hash_table_(for_gnu_hash_table), candidates_(candidates),
+      costs_(costs)
+  { }
+
+  // The cost we record for a bucket count which may not be used.
+  static const uint64_t invalid_cost = static_cast<uint64_t>(-1);
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    unsigned int bucketcount = this->candidates_[piece];
+
+    // The GNU hash table uses the low bits of the hash code for the
+    // bloom filter, so avoid bucket counts that would correlate with
+    // them.
+    if (this->for_gnu_hash_table_ && (bucketcount & 31) == 0)
+      {
+	(*this->costs_)[piece] = invalid_cost;
+	return;
+      }
+
+    std::vector<uint32_t> counts(bucketcount);
+    const unsigned int symcount = this->hashcodes_.size();
+    for (unsigned int i = 0; i < symcount; ++i)
+      ++counts[this->hashcodes_[i] % bucketcount];
+
+    // We need 2 + SYMCOUNT entries for the header and the chains
+    // whatever the bucket count is.
+    uint64_t cost = (2 + static_cast<uint64_t>(symcount)) * this->entry_size_;
+    for (unsigned int i = 0; i < bucketcount; ++i)
+      cost += static_cast<uint64_t>(counts[i]) * counts[i];
+
+    // This information need not be accurate, it only weighs the
+    // size of the table against the chain lengths.
+    const unsigned int pagesize = 4096;
+    uint64_t fact = bucketcount / (pagesize / this->entry_size_) + 1;
+    (*this->costs_)[piece] = cost * fact * fact;
+  }
+
+ private:
+  const std::vector<uint32_t>& hashcodes_;
+  unsigned int entry_size_;
+  bool for_gnu_hash_table_;
+  const std::vector<unsigned int>& candidates_;
+  std::vector<uint64_t>* costs_;
+};
+
+// Build the bloom filter of a GNU hash table.  The symbols are split
+// into pieces, each of which sets bits in its own copy of the filter;
+// the copies are then ORed together.
+
+template<typename Word>
+class Gnu_hash_bloom_filter : public Parallel_work
+{
+ public:
+  Gnu_hash_bloom_filter(const std::vector<uint32_t>& hashvals,
+			uint32_t shift1, uint32_t shift2, uint32_t maskbits,
+			std::vector<Word>* bitmask)
+    : hashvals_(hashvals), shift1_(shift1), shift2_(shift2),
+      maskbits_(maskbits), bitmask_(bitmask), piece_count_(0),
+      piece_bitmasks_()
+  { }
+
+  // Set the bits for all the hash codes in *BITMASK.
+  void
+  build()
+  {
+    const unsigned int min_piece_size = 65536;
+    unsigned int count = this->hashvals_.size();
+    unsigned int pieces = Parallel_work::thread_count();
+    if (pieces > count / min_piece_size)
+      pieces = count / min_piece_size;
+    if (pieces == 0)
+      pieces = 1;
+    this->piece_count_ = pieces;
+
+    // Piece 0 uses *BITMASK directly.
+    this->piece_bitmasks_.resize(pieces - 1,
+				 std::vector<Word>(this->bitmask_->size()));
+    this->run(pieces);
+
+    const unsigned int maskwords = this->bitmask_->size();
+    for (unsigned int i = 0; i < pieces - 1; ++i)
+      {
+	const std::vector<Word>& m(this->piece_bitmasks_[i]);
+	for (unsigned int j = 0; j < maskwords; ++j)
+	  (*this->bitmask_)[j] |= m[j];
+      }
+  }
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    std::vector<Word>& bitmask(piece == 0
+			       ? *this->bitmask_
+			       : this->piece_bitmasks_[piece - 1]);
+    const uint64_t count = this->hashvals_.size();
+    const unsigned int start = count * piece / this->piece_count_;
+    const unsigned int end = count * (piece + 1) / this->piece_count_;
+    const uint32_t shift1 = this->shift1_;
+    const uint32_t shift2 = this->shift2_;
+    const uint32_t mask = (1U << shift1) - 1U;
+    const uint32_t wordmask = (this->maskbits_ >> shift1) - 1;
+    for (unsigned int i = start; i < end; ++i)
+      {
+	uint32_t hashval = this->hashvals_[i];
+	unsigned int val = (hashval >> shift1) & wordmask;
+	bitmask[val] |= (static_cast<Word>(1U)) << (hashval & mask);
+	bitmask[val] |= (static_cast<Word>(1U)) << ((hashval >> shift2) & mask);
+      }
+  }
+
+ private:
+  const std::vector<uint32_t>& hashvals_;
+  uint32_t shift1_;
+  uint32_t shift2_;
+  uint32_t maskbits_;
+  std::vector<Word>* bitmask_;
+  unsigned int piece_count_;
+  std::vector<std::vector<Word> > piece_bitmasks_;
+};
+
+} // End anonymous namespace.
+
 // Given a vector of hash codes, compute the number of hash buckets to
 // use.
 
@@ -857,8 +1045,6 @@ unsigned int
 Dynobj::compute_bucket_count(const std::vector<uint32_t>& hashcodes,
 			     bool for_gnu_hash_table)
 {
-  // FIXME: Implement optional hash table optimization.
-
   // Array used to determine the number of hash table buckets to use
   // based on the number of symbols there are.  If there are fewer
   // than 3 symbols we use 1 bucket, fewer than 17 symbols we use 3
@@ -886,9 +1072,78 @@ Dynobj::compute_bucket_count(const std::vector<uint32_t>& hashcodes,
   if (for_gnu_hash_table && ret < 2)
     ret = 2;
 
+  if (parameters->options().hash_bucket_search() && symcount > 0)
+    ret = Dynobj::optimize_bucket_count(hashcodes, for_gnu_hash_table, ret);
+
   return ret;
 }
 
+// With --hash-bucket-search, search for the bucket count which gives
+// the shortest chains for the hash codes in HASHCODES, as the old GNU
+// linker does with -O1.  DEFAULT_COUNT is the bucket count chosen
+// from the table; if the user asked for a fraction of empty buckets,
+// we never use fewer buckets than that.  All the candidates are
+// evaluated in a single Parallel_work run, and then compared in
+// order, so the result does not depend on the number of threads.
+
+unsigned int
+Dynobj::optimize_bucket_count(const std::vector<uint32_t>& hashcodes,
+			      bool for_gnu_hash_table,
+			      unsigned int default_count)
+{
+  const unsigned int symcount = hashcodes.size();
+
+  unsigned int minsize = symcount / 4;
+  if (minsize == 0)
+    minsize = 1;
+  if (for_gnu_hash_table && minsize < 2)
+    minsize = 2;
+  if (parameters->options().user_set_hash_bucket_empty_fraction()
+      && minsize < default_count)
+    minsize = default_count;
+  const unsigned int maxsize = symcount * 2;
+  if (minsize >= maxsize)
+    return default_count;
+
+  unsigned int entry_size;
+  if (for_gnu_hash_table)
+    entry_size = 4;
+  else
+    entry_size = parameters->target().hash_entry_size() / 8;
+
+  // Evaluating a candidate looks at every hash code.  The old GNU
+  // linker tries every bucket count from MINSIZE to MAXSIZE, which
+  // takes far too long with many symbols, so we limit the total work
+  // and spread the candidates evenly over the range.
+  const uint64_t max_work = 1U << 26;
+  const unsigned int range = maxsize - minsize;
+  unsigned int ncandidates = range;
+  if (static_cast<uint64_t>(ncandidates) * symcount > max_work)
+    ncandidates = std::max(max_work / symcount, static_cast<uint64_t>(1));
+  std::vector<unsigned int> candidates(ncandidates);
+  for (unsigned int i = 0; i < ncandidates; ++i)
+    candidates[i] = (minsize
+		     + static_cast<uint64_t>(range) * i / ncandidates);
+
+  std::vector<uint64_t> costs(ncandidates);
+  Bucket_count_cost evaluator(hashcodes, entry_size, for_gnu_hash_table,
+			      candidates, &costs);
+  evaluator.run(ncandidates);
+
+  unsigned int best_size = default_count;
+  uint64_t best_cost = Bucket_count_cost::invalid_cost;
+  for (unsigned int i = 0; i < ncandidates; ++i)
+    {
+      if (costs[i] < best_cost)
+	{
+	  best_cost = costs[i];
+	  best_size = candidates[i];
+	}
+    }
+
+  return best_size;
+}
+
 // The standard ELF hash function.  This hash function must not
 // change, as the dynamic linker uses it also.
 
@@ -928,9 +1183,9 @@ Dynobj::create_elf_hash_table(const std::vector<Symbol*>& dynsyms,
   unsigned int dynsym_count = dynsyms.size();
 
   // Get the hash values for all the symbols.
-  std::vector<uint32_t> dynsym_hashvals(dynsym_count);
-  for (unsigned int i = 0; i < dynsym_count; ++i)
-    dynsym_hashvals[i] = Dynobj::elf_hash(dynsyms[i]->name());
+  std::vector<uint32_t> dynsym_hashvals;
+  Dynsym_hasher hasher(dynsyms, &Dynobj::elf_hash, &dynsym_hashvals);
+  hasher.hash();
 
   const unsigned int bucketcount =
     Dynobj::compute_bucket_count(dynsym_hashvals, false);
@@ -1080,9 +1335,6 @@ Dynobj::create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
   std::vector<Symbol*> hashed_dynsyms;
   hashed_dynsyms.reserve(count);
 
-  std::vector<uint32_t> dynsym_hashvals;
-  dynsym_hashvals.reserve(count);
-  
   for (unsigned int i = 0; i < count; ++i)
     {
       Symbol* sym = dynsyms[i];
@@ -1093,12 +1345,13 @@ Dynobj::create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
 	      || sym->is_forced_local()))
 	unhashed_dynsyms.push_back(sym);
       else
-	{
-	  hashed_dynsyms.push_back(sym);
-	  dynsym_hashvals.push_back(Dynobj::gnu_hash(sym->name()));
-	}
+	hashed_dynsyms.push_back(sym);
     }
 
+  std::vector<uint32_t> dynsym_hashvals;
+  Dynsym_hasher hasher(hashed_dynsyms, &Dynobj::gnu_hash, &dynsym_hashvals);
+  hasher.hash();
+
   // Put the unhashed symbols at the start of the global portion of
   // the dynamic symbol table.
   const unsigned int unhashed_count = unhashed_dynsyms.size();
@@ -1235,7 +1488,6 @@ Dynobj::sized_create_gnu_hash_table(
 	maskbitslog2 = 6;
       shift1 = 6;
     }
-  uint32_t mask = (1U << shift1) - 1U;
   uint32_t shift2 = maskbitslog2;
   uint32_t maskbits = 1U << maskbitslog2;
   uint32_t maskwords = 1U << (maskbitslog2 - shift1);
@@ -1282,11 +1534,7 @@ Dynobj::sized_create_gnu_hash_table(
       uint32_t hashval = dynsym_hashvals[i];
 
       unsigned int bucket = hashval % bucketcount;
-      unsigned int val = ((hashval >> shift1)
-			  & ((maskbits >> shift1) - 1));
-      bitmask[val] |= (static_cast<Word>(1U)) << (hashval & mask);
-      bitmask[val] |= (static_cast<Word>(1U)) << ((hashval >> shift2) & mask);
-      val = hashval & ~ 1U;
+      unsigned int val = hashval & ~ 1U;
       if (counts[bucket] == 1)
 	{
 	  // Last element terminates the chain.
@@ -1300,6 +1548,10 @@ Dynobj::sized_create_gnu_hash_table(
       ++indx[bucket];
     }
 
+  Gnu_hash_bloom_filter<Word> bloom(dynsym_hashvals, shift1, shift2,
+				    maskbits, &bitmask);
+  bloom.build();
+
   p = phash + 16;
   for (unsigned int i = 0; i < maskwords; ++i)
     {
@@ -1547,6 +1799,30 @@ Versions::record_version(const Symbol_table* symtab,
     }
 }
 
+// Record a reference to the GLIBC_ABI_DT_RELR version.  glibc
+// defines an absolute symbol named after each of its versions, which
+// we use to find the library which defines it.
+
+void
+Versions::record_dt_relr_version(const Symbol_table* symtab,
+				 Stringpool* dynpool)
+{
+  gold_assert(!this->is_finalized_);
+
+  static const char dt_relr_version[] = "GLIBC_ABI_DT_RELR";
+  const Symbol* sym = symtab->lookup(dt_relr_version);
+  if (sym == NULL || !sym->is_from_dynobj())
+    return;
+
+  Dynobj* dynobj = static_cast<Dynobj*>(sym->object());
+  if (dynobj->as_needed() && !dynobj->is_needed())
+    return;
+
+  Stringpool::Key version_key;
+  const char* version = dynpool->add(dt_relr_version, false, &version_key);
+  this->add_need(dynpool, dynobj->soname(), version, version_key);
+}
+
 // We've found a symbol SYM defined in version VERSION.
 
 void
@@ -131,6 +131,13 @@ class Dynobj : public Object
   compute_bucket_count(const std::vector<uint32_t>& hashcodes,
 		       bool for_gnu_hash_table);
 
+  // Search for the number of hash buckets which gives the shortest
+  // chains, for --hash-bucket-search.
+  static unsigned int
+  optimize_bucket_count(const std::vector<uint32_t>& hashcodes,
+			bool for_gnu_hash_table,
+			unsigned int default_count);
+
   // Sized version of create_elf_hash_table.
   template<int size, bool big_endian>
   static void
@@ -569,6 +576,13 @@ class Versions
   void
   record_version(const Symbol_table* symtab, Stringpool*, const Symbol* sym);
 
+  // The output uses DT_RELR.  If a shared library defines the
+  // GLIBC_ABI_DT_RELR version, record a reference to it, so that a
+  // dynamic linker which does not support DT_RELR refuses to load
+  // the output.
+  void
+  record_dt_relr_version(const Symbol_table* symtab, Stringpool*);
+
   // Set the version indexes.  DYNSYM_INDEX is the index we should use
   // for the next dynamic symbol.  We add new dynamic symbols to SYMS
   // and return an updated DYNSYM_INDEX.
@@ -27,6 +27,7 @@
 
 #include "elfcpp.h"
 #include "dwarf.h"
+#include "gold-threads.h"
 #include "symtab.h"
 #include "reloc.h"
 #include "ehframe.h"
@@ -188,8 +189,8 @@ Eh_frame_hdr::do_sized_write(Output_file* of)
       this->get_fde_addresses<size, big_endian>(of, &this->fde_offsets_,
 						&fde_addresses);
 
-      std::sort(fde_addresses.begin(), fde_addresses.end(),
-		Fde_address_compare<size>());
+      parallel_sort(fde_addresses.begin(), fde_addresses.end(),
+		    Fde_address_compare<size>());
 
       typename elfcpp::Elf_types<size>::Elf_Addr output_address;
       output_address = this->address();
@@ -290,11 +291,59 @@ Eh_frame_hdr::get_fde_pc(
   return pc;
 }
 
+// Read the PCs for some of the FDEs in the .eh_frame section.  Piece
+// I handles FDEs I * PIECE_SIZE up to (I + 1) * PIECE_SIZE.
+
+template<int size, bool big_endian>
+class Eh_frame_hdr::Fde_pc_reader : public Parallel_work
+{
+ public:
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+
+  Fde_pc_reader(Eh_frame_hdr* hdr, Address eh_frame_address,
+		const unsigned char* eh_frame_contents,
+		const Fde_offsets* fde_offsets,
+		Fde_addresses<size>* fde_addresses, unsigned int piece_size)
+    : hdr_(hdr), eh_frame_address_(eh_frame_address),
+      eh_frame_contents_(eh_frame_contents), fde_offsets_(fde_offsets),
+      fde_addresses_(fde_addresses), piece_size_(piece_size)
+  { }
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    unsigned int start = piece * this->piece_size_;
+    unsigned int end = std::min(start + this->piece_size_,
+				static_cast<unsigned int>(
+				  this->fde_offsets_->size()));
+    for (unsigned int i = start; i < end; ++i)
+      {
+	const Fde_offset& fo((*this->fde_offsets_)[i]);
+	Address fde_pc;
+	fde_pc = this->hdr_->get_fde_pc<size, big_endian>(
+	    this->eh_frame_address_, this->eh_frame_contents_,
+	    fo.first, fo.second);
+	this->fde_addresses_->set(i, fde_pc,
+				  this->eh_frame_address_ + fo.first);
+      }
+  }
+
+ private:
+  Eh_frame_hdr* hdr_;
+  Address eh_frame_address_;
+  const unsigned char* eh_frame_contents_;
+  const Fde_offsets* fde_offsets_;
+  Fde_addresses<size>* fde_addresses_;
+  unsigned int piece_size_;
+};
+
 // Given an array of FDE offsets in the .eh_frame section, return an
 // array of offsets from the exception frame header to the FDE's
 // output PC and to the output address of the FDE itself.  We get the
 // FDE's PC by actually looking in the .eh_frame section we just wrote
-// to the output file.
+// to the output file.  With millions of FDEs this is worth doing on
+// several threads.
 
 template<int size, bool big_endian>
 void
@@ -309,16 +358,12 @@ Eh_frame_hdr::get_fde_addresses(Output_file* of,
   const unsigned char* eh_frame_contents = of->get_input_view(eh_frame_offset,
 							      eh_frame_size);
 
-  for (Fde_offsets::const_iterator p = fde_offsets->begin();
-       p != fde_offsets->end();
-       ++p)
-    {
-      typename elfcpp::Elf_types<size>::Elf_Addr fde_pc;
-      fde_pc = this->get_fde_pc<size, big_endian>(eh_frame_address,
-						  eh_frame_contents,
-						  p->first, p->second);
-      fde_addresses->push_back(fde_pc, eh_frame_address + p->first);
-    }
+  const unsigned int piece_size = 65536;
+  unsigned int pieces = (fde_offsets->size() + piece_size - 1) / piece_size;
+  Fde_pc_reader<size, big_endian> reader(this, eh_frame_address,
+					 eh_frame_contents, fde_offsets,
+					 fde_addresses, piece_size);
+  reader.run(pieces);
 
   of->free_input_view(eh_frame_offset, eh_frame_size, eh_frame_contents);
 }
@@ -525,6 +570,27 @@ operator<(const Cie& cie1, const Cie& cie2)
   return cie1.contents_ < cie2.contents_;
 }
 
+// Class Parsed_eh_frame_section.
+
+// Delete the CIEs and FDEs.
+
+void
+Parsed_eh_frame_section::clear()
+{
+  for (Parsed_cies::iterator p = this->cies_.begin();
+       p != this->cies_.end();
+       ++p)
+    {
+      for (std::vector<Parsed_fde>::iterator pf = p->fdes.begin();
+	   pf != p->fdes.end();
+	   ++pf)
+	delete pf->fde;
+      delete p->cie;
+    }
+  this->cies_.clear();
+  this->discarded_.clear();
+}
+
 // Class Eh_frame.
 
 Eh_frame::Eh_frame()
@@ -532,6 +598,7 @@ Eh_frame::Eh_frame()
     eh_frame_hdr_(NULL),
     cie_offsets_(),
     unmergeable_cie_offsets_(),
+    mapped_sections_(),
     mappings_are_done_(false),
     final_data_size_(0)
 {
@@ -578,13 +645,51 @@ Eh_frame::add_ehframe_input_section(
     unsigned int reloc_shndx,
     unsigned int reloc_type)
 {
+  // Normally the section was parsed when the symbols were read.
+  Parsed_eh_frame_section* parsed =
+    object->release_parsed_eh_frame_section(shndx);
+  if (parsed == NULL)
+    parsed = Eh_frame::parse_ehframe_input_section(object, symbols,
+						   symbols_size,
+						   symbol_names,
+						   symbol_names_size,
+						   shndx, reloc_shndx,
+						   reloc_type);
+
+  Eh_frame_section_disposition disp =
+    this->add_parsed_ehframe_input_section(object, parsed);
+  delete parsed;
+  return disp;
+}
+
+// Parse input section SHNDX in OBJECT.  The arguments are as for
+// add_ehframe_input_section.  This returns the CIEs and FDEs that we
+// found, and what to do with the section.
+
+template<int size, bool big_endian>
+Parsed_eh_frame_section*
+Eh_frame::parse_ehframe_input_section(
+    Sized_relobj_file<size, big_endian>* object,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size,
+    unsigned int shndx,
+    unsigned int reloc_shndx,
+    unsigned int reloc_type)
+{
+  Parsed_eh_frame_section* parsed = new Parsed_eh_frame_section(shndx);
+
   // Get the section contents.
   section_size_type contents_len;
   const unsigned char* pcontents = object->section_contents(shndx,
 							    &contents_len,
 							    false);
   if (contents_len == 0)
-    return EH_EMPTY_SECTION;
+    {
+      parsed->set_disposition(EH_EMPTY_SECTION);
+      return parsed;
+    }
 
   // If this is the marker section for the end of the data, then
   // return false to force it to be handled as an ordinary input
@@ -592,46 +697,116 @@ Eh_frame::add_ehframe_input_section(
   // of unrecognized .eh_frame sections.
   if (contents_len == 4
       && elfcpp::Swap<32, big_endian>::readval(pcontents) == 0)
-    return EH_END_MARKER_SECTION;
-
-  New_cies new_cies;
-  if (!this->do_add_ehframe_input_section(object, symbols, symbols_size,
-					  symbol_names, symbol_names_size,
-					  shndx, reloc_shndx,
-					  reloc_type, pcontents,
-					  contents_len, &new_cies))
     {
-      if (this->eh_frame_hdr_ != NULL)
-	this->eh_frame_hdr_->found_unrecognized_eh_frame_section();
+      parsed->set_disposition(EH_END_MARKER_SECTION);
+      return parsed;
+    }
 
-      for (New_cies::iterator p = new_cies.begin();
-	   p != new_cies.end();
-	   ++p)
-	delete p->first;
+  if (!Eh_frame::do_parse_ehframe_input_section(object, symbols,
+						symbols_size, symbol_names,
+						symbol_names_size, shndx,
+						reloc_shndx, reloc_type,
+						pcontents, contents_len,
+						parsed))
+    {
+      parsed->clear();
+      parsed->set_disposition(EH_UNRECOGNIZED_SECTION);
+      return parsed;
+    }
+
+  parsed->set_disposition(EH_OPTIMIZABLE_SECTION);
+  return parsed;
+}
 
-      return EH_UNRECOGNIZED_SECTION;
+// Merge the CIEs and FDEs of the parsed input section PARSED from
+// OBJECT into the output data.  This is where we discard duplicate
+// CIEs, and FDEs which refer to sections which are not included in
+// the link.  This takes ownership of the CIEs and FDEs in PARSED.
+
+Eh_frame::Eh_frame_section_disposition
+Eh_frame::add_parsed_ehframe_input_section(Relobj* object,
+					   Parsed_eh_frame_section* parsed)
+{
+  Eh_frame_section_disposition disp = parsed->disposition();
+  if (disp == EH_UNRECOGNIZED_SECTION)
+    {
+      if (this->eh_frame_hdr_ != NULL)
+	this->eh_frame_hdr_->found_unrecognized_eh_frame_section();
+      return disp;
     }
+  if (disp != EH_OPTIMIZABLE_SECTION)
+    return disp;
+
+  const unsigned int shndx = parsed->shndx();
+  this->mapped_sections_.push_back(std::make_pair(object, shndx));
+
+  // Record the ranges which we already know we are dropping.  At this
+  // point we don't know for sure that we are doing a special mapping
+  // for this input section, but that's OK--if we don't do a special
+  // mapping, nobody will ever ask for the mapping we add here.
+  Parsed_eh_frame_section::Discarded_ranges& discarded(parsed->discarded());
+  for (Parsed_eh_frame_section::Discarded_ranges::const_iterator p =
+	 discarded.begin();
+       p != discarded.end();
+       ++p)
+    object->add_merge_mapping(this, shndx, p->first, p->second, -1);
 
-  // Now that we know we are using this section, record any new CIEs
-  // that we found.
-  for (New_cies::const_iterator p = new_cies.begin();
-       p != new_cies.end();
+  Parsed_eh_frame_section::Parsed_cies& cies(parsed->cies());
+  for (Parsed_eh_frame_section::Parsed_cies::iterator p = cies.begin();
+       p != cies.end();
        ++p)
     {
-      if (p->second)
-	this->cie_offsets_.insert(p->first);
+      Cie* cie = p->cie;
+      if (!p->mergeable)
+	this->unmergeable_cie_offsets_.push_back(cie);
       else
-	this->unmergeable_cie_offsets_.push_back(p->first);
+	{
+	  std::pair<Cie_offsets::iterator, bool> ins =
+	    this->cie_offsets_.insert(cie);
+	  if (!ins.second)
+	    {
+	      // We already have this CIE, so we are deleting this one.
+	      object->add_merge_mapping(this, shndx, p->input_offset,
+					p->length, -1);
+	      delete cie;
+	      cie = *ins.first;
+	    }
+	}
+
+      for (std::vector<Parsed_eh_frame_section::Parsed_fde>::const_iterator
+	     pf = p->fdes.begin();
+	   pf != p->fdes.end();
+	   ++pf)
+	{
+	  // If we have discarded the section holding the code, we can
+	  // also discard the FDE.
+	  if (pf->fde_shndx != -1U
+	      && !object->is_section_included(pf->fde_shndx))
+	    {
+	      object->add_merge_mapping(this, shndx, pf->input_offset,
+					pf->fde->length(), -1);
+	      delete pf->fde;
+	    }
+	  else
+	    cie->add_fde(pf->fde);
+	}
     }
 
+  // We have taken ownership of the CIEs and FDEs.
+  cies.clear();
+
+  // Relocations are scanned before the mappings are done, and may ask
+  // whether they apply to a discarded range.
+  object->index_merge_map(shndx);
+
   return EH_OPTIMIZABLE_SECTION;
 }
 
-// The bulk of the implementation of add_ehframe_input_section.
+// The bulk of the implementation of parse_ehframe_input_section.
 
 template<int size, bool big_endian>
 bool
-Eh_frame::do_add_ehframe_input_section(
+Eh_frame::do_parse_ehframe_input_section(
     Sized_relobj_file<size, big_endian>* object,
     const unsigned char* symbols,
     section_size_type symbols_size,
@@ -642,7 +817,7 @@ Eh_frame::do_add_ehframe_input_section(
     unsigned int reloc_type,
     const unsigned char* pcontents,
     section_size_type contents_len,
-    New_cies* new_cies)
+    Parsed_eh_frame_section* parsed)
 {
   Track_relocs<size, big_endian> relocs;
 
@@ -694,17 +869,18 @@ Eh_frame::do_add_ehframe_input_section(
       if (id == 0)
 	{
 	  // CIE.
-	  if (!this->read_cie(object, shndx, symbols, symbols_size,
-			      symbol_names, symbol_names_size,
-			      pcontents, p, pentend, &relocs, &cies,
-			      new_cies))
+	  if (!Eh_frame::read_cie(object, shndx, symbols, symbols_size,
+				  symbol_names, symbol_names_size,
+				  pcontents, p, pentend, &relocs, &cies,
+				  parsed))
 	    return false;
 	}
       else
 	{
 	  // FDE.
-	  if (!this->read_fde(object, shndx, symbols, symbols_size,
-			      pcontents, id, p, pentend, &relocs, &cies))
+	  if (!Eh_frame::read_fde(object, shndx, symbols, symbols_size,
+				  pcontents, id, p, pentend, &relocs, &cies,
+				  parsed))
 	    return false;
 	}
 
@@ -729,7 +905,7 @@ Eh_frame::read_cie(Sized_relobj_file<size, big_endian>* object,
 		   const unsigned char* pcieend,
 		   Track_relocs<size, big_endian>* relocs,
 		   Offsets_to_cie* cies,
-		   New_cies* new_cies)
+		   Parsed_eh_frame_section* parsed)
 {
   bool mergeable = true;
 
@@ -922,48 +1098,38 @@ Eh_frame::read_cie(Sized_relobj_file<size, big_endian>* object,
   if (relocs->advance(pcieend - pcontents) > 0)
     return false;
 
-  Cie cie(object, shndx, (pcie - 8) - pcontents, fde_encoding, 
+  Cie cie(object, shndx, (pcie - 8) - pcontents, fde_encoding,
 	  personality_name, pcie, pcieend - pcie);
-  Cie* cie_pointer = NULL;
+
+  // See if we already saw this CIE in this section.  Duplicates
+  // across sections are found when the section is added to the
+  // output data.
+  Parsed_eh_frame_section::Parsed_cies& parsed_cies(parsed->cies());
+  unsigned int cie_index = parsed_cies.size();
   if (mergeable)
     {
-      Cie_offsets::iterator find_cie = this->cie_offsets_.find(&cie);
-      if (find_cie != this->cie_offsets_.end())
-	cie_pointer = *find_cie;
-      else
+      for (unsigned int i = 0; i < parsed_cies.size(); ++i)
 	{
-	  // See if we already saw this CIE in this object file.
-	  for (New_cies::const_iterator pc = new_cies->begin();
-	       pc != new_cies->end();
-	       ++pc)
+	  if (*parsed_cies[i].cie == cie)
 	    {
-	      if (*(pc->first) == cie)
-		{
-		  cie_pointer = pc->first;
-		  break;
-		}
+	      cie_index = i;
+	      break;
 	    }
 	}
     }
 
-  if (cie_pointer == NULL)
-    {
-      cie_pointer = new Cie(cie);
-      new_cies->push_back(std::make_pair(cie_pointer, mergeable));
-    }
+  if (cie_index == parsed_cies.size())
+    parsed_cies.push_back(Parsed_eh_frame_section::Parsed_cie(
+	new Cie(cie), mergeable, (pcie - 8) - pcontents,
+	pcieend - (pcie - 8)));
   else
     {
-      // We are deleting this CIE.  Record that in our mapping from
-      // input sections to the output section.  At this point we don't
-      // know for sure that we are doing a special mapping for this
-      // input section, but that's OK--if we don't do a special
-      // mapping, nobody will ever ask for the mapping we add here.
-      object->add_merge_mapping(this, shndx, (pcie - 8) - pcontents,
-                                pcieend - (pcie - 8), -1);
+      // We are deleting this CIE.
+      parsed->add_discarded((pcie - 8) - pcontents, pcieend - (pcie - 8));
     }
 
   // Record this CIE plus the offset in the input section.
-  cies->insert(std::make_pair(pcie - pcontents, cie_pointer));
+  cies->insert(std::make_pair(pcie - pcontents, cie_index));
 
   return true;
 }
@@ -981,7 +1147,8 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
 		   const unsigned char* pfde,
 		   const unsigned char* pfdeend,
 		   Track_relocs<size, big_endian>* relocs,
-		   Offsets_to_cie* cies)
+		   Offsets_to_cie* cies,
+		   Parsed_eh_frame_section* parsed)
 {
   // OFFSET is the distance between the 4 bytes before PFDE to the
   // start of the CIE.  The offset we recorded for the CIE is 8 bytes
@@ -990,7 +1157,9 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
   Offsets_to_cie::const_iterator pcie = cies->find(cie_offset);
   if (pcie == cies->end())
     return false;
-  Cie* cie = pcie->second;
+  Parsed_eh_frame_section::Parsed_cie* parsed_cie =
+    &parsed->cies()[pcie->second];
+  const Cie* cie = parsed_cie->cie;
 
   int pc_size = 0;
   switch (cie->fde_encoding() & 7)
@@ -1046,8 +1215,7 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
 	{
 	  // This FDE applies to a discarded function.  We
 	  // can discard this FDE.
-	  object->add_merge_mapping(this, shndx, (pfde - 8) - pcontents,
-				    pfdeend - (pfde - 8), -1);
+	  parsed->add_discarded((pfde - 8) - pcontents, pfdeend - (pfde - 8));
 	  return true;
 	}
 
@@ -1065,8 +1233,9 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
   // pointer to a PC relative offset when generating a shared library.
   relocs->advance(pfdeend - pcontents);
 
-  // Find the section index for code that this FDE describes.
-  // If we have discarded the section, we can also discard the FDE.
+  // Find the section index for code that this FDE describes.  If we
+  // discard the section, we can also discard the FDE, but we don't
+  // know that yet.
   unsigned int fde_shndx;
   const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
   if (symndx >= symbols_size / sym_size)
@@ -1075,10 +1244,10 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
   bool is_ordinary;
   fde_shndx = object->adjust_sym_shndx(symndx, sym.get_st_shndx(),
 				       &is_ordinary);
-  bool is_discarded = (is_ordinary
-		       && fde_shndx != elfcpp::SHN_UNDEF
-		       && fde_shndx < object->shnum()
-		       && !object->is_section_included(fde_shndx));
+  if (!is_ordinary
+      || fde_shndx == elfcpp::SHN_UNDEF
+      || fde_shndx >= object->shnum())
+    fde_shndx = -1U;
 
   // Fetch the address range field from the FDE. The offset and size
   // of the field depends on the PC encoding given in the CIE, but
@@ -1101,17 +1270,17 @@ Eh_frame::read_fde(Sized_relobj_file<size, big_endian>* object,
       gold_unreachable();
     }
 
-  if (is_discarded || address_range == 0)
+  if (address_range == 0)
     {
       // This FDE applies to a discarded function.  We
       // can discard this FDE.
-      object->add_merge_mapping(this, shndx, (pfde - 8) - pcontents,
-                                pfdeend - (pfde - 8), -1);
+      parsed->add_discarded((pfde - 8) - pcontents, pfdeend - (pfde - 8));
       return true;
     }
 
-  cie->add_fde(new Fde(object, shndx, (pfde - 8) - pcontents,
-		       pfde, pfdeend - pfde));
+  parsed_cie->fdes.push_back(Parsed_eh_frame_section::Parsed_fde(
+      new Fde(object, shndx, (pfde - 8) - pcontents, pfde, pfdeend - pfde),
+      (pfde - 8) - pcontents, fde_shndx));
 
   return true;
 }
@@ -1195,6 +1364,16 @@ Eh_frame::set_final_data_size()
 					    this->addralign(),
 					    this);
 
+  // The mappings are complete, so index the merge maps again before
+  // the relocations are applied.
+  for (std::vector<std::pair<Relobj*, unsigned int> >::const_iterator p =
+	 this->mapped_sections_.begin();
+       p != this->mapped_sections_.end();
+       ++p)
+    p->first->index_merge_map(p->second);
+  std::vector<std::pair<Relobj*, unsigned int> >().swap(
+      this->mapped_sections_);
+
   this->mappings_are_done_ = true;
   this->final_data_size_ = output_offset - output_start;
 
@@ -1295,6 +1474,18 @@ Eh_frame::add_ehframe_input_section<32, false>(
     unsigned int shndx,
     unsigned int reloc_shndx,
     unsigned int reloc_type);
+
+template
+Parsed_eh_frame_section*
+Eh_frame::parse_ehframe_input_section<32, false>(
+    Sized_relobj_file<32, false>* object,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size,
+    unsigned int shndx,
+    unsigned int reloc_shndx,
+    unsigned int reloc_type);
 #endif
 
 #ifdef HAVE_TARGET_32_BIG
@@ -1309,6 +1500,18 @@ Eh_frame::add_ehframe_input_section<32, true>(
     unsigned int shndx,
     unsigned int reloc_shndx,
     unsigned int reloc_type);
+
+template
+Parsed_eh_frame_section*
+Eh_frame::parse_ehframe_input_section<32, true>(
+    Sized_relobj_file<32, true>* object,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size,
+    unsigned int shndx,
+    unsigned int reloc_shndx,
+    unsigned int reloc_type);
 #endif
 
 #ifdef HAVE_TARGET_64_LITTLE
@@ -1323,6 +1526,18 @@ Eh_frame::add_ehframe_input_section<64, false>(
     unsigned int shndx,
     unsigned int reloc_shndx,
     unsigned int reloc_type);
+
+template
+Parsed_eh_frame_section*
+Eh_frame::parse_ehframe_input_section<64, false>(
+    Sized_relobj_file<64, false>* object,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size,
+    unsigned int shndx,
+    unsigned int reloc_shndx,
+    unsigned int reloc_type);
 #endif
 
 #ifdef HAVE_TARGET_64_BIG
@@ -1337,6 +1552,18 @@ Eh_frame::add_ehframe_input_section<64, true>(
     unsigned int shndx,
     unsigned int reloc_shndx,
     unsigned int reloc_type);
+
+template
+Parsed_eh_frame_section*
+Eh_frame::parse_ehframe_input_section<64, true>(
+    Sized_relobj_file<64, true>* object,
+    const unsigned char* symbols,
+    section_size_type symbols_size,
+    const unsigned char* symbol_names,
+    section_size_type symbol_names_size,
+    unsigned int shndx,
+    unsigned int reloc_shndx,
+    unsigned int reloc_type);
 #endif
 
 } // End namespace gold.
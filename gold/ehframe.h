@@ -37,6 +37,7 @@ template<int size, bool big_endian>
 class Track_relocs;
 
 class Eh_frame;
+class Parsed_eh_frame_section;
 
 // This class manages the .eh_frame_hdr section, which holds the data
 // for the PT_GNU_EH_FRAME segment.  gcc's unwind support code uses
@@ -102,14 +103,14 @@ class Eh_frame_hdr : public Output_section_data
     typedef typename std::vector<Fde_address> Fde_address_list;
     typedef typename Fde_address_list::iterator iterator;
 
-    Fde_addresses(unsigned int reserve)
-      : fde_addresses_()
-    { this->fde_addresses_.reserve(reserve); }
+    Fde_addresses(unsigned int count)
+      : fde_addresses_(count)
+    { }
 
     void
-    push_back(Address pc_address, Address fde_address)
+    set(unsigned int i, Address pc_address, Address fde_address)
     {
-      this->fde_addresses_.push_back(std::make_pair(pc_address, fde_address));
+      this->fde_addresses_[i] = std::make_pair(pc_address, fde_address);
     }
 
     iterator
@@ -124,16 +125,27 @@ class Eh_frame_hdr : public Output_section_data
     Fde_address_list fde_addresses_;
   };
 
-  // Compare Fde_address objects.
+  // Compare Fde_address objects.  We compare the FDE addresses if
+  // the PCs are the same, so that the order does not depend on how
+  // the sort was split up.
   template<int size>
   struct Fde_address_compare
   {
     bool
     operator()(const typename Fde_addresses<size>::Fde_address& f1,
 	       const typename Fde_addresses<size>::Fde_address& f2) const
-    { return f1.first < f2.first; }
+    {
+      if (f1.first != f2.first)
+	return f1.first < f2.first;
+      return f1.second < f2.second;
+    }
   };
 
+  // Read the PCs of a range of FDEs; used to split up the work in
+  // get_fde_addresses.
+  template<int size, bool big_endian>
+  class Fde_pc_reader;
+
   // Return the PC to which an FDE refers.
   template<int size, bool big_endian>
   typename elfcpp::Elf_types<size>::Elf_Addr
@@ -385,7 +397,8 @@ class Eh_frame : public Output_section_data
   // is the relocation section if any (0 for none, -1U for multiple).
   // RELOC_TYPE is the type of the relocation section if any.  This
   // returns whether the section was incorporated into the .eh_frame
-  // data.
+  // data.  If the section was already parsed when the symbols were
+  // read, the parsed data is used.
   template<int size, bool big_endian>
   Eh_frame_section_disposition
   add_ehframe_input_section(Sized_relobj_file<size, big_endian>* object,
@@ -396,6 +409,20 @@ class Eh_frame : public Output_section_data
 			    unsigned int shndx, unsigned int reloc_shndx,
 			    unsigned int reloc_type);
 
+  // Parse the input section SHNDX in OBJECT, with arguments as for
+  // add_ehframe_input_section.  This does not refer to any Eh_frame
+  // data, so it may be called for different objects at the same time.
+  // The caller takes ownership of the result.
+  template<int size, bool big_endian>
+  static Parsed_eh_frame_section*
+  parse_ehframe_input_section(Sized_relobj_file<size, big_endian>* object,
+			      const unsigned char* symbols,
+			      section_size_type symbols_size,
+			      const unsigned char* symbol_names,
+			      section_size_type symbol_names_size,
+			      unsigned int shndx, unsigned int reloc_shndx,
+			      unsigned int reloc_type);
+
   // Add a CIE and an FDE for a PLT section, to permit unwinding
   // through a PLT.  The FDE data should start with 8 bytes of zero,
   // which will be replaced by a 4 byte PC relative reference to the
@@ -444,36 +471,33 @@ class Eh_frame : public Output_section_data
   // A list of unmergeable CIEs.
   typedef std::vector<Cie*> Unmergeable_cie_offsets;
 
-  // A mapping from offsets to CIEs.  This is used while reading an
-  // input section.
-  typedef std::map<uint64_t, Cie*> Offsets_to_cie;
-
-  // A list of CIEs, and a bool indicating whether the CIE is
-  // mergeable.
-  typedef std::vector<std::pair<Cie*, bool> > New_cies;
+  // A mapping from offsets to the index of a CIE in a
+  // Parsed_eh_frame_section.  This is used while reading an input
+  // section.
+  typedef std::map<uint64_t, unsigned int> Offsets_to_cie;
 
   // Skip an LEB128.
   static bool
   skip_leb128(const unsigned char**, const unsigned char*);
 
-  // The implementation of add_ehframe_input_section.
+  // The implementation of parse_ehframe_input_section.
   template<int size, bool big_endian>
-  bool
-  do_add_ehframe_input_section(Sized_relobj_file<size, big_endian>* object,
-			       const unsigned char* symbols,
-			       section_size_type symbols_size,
-			       const unsigned char* symbol_names,
-			       section_size_type symbol_names_size,
-			       unsigned int shndx,
-			       unsigned int reloc_shndx,
-			       unsigned int reloc_type,
-			       const unsigned char* pcontents,
-			       section_size_type contents_len,
-			       New_cies*);
+  static bool
+  do_parse_ehframe_input_section(Sized_relobj_file<size, big_endian>* object,
+				 const unsigned char* symbols,
+				 section_size_type symbols_size,
+				 const unsigned char* symbol_names,
+				 section_size_type symbol_names_size,
+				 unsigned int shndx,
+				 unsigned int reloc_shndx,
+				 unsigned int reloc_type,
+				 const unsigned char* pcontents,
+				 section_size_type contents_len,
+				 Parsed_eh_frame_section*);
 
   // Read a CIE.
   template<int size, bool big_endian>
-  bool
+  static bool
   read_cie(Sized_relobj_file<size, big_endian>* object,
 	   unsigned int shndx,
 	   const unsigned char* symbols,
@@ -485,11 +509,11 @@ class Eh_frame : public Output_section_data
 	   const unsigned char* pcieend,
 	   Track_relocs<size, big_endian>* relocs,
 	   Offsets_to_cie* cies,
-	   New_cies* new_cies);
+	   Parsed_eh_frame_section* parsed);
 
   // Read an FDE.
   template<int size, bool big_endian>
-  bool
+  static bool
   read_fde(Sized_relobj_file<size, big_endian>* object,
 	   unsigned int shndx,
 	   const unsigned char* symbols,
@@ -499,7 +523,14 @@ class Eh_frame : public Output_section_data
 	   const unsigned char* pfde,
 	   const unsigned char* pfdeend,
 	   Track_relocs<size, big_endian>* relocs,
-	   Offsets_to_cie* cies);
+	   Offsets_to_cie* cies,
+	   Parsed_eh_frame_section* parsed);
+
+  // Merge the CIEs and FDEs of a parsed input section into the
+  // output data.
+  Eh_frame_section_disposition
+  add_parsed_ehframe_input_section(Relobj* object,
+				   Parsed_eh_frame_section* parsed);
 
   // Template version of write function.
   template<int size, bool big_endian>
@@ -514,6 +545,9 @@ class Eh_frame : public Output_section_data
   // A mapping from unmergeable CIEs to their offset in the output
   // file.
   Unmergeable_cie_offsets unmergeable_cie_offsets_;
+  // The input sections for which we add merge mappings.  Their
+  // merge maps are indexed again when the mappings are done.
+  std::vector<std::pair<Relobj*, unsigned int> > mapped_sections_;
   // Whether we have created the mappings to the output section.
   bool mappings_are_done_;
   // The final data size.  This is only set if mappings_are_done_ is
@@ -521,6 +555,113 @@ class Eh_frame : public Output_section_data
   section_size_type final_data_size_;
 };
 
+// The CIEs and FDEs found in a single input .eh_frame section, as
+// read by Eh_frame::parse_ehframe_input_section.  Nothing here has
+// been merged with the output data yet.
+
+class Parsed_eh_frame_section
+{
+ public:
+  // An FDE read from the section.
+  struct Parsed_fde
+  {
+    Parsed_fde(Fde* f, section_offset_type offset, unsigned int code_shndx)
+      : fde(f), input_offset(offset), fde_shndx(code_shndx)
+    { }
+
+    // The FDE itself.
+    Fde* fde;
+    // The offset of the FDE in the input section.
+    section_offset_type input_offset;
+    // The index of the section holding the code which the FDE
+    // describes, or -1U if we can not discard the FDE.
+    unsigned int fde_shndx;
+  };
+
+  // A CIE read from the section, with its FDEs.  An input section
+  // may contain several copies of the same CIE; we only record the
+  // first one.
+  struct Parsed_cie
+  {
+    Parsed_cie(Cie* c, bool is_mergeable, section_offset_type offset,
+	       section_size_type len)
+      : cie(c), mergeable(is_mergeable), input_offset(offset), length(len),
+	fdes()
+    { }
+
+    // The CIE itself.
+    Cie* cie;
+    // Whether the CIE may be merged with CIEs from other sections.
+    bool mergeable;
+    // The offset and length of the CIE in the input section.
+    section_offset_type input_offset;
+    section_size_type length;
+    // The FDEs which use this CIE.
+    std::vector<Parsed_fde> fdes;
+  };
+
+  typedef std::vector<Parsed_cie> Parsed_cies;
+
+  // An input range which should be discarded from the output.
+  typedef std::vector<std::pair<section_offset_type, section_size_type> >
+    Discarded_ranges;
+
+  Parsed_eh_frame_section(unsigned int shndx)
+    : shndx_(shndx), disposition_(Eh_frame::EH_UNRECOGNIZED_SECTION),
+      cies_(), discarded_()
+  { }
+
+  ~Parsed_eh_frame_section()
+  { this->clear(); }
+
+  // The input section index.
+  unsigned int
+  shndx() const
+  { return this->shndx_; }
+
+  // What to do with the section.
+  Eh_frame::Eh_frame_section_disposition
+  disposition() const
+  { return this->disposition_; }
+
+  void
+  set_disposition(Eh_frame::Eh_frame_section_disposition disposition)
+  { this->disposition_ = disposition; }
+
+  // The CIEs in the section.
+  Parsed_cies&
+  cies()
+  { return this->cies_; }
+
+  // The ranges of the section to discard.
+  Discarded_ranges&
+  discarded()
+  { return this->discarded_; }
+
+  // Record that the range of LENGTH bytes at OFFSET is discarded.
+  void
+  add_discarded(section_offset_type offset, section_size_type length)
+  { this->discarded_.push_back(std::make_pair(offset, length)); }
+
+  // Delete any CIEs and FDEs that we still own.
+  void
+  clear();
+
+ private:
+  Parsed_eh_frame_section(const Parsed_eh_frame_section&);
+  Parsed_eh_frame_section& operator=(const Parsed_eh_frame_section&);
+
+  // The input section index.
+  unsigned int shndx_;
+  // What to do with the section.
+  Eh_frame::Eh_frame_section_disposition disposition_;
+  // The CIEs in the section.
+  Parsed_cies cies_;
+  // Ranges of the input section which will not appear in the output:
+  // duplicate CIEs and FDEs for discarded code.
+  Discarded_ranges discarded_;
+};
+
 } // End namespace gold.
 
 #endif // !defined(GOLD_EHFRAME_H)
@@ -25,6 +25,7 @@
 #include <cstring>
 #include <cerrno>
 #include <climits>
+#include <algorithm>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -344,26 +345,39 @@ File_read::find_view(off_t start, section_size_type size,
     if (byteshift == -1U || byteshift == 0)
       return this->whole_file_view_;
 
+  // Try the view we found last time.
+  File_read::View* v = this->last_view_;
+  if (v != NULL
+      && v->start() <= start
+      && (v->start() + static_cast<off_t>(v->size())
+	  >= start + static_cast<off_t>(size))
+      && (byteshift == -1U || byteshift == v->byteshift()))
+    {
+      v->set_accessed();
+      return v;
+    }
+
   off_t page = File_read::page_offset(start);
 
-  unsigned int bszero = 0;
-  Views::const_iterator p = this->views_.upper_bound(std::make_pair(page - 1,
-								    bszero));
+  Views::const_iterator p =
+    std::lower_bound(this->views_.begin(), this->views_.end(),
+		     std::make_pair(page, 0U), View_less());
 
-  while (p != this->views_.end() && p->first.first <= page)
+  while (p != this->views_.end() && (*p)->start() == page)
     {
-      if (p->second->start() <= start
-	  && (p->second->start() + static_cast<off_t>(p->second->size())
+      if ((*p)->start() <= start
+	  && ((*p)->start() + static_cast<off_t>((*p)->size())
 	      >= start + static_cast<off_t>(size)))
 	{
-	  if (byteshift == -1U || byteshift == p->second->byteshift())
+	  if (byteshift == -1U || byteshift == (*p)->byteshift())
 	    {
-	      p->second->set_accessed();
-	      return p->second;
+	      (*p)->set_accessed();
+	      this->last_view_ = *p;
+	      return *p;
 	    }
 
 	  if (vshifted != NULL && *vshifted == NULL)
-	    *vshifted = p->second;
+	    *vshifted = *p;
 	}
 
       ++p;
@@ -442,17 +456,21 @@ File_read::read(off_t start, section_size_type size, void* p)
 void
 File_read::add_view(File_read::View* v)
 {
-  std::pair<Views::iterator, bool> ins =
-    this->views_.insert(std::make_pair(std::make_pair(v->start(),
-						      v->byteshift()),
-				       v));
-  if (ins.second)
-    return;
+  std::pair<off_t, unsigned int> key(v->start(), v->byteshift());
+  Views::iterator p = std::lower_bound(this->views_.begin(),
+				       this->views_.end(), key, View_less());
+  if (p == this->views_.end()
+      || (*p)->start() != v->start()
+      || (*p)->byteshift() != v->byteshift())
+    {
+      this->views_.insert(p, v);
+      return;
+    }
 
   // There was an existing view at this offset.  It must not be large
   // enough.  We can't delete it here, since something might be using
   // it; we put it on a list to be deleted when the file is unlocked.
-  File_read::View* vold = ins.first->second;
+  File_read::View* vold = *p;
   gold_assert(vold->size() < v->size());
   if (vold->should_cache())
     {
@@ -461,7 +479,9 @@ File_read::add_view(File_read::View* v)
     }
   this->saved_views_.push_back(vold);
 
-  ins.first->second = v;
+  *p = v;
+  if (this->last_view_ == vold)
+    this->last_view_ = v;
 }
 
 // Make a new view with a specified byteshift, reading the data from
@@ -776,7 +796,7 @@ File_read::clear_view_cache_marks()
   for (Views::iterator p = this->views_.begin();
        p != this->views_.end();
        ++p)
-    p->second->clear_cache();
+    (*p)->clear_cache();
   for (Saved_views::iterator p = this->saved_views_.begin();
        p != this->saved_views_.end();
        ++p)
@@ -793,20 +813,26 @@ File_read::clear_views(Clear_views_mode mode)
 {
   bool keep_files_mapped = (parameters->options_valid()
 			    && parameters->options().keep_files_mapped());
-  Views::iterator p = this->views_.begin();
-  while (p != this->views_.end())
+  this->last_view_ = NULL;
+
+  // Walk the views, moving the ones we keep down over the ones we
+  // delete.
+  Views::iterator out = this->views_.begin();
+  for (Views::iterator p = this->views_.begin();
+       p != this->views_.end();
+       ++p)
     {
+      File_read::View* v = *p;
       bool should_delete;
-      if (p->second->is_locked() || p->second->is_permanent_view())
+      if (v->is_locked() || v->is_permanent_view())
 	should_delete = false;
       else if (mode == CLEAR_VIEWS_ALL)
 	should_delete = true;
-      else if ((p->second->should_cache()
-		|| p->second == this->whole_file_view_)
+      else if ((v->should_cache() || v == this->whole_file_view_)
 	       && keep_files_mapped)
 	should_delete = false;
       else if (this->object_count_ > 1
-	       && p->second->accessed()
+	       && v->accessed()
 	       && mode != CLEAR_VIEWS_ARCHIVE)
 	should_delete = false;
       else
@@ -814,37 +840,34 @@ File_read::clear_views(Clear_views_mode mode)
 
       if (should_delete)
 	{
-	  if (p->second == this->whole_file_view_)
+	  if (v == this->whole_file_view_)
 	    this->whole_file_view_ = NULL;
-	  delete p->second;
-
-	  // map::erase invalidates only the iterator to the deleted
-	  // element.
-	  Views::iterator pe = p;
-	  ++p;
-	  this->views_.erase(pe);
+	  delete v;
 	}
       else
 	{
-	  p->second->clear_accessed();
-	  ++p;
+	  v->clear_accessed();
+	  *out = v;
+	  ++out;
 	}
     }
+  this->views_.erase(out, this->views_.end());
 
-  Saved_views::iterator q = this->saved_views_.begin();
-  while (q != this->saved_views_.end())
+  Saved_views::iterator qout = this->saved_views_.begin();
+  for (Saved_views::iterator q = this->saved_views_.begin();
+       q != this->saved_views_.end();
+       ++q)
     {
       if (!(*q)->is_locked())
-	{
-	  delete *q;
-	  q = this->saved_views_.erase(q);
-	}
+	delete *q;
       else
 	{
 	  gold_assert(mode != CLEAR_VIEWS_ALL);
-	  ++q;
+	  *qout = *q;
+	  ++qout;
 	}
     }
+  this->saved_views_.erase(qout, this->saved_views_.end());
 }
 
 // Print statistical information to stderr.  This is used for --stats.
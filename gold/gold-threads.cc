@@ -22,12 +22,21 @@
 
 #include "gold.h"
 
+#include <cstdlib>
 #include <cstring>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <dirent.h>
 
 #ifdef ENABLE_THREADS
 #include <pthread.h>
 #endif
 
+#ifdef HAVE_SCHED_GETAFFINITY
+#include <sched.h>
+#endif
+
 #include "options.h"
 #include "parameters.h"
 #include "gold-threads.h"
@@ -447,4 +456,439 @@ Initialize_lock::do_run_once(void*)
   *this->pplock_ = new Lock();
 }
 
+// Class Parallel_work.
+
+Lock* Parallel_work::pool_lock_;
+Condvar* Parallel_work::work_available_;
+Condvar* Parallel_work::work_done_;
+std::vector<Parallel_work*>* Parallel_work::pending_;
+unsigned int Parallel_work::pool_thread_count_;
+unsigned int Parallel_work::busy_threads_;
+unsigned int Parallel_work::busy_helpers_;
+unsigned int Parallel_work::helper_threads_;
+
+// Return the number of threads to use for a single piece of work.
+
+unsigned int
+Parallel_work::thread_count()
+{
+#ifndef ENABLE_THREADS
+  return 1;
+#else
+  if (!parameters->options_valid() || !parameters->options().threads())
+    return 1;
+  int count = parameters->options().thread_count();
+  if (count <= 0)
+    count = Thread_placement::cpu_count();
+  // Don't use more threads than the Workqueue has.
+  if (Parallel_work::pool_thread_count_ > 0
+      && static_cast<unsigned int>(count) > Parallel_work::pool_thread_count_)
+    count = Parallel_work::pool_thread_count_;
+  return count;
+#endif
+}
+
+// Set the number of threads the Workqueue is using.  The first call
+// creates the helper pool.  We never delete it, as helper threads
+// may still be waiting on it when the program exits.
+
+void
+Parallel_work::set_thread_count(int thread_count)
+{
+#ifdef ENABLE_THREADS
+  if (!parameters->options().threads())
+    return;
+  if (Parallel_work::pool_lock_ == NULL)
+    {
+      Parallel_work::pool_lock_ = new Lock();
+      Parallel_work::work_available_ = new Condvar(*Parallel_work::pool_lock_);
+      Parallel_work::work_done_ = new Condvar(*Parallel_work::pool_lock_);
+      Parallel_work::pending_ = new std::vector<Parallel_work*>();
+    }
+  Hold_lock hl(*Parallel_work::pool_lock_);
+  Parallel_work::pool_thread_count_ = thread_count > 0 ? thread_count : 0;
+#else
+  gold_assert(thread_count >= 0);
+#endif
+}
+
+// Set the number of workqueue threads which are running tasks.
+
+void
+Parallel_work::set_busy_threads(int busy_threads)
+{
+  if (Parallel_work::pool_lock_ == NULL)
+    return;
+  Hold_lock hl(*Parallel_work::pool_lock_);
+  Parallel_work::busy_threads_ = busy_threads;
+}
+
+// Run all the pieces.
+
+void
+Parallel_work::run(unsigned int piece_count)
+{
+  unsigned int threads = Parallel_work::thread_count();
+  if (threads > piece_count)
+    threads = piece_count;
+
+  unsigned int helpers = 0;
+  if (threads > 1)
+    {
+      this->lock_ = new Lock();
+      this->next_piece_ = 0;
+      this->piece_count_ = piece_count;
+
+      // The calling thread runs pieces too, so we only need
+      // THREADS - 1 helpers.
+      helpers = this->add_helpers(threads - 1);
+      if (helpers == 0)
+	{
+	  delete this->lock_;
+	  this->lock_ = NULL;
+	}
+    }
+
+  if (helpers == 0)
+    {
+      for (unsigned int i = 0; i < piece_count; ++i)
+	this->do_run_piece(i);
+      return;
+    }
+
+  this->run_pieces();
+  this->finish_helpers();
+
+  delete this->lock_;
+  this->lock_ = NULL;
+}
+
+// Ask for up to WANTED helpers.  We only take helpers for workqueue
+// threads which are not running tasks, counting the calling thread as
+// busy even if it is not a workqueue thread.  Start new helper threads
+// if there are not enough in the pool.
+
+unsigned int
+Parallel_work::add_helpers(unsigned int wanted)
+{
+#ifndef ENABLE_THREADS
+  gold_unreachable();
+#else
+  if (Parallel_work::pool_lock_ == NULL)
+    return 0;
+
+  Hold_lock hl(*Parallel_work::pool_lock_);
+
+  unsigned int busy = (std::max(Parallel_work::busy_threads_, 1U)
+		       + Parallel_work::busy_helpers_);
+  if (Parallel_work::pool_thread_count_ <= busy)
+    return 0;
+  unsigned int helpers = std::min(wanted,
+				  Parallel_work::pool_thread_count_ - busy);
+
+  Parallel_work::busy_helpers_ += helpers;
+  this->helpers_wanted_ = helpers;
+  this->helpers_active_ = 0;
+  Parallel_work::pending_->push_back(this);
+
+  while (Parallel_work::helper_threads_ < Parallel_work::busy_helpers_)
+    {
+      pthread_attr_t attr;
+      int err = pthread_attr_init(&attr);
+      if (err != 0)
+	gold_fatal(_("pthread_attr_init failed: %s"), strerror(err));
+      err = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+      if (err != 0)
+	gold_fatal(_("pthread_attr_setdetachstate failed: %s"),
+		   strerror(err));
+      pthread_t tid;
+      err = pthread_create(&tid, &attr, &Parallel_work::helper_body, NULL);
+      if (err != 0)
+	gold_fatal(_("pthread_create failed: %s"), strerror(err));
+      pthread_attr_destroy(&attr);
+      ++Parallel_work::helper_threads_;
+    }
+
+  Parallel_work::work_available_->broadcast();
+  return helpers;
+#endif
+}
+
+// Wait for our helpers.  Helpers which have not started on this object
+// by now would find no pieces left, so we give them back.
+
+void
+Parallel_work::finish_helpers()
+{
+  Hold_lock hl(*Parallel_work::pool_lock_);
+  if (this->helpers_wanted_ > 0)
+    {
+      std::vector<Parallel_work*>* pending = Parallel_work::pending_;
+      pending->erase(std::find(pending->begin(), pending->end(), this));
+      Parallel_work::busy_helpers_ -= this->helpers_wanted_;
+      this->helpers_wanted_ = 0;
+    }
+  while (this->helpers_active_ > 0)
+    Parallel_work::work_done_->wait();
+}
+
+// Run pieces until there are no more.
+
+void
+Parallel_work::run_pieces()
+{
+  while (true)
+    {
+      unsigned int piece;
+      {
+	Hold_lock hl(*this->lock_);
+	if (this->next_piece_ >= this->piece_count_)
+	  return;
+	piece = this->next_piece_;
+	++this->next_piece_;
+      }
+      this->do_run_piece(piece);
+    }
+}
+
+// The body of a helper thread.  Wait for an object which wants a
+// helper, and run its pieces.  Passed to pthread_create.
+
+extern "C"
+void*
+Parallel_work::helper_body(void*)
+{
+  Thread_placement::place_helper_thread();
+
+  Lock* lock = Parallel_work::pool_lock_;
+  std::vector<Parallel_work*>* pending = Parallel_work::pending_;
+  lock->acquire();
+  while (true)
+    {
+      while (pending->empty())
+	Parallel_work::work_available_->wait();
+
+      Parallel_work* pw = pending->front();
+      --pw->helpers_wanted_;
+      if (pw->helpers_wanted_ == 0)
+	pending->erase(pending->begin());
+      ++pw->helpers_active_;
+
+      lock->release();
+      pw->run_pieces();
+      lock->acquire();
+
+      --pw->helpers_active_;
+      --Parallel_work::busy_helpers_;
+      if (pw->helpers_active_ == 0)
+	Parallel_work::work_done_->broadcast();
+    }
+  return NULL;
+}
+
+// Class Thread_placement.
+
+bool Thread_placement::initialized_;
+std::vector<int> Thread_placement::cpus_;
+std::vector<int> Thread_placement::nodes_;
+unsigned int Thread_placement::node_count_;
+
+// Add the CPUs in a list such as "0-3,8,10-11", as found in sysfs, to
+// *CPUS.
+
+static void
+parse_cpu_list(const char* s, std::vector<int>* cpus)
+{
+  while (*s >= '0' && *s <= '9')
+    {
+      char* end;
+      long first = strtol(s, &end, 10);
+      long last = first;
+      if (*end == '-')
+	last = strtol(end + 1, &end, 10);
+      for (long i = first; i <= last; ++i)
+	cpus->push_back(i);
+      if (*end != ',')
+	break;
+      s = end + 1;
+    }
+}
+
+// Find the CPUs we may run on, and their NUMA nodes.  On GNU/Linux
+// the nodes are listed in /sys/devices/system/node.  If we can't
+// find them, we treat all the CPUs as being on node 0.
+
+void
+Thread_placement::initialize()
+{
+  if (Thread_placement::initialized_)
+    return;
+  Thread_placement::initialized_ = true;
+
+  std::vector<int> cpus;
+#ifdef HAVE_SCHED_GETAFFINITY
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::sched_getaffinity(0, sizeof set, &set) == 0)
+    {
+      for (int i = 0; i < CPU_SETSIZE; ++i)
+	if (CPU_ISSET(i, &set))
+	  cpus.push_back(i);
+    }
+#endif
+  if (cpus.empty())
+    {
+      long count = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+      count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+      for (long i = 0; i < std::max(count, 1L); ++i)
+	cpus.push_back(i);
+    }
+
+  int max_cpu = *std::max_element(cpus.begin(), cpus.end());
+  std::vector<int> cpu_node(max_cpu + 1, 0);
+  static const char node_dir[] = "/sys/devices/system/node";
+  DIR* d = ::opendir(node_dir);
+  if (d != NULL)
+    {
+      struct dirent* de;
+      while ((de = ::readdir(d)) != NULL)
+	{
+	  int node;
+	  if (sscanf(de->d_name, "node%d", &node) != 1)
+	    continue;
+	  std::string name(std::string(node_dir) + '/' + de->d_name
+			   + "/cpulist");
+	  FILE* f = fopen(name.c_str(), "r");
+	  if (f == NULL)
+	    continue;
+	  char buf[4096];
+	  if (fgets(buf, sizeof buf, f) != NULL)
+	    {
+	      std::vector<int> node_cpus;
+	      parse_cpu_list(buf, &node_cpus);
+	      for (size_t i = 0; i < node_cpus.size(); ++i)
+		if (node_cpus[i] >= 0 && node_cpus[i] <= max_cpu)
+		  cpu_node[node_cpus[i]] = node;
+	    }
+	  fclose(f);
+	}
+      ::closedir(d);
+    }
+
+  std::vector<std::pair<int, int> > placed;
+  placed.reserve(cpus.size());
+  for (size_t i = 0; i < cpus.size(); ++i)
+    placed.push_back(std::make_pair(cpu_node[cpus[i]], cpus[i]));
+  std::sort(placed.begin(), placed.end());
+
+  Thread_placement::cpus_.clear();
+  Thread_placement::nodes_.clear();
+  Thread_placement::node_count_ = 0;
+  for (size_t i = 0; i < placed.size(); ++i)
+    {
+      if (i == 0 || placed[i].first != placed[i - 1].first)
+	++Thread_placement::node_count_;
+      Thread_placement::nodes_.push_back(placed[i].first);
+      Thread_placement::cpus_.push_back(placed[i].second);
+    }
+}
+
+// Return the number of CPUs.
+
+unsigned int
+Thread_placement::cpu_count()
+{
+  Thread_placement::initialize();
+  return Thread_placement::cpus_.size();
+}
+
+// Return the number of nodes.
+
+unsigned int
+Thread_placement::node_count()
+{
+  Thread_placement::initialize();
+  return Thread_placement::node_count_;
+}
+
+// Set *CPUS to the CPUs of NODE.
+
+void
+Thread_placement::node_cpus(int node, std::vector<int>* cpus)
+{
+  for (size_t i = 0; i < Thread_placement::cpus_.size(); ++i)
+    if (Thread_placement::nodes_[i] == node)
+      cpus->push_back(Thread_placement::cpus_[i]);
+}
+
+// Restrict the calling thread to CPUS.  This is only a hint, so we
+// quietly ignore failure.
+
+void
+Thread_placement::set_affinity(const std::vector<int>& cpus)
+{
+#ifdef HAVE_SCHED_GETAFFINITY
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (size_t i = 0; i < cpus.size(); ++i)
+    if (cpus[i] < CPU_SETSIZE)
+      CPU_SET(cpus[i], &set);
+  ::sched_setaffinity(0, sizeof set, &set);
+#else
+  (void) cpus;
+#endif
+}
+
+// Place workqueue thread THREAD_NUMBER.  Thread 0 is the main thread.
+
+void
+Thread_placement::place_thread(int thread_number)
+{
+  if (!parameters->options_valid())
+    return;
+  const char* affinity = parameters->options().thread_affinity();
+  if (strcmp(affinity, "none") == 0 || Thread_placement::cpus_.empty())
+    return;
+
+  size_t i = thread_number % Thread_placement::cpus_.size();
+  std::vector<int> cpus;
+  if (strcmp(affinity, "cpu") == 0)
+    cpus.push_back(Thread_placement::cpus_[i]);
+  else
+    Thread_placement::node_cpus(Thread_placement::nodes_[i], &cpus);
+  Thread_placement::set_affinity(cpus);
+}
+
+// Place a thread started by Parallel_work.  It inherits the affinity
+// of the thread which started it, which with --thread-affinity=cpu is
+// a single CPU, so we widen it to the node of that CPU.
+
+void
+Thread_placement::place_helper_thread()
+{
+#ifdef HAVE_SCHED_GETAFFINITY
+  if (!parameters->options_valid()
+      || strcmp(parameters->options().thread_affinity(), "none") == 0)
+    return;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::sched_getaffinity(0, sizeof set, &set) != 0)
+    return;
+  for (size_t i = 0; i < Thread_placement::cpus_.size(); ++i)
+    {
+      if (Thread_placement::cpus_[i] < CPU_SETSIZE
+	  && CPU_ISSET(Thread_placement::cpus_[i], &set))
+	{
+	  std::vector<int> cpus;
+	  Thread_placement::node_cpus(Thread_placement::nodes_[i], &cpus);
+	  Thread_placement::set_affinity(cpus);
+	  return;
+	}
+    }
+#endif
+}
+
 } // End namespace gold.
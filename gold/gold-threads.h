@@ -31,6 +31,9 @@
 #ifndef GOLD_THREADS_H
 #define GOLD_THREADS_H
 
+#include <algorithm>
+#include <vector>
+
 namespace gold
 {
 
@@ -262,6 +265,250 @@ class Initialize_lock : public Once
   Lock** const pplock_;
 };
 
+// A piece of work which can be split into a number of independent
+// pieces, several of which may be run at the same time on different
+// threads.  This is used for loops inside a single Task; ordering
+// between Tasks is still handled by the Workqueue.
+//
+// The pieces are run by the calling thread and by helper threads
+// from a pool shared by all Parallel_work objects.  The Workqueue
+// tells us how many threads it is using and how many of them are
+// running tasks, and we only use helpers for threads which would
+// otherwise be idle.  So several tasks using Parallel_work at once do
+// not run more threads than were asked for with --thread-count; if
+// all the workqueue threads are busy, the pieces are simply run on
+// the calling thread.
+
+class Parallel_work
+{
+ public:
+  Parallel_work()
+    : lock_(NULL), next_piece_(0), piece_count_(0), helpers_wanted_(0),
+      helpers_active_(0)
+  { }
+
+  virtual
+  ~Parallel_work()
+  { }
+
+  // Run pieces 0 through PIECE_COUNT - 1, and return when all of them
+  // have completed.  If we are not using threads, or no threads are
+  // idle, the pieces are run in order on the calling thread.
+  void
+  run(unsigned int piece_count);
+
+  // Return the number of threads that run() may use.  This is
+  // always 1 if we are not using threads.
+  static unsigned int
+  thread_count();
+
+  // Set the number of threads the Workqueue is using.  This is the
+  // most threads which may run at once, counting both workqueue
+  // threads and helpers.
+  static void
+  set_thread_count(int thread_count);
+
+  // Set the number of workqueue threads which are running tasks.
+  // This is called with the Workqueue lock held.
+  static void
+  set_busy_threads(int busy_threads);
+
+ protected:
+  // This must be implemented by the child class.
+  virtual void
+  do_run_piece(unsigned int piece) = 0;
+
+ private:
+  // This class can not be copied.
+  Parallel_work(const Parallel_work&);
+  Parallel_work& operator=(const Parallel_work&);
+
+  // Ask for up to WANTED helpers to run pieces of this object.
+  // Return the number we got.
+  unsigned int
+  add_helpers(unsigned int wanted);
+
+  // Wait for the helpers of this object to finish, and release any
+  // which never started.
+  void
+  finish_helpers();
+
+  // A function to pass to pthread_create.  Helper threads run this
+  // until the program exits.
+  static void*
+  helper_body(void*);
+
+  // Run pieces until there are none left.  This is called on each
+  // thread.
+  void
+  run_pieces();
+
+  // The lock controlling next_piece_.
+  Lock* lock_;
+  // The next piece to run.
+  unsigned int next_piece_;
+  // The total number of pieces.
+  unsigned int piece_count_;
+  // The number of helpers we were given which have not yet started
+  // on this object.  Protected by pool_lock_.
+  unsigned int helpers_wanted_;
+  // The number of helpers running pieces of this object.  Protected
+  // by pool_lock_.
+  unsigned int helpers_active_;
+
+  // The lock controlling the helper pool.  This is NULL if we are
+  // not using threads.
+  static Lock* pool_lock_;
+  // Signalled when there is new work for the helpers.
+  static Condvar* work_available_;
+  // Signalled when a helper finishes with an object.
+  static Condvar* work_done_;
+  // Objects waiting for helpers, in the order they asked.
+  static std::vector<Parallel_work*>* pending_;
+  // The number of threads the Workqueue is using.
+  static unsigned int pool_thread_count_;
+  // The number of workqueue threads running tasks.
+  static unsigned int busy_threads_;
+  // The number of helpers given to objects, whether or not they have
+  // started yet.
+  static unsigned int busy_helpers_;
+  // The number of helper threads we have created.
+  static unsigned int helper_threads_;
+};
+
+// The CPUs which gold may run on.  These are used to choose the
+// default number of threads, and to place threads as requested by
+// --thread-affinity.  The CPUs are ordered by NUMA node, and thread N
+// is placed on the Nth CPU, so that a link which uses fewer threads
+// than there are CPUs keeps them on as few nodes as possible, near the
+// memory holding the input files they share.
+
+class Thread_placement
+{
+ public:
+  // Find the CPUs and their nodes.  This must be called before any
+  // threads are started.  It does nothing if called again.
+  static void
+  initialize();
+
+  // Return the number of CPUs we may run on.
+  static unsigned int
+  cpu_count();
+
+  // Return the number of NUMA nodes holding those CPUs.
+  static unsigned int
+  node_count();
+
+  // Move the calling thread, which is workqueue thread THREAD_NUMBER,
+  // to its CPU or node, as requested by --thread-affinity.
+  static void
+  place_thread(int thread_number);
+
+  // Move the calling thread, which helps a workqueue thread with a
+  // Parallel_work, to all the CPUs of the node on which it started.
+  static void
+  place_helper_thread();
+
+ private:
+  // Restrict the calling thread to the CPUs in CPUS.
+  static void
+  set_affinity(const std::vector<int>& cpus);
+
+  // Set *CPUS to the CPUs of NODE.
+  static void
+  node_cpus(int node, std::vector<int>* cpus);
+
+  // Whether initialize has been called.
+  static bool initialized_;
+  // The CPUs we may run on, ordered by node and then by number.
+  static std::vector<int> cpus_;
+  // The node of each entry in cpus_.
+  static std::vector<int> nodes_;
+  // The number of different nodes in nodes_.
+  static unsigned int node_count_;
+};
+
+// The pieces of parallel_sort.  When MERGE is false, piece I sorts
+// the elements between BOUNDS[I] and BOUNDS[I + 1].  When MERGE is
+// true, piece I merges the two sorted runs starting at BOUNDS[2 * I]
+// and BOUNDS[2 * I + 1].
+
+template<typename Iterator, typename Compare>
+class Parallel_sort_work : public Parallel_work
+{
+ public:
+  Parallel_sort_work(Iterator first, Compare comp,
+		     const std::vector<size_t>* bounds, bool merge)
+    : first_(first), comp_(comp), bounds_(bounds), merge_(merge)
+  { }
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    const std::vector<size_t>& b(*this->bounds_);
+    if (!this->merge_)
+      std::stable_sort(this->first_ + b[piece], this->first_ + b[piece + 1],
+		       this->comp_);
+    else
+      std::inplace_merge(this->first_ + b[2 * piece],
+			 this->first_ + b[2 * piece + 1],
+			 this->first_ + b[2 * piece + 2], this->comp_);
+  }
+
+ private:
+  Iterator first_;
+  Compare comp_;
+  const std::vector<size_t>* bounds_;
+  bool merge_;
+};
+
+// Sort the range [FIRST, LAST) using COMP, splitting the work across
+// threads if the range is large.  The sort is stable, so the result
+// does not depend on the number of threads.
+
+template<typename Iterator, typename Compare>
+void
+parallel_sort(Iterator first, Iterator last, Compare comp)
+{
+  // Don't bother with threads for small ranges.
+  const size_t min_piece_size = 16384;
+  size_t count = last - first;
+  unsigned int pieces = Parallel_work::thread_count();
+  if (pieces > count / min_piece_size)
+    pieces = count / min_piece_size;
+  if (pieces <= 1)
+    {
+      std::stable_sort(first, last, comp);
+      return;
+    }
+
+  std::vector<size_t> bounds;
+  bounds.reserve(pieces + 1);
+  for (unsigned int i = 0; i < pieces; ++i)
+    bounds.push_back(count / pieces * i);
+  bounds.push_back(count);
+
+  Parallel_sort_work<Iterator, Compare> sorter(first, comp, &bounds, false);
+  sorter.run(pieces);
+
+  // Merge adjacent sorted runs until only one is left.
+  while (bounds.size() > 2)
+    {
+      unsigned int merges = (bounds.size() - 1) / 2;
+      Parallel_sort_work<Iterator, Compare> merger(first, comp, &bounds,
+						   true);
+      merger.run(merges);
+
+      std::vector<size_t> new_bounds;
+      new_bounds.reserve(merges + 2);
+      for (size_t i = 0; i < bounds.size() - 1; i += 2)
+	new_bounds.push_back(bounds[i]);
+      new_bounds.push_back(count);
+      bounds.swap(new_bounds);
+    }
+}
+
 } // End namespace gold.
 
 #endif // !defined(GOLD_THREADS_H)
@@ -68,6 +68,8 @@ gold_exit(Exit_status status)
     parameters->options().plugins()->cleanup();
   if (status != GOLD_OK && parameters != NULL && parameters->options_valid())
     unlink_if_ordinary(parameters->options().output_file_name());
+  if (status != GOLD_OK)
+    Output_file::remove_reflink_file();
   exit(status);
 }
 
@@ -166,6 +168,57 @@ Gc_runner::run(Workqueue* workqueue, const Task* task)
 			this->mapfile_);
 }
 
+// Return the number of threads to use for a pass of the link which
+// has WORK_ITEMS independent pieces of work, reading about
+// INPUT_SIZE bytes of input files, or -1 if that is not known yet.
+// This is used when the user does not give a thread count.  Threads
+// beyond the number of pieces of work or of CPUs we may run on only
+// add contention, and a small link is over before more threads could
+// help.
+
+static int
+default_thread_count(int work_items, off_t input_size)
+{
+  const off_t bytes_per_thread = 1024 * 1024;
+  int count = std::min(work_items,
+		       static_cast<int>(Thread_placement::cpu_count()));
+  if (input_size >= 0)
+    count = std::min(static_cast<off_t>(count),
+		     input_size / bytes_per_thread + 1);
+  return std::max(count, 1);
+}
+
+// Return the total size of the files holding the input objects.  An
+// archive is counted once, however many of its members are used.
+
+static off_t
+input_files_size(const Input_objects* input_objects)
+{
+  Unordered_set<const File_read*> files;
+  off_t size = 0;
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      if ((*p)->is_incremental())
+	continue;
+      const File_read* file = &(*p)->input_file()->file();
+      if (files.insert(file).second)
+	size += file->filesize();
+    }
+  for (Input_objects::Dynobj_iterator p = input_objects->dynobj_begin();
+       p != input_objects->dynobj_end();
+       ++p)
+    {
+      if ((*p)->is_incremental())
+	continue;
+      const File_read* file = &(*p)->input_file()->file();
+      if (files.insert(file).second)
+	size += file->filesize();
+    }
+  return size;
+}
+
 // Queue up the initial set of tasks for this link job.
 
 void
@@ -192,8 +245,8 @@ queue_initial_tasks(const General_options& options,
 
   int thread_count = options.thread_count_initial();
   if (thread_count == 0)
-    thread_count = cmdline.number_of_input_files();
-  workqueue->set_thread_count(thread_count);
+    thread_count = default_thread_count(cmdline.number_of_input_files(), -1);
+  workqueue->start_pass(0, thread_count);
 
   // For incremental links, the base output file.
   Incremental_binary* ibase = NULL;
@@ -203,7 +256,7 @@ queue_initial_tasks(const General_options& options,
       Output_file* of = new Output_file(options.output_file_name());
       if (of->open_base_file(options.incremental_base(), true))
 	{
-	  ibase = open_incremental_binary(of);
+	  ibase = open_incremental_binary(of, layout->incremental_inputs());
 	  if (ibase != NULL
 	      && ibase->check_inputs(cmdline, layout->incremental_inputs()))
 	    ibase->init_layout(layout);
@@ -577,6 +630,11 @@ queue_middle_tasks(const General_options& options,
 	(*p)->update_section_layout(layout->get_section_order_map());
     }
 
+  // Order the executable input sections using the call graph profile
+  // from --call-graph-ordering-file.
+  if (parameters->options().call_graph_ordering_file())
+    layout->order_sections_by_call_graph(task, symtab, input_objects);
+
   if (parameters->options().gc_sections()
       || parameters->options().icf_enabled())
     {
@@ -599,8 +657,10 @@ queue_middle_tasks(const General_options& options,
 
   int thread_count = options.thread_count_middle();
   if (thread_count == 0)
-    thread_count = std::max(2, input_objects->number_of_input_objects());
-  workqueue->set_thread_count(thread_count);
+    thread_count = std::max(2, default_thread_count(
+	input_objects->number_of_input_objects(),
+	input_files_size(input_objects)));
+  workqueue->start_pass(1, thread_count);
 
   // Now we have seen all the input files.
   const bool doing_static_link =
@@ -800,32 +860,40 @@ queue_final_tasks(const General_options& options,
 
   int thread_count = options.thread_count_final();
   if (thread_count == 0)
-    thread_count = std::max(2, input_objects->number_of_input_objects());
-  workqueue->set_thread_count(thread_count);
+    thread_count = std::max(2, default_thread_count(
+	input_objects->number_of_input_objects(),
+	input_files_size(input_objects)));
+  workqueue->start_pass(2, thread_count);
 
   bool any_postprocessing_sections = layout->any_postprocessing_sections();
 
+  // Split the output sections among Write_sections_tasks.
+  std::vector<Layout::Section_list> write_groups;
+  layout->group_output_sections_for_write(Parallel_work::thread_count(),
+					  &write_groups);
+  int write_sections_tasks = write_groups.size();
+
   // Use a blocker to wait until all the input sections have been
   // written out.
   Task_token* input_sections_blocker = NULL;
   if (!any_postprocessing_sections)
     {
       input_sections_blocker = new Task_token(true);
-      // Write_symbols_task, Relocate_tasks.
-      input_sections_blocker->add_blocker();
+      // Write_sections_tasks, Relocate_tasks.
+      input_sections_blocker->add_blockers(write_sections_tasks);
       input_sections_blocker->add_blockers(input_objects->number_of_relobjs());
     }
 
   // Use a blocker to block any objects which have to wait for the
   // output sections to complete before they can apply relocations.
   Task_token* output_sections_blocker = new Task_token(true);
-  output_sections_blocker->add_blocker();
+  output_sections_blocker->add_blockers(write_sections_tasks);
 
   // Use a blocker to block the final cleanup task.
   Task_token* final_blocker = new Task_token(true);
-  // Write_symbols_task, Write_sections_task, Write_data_task,
+  // Write_symbols_task, Write_sections_tasks, Write_data_task,
   // Relocate_tasks.
-  final_blocker->add_blockers(3);
+  final_blocker->add_blockers(2 + write_sections_tasks);
   final_blocker->add_blockers(input_objects->number_of_relobjs());
   if (!any_postprocessing_sections)
     final_blocker->add_blocker();
@@ -839,10 +907,12 @@ queue_final_tasks(const General_options& options,
 					  of,
 					  final_blocker));
 
-  // Queue a task to write out the output sections.
-  workqueue->queue(new Write_sections_task(layout, of, output_sections_blocker,
-					   input_sections_blocker,
-					   final_blocker));
+  // Queue tasks to write out the output sections.
+  for (int i = 0; i < write_sections_tasks; ++i)
+    workqueue->queue(new Write_sections_task(layout, of, write_groups[i],
+					     output_sections_blocker,
+					     input_sections_blocker,
+					     final_blocker));
 
   // Queue a task to write out everything else.
   workqueue->queue(new Write_data_task(layout, symtab, of, final_blocker));
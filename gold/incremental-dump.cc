@@ -471,7 +471,7 @@ main(int argc, char** argv)
       return 1;
     }
 
-  Incremental_binary* inc = open_incremental_binary(file);
+  Incremental_binary* inc = open_incremental_binary(file, NULL);
 
   if (inc == NULL)
     {
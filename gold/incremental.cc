@@ -37,6 +37,7 @@
 #include "target.h"
 #include "fileread.h"
 #include "script.h"
+#include "gold-threads.h"
 
 namespace gold {
 
@@ -133,25 +134,29 @@ class Output_section_incremental_inputs : public Output_section_data
 };
 
 // Inform the user why we don't do an incremental link.  Not called in
-// the obvious case of missing output file.  TODO: Is this helpful?
+// the obvious case of missing output file.  If INPUTS is not NULL,
+// record the reason there for --stats.  TODO: Is this helpful?
 
 void
-vexplain_no_incremental(const char* format, va_list args)
+vexplain_no_incremental(Incremental_inputs* inputs, const char* format,
+			va_list args)
 {
   char* buf = NULL;
   if (vasprintf(&buf, format, args) < 0)
     gold_nomem();
   gold_info(_("the link might take longer: "
 	      "cannot perform incremental link: %s"), buf);
+  if (inputs != NULL)
+    inputs->set_full_link_reason(buf);
   free(buf);
 }
 
 void
-explain_no_incremental(const char* format, ...)
+explain_no_incremental(Incremental_inputs* inputs, const char* format, ...)
 {
   va_list args;
   va_start(args, format);
-  vexplain_no_incremental(format, args);
+  vexplain_no_incremental(inputs, format, args);
   va_end(args);
 }
 
@@ -167,10 +172,40 @@ Incremental_binary::error(const char* format, ...) const
   // full build.
   // TODO: when we implement incremental editing of the file, we may need a
   // flag that will cause errors to be treated seriously.
-  vexplain_no_incremental(format, args);
+  vexplain_no_incremental(this->inputs_, format, args);
   va_end(args);
 }
 
+// Print statistics about incremental linking.
+
+void
+Incremental_binary::print_stats(const Incremental_inputs* inputs)
+{
+  if (!parameters->incremental())
+    return;
+
+  if (parameters->incremental_update())
+    {
+      gold_assert(inputs != NULL);
+      fprintf(stderr, _("%s: incremental relocations applied: %u\n"),
+	      program_name, inputs->applied_reloc_count());
+      fprintf(stderr, _("%s: incremental relocation pieces: %u\n"),
+	      program_name, inputs->applied_reloc_pieces());
+      return;
+    }
+
+  const char* reason;
+  if (inputs != NULL && !inputs->full_link_reason().empty())
+    reason = inputs->full_link_reason().c_str();
+  else if (parameters->options().incremental_mode()
+	   == General_options::INCREMENTAL_FULL)
+    reason = _("--incremental-full was given");
+  else
+    reason = _("no output file from a previous link");
+  fprintf(stderr, _("%s: full incremental link: %s\n"),
+	  program_name, reason);
+}
+
 // Return TRUE if a section of type SH_TYPE can be updated in place
 // during an incremental update.  We can update sections of type PROGBITS,
 // NOBITS, INIT_ARRAY, FINI_ARRAY, PREINIT_ARRAY, and NOTE.  All others
@@ -407,13 +442,15 @@ Sized_incremental_binary<size, big_endian>::do_check_inputs(
 
   if (!this->has_incremental_info_)
     {
-      explain_no_incremental(_("no incremental data from previous build"));
+      explain_no_incremental(incremental_inputs,
+			     _("no incremental data from previous build"));
       return false;
     }
 
   if (inputs.version() != INCREMENTAL_LINK_VERSION)
     {
-      explain_no_incremental(_("different version of incremental build data"));
+      explain_no_incremental(incremental_inputs,
+			     _("different version of incremental build data"));
       return false;
     }
 
@@ -425,7 +462,7 @@ Sized_incremental_binary<size, big_endian>::do_check_inputs(
       gold_debug(DEBUG_INCREMENTAL,
 		 "new command line: %s",
 		 incremental_inputs->command_line().c_str());
-      explain_no_incremental(_("command line changed"));
+      explain_no_incremental(incremental_inputs, _("command line changed"));
       return false;
     }
 
@@ -452,7 +489,8 @@ Sized_incremental_binary<size, big_endian>::do_check_inputs(
 	case INCREMENTAL_INPUT_SCRIPT:
 	  if (this->do_file_has_changed(i))
 	    {
-	      explain_no_incremental(_("%s: script file changed"),
+	      explain_no_incremental(incremental_inputs,
+				     _("%s: script file changed"),
 				     input_file.filename());
 	      return false;
 	    }
@@ -725,7 +763,58 @@ Sized_incremental_binary<size, big_endian>::do_emit_copy_relocs(
     }
 }
 
+// A Parallel_work which applies the incremental relocations for a
+// range of global symbols in each piece.  The relocations for
+// different symbols never patch the same place in the output file, so
+// the pieces are independent.
+
+template<int size, bool big_endian>
+class Apply_incremental_relocs_work : public Parallel_work
+{
+ public:
+  Apply_incremental_relocs_work(
+      Sized_incremental_binary<size, big_endian>* ibase,
+      const Relocate_info<size, big_endian>* relinfo,
+      Output_file* of, unsigned int nglobals, unsigned int piece_count)
+    : ibase_(ibase), relinfo_(relinfo), of_(of), nglobals_(nglobals),
+      piece_count_(piece_count), counts_(piece_count)
+  { }
+
+  // Return the total number of relocations applied.
+  unsigned int
+  reloc_count() const
+  {
+    unsigned int ret = 0;
+    for (unsigned int i = 0; i < this->piece_count_; ++i)
+      ret += this->counts_[i];
+    return ret;
+  }
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    uint64_t n = this->nglobals_;
+    unsigned int first = n * piece / this->piece_count_;
+    unsigned int last = n * (piece + 1) / this->piece_count_;
+    this->counts_[piece] = this->ibase_->apply_global_relocs(this->relinfo_,
+							     this->of_,
+							     first, last);
+  }
+
+ private:
+  Sized_incremental_binary<size, big_endian>* ibase_;
+  const Relocate_info<size, big_endian>* relinfo_;
+  Output_file* of_;
+  unsigned int nglobals_;
+  unsigned int piece_count_;
+  // The number of relocations applied by each piece.
+  std::vector<unsigned int> counts_;
+};
+
 // Apply incremental relocations for symbols whose values have changed.
+// When using threads, we split the global symbols into pieces and
+// patch each piece on a separate thread.
 
 template<int size, bool big_endian>
 void
@@ -734,12 +823,8 @@ Sized_incremental_binary<size, big_endian>::do_apply_incremental_relocs(
     Layout* layout,
     Output_file* of)
 {
-  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
-  typedef typename elfcpp::Elf_types<size>::Elf_Swxword Addend;
   Incremental_symtab_reader<big_endian> isymtab(this->symtab_reader());
-  Incremental_relocs_reader<size, big_endian> irelocs(this->relocs_reader());
   unsigned int nglobals = isymtab.symbol_count();
-  const unsigned int incr_reloc_size = irelocs.reloc_size;
 
   Relocate_info<size, big_endian> relinfo;
   relinfo.symtab = symtab;
@@ -750,10 +835,50 @@ Sized_incremental_binary<size, big_endian>::do_apply_incremental_relocs(
   relinfo.data_shndx = 0;
   relinfo.data_shdr = NULL;
 
+  // Don't bother with threads for a few symbols.
+  const unsigned int min_piece_size = 1024;
+  unsigned int pieces = Parallel_work::thread_count();
+  if (pieces > 1)
+    pieces *= 4;
+  if (pieces > nglobals / min_piece_size)
+    pieces = nglobals / min_piece_size;
+  Incremental_inputs* inputs = layout->incremental_inputs();
+  if (pieces <= 1)
+    {
+      inputs->add_applied_relocs(this->apply_global_relocs(&relinfo, of, 0,
+							   nglobals),
+				 1);
+      return;
+    }
+
+  Apply_incremental_relocs_work<size, big_endian> work(this, &relinfo, of,
+						       nglobals, pieces);
+  work.run(pieces);
+  inputs->add_applied_relocs(work.reloc_count(), pieces);
+}
+
+// Apply the incremental relocations for the global symbols with
+// indexes FIRST through LAST - 1.
+
+template<int size, bool big_endian>
+unsigned int
+Sized_incremental_binary<size, big_endian>::apply_global_relocs(
+    const Relocate_info<size, big_endian>* relinfo,
+    Output_file* of,
+    unsigned int first,
+    unsigned int last)
+{
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+  typedef typename elfcpp::Elf_types<size>::Elf_Swxword Addend;
+  Incremental_symtab_reader<big_endian> isymtab(this->symtab_reader());
+  Incremental_relocs_reader<size, big_endian> irelocs(this->relocs_reader());
+  const unsigned int incr_reloc_size = irelocs.reloc_size;
+
   Sized_target<size, big_endian>* target =
       parameters->sized_target<size, big_endian>();
 
-  for (unsigned int i = 0; i < nglobals; i++)
+  unsigned int count = 0;
+  for (unsigned int i = first; i < last; i++)
     {
       const Symbol* gsym = this->global_symbol(i);
 
@@ -809,16 +934,18 @@ Sized_incremental_binary<size, big_endian>::do_apply_incremental_relocs(
 			 r_type,
 			 (long)r_addend);
 
-	      target->apply_relocation(&relinfo, r_offset, r_type, r_addend,
+	      target->apply_relocation(relinfo, r_offset, r_type, r_addend,
 				       gsym, view, address, view_size);
 
 	      // FIXME: Do something more efficient if write_output_view
 	      // ever becomes more than a no-op.
 	      of->write_output_view(section_offset, view_size, view);
+	      ++count;
 	    }
 	  offset = sym_info.next_offset();
 	}
     }
+  return count;
 }
 
 // Get a view of the main symbol table and the symbol string table.
@@ -847,7 +974,8 @@ namespace
 template<int size, bool big_endian>
 Incremental_binary*
 make_sized_incremental_binary(Output_file* file,
-			      const elfcpp::Ehdr<size, big_endian>& ehdr)
+			      const elfcpp::Ehdr<size, big_endian>& ehdr,
+			      Incremental_inputs* inputs)
 {
   Target* target = select_target(NULL, 0, // XXX
 				 ehdr.get_e_machine(), size, big_endian,
@@ -855,7 +983,7 @@ make_sized_incremental_binary(Output_file* file,
 				 ehdr.get_e_ident()[elfcpp::EI_ABIVERSION]);
   if (target == NULL)
     {
-      explain_no_incremental(_("unsupported ELF machine number %d"),
+      explain_no_incremental(inputs, _("unsupported ELF machine number %d"),
 	       ehdr.get_e_machine());
       return NULL;
     }
@@ -865,17 +993,18 @@ make_sized_incremental_binary(Output_file* file,
   else if (target != &parameters->target())
     gold_error(_("%s: incompatible target"), file->filename());
 
-  return new Sized_incremental_binary<size, big_endian>(file, ehdr, target);
+  return new Sized_incremental_binary<size, big_endian>(file, ehdr, target,
+							 inputs);
 }
 
 }  // End of anonymous namespace.
 
 // Create an Incremental_binary object for FILE.  Returns NULL is this is not
 // possible, e.g. FILE is not an ELF file or has an unsupported target.  FILE
-// should be opened.
+// should be opened.  If INPUTS is not NULL, the reason is recorded there.
 
 Incremental_binary*
-open_incremental_binary(Output_file* file)
+open_incremental_binary(Output_file* file, Incremental_inputs* inputs)
 {
   off_t filesize = file->filesize();
   int want = elfcpp::Elf_recognizer::max_header_size;
@@ -885,7 +1014,7 @@ open_incremental_binary(Output_file* file)
   const unsigned char* p = file->get_input_view(0, want);
   if (!elfcpp::Elf_recognizer::is_elf_file(p, want))
     {
-      explain_no_incremental(_("output is not an ELF file."));
+      explain_no_incremental(inputs, _("output is not an ELF file."));
       return NULL;
     }
 
@@ -895,7 +1024,7 @@ open_incremental_binary(Output_file* file)
   if (!elfcpp::Elf_recognizer::is_valid_header(p, want, &size, &big_endian,
 					       &error))
     {
-      explain_no_incremental(error.c_str());
+      explain_no_incremental(inputs, error.c_str());
       return NULL;
     }
 
@@ -906,18 +1035,20 @@ open_incremental_binary(Output_file* file)
 	{
 #ifdef HAVE_TARGET_32_BIG
 	  result = make_sized_incremental_binary<32, true>(
-	      file, elfcpp::Ehdr<32, true>(p));
+	      file, elfcpp::Ehdr<32, true>(p), inputs);
 #else
-	  explain_no_incremental(_("unsupported file: 32-bit, big-endian"));
+	  explain_no_incremental(inputs,
+				 _("unsupported file: 32-bit, big-endian"));
 #endif
 	}
       else
 	{
 #ifdef HAVE_TARGET_32_LITTLE
 	  result = make_sized_incremental_binary<32, false>(
-	      file, elfcpp::Ehdr<32, false>(p));
+	      file, elfcpp::Ehdr<32, false>(p), inputs);
 #else
-	  explain_no_incremental(_("unsupported file: 32-bit, little-endian"));
+	  explain_no_incremental(inputs,
+				 _("unsupported file: 32-bit, little-endian"));
 #endif
 	}
     }
@@ -927,18 +1058,20 @@ open_incremental_binary(Output_file* file)
 	{
 #ifdef HAVE_TARGET_64_BIG
 	  result = make_sized_incremental_binary<64, true>(
-	      file, elfcpp::Ehdr<64, true>(p));
+	      file, elfcpp::Ehdr<64, true>(p), inputs);
 #else
-	  explain_no_incremental(_("unsupported file: 64-bit, big-endian"));
+	  explain_no_incremental(inputs,
+				 _("unsupported file: 64-bit, big-endian"));
 #endif
 	}
       else
 	{
 #ifdef HAVE_TARGET_64_LITTLE
 	  result = make_sized_incremental_binary<64, false>(
-	      file, elfcpp::Ehdr<64, false>(p));
+	      file, elfcpp::Ehdr<64, false>(p), inputs);
 #else
-	  explain_no_incremental(_("unsupported file: 64-bit, little-endian"));
+	  explain_no_incremental(inputs,
+				 _("unsupported file: 64-bit, little-endian"));
 #endif
 	}
     }
@@ -88,9 +88,10 @@ can_incremental_update(unsigned int sh_type);
 
 // Create an Incremental_binary object for FILE. Returns NULL is this is not
 // possible, e.g. FILE is not an ELF file or has an unsupported target.
+// If INPUTS is not NULL, the reason is recorded there.
 
 Incremental_binary*
-open_incremental_binary(Output_file* file);
+open_incremental_binary(Output_file* file, Incremental_inputs* inputs);
 
 // Base class for recording each input file.
 
@@ -563,7 +564,8 @@ class Incremental_inputs
       strtab_(new Stringpool()), current_object_(NULL),
       current_object_entry_(NULL), inputs_section_(NULL),
       symtab_section_(NULL), relocs_section_(NULL),
-      reloc_count_(0)
+      reloc_count_(0), full_link_reason_(), applied_reloc_count_(0),
+      applied_reloc_pieces_(0)
   { }
 
   ~Incremental_inputs() { delete this->strtab_; }
@@ -611,6 +613,42 @@ class Incremental_inputs
   set_reloc_count(unsigned int count)
   { this->reloc_count_ = count; }
 
+  // Record why we could not do an incremental update.  Only the first
+  // reason is kept.
+  void
+  set_full_link_reason(const char* reason)
+  {
+    if (this->full_link_reason_.empty())
+      this->full_link_reason_ = reason;
+  }
+
+  // Return why we could not do an incremental update, or an empty
+  // string.
+  const std::string&
+  full_link_reason() const
+  { return this->full_link_reason_; }
+
+  // Record that COUNT relocations were applied again in PIECES pieces
+  // during an incremental update.
+  void
+  add_applied_relocs(unsigned int count, unsigned int pieces)
+  {
+    this->applied_reloc_count_ += count;
+    this->applied_reloc_pieces_ += pieces;
+  }
+
+  // Return the number of relocations applied again during an
+  // incremental update, for --stats.
+  unsigned int
+  applied_reloc_count() const
+  { return this->applied_reloc_count_; }
+
+  // Return the number of pieces the applied relocations were split
+  // into, for --stats.
+  unsigned int
+  applied_reloc_pieces() const
+  { return this->applied_reloc_pieces_; }
+
   // Prepare for layout.  Called from Layout::finalize.
   void
   finalize();
@@ -703,6 +741,16 @@ class Incremental_inputs
   // Total count of incremental relocations.  Updated during Scan_relocs
   // phase at the completion of each object file.
   unsigned int reloc_count_;
+
+  // Why we could not do an incremental update, for --stats.
+  std::string full_link_reason_;
+
+  // The number of relocations applied again during an incremental
+  // update, for --stats.
+  unsigned int applied_reloc_count_;
+
+  // The number of pieces the applied relocations were split into.
+  unsigned int applied_reloc_pieces_;
 };
 
 // Reader class for global symbol info from an object file entry in
@@ -1340,9 +1388,10 @@ class Incremental_got_plt_reader
 class Incremental_binary
 {
  public:
-  Incremental_binary(Output_file* output, Target* /*target*/)
+  Incremental_binary(Output_file* output, Target* /*target*/,
+		     Incremental_inputs* inputs)
     : input_args_map_(), library_map_(), script_map_(),
-      output_(output)
+      output_(output), inputs_(inputs)
   { }
 
   virtual
@@ -1356,7 +1405,8 @@ class Incremental_binary
 	       Incremental_inputs* incremental_inputs)
   { return this->do_check_inputs(cmdline, incremental_inputs); }
 
-  // Report an error.
+  // Report an error.  This only explains why we can not do an
+  // incremental update.
   void
   error(const char* format, ...) const ATTRIBUTE_PRINTF_2;
 
@@ -1532,6 +1582,11 @@ class Incremental_binary
   output_file()
   { return this->output_; }
 
+  // Print statistics about incremental linking.  INPUTS is the
+  // incremental state of the link, or NULL.
+  static void
+  print_stats(const Incremental_inputs* inputs);
+
  protected:
   // Check the .gnu_incremental_inputs section to see whether an incremental
   // build is possible.
@@ -1580,6 +1635,9 @@ class Incremental_binary
  private:
   // Edited output file object.
   Output_file* output_;
+  // The incremental state of the current link, which records why we
+  // can not do an incremental update.  This may be NULL.
+  Incremental_inputs* inputs_;
 };
 
 template<int size, bool big_endian>
@@ -1591,8 +1649,8 @@ class Sized_incremental_binary : public Incremental_binary
  public:
   Sized_incremental_binary(Output_file* output,
                            const elfcpp::Ehdr<size, big_endian>& ehdr,
-                           Target* target)
-    : Incremental_binary(output, target), elf_file_(this, ehdr),
+                           Target* target, Incremental_inputs* inputs)
+    : Incremental_binary(output, target, inputs), elf_file_(this, ehdr),
       input_objects_(), section_map_(), symbol_map_(), copy_relocs_(),
       main_symtab_loc_(), main_strtab_loc_(), has_incremental_info_(false),
       inputs_reader_(), symtab_reader_(), relocs_reader_(), got_plt_reader_(),
@@ -1664,6 +1722,13 @@ class Sized_incremental_binary : public Incremental_binary
   get_symtab_view(View* symtab_view, unsigned int* sym_count,
 		  elfcpp::Elf_strtab* strtab);
 
+  // Apply the incremental relocations for the global symbols with
+  // indexes FIRST through LAST - 1.  Return the number of relocations
+  // applied.  This may be called on several threads at once.
+  unsigned int
+  apply_global_relocs(const Relocate_info<size, big_endian>* relinfo,
+		      Output_file* of, unsigned int first, unsigned int last);
+
  protected:
   typedef Incremental_inputs_reader<size, big_endian> Inputs_reader;
   typedef typename Inputs_reader::Incremental_input_entry_reader
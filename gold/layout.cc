@@ -56,6 +56,7 @@
 #include "descriptors.h"
 #include "plugin.h"
 #include "incremental.h"
+#include "call-graph.h"
 #include "layout.h"
 
 namespace gold
@@ -75,6 +76,8 @@ unsigned int Free_list::num_remove_visits = 0;
 unsigned int Free_list::num_allocates = 0;
 // The total number of nodes visited during calls to Free_list::allocate.
 unsigned int Free_list::num_allocate_visits = 0;
+// The total number of calls to Free_list::allocate which failed.
+unsigned int Free_list::num_allocate_failures = 0;
 
 // Initialize the free list.  Creates a single free list node that
 // describes the entire region of length LEN.  If EXTEND is true,
@@ -86,20 +89,97 @@ Free_list::init(off_t len, bool extend)
 {
   this->list_.push_front(Free_list_node(0, len));
   this->last_remove_ = this->list_.begin();
+  this->add_to_size_class(this->list_.begin());
   this->extend_ = extend;
   this->length_ = len;
   ++Free_list::num_lists;
   ++Free_list::num_nodes;
 }
 
+// Return the size class for a chunk of length LEN: the position of
+// the highest bit set in LEN.
+
+unsigned int
+Free_list::size_class(off_t len)
+{
+  gold_assert(len > 0);
+  unsigned int ret = 0;
+  while (len > 1)
+    {
+      len >>= 1;
+      ++ret;
+    }
+  return ret;
+}
+
+// Add node P to its size class.
+
+void
+Free_list::add_to_size_class(Iterator p)
+{
+  if (p->end_ <= p->start_)
+    return;
+  unsigned int c = Free_list::size_class(p->end_ - p->start_);
+  if (c >= this->size_classes_.size())
+    this->size_classes_.resize(c + 1);
+  this->size_classes_[c][p->start_] = p;
+}
+
+// Remove node P from its size class.
+
+void
+Free_list::remove_from_size_class(Iterator p)
+{
+  if (p->end_ <= p->start_)
+    return;
+  unsigned int c = Free_list::size_class(p->end_ - p->start_);
+  gold_assert(c < this->size_classes_.size());
+  this->size_classes_[c].erase(p->start_);
+}
+
+// Take the chunk from START to END out of node P, which must contain
+// it.  To avoid creating tiny free chunks, we give away up to FUZZ
+// extra bytes on either side.  Returns the node following the chunk.
+
+Free_list::Iterator
+Free_list::take(Iterator p, off_t start, off_t end, int fuzz)
+{
+  this->remove_from_size_class(p);
+
+  // Case 1: the chunk spans the whole node.
+  if (p->start_ + fuzz >= start && p->end_ <= end + fuzz)
+    {
+      Iterator next = this->list_.erase(p);
+      if (this->last_remove_ == p)
+	this->last_remove_ = next;
+      return next;
+    }
+
+  // Case 2: take a chunk from the start of the node.
+  if (p->start_ + fuzz >= start)
+    p->start_ = end;
+  // Case 3: take a chunk from the end of the node.
+  else if (p->end_ <= end + fuzz)
+    p->end_ = start;
+  // Case 4: take a chunk from the middle, and split the node into
+  // two.
+  else
+    {
+      Free_list_node newnode(p->start_, start);
+      p->start_ = end;
+      this->add_to_size_class(this->list_.insert(p, newnode));
+      ++Free_list::num_nodes;
+    }
+  this->add_to_size_class(p);
+  return p;
+}
+
 // Remove a chunk from the free list.  Because we start with a single
 // node that covers the entire section, and remove chunks from it one
 // at a time, we do not need to coalesce chunks or handle cases that
 // span more than one free node.  We expect to remove chunks from the
-// free list in order, and we expect to have only a few chunks of free
-// space left (corresponding to files that have changed since the last
-// incremental link), so a simple linear list should provide sufficient
-// performance.
+// free list in order, so we start looking at the node where the last
+// removal left off.
 
 void
 Free_list::remove(off_t start, off_t end)
@@ -111,7 +191,7 @@ Free_list::remove(off_t start, off_t end)
   ++Free_list::num_removes;
 
   Iterator p = this->last_remove_;
-  if (p->start_ > start)
+  if (p == this->list_.end() || p->start_ > start)
     p = this->list_.begin();
 
   for (; p != this->list_.end(); ++p)
@@ -120,26 +200,7 @@ Free_list::remove(off_t start, off_t end)
       // Find a node that wholly contains the indicated region.
       if (p->start_ <= start && p->end_ >= end)
 	{
-	  // Case 1: the indicated region spans the whole node.
-	  // Add some fuzz to avoid creating tiny free chunks.
-	  if (p->start_ + 3 >= start && p->end_ <= end + 3)
-	    p = this->list_.erase(p);
-	  // Case 2: remove a chunk from the start of the node.
-	  else if (p->start_ + 3 >= start)
-	    p->start_ = end;
-	  // Case 3: remove a chunk from the end of the node.
-	  else if (p->end_ <= end + 3)
-	    p->end_ = start;
-	  // Case 4: remove a chunk from the middle, and split
-	  // the node into two.
-	  else
-	    {
-	      Free_list_node newnode(p->start_, start);
-	      p->start_ = end;
-	      this->list_.insert(p, newnode);
-	      ++Free_list::num_nodes;
-	    }
-	  this->last_remove_ = p;
+	  this->last_remove_ = this->take(p, start, end, 3);
 	  return;
 	}
     }
@@ -152,8 +213,11 @@ Free_list::remove(off_t start, off_t end)
 }
 
 // Allocate a chunk of size LEN from the free list.  Returns -1ULL
-// if a sufficiently large chunk of free space is not found.
-// We use a simple first-fit algorithm.
+// if a sufficiently large chunk of free space is not found.  Unless
+// we were asked to use first fit, we look through the size classes
+// starting with the smallest one which may hold LEN bytes, and within
+// a size class we use the chunk with the lowest address which fits.
+// Only when no free chunk fits do we extend the region.
 
 off_t
 Free_list::allocate(off_t len, uint64_t align, off_t minoff)
@@ -172,41 +236,74 @@ Free_list::allocate(off_t len, uint64_t align, off_t minoff)
   // to keep track of all free chunks.
   const int fuzz = this->min_hole_ > 0 ? 0 : 3;
 
-  for (Iterator p = this->list_.begin(); p != this->list_.end(); ++p)
+  if (this->first_fit_)
     {
-      ++Free_list::num_allocate_visits;
-      off_t start = p->start_ > minoff ? p->start_ : minoff;
-      start = align_address(start, align);
-      off_t end = start + len;
-      if (end > p->end_ && p->end_ == this->length_ && this->extend_)
+      for (Iterator p = this->list_.begin(); p != this->list_.end(); ++p)
 	{
-	  this->length_ = end;
-	  p->end_ = end;
+	  ++Free_list::num_allocate_visits;
+	  off_t start = p->start_ > minoff ? p->start_ : minoff;
+	  start = align_address(start, align);
+	  off_t end = start + len;
+	  if (end == p->end_ || (end <= p->end_ - this->min_hole_))
+	    {
+	      this->take(p, start, end, fuzz);
+	      return start;
+	    }
 	}
-      if (end == p->end_ || (end <= p->end_ - this->min_hole_))
+    }
+  else
+    {
+      for (unsigned int c = Free_list::size_class(len);
+	   c < this->size_classes_.size();
+	   ++c)
 	{
-	  if (p->start_ + fuzz >= start && p->end_ <= end + fuzz)
-	    this->list_.erase(p);
-	  else if (p->start_ + fuzz >= start)
-	    p->start_ = end;
-	  else if (p->end_ <= end + fuzz)
-	    p->end_ = start;
-	  else
+	  const Size_class& nodes(this->size_classes_[c]);
+	  for (Size_class::const_iterator q = nodes.begin();
+	       q != nodes.end();
+	       ++q)
 	    {
-	      Free_list_node newnode(p->start_, start);
-	      p->start_ = end;
-	      this->list_.insert(p, newnode);
-	      ++Free_list::num_nodes;
+	      ++Free_list::num_allocate_visits;
+	      Iterator p = q->second;
+	      off_t start = p->start_ > minoff ? p->start_ : minoff;
+	      start = align_address(start, align);
+	      off_t end = start + len;
+	      if (end == p->end_ || (end <= p->end_ - this->min_hole_))
+		{
+		  this->take(p, start, end, fuzz);
+		  return start;
+		}
 	    }
-	  return start;
 	}
     }
+
   if (this->extend_)
     {
+      // If the last free chunk runs to the end of the region, grow
+      // it and allocate from it.
+      if (!this->list_.empty() && this->list_.back().end_ == this->length_)
+	{
+	  Iterator p = this->list_.end();
+	  --p;
+	  off_t start = p->start_ > minoff ? p->start_ : minoff;
+	  start = align_address(start, align);
+	  off_t end = start + len;
+	  if (end > p->end_)
+	    {
+	      this->remove_from_size_class(p);
+	      this->length_ = end;
+	      p->end_ = end;
+	      this->add_to_size_class(p);
+	    }
+	  this->take(p, start, end, fuzz);
+	  return start;
+	}
+
       off_t start = align_address(this->length_, align);
       this->length_ = start + len;
       return start;
     }
+
+  ++Free_list::num_allocate_failures;
   return -1;
 }
 
@@ -237,6 +334,8 @@ Free_list::print_stats()
 	  program_name, Free_list::num_allocates);
   fprintf(stderr, _("%s: nodes visited: %u\n"),
 	  program_name, Free_list::num_allocate_visits);
+  fprintf(stderr, _("%s: failed calls to Free_list::allocate: %u\n"),
+	  program_name, Free_list::num_allocate_failures);
 }
 
 // A Hash_task computes the MD5 checksum of an array of char.
@@ -382,6 +481,7 @@ Layout_task_runner::run(Workqueue* workqueue, const Task* task)
 
   if (this->mapfile_ != NULL)
     {
+      this->mapfile_->collect_input_sections(this->input_objects_);
       this->mapfile_->print_discarded_sections(this->input_objects_);
       layout->print_to_mapfile(this->mapfile_);
     }
@@ -424,7 +524,6 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     namepool_(),
     sympool_(),
     dynpool_(),
-    signatures_(),
     section_name_map_(),
     segment_list_(),
     section_list_(),
@@ -460,7 +559,6 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     input_without_gnu_stack_note_(false),
     has_static_tls_(false),
     any_postprocessing_sections_(false),
-    resized_signatures_(false),
     have_stabstr_section_(false),
     section_ordering_specified_(false),
     unique_segment_for_sections_specified_(false),
@@ -473,6 +571,7 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     section_segment_map_(),
     input_section_position_(),
     input_section_glob_(),
+    call_graph_ordering_(NULL),
     incremental_base_(NULL),
     free_list_()
 {
@@ -493,6 +592,13 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
   this->namepool_.set_optimize();
 }
 
+Layout::~Layout()
+{
+  delete this->relaxation_debug_check_;
+  delete this->segment_states_;
+  delete this->call_graph_ordering_;
+}
+
 // For incremental links, record the base file to be modified.
 
 void
@@ -500,6 +606,7 @@ Layout::set_incremental_base(Incremental_binary* base)
 {
   this->incremental_base_ = base;
   this->free_list_.init(base->output_file()->filesize(), true);
+  this->free_list_.set_first_fit();
 }
 
 // Hash a key we use to look up an output section mapping.
@@ -2660,6 +2767,56 @@ Layout::read_layout_from_file()
     }
 }
 
+// Read the call graph profile from the file specified with option
+// --call-graph-ordering-file.  We have to know that we will reorder
+// the sections before we start adding input sections to output
+// sections.
+
+void
+Layout::read_call_graph_from_file()
+{
+  this->call_graph_ordering_ = new Call_graph_ordering();
+  this->call_graph_ordering_->read_profile(
+      parameters->options().call_graph_ordering_file());
+  this->set_section_ordering_specified();
+}
+
+// Order the executable input sections using the call graph profile.
+// The sections named in the profile are given the order computed
+// from the call graph.  The other input sections in the same output
+// sections follow them, in their original order.
+
+void
+Layout::order_sections_by_call_graph(const Task* task, Symbol_table* symtab,
+				     const Input_objects* input_objects)
+{
+  gold_assert(this->call_graph_ordering_ != NULL);
+
+  if (!this->section_order_map_.empty())
+    {
+      gold_warning(_("ignoring --call-graph-ordering-file because a plugin "
+		     "specified a section order"));
+      return;
+    }
+
+  unsigned int count =
+    this->call_graph_ordering_->compute_order(task, symtab, input_objects,
+					      &this->section_order_map_);
+  if (count == 0)
+    return;
+
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    {
+      if (((*p)->flags() & elfcpp::SHF_EXECINSTR) == 0)
+	continue;
+      (*p)->update_section_layout(&this->section_order_map_);
+      if ((*p)->input_section_order_specified())
+	(*p)->order_remaining_input_sections(count + 1);
+    }
+}
+
 // Finalize the layout.  When this is called, we have created all the
 // output sections and all the output segments which are based on
 // input sections.  We have several things to do, and we have to do
@@ -3968,6 +4125,52 @@ Layout::place_orphan_sections_in_script()
     }
 }
 
+// Count the local symbols of some objects on several threads.  Each
+// object adds the names of its symbols to string pools of its own,
+// which are combined in order by Layout::count_local_symbols.  Piece
+// I handles the objects listed in (*PIECES)[I].  The objects in an
+// archive share a file, which only one thread may lock at a time, so
+// they are always in the same piece.
+
+class Local_symbol_counter : public Parallel_work
+{
+ public:
+  Local_symbol_counter(const Task* task, const std::vector<Relobj*>* relobjs,
+		       const std::vector<std::vector<unsigned int> >* pieces,
+		       std::vector<Stringpool*>* pools,
+		       std::vector<Stringpool*>* dynpools)
+    : task_(task), relobjs_(relobjs), pieces_(pieces), pools_(pools),
+      dynpools_(dynpools)
+  { }
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    const std::vector<unsigned int>& objects((*this->pieces_)[piece]);
+    for (size_t i = 0; i < objects.size(); ++i)
+      {
+	unsigned int j = objects[i];
+	Relobj* relobj = (*this->relobjs_)[j];
+	Stringpool* pool = new Stringpool();
+	Stringpool* dynpool = new Stringpool();
+	{
+	  Task_lock_obj<Object> tlo(this->task_, relobj);
+	  relobj->count_local_symbols(pool, dynpool);
+	}
+	(*this->pools_)[j] = pool;
+	(*this->dynpools_)[j] = dynpool;
+      }
+  }
+
+ private:
+  const Task* task_;
+  const std::vector<Relobj*>* relobjs_;
+  const std::vector<std::vector<unsigned int> >* pieces_;
+  std::vector<Stringpool*>* pools_;
+  std::vector<Stringpool*>* dynpools_;
+};
+
 // Count the local symbols in the regular symbol table and the dynamic
 // symbol table, and build the respective string pools.
 
@@ -3994,15 +4197,162 @@ Layout::count_local_symbols(const Task* task,
   this->sympool_.reserve(symbol_count);
   this->dynpool_.reserve(symbol_count);
 
-  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
-       p != input_objects->relobj_end();
-       ++p)
+  if (Parallel_work::thread_count() <= 1
+      || input_objects->number_of_relobjs() < 2)
     {
-      Task_lock_obj<Object> tlo(task, *p);
-      (*p)->count_local_symbols(&this->sympool_, &this->dynpool_);
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	{
+	  Task_lock_obj<Object> tlo(task, *p);
+	  (*p)->count_local_symbols(&this->sympool_, &this->dynpool_);
+	}
+      return;
+    }
+
+  // With --threads, count the symbols of each object separately, and
+  // then add the names to the string pools in the order of the
+  // objects, so that the string tables do not depend on the number
+  // of threads.  An incremental object keeps pointers to the names in
+  // the pool, so we count those in the final pass.
+  std::vector<Relobj*> relobjs(input_objects->relobj_begin(),
+			       input_objects->relobj_end());
+  std::vector<std::vector<unsigned int> > pieces;
+  Unordered_map<const File_read*, unsigned int> file_pieces;
+  for (unsigned int i = 0; i < relobjs.size(); ++i)
+    {
+      if (relobjs[i]->is_incremental())
+	continue;
+      const File_read* file = &relobjs[i]->input_file()->file();
+      std::pair<Unordered_map<const File_read*, unsigned int>::iterator,
+		bool> ins =
+	file_pieces.insert(std::make_pair(file, pieces.size()));
+      if (ins.second)
+	pieces.push_back(std::vector<unsigned int>());
+      pieces[ins.first->second].push_back(i);
+    }
+
+  std::vector<Stringpool*> pools(relobjs.size(), NULL);
+  std::vector<Stringpool*> dynpools(relobjs.size(), NULL);
+  Local_symbol_counter counter(task, &relobjs, &pieces, &pools, &dynpools);
+  counter.run(pieces.size());
+
+  for (unsigned int i = 0; i < relobjs.size(); ++i)
+    {
+      if (pools[i] == NULL)
+	{
+	  Task_lock_obj<Object> tlo(task, relobjs[i]);
+	  relobjs[i]->count_local_symbols(&this->sympool_, &this->dynpool_);
+	  continue;
+	}
+      this->sympool_.add_pool(*pools[i]);
+      this->dynpool_.add_pool(*dynpools[i]);
+      delete pools[i];
+      delete dynpools[i];
     }
 }
 
+// Finalize the local symbols of some objects on several threads.
+// Piece I handles object I, whose first symbol has index
+// (*INDEXES)[I] at offset (*OFFSETS)[I], and stores the index after
+// its last symbol in (*NEXT_INDEXES)[I].
+
+class Local_symbol_finalizer : public Parallel_work
+{
+ public:
+  Local_symbol_finalizer(const std::vector<Relobj*>* relobjs,
+			 const std::vector<unsigned int>* indexes,
+			 const std::vector<off_t>* offsets,
+			 Symbol_table* symtab,
+			 std::vector<unsigned int>* next_indexes)
+    : relobjs_(relobjs), indexes_(indexes), offsets_(offsets),
+      symtab_(symtab), next_indexes_(next_indexes)
+  { }
+
+ protected:
+  void
+  do_run_piece(unsigned int i)
+  {
+    (*this->next_indexes_)[i] =
+      (*this->relobjs_)[i]->finalize_local_symbols((*this->indexes_)[i],
+						   (*this->offsets_)[i],
+						   this->symtab_);
+  }
+
+ private:
+  const std::vector<Relobj*>* relobjs_;
+  const std::vector<unsigned int>* indexes_;
+  const std::vector<off_t>* offsets_;
+  Symbol_table* symtab_;
+  std::vector<unsigned int>* next_indexes_;
+};
+
+// Finalize the local symbols of all the objects, starting at
+// *PINDEX and *POFF, and update them to point past the last local
+// symbol.
+
+void
+Layout::finalize_local_symbols(const Input_objects* input_objects,
+			       Symbol_table* symtab, int symsize,
+			       unsigned int* pindex, off_t* poff)
+{
+  unsigned int index = *pindex;
+  off_t off = *poff;
+
+  if (Parallel_work::thread_count() <= 1
+      || input_objects->number_of_relobjs() < 2)
+    {
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	{
+	  unsigned int next = (*p)->finalize_local_symbols(index, off, symtab);
+	  off += (next - index) * symsize;
+	  index = next;
+	}
+      *pindex = index;
+      *poff = off;
+      return;
+    }
+
+  // With --threads, each object gets the number of indexes found by
+  // count_local_symbols, and is finalized separately.  Finding the
+  // value of a symbol in a relaxed section may build the lookup maps
+  // of its output section, so do that first.
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    (*p)->validate_lookup_maps();
+
+  std::vector<Relobj*> relobjs(input_objects->relobj_begin(),
+			       input_objects->relobj_end());
+  std::vector<unsigned int> indexes(relobjs.size());
+  std::vector<off_t> offsets(relobjs.size());
+  for (size_t i = 0; i < relobjs.size(); ++i)
+    {
+      indexes[i] = index;
+      offsets[i] = off;
+      unsigned int count = relobjs[i]->output_local_symbol_count();
+      index += count;
+      off += count * symsize;
+    }
+
+  std::vector<unsigned int> next_indexes(relobjs.size());
+  Local_symbol_finalizer finalizer(&relobjs, &indexes, &offsets, symtab,
+				   &next_indexes);
+  finalizer.run(relobjs.size());
+
+  // An object uses fewer indexes only if a symbol had a bad section
+  // index, which has been reported as an error.
+  for (size_t i = 0; i < relobjs.size(); ++i)
+    gold_assert(next_indexes[i] - indexes[i]
+		    == relobjs[i]->output_local_symbol_count()
+		|| parameters->errors()->error_count() > 0);
+
+  *pindex = index;
+  *poff = off;
+}
+
 // Create the symbol table sections.  Here we also set the final
 // values of the symbols.  At this point all the loadable sections are
 // fully laid out.  SHNUM is the number of sections so far.
@@ -4052,15 +4402,8 @@ Layout::create_symtab_sections(const Input_objects* input_objects,
 	}
     }
 
-  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
-       p != input_objects->relobj_end();
-       ++p)
-    {
-      unsigned int index = (*p)->finalize_local_symbols(local_symbol_index,
-							off, symtab);
-      off += (index - local_symbol_index) * symsize;
-      local_symbol_index = index;
-    }
+  this->finalize_local_symbols(input_objects, symtab, symsize,
+			       &local_symbol_index, &off);
 
   unsigned int local_symcount = local_symbol_index;
   gold_assert(static_cast<off_t>(local_symcount * symsize) == off);
@@ -4796,6 +5139,22 @@ Layout::add_target_dynamic_tags(bool use_rel, const Output_data* plt_got,
     }
 }
 
+// Add the DT_RELR, DT_RELRSZ and DT_RELRENT dynamic tags for
+// RELR_DYN.
+
+void
+Layout::add_relr_dynamic_tags(const Output_data* relr_dyn)
+{
+  Output_data_dynamic* odyn = this->dynamic_data_;
+  if (odyn == NULL || relr_dyn == NULL || relr_dyn->output_section() == NULL)
+    return;
+
+  odyn->add_section_address(elfcpp::DT_RELR, relr_dyn->output_section());
+  odyn->add_section_size(elfcpp::DT_RELRSZ, relr_dyn->output_section());
+  odyn->add_constant(elfcpp::DT_RELRENT,
+		     parameters->target().get_size() / 8);
+}
+
 void
 Layout::add_target_specific_dynamic_tag(elfcpp::DT tag, unsigned int val)
 {
@@ -5235,47 +5594,90 @@ Layout::find_or_add_kept_section(const std::string& name,
 				 bool is_group_name,
 				 Kept_section** kept_section)
 {
+  const std::string* key;
+  Kept_section* kept = this->find_kept_section(name, &key);
+  if (kept_section != NULL)
+    *kept_section = kept;
+  return this->include_kept_section(kept, object, shndx, is_comdat,
+				    is_group_name);
+}
+
+// Return the signature table entry for NAME, adding one if needed,
+// and set *KEY to the name in the table.  This is called by
+// Read_symbols tasks, which run in parallel, so the table is divided
+// into shards with separate locks.  The entries of an Unordered_map
+// do not move when it grows, so the pointers we return remain valid.
+// Only the tasks which lay out objects, which run one at a time, look
+// at the contents of an entry.
+
+Kept_section*
+Layout::find_kept_section(const std::string& name, const std::string** key)
+{
+  size_t hash = string_hash<char>(name.data(), name.length());
+  Signature_shard* shard = &this->signatures_[hash % signature_shard_count];
+
+  Hold_lock hl(shard->lock);
+
   // It's normal to see a couple of entries here, for the x86 thunk
   // sections.  If we see more than a few, we're linking a C++
   // program, and we resize to get more space to minimize rehashing.
-  if (this->signatures_.size() > 4
-      && !this->resized_signatures_)
+  if (shard->signatures.size() > 4 && !shard->is_resized)
     {
-      reserve_unordered_map(&this->signatures_,
-			    this->number_of_input_files_ * 64);
-      this->resized_signatures_ = true;
+      reserve_unordered_map(&shard->signatures,
+			    (this->number_of_input_files_ * 64
+			     / signature_shard_count) + 16);
+      shard->is_resized = true;
     }
 
-  Kept_section candidate;
-  std::pair<Signatures::iterator, bool> ins =
-    this->signatures_.insert(std::make_pair(name, candidate));
+  // Most signatures are already in the table, so look before making
+  // a copy of the name to insert.
+  Signatures::iterator p = shard->signatures.find(name);
+  if (p == shard->signatures.end())
+    {
+      Kept_section candidate;
+      p = shard->signatures.insert(std::make_pair(name, candidate)).first;
+    }
+  *key = &p->first;
+  return &p->second;
+}
 
-  if (kept_section != NULL)
-    *kept_section = &ins.first->second;
-  if (ins.second)
+// Check if the comdat group or .gnu.linkonce section with the
+// signature table entry KEPT_SECTION is selected for the link.  If
+// the entry has not been claimed, OBJECT, SHNDX, IS_COMDAT and
+// IS_GROUP_NAME are recorded in it, and the function returns true.
+
+bool
+Layout::include_kept_section(Kept_section* kept_section,
+			     Relobj* object,
+			     unsigned int shndx,
+			     bool is_comdat,
+			     bool is_group_name)
+{
+  if (!kept_section->is_claimed())
     {
       // This is the first time we've seen this signature.
-      ins.first->second.set_object(object);
-      ins.first->second.set_shndx(shndx);
+      kept_section->set_is_claimed();
+      kept_section->set_object(object);
+      kept_section->set_shndx(shndx);
       if (is_comdat)
-	ins.first->second.set_is_comdat();
+	kept_section->set_is_comdat();
       if (is_group_name)
-	ins.first->second.set_is_group_name();
+	kept_section->set_is_group_name();
       return true;
     }
 
   // We have already seen this signature.
 
-  if (ins.first->second.is_group_name())
+  if (kept_section->is_group_name())
     {
       // We've already seen a real section group with this signature.
       // If the kept group is from a plugin object, and we're in the
       // replacement phase, accept the new one as a replacement.
-      if (ins.first->second.object() == NULL
+      if (kept_section->object() == NULL
 	  && parameters->options().plugins()->in_replacement_phase())
 	{
-	  ins.first->second.set_object(object);
-	  ins.first->second.set_shndx(shndx);
+	  kept_section->set_object(object);
+	  kept_section->set_shndx(shndx);
 	  return true;
 	}
       return false;
@@ -5285,7 +5687,7 @@ Layout::find_or_add_kept_section(const std::string& name,
       // This is a real section group, and we've already seen a
       // linkonce section with this signature.  Record that we've seen
       // a section group, and don't include this section group.
-      ins.first->second.set_is_group_name();
+      kept_section->set_is_group_name();
       return false;
     }
   else
@@ -5367,15 +5769,98 @@ Layout::symtab_section_shndx() const
 // handled elsewhere.  But some Output_sections do have Output_data.
 
 void
-Layout::write_output_sections(Output_file* of) const
+Layout::write_output_sections(Output_file* of,
+			      const Section_list& sections) const
 {
+  for (Section_list::const_iterator p = sections.begin();
+       p != sections.end();
+       ++p)
+    (*p)->write(of);
+}
+
+// Sort output section indexes by decreasing amount of data to write.
+
+class Write_size_compare
+{
+ public:
+  Write_size_compare(const std::vector<off_t>* sizes)
+    : sizes_(sizes)
+  { }
+
+  bool
+  operator()(unsigned int i1, unsigned int i2) const
+  { return (*this->sizes_)[i1] > (*this->sizes_)[i2]; }
+
+ private:
+  const std::vector<off_t>* sizes_;
+};
+
+// Split the output sections which write_output_sections writes into
+// groups.  The ordinary input sections are written by the Relocate
+// tasks, so what matters is the size of the Output_section_data
+// objects, such as the GOT, the PLT, the dynamic relocations and the
+// merged sections.  We only use more than one group when there is
+// enough data to make it worthwhile.  Each section goes to the group
+// with the least data so far, biggest sections first.  Within a
+// group, the sections stay in the order of the section list.
+
+void
+Layout::group_output_sections_for_write(unsigned int max_groups,
+					std::vector<Section_list>* groups) const
+{
+  Section_list sections;
+  std::vector<off_t> sizes;
+  off_t total_size = 0;
   for (Section_list::const_iterator p = this->section_list_.begin();
        p != this->section_list_.end();
        ++p)
     {
-      if (!(*p)->after_input_sections())
-	(*p)->write(of);
+      if ((*p)->after_input_sections())
+	continue;
+      off_t size = 0;
+      const Output_section::Input_section_list& inputs((*p)->input_sections());
+      for (Output_section::Input_section_list::const_iterator q =
+	     inputs.begin();
+	   q != inputs.end();
+	   ++q)
+	if (!q->is_input_section())
+	  size += q->data_size();
+      sections.push_back(*p);
+      sizes.push_back(size);
+      total_size += size;
+    }
+
+  // Don't bother with a task for less than this much data.
+  const off_t min_group_size = 256 * 1024;
+  unsigned int group_count = std::min(static_cast<off_t>(max_groups),
+				      total_size / min_group_size + 1);
+  if (group_count <= 1)
+    {
+      groups->assign(1, sections);
+      return;
+    }
+
+  std::vector<unsigned int> order(sections.size());
+  for (unsigned int i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), Write_size_compare(&sizes));
+
+  std::vector<off_t> group_sizes(group_count, 0);
+  std::vector<unsigned int> section_groups(sections.size());
+  for (unsigned int i = 0; i < order.size(); ++i)
+    {
+      unsigned int g = 0;
+      for (unsigned int j = 1; j < group_count; ++j)
+	if (group_sizes[j] < group_sizes[g])
+	  g = j;
+      section_groups[order[i]] = g;
+      group_sizes[g] += sizes[order[i]];
     }
+
+  groups->clear();
+  groups->resize(group_count);
+  for (unsigned int i = 0; i < sections.size(); ++i)
+    (*groups)[section_groups[i]].push_back(sections[i]);
 }
 
 // Write out data not associated with a section or the symbol table.
@@ -5569,14 +6054,14 @@ Layout::write_binary(Output_file* in) const
 void
 Layout::print_to_mapfile(Mapfile* mapfile) const
 {
+  std::vector<const Output_data*> sections;
   for (Segment_list::const_iterator p = this->segment_list_.begin();
        p != this->segment_list_.end();
        ++p)
-    (*p)->print_sections_to_mapfile(mapfile);
-  for (Section_list::const_iterator p = this->unattached_section_list_.begin();
-       p != this->unattached_section_list_.end();
-       ++p)
-    (*p)->print_to_mapfile(mapfile);
+    (*p)->get_mapfile_sections(&sections);
+  sections.insert(sections.end(), this->unattached_section_list_.begin(),
+		  this->unattached_section_list_.end());
+  mapfile->print_memory_map(sections);
 }
 
 // Print statistical information to stderr.  This is used for --stats.
@@ -5621,7 +6106,7 @@ Write_sections_task::locks(Task_locker* tl)
 void
 Write_sections_task::run(Workqueue*)
 {
-  this->layout_->write_output_sections(this->of_);
+  this->layout_->write_output_sections(this->of_, this->sections_);
 }
 
 // Write_data_task methods.
@@ -59,6 +59,7 @@ class Output_reduced_debug_abbrev_section;
 class Output_reduced_debug_info_section;
 class Eh_frame;
 class Gdb_index;
+class Call_graph_ordering;
 class Target;
 struct Timespec;
 
@@ -71,7 +72,11 @@ extern std::string
 corresponding_uncompressed_section_name(std::string secname);
 
 // Maintain a list of free space within a section, segment, or file.
-// Used for incremental update links.
+// Used for incremental update links.  Besides the list in address
+// order, the free chunks are kept in size classes, so that allocate()
+// can take space from the smallest chunks that fit.  This keeps the
+// large chunks, such as the patch space at the end of a section,
+// available for large requests.
 
 class Free_list
 {
@@ -87,8 +92,8 @@ class Free_list
   typedef std::list<Free_list_node>::const_iterator Const_iterator;
 
   Free_list()
-    : list_(), last_remove_(list_.begin()), extend_(false), length_(0),
-      min_hole_(0)
+    : list_(), last_remove_(list_.begin()), size_classes_(),
+      first_fit_(false), extend_(false), length_(0), min_hole_(0)
   { }
 
   // Initialize the free list for a section of length LEN.
@@ -96,6 +101,13 @@ class Free_list
   void
   init(off_t len, bool extend);
 
+  // Allocate from the free chunk with the lowest address that fits,
+  // rather than from the smallest one.  This is used for the file as
+  // a whole, where the sections must stay within their segments.
+  void
+  set_first_fit()
+  { this->first_fit_ = true; }
+
   // Set the minimum hole size that is allowed when allocating
   // from the free list.
   void
@@ -132,12 +144,39 @@ class Free_list
  private:
   typedef std::list<Free_list_node>::iterator Iterator;
 
-  // The free list.
+  // The nodes in one size class, indexed by their start offset.
+  typedef std::map<off_t, Iterator> Size_class;
+
+  // Return the size class for a chunk of length LEN.
+  static unsigned int
+  size_class(off_t len);
+
+  // Add node P to its size class.
+  void
+  add_to_size_class(Iterator p);
+
+  // Remove node P from its size class.
+  void
+  remove_from_size_class(Iterator p);
+
+  // Take the chunk from START to END out of node P.  Returns the
+  // node following the chunk.
+  Iterator
+  take(Iterator p, off_t start, off_t end, int fuzz);
+
+  // The free list, in order by address.
   std::list<Free_list_node> list_;
 
   // The last node visited during a remove operation.
   Iterator last_remove_;
 
+  // The nodes of the free list by size class.  Class I holds the
+  // nodes whose length is at least 2**I and less than 2**(I+1).
+  std::vector<Size_class> size_classes_;
+
+  // Whether to allocate from the chunk with the lowest address.
+  bool first_fit_;
+
   // Whether we can extend past the original length.
   bool extend_;
 
@@ -161,6 +200,8 @@ class Free_list
   static unsigned int num_allocates;
   // The total number of nodes visited during calls to Free_list::allocate.
   static unsigned int num_allocate_visits;
+  // The total number of calls to Free_list::allocate which failed.
+  static unsigned int num_allocate_failures;
 };
 
 // This task function handles mapping the input sections to output
@@ -229,15 +270,16 @@ class Kept_section
 
  public:
   Kept_section()
-    : object_(NULL), shndx_(0), is_comdat_(false), is_group_name_(false)
+    : object_(NULL), shndx_(0), is_claimed_(false), is_comdat_(false),
+      is_group_name_(false)
   { this->u_.linkonce_size = 0; }
 
   // We need to support copies for the signature map in the Layout
   // object, but we should never copy an object after it has been
   // marked as a comdat section.
   Kept_section(const Kept_section& k)
-    : object_(k.object_), shndx_(k.shndx_), is_comdat_(false),
-      is_group_name_(k.is_group_name_)
+    : object_(k.object_), shndx_(k.shndx_), is_claimed_(k.is_claimed_),
+      is_comdat_(false), is_group_name_(k.is_group_name_)
   {
     gold_assert(!k.is_comdat_);
     this->u_.linkonce_size = 0;
@@ -275,6 +317,21 @@ class Kept_section
     this->shndx_ = shndx;
   }
 
+  // Whether some object has used this signature.  An entry can be
+  // added to the signature table by Layout::find_kept_section before
+  // any object decides to keep it.
+  bool
+  is_claimed() const
+  { return this->is_claimed_; }
+
+  // Note that some object has used this signature.
+  void
+  set_is_claimed()
+  {
+    gold_assert(!this->is_claimed_);
+    this->is_claimed_ = true;
+  }
+
   // Whether this is a comdat group.
   bool
   is_comdat() const
@@ -365,6 +422,8 @@ class Kept_section
   // Index of the group section for comdats and the section itself for
   // .gnu.linkonce.
   unsigned int shndx_;
+  // True if some object has used this signature.
+  bool is_claimed_;
   // True if this is for a comdat group rather than a .gnu.linkonce
   // section.
   bool is_comdat_;
@@ -494,11 +553,7 @@ class Layout
  public:
   Layout(int number_of_input_files, Script_options*);
 
-  ~Layout()
-  {
-    delete this->relaxation_debug_check_;
-    delete this->segment_states_;
-  }
+  ~Layout();
 
   // For incremental links, record the base file to be modified.
   void
@@ -594,6 +649,16 @@ class Layout
   void
   read_layout_from_file();
 
+  // Read the call graph profile from the file specified with linker
+  // option --call-graph-ordering-file.
+  void
+  read_call_graph_from_file();
+
+  // Order the executable input sections using the call graph profile.
+  void
+  order_sections_by_call_graph(const Task*, Symbol_table*,
+			       const Input_objects*);
+
   // Layout an input reloc section when doing a relocatable link.  The
   // section is RELOC_SHNDX in OBJECT, with data in SHDR.
   // DATA_SECTION is the reloc section to which it refers.  RR is the
@@ -792,6 +857,24 @@ class Layout
 			   unsigned int shndx, bool is_comdat,
 			   bool is_group_name, Kept_section** kept_section);
 
+  // Return the entry in the signature table for the comdat group or
+  // .gnu.linkonce signature NAME, adding an unclaimed entry if there
+  // is none, and set *KEY to the copy of NAME in the table.  Unlike
+  // the other functions here, this may be called by Read_symbols
+  // tasks running in parallel.
+  Kept_section*
+  find_kept_section(const std::string& name, const std::string** key);
+
+  // Check if the comdat group or .gnu.linkonce section whose
+  // signature table entry is KEPT_SECTION is selected for the link.
+  // This is find_or_add_kept_section for an entry which has already
+  // been found.  Entries are claimed in the order that the objects
+  // are laid out, so the first object on the command line wins.
+  bool
+  include_kept_section(Kept_section* kept_section, Relobj* object,
+		       unsigned int shndx, bool is_comdat,
+		       bool is_group_name);
+
   // Finalize the layout after all the input sections have been added.
   off_t
   finalize(const Input_objects*, Symbol_table*, Target*, const Task*);
@@ -841,10 +924,6 @@ class Layout
   dynamic_data() const
   { return this->dynamic_data_; }
 
-  // Write out the output sections.
-  void
-  write_output_sections(Output_file* of) const;
-
   // Write out data not associated with an input file or the symbol
   // table.
   void
@@ -902,6 +981,11 @@ class Layout
 			  const Output_data_reloc_generic* dyn_rel,
 			  bool add_debug, bool dynrel_includes_plt);
 
+  // For the target-specific code to add the dynamic tags for
+  // RELR_DYN, a SHT_RELR section of packed relative relocs.
+  void
+  add_relr_dynamic_tags(const Output_data* relr_dyn);
+
   // Add a target-specific dynamic tag with constant value.
   void
   add_target_specific_dynamic_tag(elfcpp::DT tag, unsigned int val);
@@ -943,6 +1027,17 @@ class Layout
   void
   get_executable_sections(Section_list*) const;
 
+  // Split the output sections which are not written after the input
+  // sections into at most MAX_GROUPS groups, to be written out by
+  // separate tasks.
+  void
+  group_output_sections_for_write(unsigned int max_groups,
+				  std::vector<Section_list>* groups) const;
+
+  // Write out the output sections in SECTIONS.
+  void
+  write_output_sections(Output_file* of, const Section_list& sections) const;
+
   // Make a section for a linker script to hold data.
   Output_section*
   make_output_section_for_script(const char* name,
@@ -1064,6 +1159,11 @@ class Layout
   void
   count_local_symbols(const Task*, const Input_objects*);
 
+  // Finalize the local symbols.
+  void
+  finalize_local_symbols(const Input_objects*, Symbol_table*, int,
+			 unsigned int*, off_t*);
+
   // Create the output sections for the symbol table.
   void
   create_symtab_sections(const Input_objects*, Symbol_table*,
@@ -1246,6 +1346,25 @@ class Layout
   // A mapping used for kept comdats/.gnu.linkonce group signatures.
   typedef Unordered_map<std::string, Kept_section> Signatures;
 
+  // The signatures are divided among this many tables, each with its
+  // own lock, so that Read_symbols tasks can add them in parallel.
+  static const unsigned int signature_shard_count = 64;
+
+  // One of the signature tables.
+  struct Signature_shard
+  {
+    Signature_shard()
+      : lock(), signatures(), is_resized(false)
+    { }
+
+    // Lock controlling access to the table.
+    Lock lock;
+    // The table.
+    Signatures signatures;
+    // Whether we have resized the table.
+    bool is_resized;
+  };
+
   // Mapping from input section name/type/flags to output section.  We
   // use canonicalized strings here.
 
@@ -1329,8 +1448,9 @@ class Layout
   Stringpool sympool_;
   // The dynamic strings, if needed.
   Stringpool dynpool_;
-  // The list of group sections and linkonce sections which we have seen.
-  Signatures signatures_;
+  // The list of group sections and linkonce sections which we have
+  // seen, divided by hash code.
+  Signature_shard signatures_[signature_shard_count];
   // The mapping from input section name/type/flags to output sections.
   Section_name_map section_name_map_;
   // The list of output segments.
@@ -1408,8 +1528,6 @@ class Layout
   bool has_static_tls_;
   // Whether any sections require postprocessing.
   bool any_postprocessing_sections_;
-  // Whether we have resized the signatures_ hash table.
-  bool resized_signatures_;
   // Whether we have created a .stab*str output section.
   bool have_stabstr_section_;
   // True if the input sections in the output sections should be sorted
@@ -1441,6 +1559,8 @@ class Layout
   Unordered_map<std::string, unsigned int> input_section_position_;
   // Vector of glob only patterns in the section_ordering file.
   std::vector<std::string> input_section_glob_;
+  // The call graph profile from --call-graph-ordering-file, if any.
+  Call_graph_ordering* call_graph_ordering_;
   // For incremental links, the base file to be modified.
   Incremental_binary* incremental_base_;
   // For incremental links, a list of free space within the file.
@@ -1448,18 +1568,20 @@ class Layout
 };
 
 // This task handles writing out data in output sections which is not
-// part of an input section, or which requires special handling.  When
-// this is done, it unblocks both output_sections_blocker and
-// final_blocker.
+// part of an input section, or which requires special handling.  With
+// threads, there may be several of these tasks, each writing a group
+// of the output sections.  When this is done, it unblocks both
+// output_sections_blocker and final_blocker.
 
 class Write_sections_task : public Task
 {
  public:
   Write_sections_task(const Layout* layout, Output_file* of,
+		      const Layout::Section_list& sections,
 		      Task_token* output_sections_blocker,
 		      Task_token* input_sections_blocker,
 		      Task_token* final_blocker)
-    : layout_(layout), of_(of),
+    : layout_(layout), of_(of), sections_(sections),
       output_sections_blocker_(output_sections_blocker),
       input_sections_blocker_(input_sections_blocker),
       final_blocker_(final_blocker)
@@ -1485,6 +1607,7 @@ class Write_sections_task : public Task
 
   const Layout* layout_;
   Output_file* of_;
+  Layout::Section_list sections_;
   Task_token* output_sections_blocker_;
   Task_token* input_sections_blocker_;
   Task_token* final_blocker_;
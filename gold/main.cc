@@ -29,6 +29,10 @@
 #include <malloc.h>
 #endif
 
+#ifdef HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
 #include "libiberty.h"
 
 #include "script.h"
@@ -48,6 +52,8 @@
 #include "icf.h"
 #include "incremental.h"
 #include "gdb-index.h"
+#include "reloc-cache.h"
+#include "prefetch.h"
 #include "timer.h"
 
 using namespace gold;
@@ -174,6 +180,9 @@ main(int argc, char** argv)
   // Store some options in the globally accessible parameters.
   set_parameters_options(&command_line.options());
 
+  // Start reading in the input files.
+  Input_prefetcher::start(&command_line);
+
   // Do this as early as possible (since it prints a welcome message).
   write_debug_script(command_line.options().output_file_name(),
                      program_name, args.c_str());
@@ -235,14 +244,20 @@ main(int argc, char** argv)
   if (parameters->options().section_ordering_file())
     layout.read_layout_from_file();
 
+  if (parameters->options().call_graph_ordering_file())
+    layout.read_call_graph_from_file();
+
   // Load plugin libraries.
   if (command_line.options().has_plugins())
-    command_line.options().plugins()->load_plugins(&layout);
+    command_line.options().plugins()->load_plugins(&layout, command_line);
 
   // Get the search path from the -L options.
   Dirsearch search_path;
   search_path.initialize(&workqueue, &command_line.options().library_path());
 
+  // Open the relocation cache if --reloc-cache was used.
+  Reloc_cache::initialize();
+
   // Queue up the first set of tasks.
   queue_initial_tasks(command_line.options(), search_path,
 		      command_line, &workqueue, &input_objects,
@@ -251,6 +266,9 @@ main(int argc, char** argv)
   // Run the main task processing loop.
   workqueue.process(0);
 
+  Reloc_cache::finish();
+  Input_prefetcher::finish();
+
   if (command_line.options().print_output_format())
     print_output_format();
 
@@ -289,11 +307,18 @@ main(int argc, char** argv)
               elapsed.user / 1000, (elapsed.user % 1000) * 1000,
               elapsed.sys / 1000, (elapsed.sys % 1000) * 1000,
               elapsed.wall / 1000, (elapsed.wall % 1000) * 1000);
+      workqueue.print_stats();
 
 #ifdef HAVE_MALLINFO
       struct mallinfo m = mallinfo();
       fprintf(stderr, _("%s: total space allocated by malloc: %d bytes\n"),
 	      program_name, m.arena);
+#endif
+#ifdef HAVE_GETRUSAGE
+      struct rusage ru;
+      if (getrusage(RUSAGE_SELF, &ru) == 0)
+	fprintf(stderr, _("%s: maximum resident set size: %ld kB\n"),
+		program_name, static_cast<long>(ru.ru_maxrss));
 #endif
       File_read::print_stats();
       Archive::print_stats();
@@ -304,6 +329,10 @@ main(int argc, char** argv)
       layout.print_stats();
       Gdb_index::print_stats();
       Free_list::print_stats();
+      Incremental_binary::print_stats(layout.incremental_inputs());
+      Reloc_cache::print_stats();
+      Input_prefetcher::print_stats();
+      Output_file::print_stats();
     }
 
   // Issue defined symbol report.
@@ -312,8 +341,13 @@ main(int argc, char** argv)
 
   // Output cross reference table.
   if (command_line.options().cref())
-    input_objects.print_cref(&symtab,
-			     mapfile == NULL ? stdout : mapfile->file());
+    {
+      if (mapfile == NULL)
+	input_objects.print_cref(&symtab, stdout, false);
+      else
+	input_objects.print_cref(&symtab, mapfile->cref_file(),
+				 mapfile->is_json());
+    }
 
   if (mapfile != NULL)
     mapfile->close();
@@ -23,12 +23,16 @@
 #include "gold.h"
 
 #include <cerrno>
+#include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 
 #include "archive.h"
 #include "symtab.h"
 #include "output.h"
+#include "object.h"
+#include "gold-threads.h"
 #include "mapfile.h"
 
 // This file holds the code for printing information to the map file.
@@ -37,22 +41,207 @@
 namespace gold
 {
 
+// The information we collect about the input sections of an object.
+// Reading it requires locking the object, so we collect it for all
+// objects at once, on several threads, before printing anything.
+
+struct Mapfile::Object_info
+{
+  // The section names, each followed by a NUL byte.
+  std::string names;
+  // The offset in NAMES of the name of each section.
+  std::vector<unsigned int> name_offsets;
+  // The size of each section, before any compression.
+  std::vector<uint64_t> sizes;
+  // The symbols defined in section I are SYMBOLS[SYMBOL_STARTS[I]]
+  // through SYMBOLS[SYMBOL_STARTS[I + 1] - 1], in symbol table order.
+  std::vector<unsigned int> symbol_starts;
+  std::vector<const Symbol*> symbols;
+  // The discarded sections to list in the map file.
+  std::vector<unsigned int> discarded;
+};
+
+// Collect the Object_info for groups of objects.  The objects in a
+// group share an input file, such as an archive, so they must be
+// handled on the same thread.
+
+class Mapfile::Object_info_collector : public Parallel_work
+{
+ public:
+  typedef std::vector<std::vector<Relobj*> > Groups;
+
+  Object_info_collector(const Groups* groups, const Object_infos* infos)
+    : groups_(groups), infos_(infos)
+  { }
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    const std::vector<Relobj*>& group((*this->groups_)[piece]);
+    for (std::vector<Relobj*>::const_iterator p = group.begin();
+	 p != group.end();
+	 ++p)
+      {
+	Object_infos::const_iterator pi = this->infos_->find(*p);
+	gold_assert(pi != this->infos_->end());
+	this->collect(*p, pi->second);
+      }
+  }
+
+ private:
+  void
+  collect(Relobj*, Object_info*);
+
+  const Groups* groups_;
+  const Object_infos* infos_;
+};
+
+// Collect the information for RELOBJ.
+
+void
+Mapfile::Object_info_collector::collect(Relobj* relobj, Object_info* info)
+{
+  // Lock the object so we can read from it.  Nothing else is using
+  // the objects while we print the map file, and no other thread uses
+  // this input file.  Unfortunately we have no way to pass in a Task
+  // token.
+  const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+  Task_lock_obj<Object> tl(dummy_task, relobj);
+
+  unsigned int shnum = relobj->shnum();
+  info->name_offsets.resize(shnum);
+  info->sizes.resize(shnum);
+  for (unsigned int i = 0; i < shnum; ++i)
+    {
+      info->name_offsets[i] = info->names.size();
+      info->names += relobj->section_name(i);
+      info->names += '\0';
+
+      section_size_type size;
+      if (!relobj->section_is_compressed(i, &size))
+	size = relobj->section_size(i);
+      info->sizes[i] = size;
+
+      unsigned int sh_type = relobj->section_type(i);
+      if ((sh_type == elfcpp::SHT_PROGBITS
+	   || sh_type == elfcpp::SHT_NOBITS
+	   || sh_type == elfcpp::SHT_GROUP)
+	  && !relobj->is_section_included(i))
+	info->discarded.push_back(i);
+    }
+
+  // Sort the defined symbols by section, keeping them in symbol table
+  // order within each section.
+  info->symbol_starts.resize(shnum + 1);
+  const Object::Symbols* syms = relobj->get_global_symbols();
+  if (syms == NULL)
+    return;
+  std::vector<const Symbol*> defined;
+  std::vector<unsigned int> defined_shndx;
+  for (Object::Symbols::const_iterator p = syms->begin();
+       p != syms->end();
+       ++p)
+    {
+      const Symbol* sym = *p;
+      bool is_ordinary;
+      unsigned int shndx;
+      if (sym != NULL
+	  && sym->source() == Symbol::FROM_OBJECT
+	  && sym->object() == relobj
+	  && (shndx = sym->shndx(&is_ordinary)) < shnum
+	  && is_ordinary
+	  && sym->is_defined())
+	{
+	  defined.push_back(sym);
+	  defined_shndx.push_back(shndx);
+	  ++info->symbol_starts[shndx + 1];
+	}
+    }
+  for (unsigned int i = 0; i < shnum; ++i)
+    info->symbol_starts[i + 1] += info->symbol_starts[i];
+  info->symbols.resize(defined.size());
+  std::vector<unsigned int> next(info->symbol_starts.begin(),
+				 info->symbol_starts.end() - 1);
+  for (size_t i = 0; i < defined.size(); ++i)
+    info->symbols[next[defined_shndx[i]]++] = defined[i];
+}
+
+// A piece of the memory map.  This is either a whole Output_data,
+// or input sections FIRST through LAST - 1 of an Output_section.
+
+struct Mapfile::Memory_map_chunk
+{
+  const Output_data* od;
+  size_t first;
+  size_t last;
+};
+
+// Print chunks of the memory map, each into its own Mapfile.
+
+class Mapfile::Memory_map_printer : public Parallel_work
+{
+ public:
+  Memory_map_printer(const Memory_map_chunk* chunks, Mapfile** maps)
+    : chunks_(chunks), maps_(maps)
+  { }
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  { this->maps_[piece]->print_memory_map_chunk(&this->chunks_[piece]); }
+
+ private:
+  const Memory_map_chunk* chunks_;
+  Mapfile** maps_;
+};
+
 // Mapfile constructor.
 
 Mapfile::Mapfile()
   : map_file_(NULL),
+    parent_(NULL),
+    is_json_(strcmp(parameters->options().map_format(), "json") == 0),
+    buffer_(),
+    object_infos_(),
+    json_array_(NULL),
+    json_first_element_(true),
+    json_in_output_section_(false),
+    json_first_input_(true),
     printed_archive_header_(false),
     printed_common_header_(false),
     printed_memory_map_header_(false)
 {
 }
 
+// Make a Mapfile which prints part of the memory map of PARENT.
+
+Mapfile::Mapfile(const Mapfile* parent)
+  : map_file_(NULL),
+    parent_(parent),
+    is_json_(parent->is_json_),
+    buffer_(),
+    object_infos_(),
+    json_array_(NULL),
+    json_first_element_(true),
+    json_in_output_section_(false),
+    json_first_input_(true),
+    printed_archive_header_(true),
+    printed_common_header_(true),
+    printed_memory_map_header_(true)
+{
+}
+
 // Mapfile destructor.
 
 Mapfile::~Mapfile()
 {
   if (this->map_file_ != NULL)
     this->close();
+  for (Object_infos::iterator p = this->object_infos_.begin();
+       p != this->object_infos_.end();
+       ++p)
+    delete p->second;
 }
 
 // Open the map file.
@@ -80,11 +269,143 @@ Mapfile::open(const char* map_filename)
 void
 Mapfile::close()
 {
+  if (this->is_json_)
+    {
+      if (this->json_array_ == NULL)
+	this->put('{');
+      else
+	this->put(']');
+      this->put("}\n");
+    }
+  this->write_buffer(0);
   if (fclose(this->map_file_) != 0)
     gold_error(_("cannot close map file: %s"), strerror(errno));
   this->map_file_ = NULL;
 }
 
+// Return the file, after writing out the buffered output.
+
+FILE*
+Mapfile::file()
+{
+  this->write_buffer(0);
+  return this->map_file_;
+}
+
+// Return the file for the cross reference table.  In a JSON map the
+// table is the last array, so close will end it.
+
+FILE*
+Mapfile::cref_file()
+{
+  if (this->is_json_)
+    this->start_json_array("cross_references");
+  return this->file();
+}
+
+// The amount of output we buffer.
+
+const size_t Mapfile::buffer_size = 1024 * 1024;
+
+// Write out the buffer.
+
+void
+Mapfile::write_buffer(size_t min)
+{
+  if (this->buffer_.size() < min || this->buffer_.empty())
+    return;
+  gold_assert(this->map_file_ != NULL);
+  if (fwrite(this->buffer_.data(), 1, this->buffer_.size(), this->map_file_)
+      != this->buffer_.size())
+    gold_error(_("cannot write map file: %s"), strerror(errno));
+  this->buffer_.clear();
+}
+
+// Add formatted text to the buffer.
+
+void
+Mapfile::print(const char* format, ...)
+{
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof buf, format, args);
+  va_end(args);
+  gold_assert(len >= 0);
+  if (static_cast<size_t>(len) < sizeof buf)
+    {
+      this->buffer_.append(buf, len);
+      return;
+    }
+
+  std::vector<char> bigbuf(len + 1);
+  va_start(args, format);
+  vsnprintf(&bigbuf[0], len + 1, format, args);
+  va_end(args);
+  this->buffer_.append(&bigbuf[0], len);
+}
+
+// Append a quoted JSON string to *OUT.
+
+void
+Mapfile::append_json_string(const char* s, std::string* out)
+{
+  *out += '"';
+  for (; *s != '\0'; ++s)
+    {
+      unsigned char c = *s;
+      if (c == '"' || c == '\\')
+	{
+	  *out += '\\';
+	  *out += c;
+	}
+      else if (c < 0x20)
+	{
+	  char buf[8];
+	  snprintf(buf, sizeof buf, "\\u%04x", c);
+	  *out += buf;
+	}
+      else
+	*out += c;
+    }
+  *out += '"';
+}
+
+// Start the JSON array KEY of the top level object.  The arrays are
+// written in the order in which the linker reports things, so we
+// only need to close the previous one.
+
+void
+Mapfile::start_json_array(const char* key)
+{
+  if (this->json_array_ != NULL && strcmp(this->json_array_, key) == 0)
+    return;
+  if (this->json_array_ == NULL)
+    this->put('{');
+  else
+    this->put("],");
+  this->put_json_string(key);
+  this->put(":[");
+  this->json_array_ = key;
+  this->json_first_element_ = true;
+}
+
+// Start a JSON object.  If we are printing an output section, this
+// is an input section in it; otherwise it is an element of the
+// current array.
+
+void
+Mapfile::start_json_element()
+{
+  bool* pfirst = (this->json_in_output_section_
+		  ? &this->json_first_input_
+		  : &this->json_first_element_);
+  if (!*pfirst)
+    this->put(',');
+  *pfirst = false;
+  this->put('{');
+}
+
 // Advance to a column.
 
 void
@@ -92,14 +413,11 @@ Mapfile::advance_to_column(size_t from, size_t to)
 {
   if (from >= to - 1)
     {
-      putc('\n', this->map_file_);
+      this->put('\n');
       from = 0;
     }
-  while (from < to)
-    {
-      putc(' ', this->map_file_);
-      ++from;
-    }
+  if (from < to)
+    this->buffer_.append(to - from, ' ');
 }
 
 // Report about including a member from an archive.
@@ -108,31 +426,17 @@ void
 Mapfile::report_include_archive_member(const std::string& member_name,
 				       const Symbol* sym, const char* why)
 {
-  // We print a header before the list of archive members, mainly for
-  // GNU ld compatibility.
-  if (!this->printed_archive_header_)
-    {
-      fprintf(this->map_file_,
-	      _("Archive member included because of file (symbol)\n\n"));
-      this->printed_archive_header_ = true;
-    }
-
-  fprintf(this->map_file_, "%s", member_name.c_str());
-
-  this->advance_to_column(member_name.length(), 30);
-
-  if (sym == NULL)
-    fprintf(this->map_file_, "%s", why);
-  else
+  const char* from = NULL;
+  if (sym != NULL)
     {
       switch (sym->source())
 	{
 	case Symbol::FROM_OBJECT:
-	  fprintf(this->map_file_, "%s", sym->object()->name().c_str());
+	  from = sym->object()->name().c_str();
 	  break;
 
 	case Symbol::IS_UNDEFINED:
-	  fprintf(this->map_file_, "-u");
+	  from = "-u";
 	  break;
 
 	default:
@@ -142,11 +446,51 @@ Mapfile::report_include_archive_member(const std::string& member_name,
 	  // We should only see an undefined symbol here.
 	  gold_unreachable();
 	}
+    }
 
-      fprintf(this->map_file_, " (%s)", sym->name());
+  if (this->is_json_)
+    {
+      this->start_json_array("archive_members");
+      this->start_json_element();
+      this->put("\"member\":");
+      this->put_json_string(member_name.c_str());
+      if (sym == NULL)
+	{
+	  this->put(",\"reason\":");
+	  this->put_json_string(why);
+	}
+      else
+	{
+	  this->put(",\"file\":");
+	  this->put_json_string(from);
+	  this->put(",\"symbol\":");
+	  this->put_json_string(sym->name());
+	}
+      this->put('}');
+      this->write_buffer(Mapfile::buffer_size);
+      return;
     }
 
-  putc('\n', this->map_file_);
+  // We print a header before the list of archive members, mainly for
+  // GNU ld compatibility.
+  if (!this->printed_archive_header_)
+    {
+      this->print("%s",
+		  _("Archive member included because of file (symbol)\n\n"));
+      this->printed_archive_header_ = true;
+    }
+
+  this->put(member_name);
+
+  this->advance_to_column(member_name.length(), 30);
+
+  if (sym == NULL)
+    this->print("%s", why);
+  else
+    this->print("%s (%s)", from, sym->name());
+
+  this->put('\n');
+  this->write_buffer(Mapfile::buffer_size);
 }
 
 // Report allocating a common symbol.
@@ -154,31 +498,37 @@ Mapfile::report_include_archive_member(const std::string& member_name,
 void
 Mapfile::report_allocate_common(const Symbol* sym, uint64_t symsize)
 {
+  std::string demangled_name = sym->demangled_name();
+
+  if (this->is_json_)
+    {
+      this->start_json_array("common_symbols");
+      this->start_json_element();
+      this->put("\"name\":");
+      this->put_json_string(demangled_name.c_str());
+      this->print(",\"size\":%llu,\"file\":",
+		  static_cast<unsigned long long>(symsize));
+      this->put_json_string(sym->object()->name().c_str());
+      this->put('}');
+      this->write_buffer(Mapfile::buffer_size);
+      return;
+    }
+
   if (!this->printed_common_header_)
     {
-      fprintf(this->map_file_, _("\nAllocating common symbols\n"));
-      fprintf(this->map_file_,
-	      _("Common symbol       size              file\n\n"));
+      this->print("%s", _("\nAllocating common symbols\n"));
+      this->print("%s", _("Common symbol       size              file\n\n"));
       this->printed_common_header_ = true;
     }
 
-  std::string demangled_name = sym->demangled_name();
-  fprintf(this->map_file_, "%s", demangled_name.c_str());
+  this->put(demangled_name);
 
   this->advance_to_column(demangled_name.length(), 20);
 
   char buf[50];
   snprintf(buf, sizeof buf, "0x%llx", static_cast<unsigned long long>(symsize));
-  fprintf(this->map_file_, "%s", buf);
-
-  size_t len = strlen(buf);
-  while (len < 18)
-    {
-      putc(' ', this->map_file_);
-      ++len;
-    }
-
-  fprintf(this->map_file_, "%s\n", sym->object()->name().c_str());
+  this->print("%-18s%s\n", buf, sym->object()->name().c_str());
+  this->write_buffer(Mapfile::buffer_size);
 }
 
 // The space we make for a section name.
@@ -192,40 +542,92 @@ Mapfile::print_memory_map_header()
 {
   if (!this->printed_memory_map_header_)
     {
-      fprintf(this->map_file_, _("\nMemory map\n\n"));
+      this->print("%s", _("\nMemory map\n\n"));
       this->printed_memory_map_header_ = true;
     }
 }
 
+// Collect the information about the input sections of each object.
+// We group the objects by input file, since objects in the same
+// archive can not be read at the same time.
+
+void
+Mapfile::collect_input_sections(const Input_objects* input_objects)
+{
+  Object_info_collector::Groups groups;
+  Unordered_map<const Input_file*, size_t> group_index;
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      Relobj* relobj = *p;
+      std::pair<Object_infos::iterator, bool> ins =
+	this->object_infos_.insert(std::make_pair(relobj,
+						  static_cast<Object_info*>(NULL)));
+      if (!ins.second)
+	continue;
+      ins.first->second = new Object_info();
+
+      std::pair<Unordered_map<const Input_file*, size_t>::iterator, bool>
+	gins = group_index.insert(std::make_pair(relobj->input_file(),
+						 groups.size()));
+      if (gins.second)
+	groups.push_back(std::vector<Relobj*>());
+      groups[gins.first->second].push_back(relobj);
+    }
+
+  Object_info_collector collector(&groups, &this->object_infos_);
+  collector.run(groups.size());
+}
+
+// Return the information for RELOBJ.
+
+const Mapfile::Object_info*
+Mapfile::object_info(const Relobj* relobj) const
+{
+  const Mapfile* top = this->parent_ != NULL ? this->parent_ : this;
+  Object_infos::const_iterator p = top->object_infos_.find(relobj);
+  gold_assert(p != top->object_infos_.end());
+  return p->second;
+}
+
+// Return the final value of a symbol.
+
+static uint64_t
+mapfile_symbol_value(const Symbol* sym)
+{
+  if (parameters->target().get_size() == 32)
+    return static_cast<const Sized_symbol<32>*>(sym)->value();
+  else
+    return static_cast<const Sized_symbol<64>*>(sym)->value();
+}
+
 // Print the symbols associated with an input section.
 
-template<int size, bool big_endian>
 void
-Mapfile::print_input_section_symbols(
-    const Sized_relobj_file<size, big_endian>* relobj,
-    unsigned int shndx)
+Mapfile::print_input_section_symbols(const Object_info* info,
+				     unsigned int shndx)
 {
-  unsigned int symcount = relobj->symbol_count();
-  for (unsigned int i = relobj->local_symbol_count(); i < symcount; ++i)
+  const int size = parameters->target().get_size();
+  unsigned int end = info->symbol_starts[shndx + 1];
+  for (unsigned int i = info->symbol_starts[shndx]; i < end; ++i)
     {
-      const Symbol* sym = relobj->global_symbol(i);
-      bool is_ordinary;
-      if (sym != NULL
-	  && sym->source() == Symbol::FROM_OBJECT
-	  && sym->object() == relobj
-	  && sym->shndx(&is_ordinary) == shndx
-	  && is_ordinary
-	  && sym->is_defined())
+      const Symbol* sym = info->symbols[i];
+      std::string name = sym->demangled_name();
+      unsigned long long value = mapfile_symbol_value(sym);
+      if (this->is_json_)
+	{
+	  if (i > info->symbol_starts[shndx])
+	    this->put(',');
+	  this->put("{\"name\":");
+	  this->put_json_string(name.c_str());
+	  this->print(",\"value\":%llu}", value);
+	}
+      else
 	{
-	  for (size_t i = 0; i < Mapfile::section_name_map_length; ++i)
-	    putc(' ', this->map_file_);
-	  const Sized_symbol<size>* ssym =
-	    static_cast<const Sized_symbol<size>*>(sym);
-	  fprintf(this->map_file_,
-		  "0x%0*llx                %s\n",
-		  size / 4,
-		  static_cast<unsigned long long>(ssym->value()),
-		  sym->demangled_name().c_str());
+	  this->buffer_.append(Mapfile::section_name_map_length, ' ');
+	  this->print("0x%0*llx                %s\n", size / 4, value,
+		      name.c_str());
 	}
     }
 }
@@ -235,12 +637,14 @@ Mapfile::print_input_section_symbols(
 void
 Mapfile::print_input_section(Relobj* relobj, unsigned int shndx)
 {
-  putc(' ', this->map_file_);
-
-  std::string name = relobj->section_name(shndx);
-  fprintf(this->map_file_, "%s", name.c_str());
+  this->print_input_section(relobj, this->object_info(relobj), shndx);
+}
 
-  this->advance_to_column(name.length() + 1, Mapfile::section_name_map_length);
+void
+Mapfile::print_input_section(Relobj* relobj, const Object_info* info,
+			     unsigned int shndx)
+{
+  const char* name = info->names.c_str() + info->name_offsets[shndx];
 
   Output_section* os;
   uint64_t addr;
@@ -257,62 +661,42 @@ Mapfile::print_input_section(Relobj* relobj, unsigned int shndx)
 	addr += os->address();
     }
 
-  char sizebuf[50];
-  section_size_type size;
-  if (!relobj->section_is_compressed(shndx, &size))
-    size = relobj->section_size(shndx);
-  snprintf(sizebuf, sizeof sizebuf, "0x%llx",
-	   static_cast<unsigned long long>(size));
+  unsigned long long size = info->sizes[shndx];
 
-  fprintf(this->map_file_, "0x%0*llx %10s %s\n",
-	  parameters->target().get_size() / 4,
-	  static_cast<unsigned long long>(addr), sizebuf,
-	  relobj->name().c_str());
-
-  if (os != NULL)
+  if (this->is_json_)
     {
-      switch (parameters->size_and_endianness())
+      this->start_json_element();
+      this->put("\"name\":");
+      this->put_json_string(name);
+      this->put(",\"file\":");
+      this->put_json_string(relobj->name().c_str());
+      this->print(",\"address\":%llu,\"size\":%llu",
+		  static_cast<unsigned long long>(addr), size);
+      if (os != NULL)
 	{
-#ifdef HAVE_TARGET_32_LITTLE
-	case Parameters::TARGET_32_LITTLE:
-	  {
-	    const Sized_relobj_file<32, false>* sized_relobj =
-	      static_cast<Sized_relobj_file<32, false>*>(relobj);
-	    this->print_input_section_symbols(sized_relobj, shndx);
-	  }
-	  break;
-#endif
-#ifdef HAVE_TARGET_32_BIG
-	case Parameters::TARGET_32_BIG:
-	  {
-	    const Sized_relobj_file<32, true>* sized_relobj =
-	      static_cast<Sized_relobj_file<32, true>*>(relobj);
-	    this->print_input_section_symbols(sized_relobj, shndx);
-	  }
-	  break;
-#endif
-#ifdef HAVE_TARGET_64_LITTLE
-	case Parameters::TARGET_64_LITTLE:
-	  {
-	    const Sized_relobj_file<64, false>* sized_relobj =
-	      static_cast<Sized_relobj_file<64, false>*>(relobj);
-	    this->print_input_section_symbols(sized_relobj, shndx);
-	  }
-	  break;
-#endif
-#ifdef HAVE_TARGET_64_BIG
-	case Parameters::TARGET_64_BIG:
-	  {
-	    const Sized_relobj_file<64, true>* sized_relobj =
-	      static_cast<Sized_relobj_file<64, true>*>(relobj);
-	    this->print_input_section_symbols(sized_relobj, shndx);
-	  }
-	  break;
-#endif
-	default:
-	  gold_unreachable();
+	  this->put(",\"symbols\":[");
+	  this->print_input_section_symbols(info, shndx);
+	  this->put(']');
 	}
+      this->put('}');
+      return;
     }
+
+  this->put(' ');
+  this->print("%s", name);
+
+  this->advance_to_column(strlen(name) + 1, Mapfile::section_name_map_length);
+
+  char sizebuf[50];
+  snprintf(sizebuf, sizeof sizebuf, "0x%llx", size);
+
+  this->print("0x%0*llx %10s %s\n",
+	      parameters->target().get_size() / 4,
+	      static_cast<unsigned long long>(addr), sizebuf,
+	      relobj->name().c_str());
+
+  if (os != NULL)
+    this->print_input_section_symbols(info, shndx);
 }
 
 // Print an Output_section_data.  This is printed to look like an
@@ -321,24 +705,33 @@ Mapfile::print_input_section(Relobj* relobj, unsigned int shndx)
 void
 Mapfile::print_output_data(const Output_data* od, const char* name)
 {
+  unsigned long long addr = (od->is_address_valid()
+			     ? static_cast<unsigned long long>(od->address())
+			     : 0);
+  unsigned long long size = od->current_data_size();
+
+  if (this->is_json_)
+    {
+      this->start_json_element();
+      this->put("\"name\":");
+      this->put_json_string(name);
+      this->print(",\"address\":%llu,\"size\":%llu}", addr, size);
+      return;
+    }
+
   this->print_memory_map_header();
 
-  putc(' ', this->map_file_);
+  this->put(' ');
 
-  fprintf(this->map_file_, "%s", name);
+  this->print("%s", name);
 
   this->advance_to_column(strlen(name) + 1, Mapfile::section_name_map_length);
 
   char sizebuf[50];
-  snprintf(sizebuf, sizeof sizebuf, "0x%llx",
-	   static_cast<unsigned long long>(od->current_data_size()));
-
-  fprintf(this->map_file_, "0x%0*llx %10s\n",
-	  parameters->target().get_size() / 4,
-	  (od->is_address_valid()
-	   ? static_cast<unsigned long long>(od->address())
-	   : 0),
-	  sizebuf);
+  snprintf(sizebuf, sizeof sizebuf, "0x%llx", size);
+
+  this->print("0x%0*llx %10s\n", parameters->target().get_size() / 4,
+	      addr, sizebuf);
 }
 
 // Print the discarded input sections.
@@ -352,30 +745,24 @@ Mapfile::print_discarded_sections(const Input_objects* input_objects)
        ++p)
     {
       Relobj* relobj = *p;
-      // Lock the object so we can read from it.  This is only called
-      // single-threaded from Layout_task_runner, so it is OK to lock.
-      // Unfortunately we have no way to pass in a Task token.
-      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-      Task_lock_obj<Object> tl(dummy_task, relobj);
-
-      unsigned int shnum = relobj->shnum();
-      for (unsigned int i = 0; i < shnum; ++i)
+      const Object_info* info = this->object_info(relobj);
+      for (std::vector<unsigned int>::const_iterator pd =
+	     info->discarded.begin();
+	   pd != info->discarded.end();
+	   ++pd)
 	{
-	  unsigned int sh_type = relobj->section_type(i);
-	  if ((sh_type == elfcpp::SHT_PROGBITS
-	       || sh_type == elfcpp::SHT_NOBITS
-	       || sh_type == elfcpp::SHT_GROUP)
-	      && !relobj->is_section_included(i))
+	  if (!printed_header)
 	    {
-	      if (!printed_header)
-		{
-		  fprintf(this->map_file_, _("\nDiscarded input sections\n\n"));
-		  printed_header = true;
-		}
-
-	      this->print_input_section(relobj, i);
+	      if (this->is_json_)
+		this->start_json_array("discarded_sections");
+	      else
+		this->print("%s", _("\nDiscarded input sections\n\n"));
+	      printed_header = true;
 	    }
+
+	  this->print_input_section(relobj, info, *pd);
 	}
+      this->write_buffer(Mapfile::buffer_size);
     }
 }
 
@@ -384,29 +771,167 @@ Mapfile::print_discarded_sections(const Input_objects* input_objects)
 void
 Mapfile::print_output_section(const Output_section* os)
 {
+  unsigned long long size = os->current_data_size();
+
+  if (this->is_json_)
+    {
+      this->start_json_element();
+      this->put("\"name\":");
+      this->put_json_string(os->name());
+      this->print(",\"address\":%llu,\"size\":%llu",
+		  static_cast<unsigned long long>(os->address()), size);
+      if (os->has_load_address())
+	this->print(",\"load_address\":%llu",
+		    static_cast<unsigned long long>(os->load_address()));
+      if (os->requires_postprocessing())
+	this->put(",\"before_compression\":true");
+      this->put(",\"inputs\":[");
+      this->json_in_output_section_ = true;
+      this->json_first_input_ = true;
+      return;
+    }
+
   this->print_memory_map_header();
 
-  fprintf(this->map_file_, "\n%s", os->name());
+  this->print("\n%s", os->name());
 
   this->advance_to_column(strlen(os->name()), Mapfile::section_name_map_length);
 
   char sizebuf[50];
-  snprintf(sizebuf, sizeof sizebuf, "0x%llx",
-	   static_cast<unsigned long long>(os->current_data_size()));
+  snprintf(sizebuf, sizeof sizebuf, "0x%llx", size);
 
-  fprintf(this->map_file_, "0x%0*llx %10s",
-	  parameters->target().get_size() / 4,
-	  static_cast<unsigned long long>(os->address()), sizebuf);
+  this->print("0x%0*llx %10s",
+	      parameters->target().get_size() / 4,
+	      static_cast<unsigned long long>(os->address()), sizebuf);
 
   if (os->has_load_address())
-    fprintf(this->map_file_, " load address 0x%-*llx",
-	    parameters->target().get_size() / 4,
-	    static_cast<unsigned long long>(os->load_address()));
+    this->print(" load address 0x%-*llx",
+		parameters->target().get_size() / 4,
+		static_cast<unsigned long long>(os->load_address()));
 
   if (os->requires_postprocessing())
-    fprintf(this->map_file_, " (before compression)");
+    this->print(" (before compression)");
+
+  this->put('\n');
+}
+
+// Finish printing an output section.
+
+void
+Mapfile::finish_output_section()
+{
+  if (this->is_json_)
+    {
+      gold_assert(this->json_in_output_section_);
+      this->put("]}");
+      this->json_in_output_section_ = false;
+    }
+}
+
+// Print a chunk of the memory map.
+
+void
+Mapfile::print_memory_map_chunk(const Memory_map_chunk* chunk)
+{
+  if (!chunk->od->is_section())
+    {
+      chunk->od->print_to_mapfile(this);
+      return;
+    }
+
+  const Output_section* os = static_cast<const Output_section*>(chunk->od);
+  if (chunk->first == 0)
+    this->print_output_section(os);
+  else
+    {
+      this->json_in_output_section_ = true;
+      this->json_first_input_ = false;
+    }
+  os->print_input_sections_to_mapfile(this, chunk->first, chunk->last);
+  if (chunk->last == os->mapfile_input_section_count())
+    this->finish_output_section();
+}
+
+// Print the memory map.  We split the output sections with many
+// input sections into chunks, and print the chunks into separate
+// buffers on several threads.  To limit the memory we use, we do
+// this for a batch of chunks at a time.
+
+void
+Mapfile::print_memory_map(const std::vector<const Output_data*>& output_data)
+{
+  if (this->is_json_)
+    this->start_json_array("memory_map");
+
+  const size_t chunk_input_sections = 1024;
+  std::vector<Memory_map_chunk> chunks;
+  for (std::vector<const Output_data*>::const_iterator p = output_data.begin();
+       p != output_data.end();
+       ++p)
+    {
+      Memory_map_chunk chunk;
+      chunk.od = *p;
+      chunk.first = 0;
+      chunk.last = 0;
+      if (!(*p)->is_section())
+	{
+	  chunks.push_back(chunk);
+	  continue;
+	}
+      const Output_section* os = static_cast<const Output_section*>(*p);
+      size_t count = os->mapfile_input_section_count();
+      do
+	{
+	  chunk.last = std::min(chunk.first + chunk_input_sections, count);
+	  chunks.push_back(chunk);
+	  chunk.first = chunk.last;
+	}
+      while (chunk.first < count);
+    }
 
-  putc('\n', this->map_file_);
+  unsigned int threads = Parallel_work::thread_count();
+  if (threads <= 1)
+    {
+      for (std::vector<Memory_map_chunk>::const_iterator p = chunks.begin();
+	   p != chunks.end();
+	   ++p)
+	{
+	  this->print_memory_map_chunk(&*p);
+	  this->write_buffer(Mapfile::buffer_size);
+	}
+      return;
+    }
+
+  const size_t batch_size = threads * 16;
+  std::vector<Mapfile*> maps(batch_size);
+  for (size_t start = 0; start < chunks.size(); start += batch_size)
+    {
+      size_t count = std::min(batch_size, chunks.size() - start);
+      for (size_t i = 0; i < count; ++i)
+	maps[i] = new Mapfile(this);
+      Memory_map_printer printer(&chunks[start], &maps[0]);
+      printer.run(count);
+
+      for (size_t i = 0; i < count; ++i)
+	{
+	  if (this->is_json_)
+	    {
+	      // Each chunk which starts an entry is a new element of
+	      // the memory map.
+	      if (chunks[start + i].first == 0)
+		{
+		  if (!this->json_first_element_)
+		    this->put(',');
+		  this->json_first_element_ = false;
+		}
+	    }
+	  else if (!maps[i]->buffer_.empty())
+	    this->print_memory_map_header();
+	  this->put(maps[i]->buffer_);
+	  delete maps[i];
+	  this->write_buffer(Mapfile::buffer_size);
+	}
+    }
 }
 
 } // End namespace gold.
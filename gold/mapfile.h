@@ -25,6 +25,7 @@
 
 #include <cstdio>
 #include <string>
+#include <vector>
 
 namespace gold
 {
@@ -32,12 +33,14 @@ namespace gold
 class Archive;
 class Symbol;
 class Relobj;
-template<int size, bool big_endian>
-class Sized_relobj_file;
+class Input_objects;
 class Output_section;
 class Output_data;
 
-// This class manages map file output.
+// This class manages map file output.  The output is collected in a
+// buffer and written out in large blocks.  The map may be written as
+// text, in the format used by GNU ld, or as JSON for tools; this is
+// controlled by --map-format.
 
 class Mapfile
 {
@@ -54,10 +57,25 @@ class Mapfile
   void
   close();
 
-  // Return the underlying file.
+  // Return the underlying file.  This writes out any buffered
+  // output, so that the caller may write to the file directly.
   FILE*
-  file()
-  { return this->map_file_; }
+  file();
+
+  // Return whether we are writing a JSON map.
+  bool
+  is_json() const
+  { return this->is_json_; }
+
+  // Return the file to which to write the cross reference table.
+  // For a JSON map this first starts the "cross_references" array,
+  // and the caller writes its elements.
+  FILE*
+  cref_file();
+
+  // Append S to *OUT as a quoted JSON string.
+  static void
+  append_json_string(const char* s, std::string* out);
 
   // Report that we are including a member from an archive.  This is
   // called by the archive reading code.
@@ -69,14 +87,31 @@ class Mapfile
   void
   report_allocate_common(const Symbol*, uint64_t symsize);
 
+  // Read the names and sizes of the input sections, and the symbols
+  // defined in them, from the input objects.  This is done on several
+  // threads.  It must be called before printing any input sections.
+  void
+  collect_input_sections(const Input_objects*);
+
   // Print discarded input sections.
   void
   print_discarded_sections(const Input_objects*);
 
-  // Print an output section.
+  // Print the memory map.  OUTPUT_DATA is the list of output sections
+  // and data in address order.  The entries are formatted on several
+  // threads.
+  void
+  print_memory_map(const std::vector<const Output_data*>& output_data);
+
+  // Print an output section.  This is followed by the input sections
+  // and then by a call to finish_output_section.
   void
   print_output_section(const Output_section*);
 
+  // Finish printing an output section.
+  void
+  finish_output_section();
+
   // Print an input section.
   void
   print_input_section(Relobj*, unsigned int shndx);
@@ -86,9 +121,59 @@ class Mapfile
   print_output_data(const Output_data*, const char* name);
 
  private:
+  struct Object_info;
+  class Object_info_collector;
+  struct Memory_map_chunk;
+  class Memory_map_printer;
+
+  // Map from an input object to the information we collected.
+  typedef Unordered_map<const Relobj*, Object_info*> Object_infos;
+
+  // Make a map file which only collects output in its buffer.  This
+  // is used to print part of the memory map of PARENT.
+  explicit Mapfile(const Mapfile* parent);
+
+  // This class can not be copied.
+  Mapfile(const Mapfile&);
+  Mapfile& operator=(const Mapfile&);
+
   // The space we allow for a section name.
   static const size_t section_name_map_length;
 
+  // The amount of output we buffer before writing it out.
+  static const size_t buffer_size;
+
+  // Add formatted text to the buffer.
+  void
+  print(const char* format, ...) ATTRIBUTE_PRINTF_2;
+
+  // Add a character to the buffer.
+  void
+  put(char c)
+  { this->buffer_ += c; }
+
+  // Add a string to the buffer.
+  void
+  put(const std::string& s)
+  { this->buffer_ += s; }
+
+  // Add a string to the buffer as a quoted JSON string.
+  void
+  put_json_string(const char* s)
+  { Mapfile::append_json_string(s, &this->buffer_); }
+
+  // Start a JSON object which is an element of the current array.
+  void
+  start_json_element();
+
+  // Start the JSON array named KEY, unless it is already current.
+  void
+  start_json_array(const char* key);
+
+  // Write out the buffered output if there are at least MIN bytes.
+  void
+  write_buffer(size_t min);
+
   // Advance to a column.
   void
   advance_to_column(size_t from, size_t to);
@@ -97,14 +182,44 @@ class Mapfile
   void
   print_memory_map_header();
 
+  // Print a chunk of the memory map.
+  void
+  print_memory_map_chunk(const Memory_map_chunk*);
+
+  // Return the information collected for RELOBJ.
+  const Object_info*
+  object_info(const Relobj* relobj) const;
+
+  // Print an input section, given the information for its object.
+  void
+  print_input_section(Relobj*, const Object_info*, unsigned int shndx);
+
   // Print symbols for an input section.
-  template<int size, bool big_endian>
   void
-  print_input_section_symbols(const Sized_relobj_file<size, big_endian>*,
-			      unsigned int shndx);
+  print_input_section_symbols(const Object_info*, unsigned int shndx);
 
-  // Map file to write to.
+  // Map file to write to.  This is NULL if we are only collecting
+  // output for a parent.
   FILE* map_file_;
+  // The parent, when printing part of the memory map.
+  const Mapfile* parent_;
+  // Whether we are writing JSON.
+  bool is_json_;
+  // The buffered output.
+  std::string buffer_;
+  // The information collected from the input objects.
+  Object_infos object_infos_;
+  // The name of the current JSON array, or NULL if none.
+  const char* json_array_;
+  // Whether we have not yet printed any element of the current JSON
+  // array.
+  bool json_first_element_;
+  // Whether we are printing the input sections of an output section
+  // in JSON.
+  bool json_in_output_section_;
+  // Whether we have not yet printed any input section of the current
+  // output section in JSON.
+  bool json_first_input_;
   // Whether we have printed the archive member header.
   bool printed_archive_header_;
   // Whether we have printed the allocated common header.
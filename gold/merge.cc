@@ -97,6 +97,14 @@ void
 Object_merge_map::Input_merge_map::add_mapping(
     section_offset_type input_offset, section_size_type length,
     section_offset_type output_offset) {
+  // Any index is now out of date.  Mappings are only added in serial
+  // phases of the link, so nothing can be using it.
+  if (this->indexed)
+    {
+      this->index.clear();
+      this->indexed = false;
+    }
+
   // Try to merge the new entry in the last one we saw.
   if (!this->entries.empty())
     {
@@ -132,36 +140,139 @@ Object_merge_map::Input_merge_map::add_mapping(
   this->entries.push_back(entry);
 }
 
-// Get the output offset for an input address.
+// Sort the entries and build the index.  We pick the block size so
+// that there are no more blocks than entries, which makes the index
+// small compared to the entries.  Usually only one or two entries
+// start in each block, so a lookup is an index operation followed by
+// a very short scan.
 
-bool
-Object_merge_map::get_output_offset(unsigned int shndx,
-				    section_offset_type input_offset,
-				    section_offset_type* output_offset)
+void
+Object_merge_map::Input_merge_map::build_index()
 {
-  Input_merge_map* map = this->get_input_merge_map(shndx);
-  if (map == NULL)
-    return false;
+  if (this->indexed)
+    return;
+  this->indexed = true;
 
-  if (!map->sorted)
+  if (!this->sorted)
     {
-      std::sort(map->entries.begin(), map->entries.end(),
+      std::sort(this->entries.begin(), this->entries.end(),
 		Input_merge_compare());
-      map->sorted = true;
+      this->sorted = true;
     }
 
-  Input_merge_entry entry;
-  entry.input_offset = input_offset;
-  std::vector<Input_merge_entry>::const_iterator p =
-    std::upper_bound(map->entries.begin(), map->entries.end(),
-		     entry, Input_merge_compare());
-  if (p == map->entries.begin())
-    return false;
+  size_t count = this->entries.size();
+  if (count == 0 || count >= 0xffffffffU)
+    return;
+
+  const Input_merge_entry& last(this->entries.back());
+  uint64_t end = last.input_offset + last.length;
+  unsigned int shift = 0;
+  while ((end >> shift) >= count)
+    ++shift;
+  this->index_shift = shift;
+
+  size_t blocks = (end >> shift) + 1;
+  this->index.resize(blocks + 1);
+  size_t e = 0;
+  for (size_t b = 0; b <= blocks; ++b)
+    {
+      uint64_t start = static_cast<uint64_t>(b) << shift;
+      while (e < count
+	     && (static_cast<uint64_t>(this->entries[e].input_offset)
+		 + this->entries[e].length) <= start)
+	++e;
+      this->index[b] = e;
+    }
+}
+
+// Return the entry which holds INPUT_OFFSET, or NULL if there is
+// none.  The map does not change here, so this may be called from
+// several threads at once.
+
+const Object_merge_map::Input_merge_entry*
+Object_merge_map::Input_merge_map::find_entry(
+    section_offset_type input_offset) const
+{
+  gold_assert(this->indexed);
+
+  Entries::const_iterator p;
+  if (!this->index.empty())
+    {
+      if (input_offset < 0)
+	return NULL;
+      size_t b = static_cast<uint64_t>(input_offset) >> this->index_shift;
+      if (b + 1 >= this->index.size())
+	return NULL;
+
+      // The entry holding INPUT_OFFSET is the last one which starts
+      // at or before it.  Entries before INDEX[B] end before block B,
+      // and the entry at INDEX[B + 1] may start in block B.
+      Entries::const_iterator lo = this->entries.begin() + this->index[b];
+      Entries::const_iterator hi =
+	this->entries.begin() + std::min(static_cast<size_t>(this->index[b + 1])
+					 + 1,
+					 this->entries.size());
+      if (hi - lo <= 8)
+	{
+	  p = lo;
+	  while (p != hi && p->input_offset <= input_offset)
+	    ++p;
+	}
+      else
+	{
+	  Input_merge_entry entry;
+	  entry.input_offset = input_offset;
+	  p = std::upper_bound(lo, hi, entry, Input_merge_compare());
+	}
+      if (p == lo)
+	return NULL;
+    }
+  else
+    {
+      if (this->entries.empty())
+	return NULL;
+      Input_merge_entry entry;
+      entry.input_offset = input_offset;
+      p = std::upper_bound(this->entries.begin(), this->entries.end(),
+			   entry, Input_merge_compare());
+      if (p == this->entries.begin())
+	return NULL;
+    }
   --p;
   gold_assert(p->input_offset <= input_offset);
 
   if (input_offset - p->input_offset
       >= static_cast<section_offset_type>(p->length))
+    return NULL;
+  return &*p;
+}
+
+// Get the output offset for an input address.
+
+bool
+Object_merge_map::get_output_offset(unsigned int shndx,
+				    section_offset_type input_offset,
+				    section_offset_type* output_offset) const
+{
+  const Input_merge_map* map = this->get_input_merge_map(shndx);
+  if (map == NULL)
+    return false;
+
+  if (map->entsize != 0)
+    {
+      if (input_offset < 0)
+	return false;
+      section_size_type i = input_offset / map->entsize;
+      if (i >= map->constants.size())
+	return false;
+      *output_offset = (static_cast<section_offset_type>(map->constants[i])
+			* map->output_entsize
+			+ input_offset % map->entsize);
+      return true;
+    }
+
+  const Input_merge_entry* p = map->find_entry(input_offset);
+  if (p == NULL)
     return false;
 
   *output_offset = p->output_offset;
@@ -170,6 +281,16 @@ Object_merge_map::get_output_offset(unsigned int shndx,
   return true;
 }
 
+// Build the index for section SHNDX, if it has a merge map.
+
+void
+Object_merge_map::build_index(unsigned int shndx)
+{
+  Input_merge_map* map = this->get_input_merge_map(shndx);
+  if (map != NULL)
+    map->build_index();
+}
+
 // Return whether this is the merge map for section SHNDX.
 
 const Output_section_data*
@@ -181,45 +302,6 @@ Object_merge_map::find_merge_section(unsigned int shndx) const {
   return map->output_data;
 }
 
-// Initialize a mapping from input offsets to output addresses.
-
-template<int size>
-void
-Object_merge_map::initialize_input_to_output_map(
-    unsigned int shndx,
-    typename elfcpp::Elf_types<size>::Elf_Addr starting_address,
-    Unordered_map<section_offset_type,
-		  typename elfcpp::Elf_types<size>::Elf_Addr>* initialize_map)
-{
-  Input_merge_map* map = this->get_input_merge_map(shndx);
-  gold_assert(map != NULL);
-
-  gold_assert(initialize_map->empty());
-  // We know how many entries we are going to add.
-  // reserve_unordered_map takes an expected count of buckets, not a
-  // count of elements, so double it to try to reduce collisions.
-  reserve_unordered_map(initialize_map, map->entries.size() * 2);
-
-  for (Input_merge_map::Entries::const_iterator p = map->entries.begin();
-       p != map->entries.end();
-       ++p)
-    {
-      section_offset_type output_offset = p->output_offset;
-      if (output_offset != -1)
-	output_offset += starting_address;
-      else
-	{
-	  // If we see a relocation against an address we have chosen
-	  // to discard, we relocate to zero.  FIXME: We could also
-	  // issue a warning in this case; that would require
-	  // reporting this somehow and checking it in the routines in
-	  // reloc.h.
-	  output_offset = 0;
-	}
-      initialize_map->insert(std::make_pair(p->input_offset, output_offset));
-    }
-}
-
 // Class Output_merge_base.
 
 // Return the output offset for an input offset.  The input address is
@@ -260,11 +342,9 @@ Output_merge_base::record_input_section(Relobj* relobj, unsigned int shndx)
 // Compute the hash code for a fixed-size constant.
 
 size_t
-Output_merge_data::Merge_data_hash::operator()(Merge_data_key k) const
+Output_merge_data::hash_constant(const unsigned char* p) const
 {
-  const unsigned char* p = this->pomd_->constant(k);
-  section_size_type entsize =
-    convert_to_section_size_type(this->pomd_->entsize());
+  section_size_type entsize = convert_to_section_size_type(this->entsize());
 
   // Fowler/Noll/Vo (FNV) hash (type FNV-1a).
   if (sizeof(size_t) == 8)
@@ -272,7 +352,7 @@ Output_merge_data::Merge_data_hash::operator()(Merge_data_key k) const
       size_t result = static_cast<size_t>(14695981039346656037ULL);
       for (section_size_type i = 0; i < entsize; ++i)
 	{
-	  result &= (size_t) *p++;
+	  result ^= (size_t) *p++;
 	  result *= 1099511628211ULL;
 	}
       return result;
@@ -289,36 +369,97 @@ Output_merge_data::Merge_data_hash::operator()(Merge_data_key k) const
     }
 }
 
-// Return whether one hash table key equals another.
-
-bool
-Output_merge_data::Merge_data_eq::operator()(Merge_data_key k1,
-					     Merge_data_key k2) const
-{
-  const unsigned char* p1 = this->pomd_->constant(k1);
-  const unsigned char* p2 = this->pomd_->constant(k2);
-  return memcmp(p1, p2, this->pomd_->entsize()) == 0;
-}
-
-// Add a constant to the end of the section contents.
+// Make room for COUNT more constants.  The hash table is kept at
+// most half full, and is only resized here, so that it does not
+// change while we add the constants of an input section.
 
 void
-Output_merge_data::add_constant(const unsigned char* p)
+Output_merge_data::reserve_constants(size_t count)
 {
+  size_t needed = (this->hashtable_count_ + count) * 2;
+  if (needed > this->hashtable_.size())
+    {
+      size_t buckets = std::max(this->hashtable_.size(),
+				static_cast<size_t>(128));
+      while (buckets < needed)
+	buckets *= 2;
+
+      Merge_data_entry empty;
+      empty.hash = 0;
+      empty.offset = -1;
+      Merge_data_hashtable table(buckets, empty);
+      size_t mask = buckets - 1;
+      for (Merge_data_hashtable::const_iterator p = this->hashtable_.begin();
+	   p != this->hashtable_.end();
+	   ++p)
+	{
+	  if (p->offset == -1)
+	    continue;
+	  size_t i = p->hash & mask;
+	  while (table[i].offset != -1)
+	    i = (i + 1) & mask;
+	  table[i] = *p;
+	}
+      this->hashtable_.swap(table);
+    }
+
   section_size_type entsize = convert_to_section_size_type(this->entsize());
   section_size_type addralign =
     convert_to_section_size_type(this->addralign());
   section_size_type addsize = std::max(entsize, addralign);
-  if (this->len_ + addsize > this->alc_)
+  section_size_type len = this->len_ + count * addsize;
+  if (len > this->alc_)
     {
       if (this->alc_ == 0)
 	this->alc_ = 128 * addsize;
-      else
+      while (this->alc_ < len)
 	this->alc_ *= 2;
       this->p_ = static_cast<unsigned char*>(realloc(this->p_, this->alc_));
       if (this->p_ == NULL)
 	gold_nomem();
     }
+}
+
+// Return the offset of the constant at P in the section contents,
+// adding it if this is the first time we have seen it.  The caller
+// must have called reserve_constants.
+
+section_offset_type
+Output_merge_data::find_or_add_constant(const unsigned char* p)
+{
+  size_t entsize = this->entsize();
+  size_t hash = this->hash_constant(p);
+  size_t mask = this->hashtable_.size() - 1;
+  size_t i = hash & mask;
+  while (true)
+    {
+      Merge_data_entry* entry = &this->hashtable_[i];
+      if (entry->offset == -1)
+	{
+	  entry->hash = hash;
+	  entry->offset = this->len_;
+	  ++this->hashtable_count_;
+	  this->add_constant(p);
+	  return entry->offset;
+	}
+      if (entry->hash == hash
+	  && memcmp(this->p_ + entry->offset, p, entsize) == 0)
+	return entry->offset;
+      i = (i + 1) & mask;
+    }
+}
+
+// Add a constant to the end of the section contents.  The caller
+// must have called reserve_constants.
+
+void
+Output_merge_data::add_constant(const unsigned char* p)
+{
+  section_size_type entsize = convert_to_section_size_type(this->entsize());
+  section_size_type addralign =
+    convert_to_section_size_type(this->addralign());
+  section_size_type addsize = std::max(entsize, addralign);
+  gold_assert(this->len_ + addsize <= this->alc_);
 
   memcpy(this->p_ + this->len_, p, entsize);
   if (addsize > entsize)
@@ -348,32 +489,37 @@ Output_merge_data::do_add_input_section(Relobj* object, unsigned int shndx)
       return false;
     }
 
-  this->input_count_ += len / entsize;
+  size_t count = len / entsize;
+  this->input_count_ += count;
+  this->reserve_constants(count);
 
   Object_merge_map* merge_map = object->get_or_create_merge_map();
   Object_merge_map::Input_merge_map* input_merge_map =
     merge_map->get_or_make_input_merge_map(this, shndx);
 
-  for (section_size_type i = 0; i < len; i += entsize, p += entsize)
+  // Each constant takes ADDSIZE bytes in the output, so we can record
+  // the offset of each one as an index.  We only need the general
+  // list of mappings if there might be too many constants for that.
+  section_size_type addsize =
+    std::max(entsize, convert_to_section_size_type(this->addralign()));
+  bool use_index = (this->len_ / addsize + count
+		    <= static_cast<uint64_t>(0xffffffffU));
+  if (use_index)
+    input_merge_map->set_constants(entsize, addsize, count);
+
+  const unsigned char* pc = p;
+  for (section_size_type i = 0; i < len; i += entsize, pc += entsize)
     {
-      // Add the constant to the section contents.  If we find that it
-      // is already in the hash table, we will remove it again.
-      Merge_data_key k = this->len_;
-      this->add_constant(p);
-
-      std::pair<Merge_data_hashtable::iterator, bool> ins =
-	this->hashtable_.insert(k);
-
-      if (!ins.second)
-	{
-	  // Key was already present.  Remove the copy we just added.
-	  this->len_ -= entsize;
-	  k = *ins.first;
-	}
+      section_offset_type k = this->find_or_add_constant(pc);
 
       // Record the offset of this constant in the output section.
-      input_merge_map->add_mapping(i, entsize, k);
+      if (use_index)
+	input_merge_map->constants.push_back(k / addsize);
+      else
+	input_merge_map->add_mapping(i, entsize, k);
     }
+  if (!use_index)
+    input_merge_map->build_index();
 
   // For script processing, we keep the input sections.
   if (this->keeps_input_sections())
@@ -393,10 +539,13 @@ Output_merge_data::set_final_data_size()
 {
   // Release the memory we don't need.
   this->p_ = static_cast<unsigned char*>(realloc(this->p_, this->len_));
+  this->alc_ = this->len_;
   // An Output_merge_data object may be empty and realloc is allowed
   // to return a NULL pointer in this case.  An Output_merge_data is empty
   // if all its input sections have sizes that are not multiples of entsize.
   gold_assert(this->p_ != NULL || this->len_ == 0);
+  // We are done adding constants.
+  Merge_data_hashtable().swap(this->hashtable_);
   this->set_data_size(this->len_);
 }
 
@@ -426,7 +575,7 @@ Output_merge_data::do_print_merge_stats(const char* section_name)
 	  _("%s: %s merged constants size: %lu; input: %zu; output: %zu\n"),
 	  program_name, section_name,
 	  static_cast<unsigned long>(this->entsize()),
-	  this->input_count_, this->hashtable_.size());
+	  this->input_count_, this->hashtable_count_);
 }
 
 // Class Output_merge_string.
@@ -573,6 +722,7 @@ Output_merge_string<Char_type>::finalize_merged_data()
 	    last_output_offset =
 	        this->stringpool_.get_offset_from_key(p->stringpool_key);
 	}
+      input_merge_map->build_index();
       delete *l;
     }
 
@@ -668,22 +818,4 @@ class Output_merge_string<uint16_t>;
 template
 class Output_merge_string<uint32_t>;
 
-#if defined(HAVE_TARGET_32_LITTLE) || defined(HAVE_TARGET_32_BIG)
-template
-void
-Object_merge_map::initialize_input_to_output_map<32>(
-    unsigned int shndx,
-    elfcpp::Elf_types<32>::Elf_Addr starting_address,
-    Unordered_map<section_offset_type, elfcpp::Elf_types<32>::Elf_Addr>*);
-#endif
-
-#if defined(HAVE_TARGET_64_LITTLE) || defined(HAVE_TARGET_64_BIG)
-template
-void
-Object_merge_map::initialize_input_to_output_map<64>(
-    unsigned int shndx,
-    elfcpp::Elf_types<64>::Elf_Addr starting_address,
-    Unordered_map<section_offset_type, elfcpp::Elf_types<64>::Elf_Addr>*);
-#endif
-
 } // End namespace gold.
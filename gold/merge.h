@@ -67,22 +67,18 @@ class Object_merge_map
   bool
   get_output_offset(unsigned int shndx,
 		    section_offset_type offset,
-		    section_offset_type* output_offset);
+		    section_offset_type* output_offset) const;
+
+  // Build the index for the input section SHNDX.  This must be
+  // called after adding mappings for the section, and before any call
+  // to get_output_offset for it, which may then be made from several
+  // threads at once.
+  void
+  build_index(unsigned int shndx);
 
   const Output_section_data*
   find_merge_section(unsigned int shndx) const;
 
-  // Initialize an mapping from input offsets to output addresses for
-  // section SHNDX.  STARTING_ADDRESS is the output address of the
-  // merged section.
-  template<int size>
-  void
-  initialize_input_to_output_map(
-      unsigned int shndx,
-      typename elfcpp::Elf_types<size>::Elf_Addr starting_address,
-      Unordered_map<section_offset_type,
-		    typename elfcpp::Elf_types<size>::Elf_Addr>*);
-
   // Map input section offsets to a length and an output section
   // offset.  An output section offset of -1 means that this part of
   // the input section is being discarded.
@@ -128,10 +124,58 @@ class Object_merge_map
     Entries entries;
     // Whether the ENTRIES field is sorted by input_offset.
     bool sorted;
+    // For a section of fixed size constants, the size of each
+    // constant, or 0 if ENTRIES is used instead of CONSTANTS.
+    section_size_type entsize;
+    // For a section of fixed size constants, the distance between
+    // constants in the output.
+    section_size_type output_entsize;
+    // For a section of fixed size constants, the output offset of
+    // each constant in turn, divided by OUTPUT_ENTSIZE.  This takes
+    // much less memory than ENTRIES, and needs no search.
+    std::vector<uint32_t> constants;
+    // An index into ENTRIES, so that we can find the entry for an
+    // input offset without searching the whole list.  The input
+    // section is divided into blocks of 1 << INDEX_SHIFT bytes, and
+    // element I is the first entry which ends after the start of
+    // block I.  There is one more element than there are blocks.
+    // This is empty until build_index is called, and stays empty if
+    // there are too many entries to index.
+    std::vector<uint32_t> index;
+    // The log of the size of a block for INDEX.
+    unsigned int index_shift;
+    // Whether build_index has been called since the last mapping was
+    // added.
+    bool indexed;
 
     Input_merge_map()
-      : output_data(NULL), entries(), sorted(true)
+      : output_data(NULL), entries(), sorted(true), entsize(0),
+	output_entsize(0), constants(), index(), index_shift(0),
+	indexed(false)
     { }
+
+    // Sort ENTRIES and build INDEX.  This is called when all the
+    // mappings are known.
+    void
+    build_index();
+
+    // Return the entry which holds INPUT_OFFSET, or NULL.  This may
+    // only be called after build_index.
+    const Input_merge_entry*
+    find_entry(section_offset_type input_offset) const;
+
+    // Record that the section holds COUNT constants of size ENTSIZE,
+    // spaced OUTPUT_ENTSIZE bytes apart in the output.  The caller
+    // then fills in CONSTANTS.
+    void
+    set_constants(section_size_type entsize, section_size_type output_entsize,
+		  size_t count)
+    {
+      gold_assert(this->entries.empty() && this->constants.empty());
+      this->entsize = entsize;
+      this->output_entsize = output_entsize;
+      this->constants.reserve(count);
+    }
   };
 
   // Get or make the Input_merge_map to use for the section SHNDX
@@ -279,8 +323,7 @@ class Output_merge_data : public Output_merge_base
  public:
   Output_merge_data(uint64_t entsize, uint64_t addralign)
     : Output_merge_base(entsize, addralign), p_(NULL), len_(0), alc_(0),
-      input_count_(0),
-      hashtable_(128, Merge_data_hash(this), Merge_data_eq(this))
+      input_count_(0), hashtable_(), hashtable_count_(0)
   { }
 
  protected:
@@ -318,64 +361,36 @@ class Output_merge_data : public Output_merge_base
   }
 
  private:
-  // We build a hash table of the fixed-size constants.  Each constant
-  // is stored as a pointer into the section data we are accumulating.
-
-  // A key in the hash table.  This is an offset in the section
-  // contents we are building.
-  typedef section_offset_type Merge_data_key;
-
-  // Compute the hash code.  To do this we need a pointer back to the
-  // object holding the data.
-  class Merge_data_hash
+  // We build a hash table of the fixed-size constants.  This is an
+  // open addressing table with linear probing, whose size is a power
+  // of two.  Each entry holds the hash code of a constant and the
+  // offset of the constant in the section data we are accumulating,
+  // so that lookups only look at the data when the hash codes match.
+  struct Merge_data_entry
   {
-   public:
-    Merge_data_hash(const Output_merge_data* pomd)
-      : pomd_(pomd)
-    { }
-
-    size_t
-    operator()(Merge_data_key) const;
-
-   private:
-    const Output_merge_data* pomd_;
+    // The hash code.
+    size_t hash;
+    // The offset in the section contents, or -1 if the entry is
+    // empty.
+    section_offset_type offset;
   };
 
-  friend class Merge_data_hash;
-
-  // Compare two entries in the hash table for equality.  To do this
-  // we need a pointer back to the object holding the data.  Note that
-  // we now have a pointer to the object stored in two places in the
-  // hash table.  Fixing this would require specializing the hash
-  // table, which would be hard to do portably.
-  class Merge_data_eq
-  {
-   public:
-    Merge_data_eq(const Output_merge_data* pomd)
-      : pomd_(pomd)
-    { }
-
-    bool
-    operator()(Merge_data_key k1, Merge_data_key k2) const;
-
-   private:
-    const Output_merge_data* pomd_;
-  };
+  // The type of the hash table.
+  typedef std::vector<Merge_data_entry> Merge_data_hashtable;
 
-  friend class Merge_data_eq;
+  // Compute the hash code of a constant.
+  size_t
+  hash_constant(const unsigned char*) const;
 
-  // The type of the hash table.
-  typedef Unordered_set<Merge_data_key, Merge_data_hash, Merge_data_eq>
-    Merge_data_hashtable;
+  // Make room for COUNT more constants in the hash table and in the
+  // section contents.
+  void
+  reserve_constants(size_t count);
 
-  // Given a hash table key, which is just an offset into the section
-  // data, return a pointer to the corresponding constant.
-  const unsigned char*
-  constant(Merge_data_key k) const
-  {
-    gold_assert(k >= 0 && k < static_cast<section_offset_type>(this->len_));
-    return this->p_ + k;
-  }
+  // Return the offset in the section contents of the constant at P,
+  // adding it if it has not been seen before.
+  section_offset_type
+  find_or_add_constant(const unsigned char* p);
 
   // Add a constant to the output.
   void
@@ -391,6 +406,8 @@ class Output_merge_data : public Output_merge_base
   size_t input_count_;
   // The hash table.
   Merge_data_hashtable hashtable_;
+  // The number of constants in the hash table.
+  size_t hashtable_count_;
 };
 
 // Handle SHF_MERGE sections with string data.  This is a template
@@ -42,6 +42,7 @@
 #include "compressed_output.h"
 #include "incremental.h"
 #include "merge.h"
+#include "ehframe.h"
 
 namespace gold
 {
@@ -269,17 +270,6 @@ Object::handle_split_stack_section(const char* name)
 
 // Class Relobj
 
-template<int size>
-void
-Relobj::initialize_input_to_output_map(unsigned int shndx,
-	  typename elfcpp::Elf_types<size>::Elf_Addr starting_address,
-	  Unordered_map<section_offset_type,
-	  typename elfcpp::Elf_types<size>::Elf_Addr>* output_addresses) const {
-  Object_merge_map *map = this->object_merge_map_;
-  map->initialize_input_to_output_map<size>(shndx, starting_address,
-					    output_addresses);
-}
-
 void
 Relobj::add_merge_mapping(Output_section_data *output_data,
                           unsigned int shndx, section_offset_type offset,
@@ -298,6 +288,13 @@ Relobj::merge_output_offset(unsigned int shndx, section_offset_type offset,
   return object_merge_map->get_output_offset(shndx, offset, poutput);
 }
 
+void
+Relobj::index_merge_map(unsigned int shndx)
+{
+  if (this->object_merge_map_ != NULL)
+    this->object_merge_map_->build_index(shndx);
+}
+
 const Output_section_data*
 Relobj::find_merge_section(unsigned int shndx) const {
   Object_merge_map* object_merge_map = this->object_merge_map_;
@@ -477,6 +474,7 @@ Sized_relobj_file<size, big_endian>::Sized_relobj_file(
     kept_comdat_sections_(),
     has_eh_frame_(false),
     discarded_eh_frame_shndx_(-1U),
+    parsed_eh_frame_sections_(),
     is_deferred_layout_(false),
     deferred_layout_(),
     deferred_layout_relocs_(),
@@ -488,6 +486,11 @@ Sized_relobj_file<size, big_endian>::Sized_relobj_file(
 template<int size, bool big_endian>
 Sized_relobj_file<size, big_endian>::~Sized_relobj_file()
 {
+  for (typename std::vector<Parsed_eh_frame_section*>::iterator p =
+	 this->parsed_eh_frame_sections_.begin();
+       p != this->parsed_eh_frame_sections_.end();
+       ++p)
+    delete *p;
 }
 
 // Set up an object file based on the file header.  This sets up the
@@ -918,6 +921,112 @@ Sized_relobj_file<size, big_endian>::base_read_symbols(Read_symbols_data* sd)
   sd->symbol_names = fvstrtab;
   sd->symbol_names_size =
     convert_to_section_size_type(strtabshdr.get_sh_size());
+
+  if (this->has_eh_frame_)
+    this->parse_eh_frame_sections(sd);
+}
+
+// Parse the .eh_frame sections of this object.  Reading the CIEs and
+// FDEs only requires the object itself, so we do it here, when the
+// symbols of different objects are read in parallel.  The results
+// are merged into the output .eh_frame data, discarding duplicate
+// CIEs, when the sections are laid out.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::parse_eh_frame_sections(
+    Read_symbols_data* sd)
+{
+  // We only optimize .eh_frame sections in a normal link.  See
+  // Layout::layout_eh_frame.
+  if (parameters->options().relocatable()
+      || parameters->incremental()
+      || sd->symbols == NULL
+      || sd->external_symbols_offset != 0)
+    return;
+
+  const unsigned int shnum = this->shnum();
+  const unsigned char* const shdrs = sd->section_headers->data();
+  const char* const names =
+    reinterpret_cast<const char*>(sd->section_names->data());
+  const section_size_type names_size = sd->section_names_size;
+
+  std::vector<unsigned int> eh_frame_shndx;
+  const unsigned char* pshdrs = shdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, pshdrs += This::shdr_size)
+    {
+      typename This::Shdr shdr(pshdrs);
+      if (shdr.get_sh_name() < names_size
+	  && strcmp(names + shdr.get_sh_name(), ".eh_frame") == 0
+	  && this->check_eh_frame_flags(&shdr))
+	eh_frame_shndx.push_back(i);
+    }
+  if (eh_frame_shndx.empty())
+    return;
+
+  // Find the reloc sections, as in do_layout.  Use 0 to mean that
+  // there is no reloc section, -1U to mean that there is more than
+  // one.
+  std::vector<unsigned int> reloc_shndx(eh_frame_shndx.size(), 0);
+  std::vector<unsigned int> reloc_type(eh_frame_shndx.size(),
+				       elfcpp::SHT_NULL);
+  pshdrs = shdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, pshdrs += This::shdr_size)
+    {
+      typename This::Shdr shdr(pshdrs);
+      unsigned int sh_type = shdr.get_sh_type();
+      if (sh_type != elfcpp::SHT_REL && sh_type != elfcpp::SHT_RELA)
+	continue;
+      unsigned int target_shndx = this->adjust_shndx(shdr.get_sh_info());
+      for (size_t j = 0; j < eh_frame_shndx.size(); ++j)
+	{
+	  if (eh_frame_shndx[j] != target_shndx)
+	    continue;
+	  if (reloc_shndx[j] != 0)
+	    reloc_shndx[j] = -1U;
+	  else
+	    {
+	      reloc_shndx[j] = i;
+	      reloc_type[j] = sh_type;
+	    }
+	}
+    }
+
+  for (size_t j = 0; j < eh_frame_shndx.size(); ++j)
+    {
+      Parsed_eh_frame_section* parsed =
+	Eh_frame::parse_ehframe_input_section(this,
+					      sd->symbols->data(),
+					      sd->symbols_size,
+					      sd->symbol_names->data(),
+					      sd->symbol_names_size,
+					      eh_frame_shndx[j],
+					      reloc_shndx[j],
+					      reloc_type[j]);
+      this->parsed_eh_frame_sections_.push_back(parsed);
+    }
+}
+
+// Return the parsed contents of .eh_frame section SHNDX, if any.
+
+template<int size, bool big_endian>
+Parsed_eh_frame_section*
+Sized_relobj_file<size, big_endian>::release_parsed_eh_frame_section(
+    unsigned int shndx)
+{
+  for (typename std::vector<Parsed_eh_frame_section*>::iterator p =
+	 this->parsed_eh_frame_sections_.begin();
+       p != this->parsed_eh_frame_sections_.end();
+       ++p)
+    {
+      if ((*p)->shndx() == shndx)
+	{
+	  Parsed_eh_frame_section* ret = *p;
+	  this->parsed_eh_frame_sections_.erase(p);
+	  return ret;
+	}
+    }
+  return NULL;
 }
 
 // Return the section index of symbol SYM.  Set *VALUE to its value in
@@ -947,35 +1056,76 @@ Sized_relobj_file<size, big_endian>::symbol_section_and_value(unsigned int sym,
   return this->adjust_sym_shndx(sym, elfsym.get_st_shndx(), is_ordinary);
 }
 
-// Return whether to include a section group in the link.  LAYOUT is
-// used to keep track of which section groups we have already seen.
-// INDEX is the index of the section group and SHDR is the section
-// header.  If we do not want to include this group, we set bits in
-// OMIT for each section which should be discarded.
+// Find the COMDAT groups in this object, and add their signatures to
+// the signature table in LAYOUT.  This is called by the Read_symbols
+// task, so that reading the signatures and looking them up is done
+// in parallel for different objects.  Which group is kept is still
+// decided by include_section_group, when the object is laid out, so
+// it is still the first group on the command line.
 
 template<int size, bool big_endian>
-bool
-Sized_relobj_file<size, big_endian>::include_section_group(
-    Symbol_table* symtab,
+void
+Sized_relobj_file<size, big_endian>::do_find_comdat_groups(
     Layout* layout,
+    Read_symbols_data* sd)
+{
+  if (this->input_file()->just_symbols()
+      || sd->section_headers == NULL
+      || sd->section_names == NULL)
+    return;
+
+  const unsigned int shnum = this->shnum();
+  const unsigned char* const shdrs = sd->section_headers->data();
+  const char* const names =
+    reinterpret_cast<const char*>(sd->section_names->data());
+  const section_size_type names_size = sd->section_names_size;
+
+  std::vector<unsigned int> group_shndx;
+  const unsigned char* pshdrs = shdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, pshdrs += This::shdr_size)
+    {
+      typename This::Shdr shdr(pshdrs);
+      if (shdr.get_sh_type() != elfcpp::SHT_GROUP
+	  || shdr.get_sh_name() >= names_size
+	  || shdr.get_sh_size() < sizeof(elfcpp::Elf_Word))
+	continue;
+
+      const unsigned char* pcon = this->get_view(shdr.get_sh_offset(),
+						 sizeof(elfcpp::Elf_Word),
+						 true, false);
+      elfcpp::Elf_Word flags = elfcpp::Swap<32, big_endian>::readval(pcon);
+      if ((flags & elfcpp::GRP_COMDAT) != 0)
+	group_shndx.push_back(i);
+    }
+  if (group_shndx.empty())
+    return;
+
+  sd->comdat_groups.resize(group_shndx.size());
+  std::string signature;
+  for (size_t j = 0; j < group_shndx.size(); ++j)
+    {
+      Comdat_group_signature* cgs = &sd->comdat_groups[j];
+      cgs->shndx = group_shndx[j];
+      if (this->section_group_signature(cgs->shndx, shdrs, names, names_size,
+					&signature))
+	cgs->kept_section = layout->find_kept_section(signature,
+						      &cgs->signature);
+    }
+}
+
+// Get the signature of the section group INDEX in *SIGNATURE.
+// Return false, after reporting an error, if it is invalid.
+
+template<int size, bool big_endian>
+bool
+Sized_relobj_file<size, big_endian>::section_group_signature(
     unsigned int index,
-    const char* name,
     const unsigned char* shdrs,
     const char* section_names,
     section_size_type section_names_size,
-    std::vector<bool>* omit)
+    std::string* signature)
 {
-  // Read the section contents.
   typename This::Shdr shdr(shdrs + index * This::shdr_size);
-  const unsigned char* pcon = this->get_view(shdr.get_sh_offset(),
-					     shdr.get_sh_size(), true, false);
-  const elfcpp::Elf_Word* pword =
-    reinterpret_cast<const elfcpp::Elf_Word*>(pcon);
-
-  // The first word contains flags.  We only care about COMDAT section
-  // groups.  Other section groups are always included in the link
-  // just like ordinary sections.
-  elfcpp::Elf_Word flags = elfcpp::Swap<32, big_endian>::readval(pword);
 
   // Look up the group signature, which is the name of a symbol.  ELF
   // uses a symbol name because some group signatures are long, and
@@ -1016,12 +1166,12 @@ Sized_relobj_file<size, big_endian>::include_section_group(
       return false;
     }
 
-  std::string signature(psymnames + sym.get_st_name());
+  signature->assign(psymnames + sym.get_st_name());
 
   // It seems that some versions of gas will create a section group
   // associated with a section symbol, and then fail to give a name to
   // the section symbol.  In such a case, use the name of the section.
-  if (signature[0] == '\0' && sym.get_st_type() == elfcpp::STT_SECTION)
+  if (signature->empty() && sym.get_st_type() == elfcpp::STT_SECTION)
     {
       bool is_ordinary;
       unsigned int sym_shndx = this->adjust_sym_shndx(symndx,
@@ -1035,8 +1185,60 @@ Sized_relobj_file<size, big_endian>::include_section_group(
 	}
       typename This::Shdr member_shdr(shdrs + sym_shndx * This::shdr_size);
       if (member_shdr.get_sh_name() < section_names_size)
-	signature = section_names + member_shdr.get_sh_name();
+	signature->assign(section_names + member_shdr.get_sh_name());
+    }
+
+  return true;
+}
+
+// Return whether to include a section group in the link.  LAYOUT is
+// used to keep track of which section groups we have already seen.
+// INDEX is the index of the section group and SHDR is the section
+// header.  CGS is the signature found by find_comdat_groups, or NULL.
+// If we do not want to include this group, we set bits in OMIT for
+// each section which should be discarded.
+
+template<int size, bool big_endian>
+bool
+Sized_relobj_file<size, big_endian>::include_section_group(
+    Symbol_table* symtab,
+    Layout* layout,
+    unsigned int index,
+    const char* name,
+    const unsigned char* shdrs,
+    const char* section_names,
+    section_size_type section_names_size,
+    const Comdat_group_signature* cgs,
+    std::vector<bool>* omit)
+{
+  // Read the section contents.
+  typename This::Shdr shdr(shdrs + index * This::shdr_size);
+  const unsigned char* pcon = this->get_view(shdr.get_sh_offset(),
+					     shdr.get_sh_size(), true, false);
+  const elfcpp::Elf_Word* pword =
+    reinterpret_cast<const elfcpp::Elf_Word*>(pcon);
+
+  // The first word contains flags.  We only care about COMDAT section
+  // groups.  Other section groups are always included in the link
+  // just like ordinary sections.
+  elfcpp::Elf_Word flags = elfcpp::Swap<32, big_endian>::readval(pword);
+
+  std::string signature_buf;
+  const std::string* psignature;
+  if (cgs != NULL)
+    {
+      if (cgs->kept_section == NULL)
+	return false;
+      psignature = cgs->signature;
     }
+  else
+    {
+      if (!this->section_group_signature(index, shdrs, section_names,
+					 section_names_size, &signature_buf))
+	return false;
+      psignature = &signature_buf;
+    }
+  const std::string& signature(*psignature);
 
   // Record this section group in the layout, and see whether we've already
   // seen one with the same signature.
@@ -1049,6 +1251,13 @@ Sized_relobj_file<size, big_endian>::include_section_group(
       include_group = true;
       is_comdat = false;
     }
+  else if (cgs != NULL)
+    {
+      kept_section = cgs->kept_section;
+      include_group = layout->include_kept_section(kept_section, this, index,
+						   true, true);
+      is_comdat = true;
+    }
   else
     {
       include_group = layout->find_or_add_kept_section(signature,
@@ -1302,6 +1511,11 @@ Sized_relobj_file<size, big_endian>::layout_eh_frame_section(
 					       reloc_type,
 					       &offset);
   this->output_sections()[shndx] = os;
+
+  // If layout_eh_frame did not use the data parsed while reading
+  // symbols, free it now.
+  delete this->release_parsed_eh_frame_section(shndx);
+
   if (os == NULL || offset == -1)
     {
       // An object can contain at most one section holding exception
@@ -1430,7 +1644,7 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
 
   const char* pnames = reinterpret_cast<const char*>(pnamesu);
 
-  // If any input files have been claimed by plugins, we need to defer
+  // If any earlier input files were claimed by plugins, we need to defer
   // actual layout until the replacement files have arrived.
   const bool should_defer_layout =
       (parameters->options().has_plugins()
@@ -1511,6 +1725,9 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
   // Keep track of which sections to omit.
   std::vector<bool> omit(shnum, false);
 
+  // The next COMDAT group found by find_comdat_groups.
+  size_t next_comdat_group = 0;
+
   // Keep track of reloc sections when emitting relocations.
   const bool relocatable = parameters->options().relocatable();
   const bool emit_relocs = (relocatable
@@ -1577,10 +1794,21 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
 	    {
 	      if (shdr.get_sh_type() == elfcpp::SHT_GROUP)
 		{
+		  const Comdat_group_signature* cgs = NULL;
+		  if (sd != NULL)
+		    {
+		      while (next_comdat_group < sd->comdat_groups.size()
+			     && (sd->comdat_groups[next_comdat_group].shndx
+				 < i))
+			++next_comdat_group;
+		      if (next_comdat_group < sd->comdat_groups.size()
+			  && sd->comdat_groups[next_comdat_group].shndx == i)
+			cgs = &sd->comdat_groups[next_comdat_group];
+		    }
 		  if (!this->include_section_group(symtab, layout, i, name,
 						   shdrs, pnames,
 						   section_names_size,
-						   &omit))
+						   cgs, &omit))
 		    discard = true;
 		}
 	      else if ((shdr.get_sh_flags() & elfcpp::SHF_GROUP) == 0
@@ -2150,9 +2378,9 @@ Sized_relobj_file<size, big_endian>::set_local_plt_offset(
 
 // First pass over the local symbols.  Here we add their names to
 // *POOL and *DYNPOOL, and we store the symbol value in
-// THIS->LOCAL_VALUES_.  This function is always called from a
-// singleton thread.  This is followed by a call to
-// finalize_local_symbols.
+// THIS->LOCAL_VALUES_.  With --threads, several objects may be
+// counted at once, each with pools of its own.  This is followed by a
+// call to finalize_local_symbols.
 
 template<int size, bool big_endian>
 void
@@ -2486,8 +2714,8 @@ Sized_relobj_file<size, big_endian>::compute_final_local_value(
 
 // Finalize the local symbols.  Here we set the final value in
 // THIS->LOCAL_VALUES_ and set their output symbol table indexes.
-// This function is always called from a singleton thread.  The actual
-// output of the local symbols will occur in a separate task.
+// With --threads, several objects may be finalized at once.  The
+// actual output of the local symbols will occur in a separate task.
 
 template<int size, bool big_endian>
 unsigned int
@@ -3094,10 +3322,11 @@ Input_objects::print_symbol_counts(const Symbol_table* symtab) const
 // Print a cross reference table.
 
 void
-Input_objects::print_cref(const Symbol_table* symtab, FILE* f) const
+Input_objects::print_cref(const Symbol_table* symtab, FILE* f,
+			  bool is_json) const
 {
   if (parameters->options().cref() && this->cref_ != NULL)
-    this->cref_->print_cref(symtab, f);
+    this->cref_->print_cref(symtab, f, is_json);
 }
 
 // Relocate_info methods.
@@ -3299,24 +3528,6 @@ make_elf_object(const std::string& name, Input_file* input_file, off_t offset,
 
 // Instantiate the templates we need.
 
-#if defined(HAVE_TARGET_64_LITTLE) || defined(HAVE_TARGET_64_BIG)
-template
-void
-Relobj::initialize_input_to_output_map<64>(unsigned int shndx,
-      elfcpp::Elf_types<64>::Elf_Addr starting_address,
-      Unordered_map<section_offset_type,
-      elfcpp::Elf_types<64>::Elf_Addr>* output_addresses) const;
-#endif
-
-#if defined(HAVE_TARGET_32_LITTLE) || defined(HAVE_TARGET_32_BIG)
-template
-void
-Relobj::initialize_input_to_output_map<32>(unsigned int shndx,
-      elfcpp::Elf_types<32>::Elf_Addr starting_address,
-      Unordered_map<section_offset_type,
-      elfcpp::Elf_types<32>::Elf_Addr>* output_addresses) const;
-#endif
-
 #ifdef HAVE_TARGET_32_LITTLE
 template
 void
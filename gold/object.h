@@ -39,6 +39,7 @@ class General_options;
 class Task;
 class Cref;
 class Layout;
+class Kept_section;
 class Output_data;
 class Output_section;
 class Output_section_data;
@@ -48,18 +49,37 @@ class Pluginobj;
 class Dynobj;
 class Object_merge_map;
 class Relocatable_relocs;
+class Parsed_eh_frame_section;
 struct Symbols_data;
 
 template<typename Stringpool_char>
 class Stringpool_template;
 
+// A COMDAT group signature found by Relobj::find_comdat_groups.
+
+struct Comdat_group_signature
+{
+  Comdat_group_signature()
+    : shndx(0), kept_section(NULL), signature(NULL)
+  { }
+
+  // The index of the SHT_GROUP section.
+  unsigned int shndx;
+  // The entry for the signature in the Layout signature table.  This
+  // is NULL if the group is invalid; the error has been reported.
+  Kept_section* kept_section;
+  // The signature, which is the key of the entry in the table.
+  const std::string* signature;
+};
+
 // Data to pass from read_symbols() to add_symbols().
 
 struct Read_symbols_data
 {
   Read_symbols_data()
     : section_headers(NULL), section_names(NULL), symbols(NULL),
-      symbol_names(NULL), versym(NULL), verdef(NULL), verneed(NULL)
+      symbol_names(NULL), versym(NULL), verdef(NULL), verneed(NULL),
+      comdat_groups()
   { }
 
   ~Read_symbols_data();
@@ -95,6 +115,10 @@ struct Read_symbols_data
   File_view* verneed;
   section_size_type verneed_size;
   unsigned int verneed_info;
+
+  // The COMDAT groups in a relocatable object, sorted by section
+  // index, if they were found by find_comdat_groups.
+  std::vector<Comdat_group_signature> comdat_groups;
 };
 
 // Information used to print error messages.
@@ -126,6 +150,11 @@ struct Section_relocs
   File_view* contents;
   // Reloc section type.
   unsigned int sh_type;
+  // File offset and size of the reloc section.  If CONTENTS is NULL
+  // because of --reloc-memory-budget, the relocs are read from here
+  // when they are needed.
+  off_t contents_offset;
+  section_size_type contents_size;
   // Number of reloc entries.
   size_t reloc_count;
   // Output section.
@@ -650,6 +679,14 @@ class Object
   layout(Symbol_table* symtab, Layout* layout, Read_symbols_data* sd)
   { this->do_layout(symtab, layout, sd); }
 
+  // Find the signatures of the COMDAT groups, add them to the
+  // signature table in LAYOUT, and record them in SD for layout.
+  // This is called after read_symbols, while the file is locked, so
+  // that the work is done in parallel for different objects.
+  void
+  find_comdat_groups(Layout* layout, Read_symbols_data* sd)
+  { this->do_find_comdat_groups(layout, sd); }
+
   // Add symbol information to the global symbol table.
   void
   add_symbols(Symbol_table* symtab, Read_symbols_data* sd, Layout *layout)
@@ -856,6 +893,12 @@ class Object
   do_dynobj()
   { return NULL; }
 
+  // Find the COMDAT groups.  Only relocatable objects have any, and
+  // it is always OK to leave them to layout.
+  virtual void
+  do_find_comdat_groups(Layout*, Read_symbols_data*)
+  { }
+
   // Returns NULL for Objects that are not plugin objects.  This method
   // is overridden in the Pluginobj class.
   virtual Pluginobj*
@@ -1313,13 +1356,6 @@ class Relobj : public Object
   Object_merge_map*
   get_or_create_merge_map();
 
-  template<int size>
-  void
-  initialize_input_to_output_map(unsigned int shndx,
-      typename elfcpp::Elf_types<size>::Elf_Addr starting_address,
-      Unordered_map<section_offset_type,
-	    typename elfcpp::Elf_types<size>::Elf_Addr>* output_address) const;
-
   void
   add_merge_mapping(Output_section_data *output_data,
                     unsigned int shndx, section_offset_type offset,
@@ -1330,6 +1366,11 @@ class Relobj : public Object
   merge_output_offset(unsigned int shndx, section_offset_type offset,
                       section_offset_type *poutput) const;
 
+  // Build the index of the merge map for section SHNDX, after adding
+  // mappings for it.
+  void
+  index_merge_map(unsigned int shndx);
+
   const Output_section_data*
   find_merge_section(unsigned int shndx) const;
 
@@ -1393,6 +1434,19 @@ class Relobj : public Object
   virtual void
   do_scan_relocs(Symbol_table*, Layout*, Read_relocs_data*) = 0;
 
+  // Return the contents of the reloc section described by SR.  If
+  // they were not read by read_relocs, read them into *BUF.
+  const unsigned char*
+  section_relocs_contents(const Section_relocs& sr,
+			  std::vector<unsigned char>* buf)
+  {
+    if (sr.contents != NULL)
+      return sr.contents->data();
+    buf->resize(sr.contents_size);
+    this->read(sr.contents_offset, sr.contents_size, &(*buf)[0]);
+    return &(*buf)[0];
+  }
+
   // Return the value of a local symbol.
   virtual uint64_t
   do_local_symbol_value(unsigned int symndx, uint64_t addend) const = 0;
@@ -1593,24 +1647,10 @@ class Merged_symbol_value
  public:
   typedef typename elfcpp::Elf_types<size>::Elf_Addr Value;
 
-  // We use a hash table to map offsets in the input section to output
-  // addresses.
-  typedef Unordered_map<section_offset_type, Value> Output_addresses;
-
   Merged_symbol_value(Value input_value, Value output_start_address)
-    : input_value_(input_value), output_start_address_(output_start_address),
-      output_addresses_()
+    : input_value_(input_value), output_start_address_(output_start_address)
   { }
 
-  // Initialize the hash table.
-  void
-  initialize_input_to_output_map(const Relobj*, unsigned int input_shndx);
-
-  // Release the hash table to save space.
-  void
-  free_input_to_output_map()
-  { this->output_addresses_.clear(); }
-
   // Get the output value corresponding to an addend.  The object and
   // input section index are passed in because the caller will have
   // them; otherwise we could store them here.
@@ -1640,18 +1680,13 @@ class Merged_symbol_value
 	input_offset += addend;
 	addend = 0;
       }
-    typename Output_addresses::const_iterator p =
-      this->output_addresses_.find(input_offset);
-    if (p != this->output_addresses_.end())
-      return p->second + addend;
-
     return (this->value_from_output_section(object, input_shndx, input_offset)
 	    + addend);
   }
 
  private:
-  // Get the output value for an input offset if we couldn't find it
-  // in the hash table.
+  // Get the output value for an input offset.  The merge map for the
+  // section has an index, so this does not need a search.
   Value
   value_from_output_section(const Relobj*, unsigned int input_shndx,
 			    Value input_offset) const;
@@ -1661,9 +1696,6 @@ class Merged_symbol_value
   Value input_value_;
   // The start address of this merged section in the output file.
   Value output_start_address_;
-  // A hash table which maps offsets in the input section to output
-  // addresses.  This only maps specific offsets, not all offsets.
-  Output_addresses output_addresses_;
 };
 
 // This POD class is holds the value of a symbol.  This is used for
@@ -1720,29 +1752,6 @@ class Symbol_value
     this->u_.merged_symbol_value = msv;
   }
 
-  // Initialize the input to output map for a section symbol in a
-  // merged section.  We also initialize the value of a non-section
-  // symbol in a merged section.
-  void
-  initialize_input_to_output_map(const Relobj* object)
-  {
-    if (!this->has_output_value_)
-      {
-	gold_assert(this->is_section_symbol_ && this->is_ordinary_shndx_);
-	Merged_symbol_value<size>* msv = this->u_.merged_symbol_value;
-	msv->initialize_input_to_output_map(object, this->input_shndx_);
-      }
-  }
-
-  // Free the input to output map for a section symbol in a merged
-  // section.
-  void
-  free_input_to_output_map()
-  {
-    if (!this->has_output_value_)
-      this->u_.merged_symbol_value->free_input_to_output_map();
-  }
-
   // Set the value of the symbol from the input file.  This is only
   // called by count_local_symbols, to communicate the value to
   // finalize_local_symbols.
@@ -2326,6 +2335,12 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   bool is_deferred_layout() const
   { return this->is_deferred_layout_; }
 
+  // Return the contents of .eh_frame section SHNDX as parsed when
+  // the symbols were read, or NULL if it was not parsed then.  The
+  // caller takes ownership of the result.
+  Parsed_eh_frame_section*
+  release_parsed_eh_frame_section(unsigned int shndx);
+
  protected:
   typedef typename Sized_relobj<size, big_endian>::Output_sections
       Output_sections;
@@ -2380,6 +2395,10 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   do_layout(Symbol_table*, Layout*, Read_symbols_data*);
 
+  // Find the COMDAT groups.
+  void
+  do_find_comdat_groups(Layout*, Read_symbols_data*);
+
   // Layout sections whose layout was deferred while waiting for
   // input files from a plugin.
   void
@@ -2512,16 +2531,6 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
     return shndx;
   }
 
-  // Initialize input to output maps for section symbols in merged
-  // sections.
-  void
-  initialize_input_to_output_maps();
-
-  // Free the input to output maps for section symbols in merged
-  // sections.
-  void
-  free_input_to_output_maps();
-
   // Return symbol table section index.
   unsigned int
   symtab_shndx() const
@@ -2621,11 +2630,22 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   find_eh_frame(const unsigned char* pshdrs, const char* names,
 		section_size_type names_size) const;
 
+  // Parse the GNU style exception frame sections.  This is called
+  // when reading the symbols, so that the work can be done in
+  // parallel for different objects.
+  void
+  parse_eh_frame_sections(Read_symbols_data*);
+
+  // Get the signature of a section group.
+  bool
+  section_group_signature(unsigned int, const unsigned char*, const char*,
+			  section_size_type, std::string*);
+
   // Whether to include a section group in the link.
   bool
   include_section_group(Symbol_table*, Layout*, unsigned int, const char*,
 			const unsigned char*, const char*, section_size_type,
-			std::vector<bool>*);
+			const Comdat_group_signature*, std::vector<bool>*);
 
   // Whether to include a linkonce section in the link.
   bool
@@ -2668,7 +2688,8 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   // Scan the input relocations for --emit-relocs.
   void
   emit_relocs_scan(Symbol_table*, Layout*, const unsigned char* plocal_syms,
-		   const Read_relocs_data::Relocs_list::iterator&);
+		   const Read_relocs_data::Relocs_list::iterator&,
+		   const unsigned char* prelocs);
 
   // Scan the input relocations for --emit-relocs, templatized on the
   // type of the relocation section.
@@ -2681,14 +2702,16 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
 
   // Scan the input relocations for --incremental.
   void
-  incremental_relocs_scan(const Read_relocs_data::Relocs_list::iterator&);
+  incremental_relocs_scan(const Read_relocs_data::Relocs_list::iterator&,
+			  const unsigned char* prelocs);
 
   // Scan the input relocations for --incremental, templatized on the
   // type of the relocation section.
   template<int sh_type>
   void
   incremental_relocs_scan_reltype(
-      const Read_relocs_data::Relocs_list::iterator&);
+      const Read_relocs_data::Relocs_list::iterator&,
+      const unsigned char* prelocs);
 
   void
   incremental_relocs_write(const Relocate_info<size, big_endian>*,
@@ -2845,6 +2868,9 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   // If this object has a GNU style .eh_frame section that is discarded in
   // output, record the index here.  Otherwise it is -1U.
   unsigned int discarded_eh_frame_shndx_;
+  // The .eh_frame sections parsed when the symbols were read, which
+  // have not yet been laid out.
+  std::vector<Parsed_eh_frame_section*> parsed_eh_frame_sections_;
   // True if the layout of this object was deferred, waiting for plugin
   // replacement files.
   bool is_deferred_layout_;
@@ -2900,9 +2926,10 @@ class Input_objects
   void
   print_symbol_counts(const Symbol_table*) const;
 
-  // Print a cross reference table.
+  // Print a cross reference table.  If IS_JSON, print the elements
+  // of a JSON array rather than text.
   void
-  print_cref(const Symbol_table*, FILE*) const;
+  print_cref(const Symbol_table*, FILE*, bool is_json) const;
 
   // Iterate over all regular objects.
 
@@ -1317,6 +1317,11 @@ General_options::finalize()
     gold_fatal(_("binary output format not compatible "
 		 "with -shared or -pie or -r"));
 
+  if (this->call_graph_ordering_file() != NULL
+      && this->section_ordering_file() != NULL)
+    gold_fatal(_("--call-graph-ordering-file and --section-ordering-file "
+		 "are incompatible"));
+
   if (this->user_set_hash_bucket_empty_fraction()
       && (this->hash_bucket_empty_fraction() < 0.0
 	  || this->hash_bucket_empty_fraction() >= 1.0))
@@ -711,6 +711,11 @@ class General_options
   DEFINE_string(format, options::TWO_DASHES, 'b', "elf",
 		N_("Set input format"), ("[elf,binary]"));
 
+  DEFINE_bool(batch_relocs, options::TWO_DASHES, '\0', true,
+	      N_("(x86-64 only) Apply common relocations in batches "
+		 "(default)"),
+	      N_("(x86-64 only) Apply each relocation separately"));
+
   DEFINE_bool(be8,options::TWO_DASHES, '\0', false,
 	      N_("Output BE8 format image"), NULL);
 
@@ -751,6 +756,11 @@ class General_options
 
   // c
 
+  DEFINE_string(call_graph_ordering_file, options::TWO_DASHES, '\0', NULL,
+		N_("Order functions using the call graph profile in "
+		   "FILENAME"),
+		N_("FILENAME"));
+
   DEFINE_bool(check_sections, options::TWO_DASHES, '\0', true,
 	      N_("Check segment addresses for overlaps"),
 	      N_("Do not check segment addresses for overlaps"));
@@ -925,6 +935,12 @@ class General_options
 		N_("Min fraction of empty buckets in dynamic hash"),
 		N_("FRACTION"));
 
+  DEFINE_bool(hash_bucket_search, options::TWO_DASHES, '\0', false,
+	      N_("Search for the number of dynamic hash buckets which "
+		 "gives the shortest chains"),
+	      N_("Choose the number of dynamic hash buckets from a "
+		 "table (default)"));
+
   DEFINE_enum(hash_style, options::TWO_DASHES, '\0', "sysv",
 	      N_("Dynamic hash style"), N_("[sysv,gnu,both]"),
 	      {"sysv", "gnu", "both"});
@@ -1042,6 +1058,10 @@ class General_options
   DEFINE_string(Map, options::ONE_DASH, '\0', NULL, N_("Write map file"),
 		N_("MAPFILENAME"));
 
+  DEFINE_enum(map_format, options::TWO_DASHES, '\0', "text",
+	      N_("Map file format"),
+	      N_("[text,json]"), {"text", "json"});
+
   // n
 
   DEFINE_bool(nmagic, options::TWO_DASHES, 'n', false,
@@ -1123,6 +1143,15 @@ class General_options
 	      N_("Use posix_fallocate to reserve space in the output file"),
 	      N_("Use fallocate or ftruncate to reserve space"));
 
+  DEFINE_bool(prefetch_inputs, options::TWO_DASHES, '\0', false,
+	      N_("Ask the kernel to read the headers and symbol tables "
+		 "of the input files ahead of use"),
+	      N_("Do not prefetch input files"));
+  DEFINE_uint64(prefetch_budget, options::TWO_DASHES, '\0', 256 << 20,
+		N_("Prefetch at most SIZE bytes of input files "
+		   "(default 256 MiB)"),
+		N_("SIZE"));
+
   DEFINE_bool(preread_archive_symbols, options::TWO_DASHES, '\0', false,
 	      N_("Preread archive symbols when multi-threaded"), NULL);
 
@@ -1156,12 +1185,32 @@ class General_options
 
   // r
 
+  DEFINE_bool(reflink_output, options::TWO_DASHES, '\0', false,
+	      N_("Write only the changed parts of an existing output "
+		 "file, sharing the rest on copy-on-write file systems"),
+	      N_("Always write the whole output file (default)"));
+
   DEFINE_bool(relocatable, options::EXACTLY_ONE_DASH, 'r', false,
 	      N_("Generate relocatable output"), NULL);
 
   DEFINE_bool(relax, options::TWO_DASHES, '\0', false,
 	      N_("Relax branches on certain targets"), NULL);
 
+  DEFINE_string(reloc_cache, options::TWO_DASHES, '\0', NULL,
+		N_("Reuse relocated section contents from earlier links, "
+		   "cached in DIR"),
+		N_("DIR"));
+  DEFINE_uint64(reloc_cache_size, options::TWO_DASHES, '\0', 256 << 20,
+		N_("Limit the relocation cache to SIZE bytes "
+		   "(default 256 MiB)"),
+		N_("SIZE"));
+
+  DEFINE_uint64(reloc_memory_budget, options::TWO_DASHES, '\0', 0,
+		N_("Keep at most SIZE bytes of relocations in memory ahead "
+		   "of scanning them, and read the rest one section at a "
+		   "time (default 0, no limit)"),
+		N_("SIZE"));
+
   DEFINE_string(retain_symbols_file, options::TWO_DASHES, '\0', NULL,
 		N_("keep only symbols listed in this file"), N_("FILE"));
 
@@ -1285,6 +1334,10 @@ class General_options
 	      N_("Number of threads to use in middle pass"), N_("COUNT"));
   DEFINE_uint(thread_count_final, options::TWO_DASHES, '\0', 0,
 	      N_("Number of threads to use in final pass"), N_("COUNT"));
+  DEFINE_enum(thread_affinity, options::TWO_DASHES, '\0', "none",
+	      N_("Bind each thread to a CPU or to a NUMA node"),
+	      N_("[none,cpu,node]"),
+	      {"none", "cpu", "node"});
 
   DEFINE_bool(toc_optimize, options::TWO_DASHES, '\0', true,
 	      N_("(PowerPC64 only) Optimize TOC code sequences"),
@@ -1468,6 +1521,10 @@ class General_options
   DEFINE_bool(origin, options::DASH_Z, '\0', false,
 	      N_("Mark DSO to indicate that needs immediate $ORIGIN "
 		 "processing at runtime"), NULL);
+  DEFINE_bool(pack_relative_relocs, options::DASH_Z, '\0', false,
+	      N_("(x86-64 and aarch64 only) Pack relative relocations "
+		 "into a DT_RELR section"),
+	      N_("Do not pack relative relocations"));
   DEFINE_bool(relro, options::DASH_Z, '\0', DEFAULT_LD_Z_RELRO,
 	      N_("Where possible mark variables read-only after relocation"),
 	      N_("Don't mark variables read-only after relocation"));
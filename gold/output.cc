@@ -34,6 +34,10 @@
 #include <sys/mman.h>
 #endif
 
+#ifdef __linux__
+#include <sys/ioctl.h>
+#endif
+
 #include "libiberty.h"
 
 #include "dwarf.h"
@@ -116,6 +120,11 @@ extern "C" void *gold_mremap(void *, size_t, size_t, int);
 # define S_ISLNK(mode) 0
 #endif
 
+// The ioctl to clone a file on Linux, from <linux/fs.h>.
+#if defined(__linux__) && !defined(FICLONE)
+# define FICLONE _IOW(0x94, 9, int)
+#endif
+
 namespace gold
 {
 
@@ -140,6 +149,22 @@ gold_fallocate(int o, off_t offset, off_t len)
   return 0;
 }
 
+// Make the file O a copy of the file FROM which shares its blocks.
+// This only works on file systems which support copy on write.
+// Return 0 on success or an errno value.
+
+static int
+gold_reflink(int o, int from)
+{
+#ifdef FICLONE
+  if (::ioctl(o, FICLONE, from) == 0)
+    return 0;
+  return errno;
+#else
+  return ENOSYS;
+#endif
+}
+
 // Output_data variables.
 
 bool Output_data::allocated_sizes_are_fixed;
@@ -1153,55 +1178,26 @@ Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>::symbol_value(
   return symval->value(relobj, addend);
 }
 
-// Reloc comparison.  This function sorts the dynamic relocs for the
-// benefit of the dynamic linker.  First we sort all relative relocs
-// to the front.  Among relative relocs, we sort by output address.
-// Among non-relative relocs, we sort by symbol index, then by output
-// address.
+// Set the key used to sort this reloc.  This sorts the dynamic relocs
+// for the benefit of the dynamic linker.  First we sort all relative
+// relocs to the front.  Among relative relocs, we sort by output
+// address.  Among non-relative relocs, we sort by symbol index, then
+// by output address.  The final tie breaker is the reloc type, in
+// order to generate the same output on any host.
 
 template<bool dynamic, int size, bool big_endian>
-int
-Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>::
-  compare(const Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>& r2)
-    const
+void
+Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>::set_sort_key(
+    Output_reloc_sort_key<size>* key) const
 {
   if (this->is_relative_)
-    {
-      if (!r2.is_relative_)
-	return -1;
-      // Otherwise sort by reloc address below.
-    }
-  else if (r2.is_relative_)
-    return 1;
+    key->symbol = 0;
   else
-    {
-      unsigned int sym1 = this->get_symbol_index();
-      unsigned int sym2 = r2.get_symbol_index();
-      if (sym1 < sym2)
-	return -1;
-      else if (sym1 > sym2)
-	return 1;
-      // Otherwise sort by reloc address.
-    }
-
-  section_offset_type addr1 = this->get_address();
-  section_offset_type addr2 = r2.get_address();
-  if (addr1 < addr2)
-    return -1;
-  else if (addr1 > addr2)
-    return 1;
-
-  // Final tie breaker, in order to generate the same output on any
-  // host: reloc type.
-  unsigned int type1 = this->type_;
-  unsigned int type2 = r2.type_;
-  if (type1 < type2)
-    return -1;
-  else if (type1 > type2)
-    return 1;
-
-  // These relocs appear to be exactly the same.
-  return 0;
+    key->symbol = ((static_cast<uint64_t>(1) << 32)
+		   | this->get_symbol_index());
+  key->address = this->get_address();
+  key->type = this->type_;
+  key->addend = 0;
 }
 
 // Write out a Rela relocation.
@@ -1276,6 +1272,130 @@ Output_data_reloc_base<sh_type, dynamic, size, big_endian>::do_write(
   this->do_write_generic<Writer>(of);
 }
 
+// Class Output_data_relr.
+
+// Set the entry size of the output section.
+
+template<int size, bool big_endian>
+void
+Output_data_relr<size, big_endian>::do_adjust_output_section(
+    Output_section* os)
+{
+  os->set_entsize(size / 8);
+}
+
+// Return the final address of a reloc.
+
+template<int size, bool big_endian>
+typename Output_data_relr<size, big_endian>::Address
+Output_data_relr<size, big_endian>::reloc_address(const Relr_reloc& r) const
+{
+  if (r.relobj == NULL)
+    return r.od->address() + r.address;
+
+  Output_section* os = r.relobj->output_section(r.shndx);
+  gold_assert(os != NULL);
+  Address off = r.relobj->get_output_section_offset(r.shndx);
+  if (off != invalid_address)
+    return os->address() + off + r.address;
+
+  // The section may have been replaced by a relaxed input section.
+  Sized_relobj_file<size, big_endian>* relobj = r.relobj->sized_relobj();
+  gold_assert(relobj != NULL);
+  Address address = os->output_address(relobj, r.shndx, r.address);
+  gold_assert(address != invalid_address);
+  return address;
+}
+
+// Compute the section contents.  We use an address entry for the
+// first reloc which is not covered by the previous bitmap, followed
+// by as many bitmaps as are needed to cover the relocs after it.
+
+template<int size, bool big_endian>
+bool
+Output_data_relr<size, big_endian>::update_entries()
+{
+  const Address wordsize = size / 8;
+  const Address bits = size - 1;
+
+  std::vector<Address> addresses;
+  addresses.reserve(this->relocs_.size());
+  for (typename std::vector<Relr_reloc>::const_iterator p =
+	 this->relocs_.begin();
+       p != this->relocs_.end();
+       ++p)
+    {
+      Address address = this->reloc_address(*p);
+      gold_assert(address % wordsize == 0);
+      addresses.push_back(address);
+    }
+  std::sort(addresses.begin(), addresses.end());
+  addresses.erase(std::unique(addresses.begin(), addresses.end()),
+		  addresses.end());
+
+  this->entries_.clear();
+  typename std::vector<Address>::const_iterator p = addresses.begin();
+  while (p != addresses.end())
+    {
+      this->entries_.push_back(*p);
+      Address base = *p + wordsize;
+      ++p;
+      while (p != addresses.end())
+	{
+	  Address bitmap = 0;
+	  while (p != addresses.end() && *p - base < bits * wordsize)
+	    {
+	      bitmap |= static_cast<Address>(1) << ((*p - base) / wordsize);
+	      ++p;
+	    }
+	  if (bitmap == 0)
+	    break;
+	  this->entries_.push_back((bitmap << 1) | 1);
+	  base += bits * wordsize;
+	}
+    }
+
+  if (this->entries_.size() <= this->max_entries_)
+    return false;
+  this->max_entries_ = this->entries_.size();
+  return true;
+}
+
+// Write out the section.
+
+template<int size, bool big_endian>
+void
+Output_data_relr<size, big_endian>::do_write(Output_file* of)
+{
+  const off_t off = this->offset();
+  const section_size_type oview_size =
+    convert_to_section_size_type(this->data_size());
+  unsigned char* const oview = of->get_output_view(off, oview_size);
+
+  gold_assert(this->entries_.size() <= this->max_entries_);
+  unsigned char* pov = oview;
+  for (typename std::vector<Address>::const_iterator p =
+	 this->entries_.begin();
+       p != this->entries_.end();
+       ++p)
+    {
+      elfcpp::Swap<size, big_endian>::writeval(pov, *p);
+      pov += size / 8;
+    }
+  for (size_t i = this->entries_.size(); i < this->max_entries_; ++i)
+    {
+      elfcpp::Swap<size, big_endian>::writeval(pov, 1);
+      pov += size / 8;
+    }
+  gold_assert(static_cast<section_size_type>(pov - oview) == oview_size);
+
+  of->write_output_view(off, oview_size, oview);
+
+  // We no longer need the relocs.
+  std::vector<Relr_reloc>().swap(this->relocs_);
+  std::vector<Address>().swap(this->entries_);
+}
+
 // Class Output_relocatable_relocs.
 
 template<int sh_type, int size, bool big_endian>
@@ -3096,9 +3216,19 @@ Output_section::find_starting_output_address(const Relobj* object,
   if (data == NULL)
     return false;
 
-  // FIXME: This becomes a bottle-neck if we have many relaxed sections.
-  // Looking up the merge section map does not always work as we sometimes
-  // find a merge section without its address set.
+  // Once set_final_data_size has run, the merge section has its
+  // address, so we don't need to walk the input sections.
+  if (data->is_address_valid()
+      && this->is_address_valid()
+      && data->output_section() == this)
+    {
+      *paddr = data->address();
+      return true;
+    }
+
+  // Otherwise we sometimes find a merge section without its address
+  // set, as while relaxing.  This becomes a bottle-neck if we have
+  // many relaxed sections.
   uint64_t addr = this->address() + this->first_input_offset_;
   for (Input_section_list::const_iterator p = this->input_sections_.begin();
        p != this->input_sections_.end();
@@ -3599,6 +3729,26 @@ Output_section::update_section_layout(
     }
 }
 
+// Give the input sections which were not given a section order index
+// by update_section_layout an index after all the others.
+
+void
+Output_section::order_remaining_input_sections(unsigned int first_index)
+{
+  unsigned int section_order_index = first_index;
+  for (Input_section_list::iterator p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    {
+      if ((p->is_input_section() || p->is_relaxed_input_section())
+	  && p->section_order_index() == 0)
+	{
+	  p->set_section_order_index(section_order_index);
+	  ++section_order_index;
+	}
+    }
+}
+
 // Sort the input sections attached to an output section.
 
 void
@@ -4036,11 +4186,22 @@ void
 Output_section::do_print_to_mapfile(Mapfile* mapfile) const
 {
   mapfile->print_output_section(this);
+  this->print_input_sections_to_mapfile(mapfile, 0,
+					this->input_sections_.size());
+  mapfile->finish_output_section();
+}
 
-  for (Input_section_list::const_iterator p = this->input_sections_.begin();
-       p != this->input_sections_.end();
-       ++p)
-    p->print_to_mapfile(mapfile);
+// Print some of the input sections to the map file.  The map file is
+// printed in pieces on several threads.
+
+void
+Output_section::print_input_sections_to_mapfile(Mapfile* mapfile,
+						size_t first,
+						size_t last) const
+{
+  gold_assert(first <= last && last <= this->input_sections_.size());
+  for (size_t i = first; i < last; ++i)
+    this->input_sections_[i].print_to_mapfile(mapfile);
 }
 
 // Print stats for merge sections to stderr.
@@ -4940,27 +5101,17 @@ Output_segment::write_section_headers_list(const Layout* layout,
   return v;
 }
 
-// Print the output sections to the map file.
+// Add the output sections to print in the map file to *PLIST.
 
 void
-Output_segment::print_sections_to_mapfile(Mapfile* mapfile) const
+Output_segment::get_mapfile_sections(
+    std::vector<const Output_data*>* plist) const
 {
   if (this->type() != elfcpp::PT_LOAD)
     return;
   for (int i = 0; i < static_cast<int>(ORDER_MAX); ++i)
-    this->print_section_list_to_mapfile(mapfile, &this->output_lists_[i]);
-}
-
-// Print an output section list to the map file.
-
-void
-Output_segment::print_section_list_to_mapfile(Mapfile* mapfile,
-					      const Output_data_list* pdl) const
-{
-  for (Output_data_list::const_iterator p = pdl->begin();
-       p != pdl->end();
-       ++p)
-    (*p)->print_to_mapfile(mapfile);
+    plist->insert(plist->end(), this->output_lists_[i].begin(),
+		  this->output_lists_[i].end());
 }
 
 // Output_file methods.
@@ -4972,7 +5123,9 @@ Output_file::Output_file(const char* name)
     base_(NULL),
     map_is_anonymous_(false),
     map_is_allocated_(false),
-    is_temporary_(false)
+    is_temporary_(false),
+    reflink_name_(),
+    reflink_size_(0)
 {
 }
 
@@ -5093,6 +5246,19 @@ Output_file::open(off_t file_size)
     {
       if (strcmp(this->name_, "-") == 0)
 	this->o_ = STDOUT_FILENO;
+      else if (parameters->options().reflink_output()
+	       && !parameters->incremental()
+	       && this->open_reflink())
+	{
+	  // Build the output in memory, so that we can tell which
+	  // parts of it changed when we close the file.
+	  if (this->map_anonymous())
+	    return;
+	  gold_fatal(_("%s: mmap: failed to allocate %lu bytes for output "
+		       "file: %s"),
+		     this->name_, static_cast<unsigned long>(this->file_size_),
+		     strerror(errno));
+	}
       else
 	{
 	  struct stat s;
@@ -5125,6 +5291,75 @@ Output_file::open(off_t file_size)
   this->map();
 }
 
+// With --reflink-output, if the output file already exists, make a
+// copy of it next to it which shares its blocks.  We write the parts
+// of the new output which differ to the copy, and then rename it
+// over the output file, so that the blocks which did not change are
+// neither written nor duplicated on disk.  Return false if there is
+// no existing file or the file system can't share blocks; then we
+// write the whole file as usual.
+
+bool
+Output_file::open_reflink()
+{
+  struct stat s;
+  if (::stat(this->name_, &s) != 0
+      || !S_ISREG(s.st_mode)
+      || s.st_size == 0)
+    return false;
+
+  int from = open_descriptor(-1, this->name_, O_RDONLY, 0);
+  if (from < 0)
+    return false;
+
+  std::string tmpl = std::string(this->name_) + ".XXXXXX";
+  std::vector<char> tmpname(tmpl.begin(), tmpl.end());
+  tmpname.push_back('\0');
+  int o = mkstemps(&tmpname[0], 0);
+  if (o < 0)
+    {
+      release_descriptor(from, true);
+      return false;
+    }
+
+  int err = gold_reflink(o, from);
+  release_descriptor(from, true);
+  if (err != 0)
+    {
+      ::close(o);
+      ::unlink(&tmpname[0]);
+      return false;
+    }
+
+  // Give the file the permissions that open would have.
+  int mask = ::umask(0);
+  ::umask(mask);
+  int mode = parameters->options().relocatable() ? 0666 : 0777;
+  ::fchmod(o, mode & ~mask);
+
+  this->o_ = o;
+  this->reflink_name_ = &tmpname[0];
+  this->reflink_size_ = s.st_size;
+  Output_file::reflink_file_name = this->reflink_name_.c_str();
+  return true;
+}
+
+// The copy of the output file which we are writing.
+
+const char* Output_file::reflink_file_name = NULL;
+
+// Remove the copy of the output file, if we have not renamed it yet.
+
+void
+Output_file::remove_reflink_file()
+{
+  if (Output_file::reflink_file_name != NULL)
+    {
+      ::unlink(Output_file::reflink_file_name);
+      Output_file::reflink_file_name = NULL;
+    }
+}
+
 // Resize the output file.
 
 void
@@ -5275,13 +5510,94 @@ Output_file::unmap()
   this->base_ = NULL;
 }
 
+// Write the parts of the output file which differ from the copy of
+// the existing file made by open_reflink, and set the size of the
+// file.  We compare a file system block at a time, and write each run
+// of changed blocks with a single call.
+
+void
+Output_file::write_changed()
+{
+  const off_t file_size = this->file_size_;
+  if (::ftruncate(this->o_, file_size) < 0)
+    gold_error(_("%s: ftruncate: %s"), this->name_, strerror(errno));
+
+  off_t block_size = 4096;
+  struct stat s;
+  if (::fstat(this->o_, &s) == 0 && s.st_blksize > 0)
+    block_size = s.st_blksize;
+
+  // If we can't map the old contents, we write everything.
+  const off_t old_size = std::min(this->reflink_size_, file_size);
+  const unsigned char* old = NULL;
+  if (old_size > 0)
+    {
+      void* p = ::mmap(NULL, old_size, PROT_READ, MAP_SHARED, this->o_, 0);
+      if (p != MAP_FAILED)
+	old = static_cast<const unsigned char*>(p);
+    }
+
+  off_t run_start = -1;
+  for (off_t off = 0; off < file_size; off += block_size)
+    {
+      off_t len = std::min(block_size, file_size - off);
+      if (old != NULL
+	  && off + len <= old_size
+	  && memcmp(old + off, this->base_ + off, len) == 0)
+	{
+	  if (run_start >= 0)
+	    {
+	      this->write_range(run_start, off - run_start);
+	      run_start = -1;
+	    }
+	  Output_file::reflink_bytes_shared += len;
+	}
+      else if (run_start < 0)
+	run_start = off;
+    }
+  if (run_start >= 0)
+    this->write_range(run_start, file_size - run_start);
+
+  if (old != NULL)
+    ::munmap(const_cast<unsigned char*>(old), old_size);
+}
+
+// Write LEN bytes at OFFSET from the map to the file.
+
+void
+Output_file::write_range(off_t offset, size_t len)
+{
+  Output_file::reflink_bytes_written += len;
+  if (::lseek(this->o_, offset, SEEK_SET) < 0)
+    {
+      gold_error(_("%s: lseek: %s"), this->name_, strerror(errno));
+      return;
+    }
+  while (len > 0)
+    {
+      ssize_t bytes_written = ::write(this->o_, this->base_ + offset, len);
+      if (bytes_written <= 0)
+	{
+	  gold_error(_("%s: write: %s"), this->name_,
+		     bytes_written == 0 ? _("unexpected 0 return-value")
+		     : strerror(errno));
+	  return;
+	}
+      len -= bytes_written;
+      offset += bytes_written;
+    }
+}
+
 // Close the output file.
 
 void
 Output_file::close()
 {
-  // If the map isn't file-backed, we need to write it now.
-  if (this->map_is_anonymous_ && !this->is_temporary_)
+  // With --reflink-output, write the parts which changed.  Otherwise,
+  // if the map isn't file-backed, we need to write it now.
+  if (!this->reflink_name_.empty())
+    this->write_changed();
+  else if (this->map_is_anonymous_ && !this->is_temporary_)
     {
       size_t bytes_to_write = this->file_size_;
       size_t offset = 0;
@@ -5309,6 +5625,36 @@ Output_file::close()
     if (::close(this->o_) < 0)
       gold_error(_("%s: close: %s"), this->name_, strerror(errno));
   this->o_ = -1;
+
+  // Replace the old output file with the copy we have written.
+  if (!this->reflink_name_.empty())
+    {
+      if (::rename(this->reflink_name_.c_str(), this->name_) < 0)
+	{
+	  gold_error(_("%s: rename: %s"), this->name_, strerror(errno));
+	  ::unlink(this->reflink_name_.c_str());
+	}
+      Output_file::reflink_file_name = NULL;
+      this->reflink_name_.clear();
+    }
+}
+
+// Print statistics.
+
+uint64_t Output_file::reflink_bytes_written = 0;
+uint64_t Output_file::reflink_bytes_shared = 0;
+
+void
+Output_file::print_stats()
+{
+  if (!parameters->options().reflink_output())
+    return;
+  fprintf(stderr, _("%s: output bytes written: %llu\n"),
+	  program_name,
+	  static_cast<unsigned long long>(Output_file::reflink_bytes_written));
+  fprintf(stderr, _("%s: output bytes shared with previous output: %llu\n"),
+	  program_name,
+	  static_cast<unsigned long long>(Output_file::reflink_bytes_shared));
 }
 
 // Instantiate the templates we need.  We could use the configure
@@ -5566,6 +5912,26 @@ template
 class Output_relocatable_relocs<elfcpp::SHT_RELA, 64, true>;
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+class Output_data_relr<32, false>;
+#endif
+
+#ifdef HAVE_TARGET_32_BIG
+template
+class Output_data_relr<32, true>;
+#endif
+
+#ifdef HAVE_TARGET_64_LITTLE
+template
+class Output_data_relr<64, false>;
+#endif
+
+#ifdef HAVE_TARGET_64_BIG
+template
+class Output_data_relr<64, true>;
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 class Output_data_group<32, false>;
@@ -31,6 +31,7 @@
 #include "mapfile.h"
 #include "layout.h"
 #include "reloc-types.h"
+#include "gold-threads.h"
 
 namespace gold
 {
@@ -140,7 +141,34 @@ class Output_file
   free_input_view(off_t, size_t, const unsigned char*)
   { }
 
+  // Print statistics.
+  static void
+  print_stats();
+
+  // Remove the copy of the output file made for --reflink-output, if
+  // it has not replaced the output file yet.  This is called when the
+  // link fails.
+  static void
+  remove_reflink_file();
+
+  // Statistics for --reflink-output.
+  static uint64_t reflink_bytes_written;
+  static uint64_t reflink_bytes_shared;
+
  private:
+  // Open a copy of the existing output file for --reflink-output.
+  bool
+  open_reflink();
+
+  // Write the parts of the output file which changed for
+  // --reflink-output.
+  void
+  write_changed();
+
+  // Write LEN bytes at OFFSET from the map to the file.
+  void
+  write_range(off_t offset, size_t len);
+
   // Map the file into memory or, if that fails, allocate anonymous
   // memory.
   void
@@ -172,6 +200,15 @@ class Output_file
   bool map_is_allocated_;
   // True if this is a temporary file which should not be output.
   bool is_temporary_;
+  // With --reflink-output, the name of the copy of the existing
+  // output file which we are writing, or the empty string.
+  std::string reflink_name_;
+  // The size of the existing output file.
+  off_t reflink_size_;
+
+  // The name of the copy of the output file which we are writing for
+  // --reflink-output, or NULL.  This points into reflink_name_.
+  static const char* reflink_file_name;
 };
 
 // An abtract class for data which has to go into the output file.
@@ -1119,6 +1156,44 @@ class Output_data_strtab : public Output_section_data
 template<int sh_type, bool dynamic, int size, bool big_endian>
 class Output_reloc;
 
+// The key used to sort dynamic relocs.  This is computed once for
+// each reloc, so that sorting does not look up symbol indexes and
+// output addresses on every comparison.  See
+// Output_reloc::set_sort_key for the order.
+
+template<int size>
+struct Output_reloc_sort_key
+{
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Addend;
+
+  // Zero for a relative reloc, otherwise the symbol index with bit 32
+  // set.
+  uint64_t symbol;
+  // The output address.
+  section_offset_type address;
+  // The reloc type.
+  unsigned int type;
+  // The addend of a RELA reloc, or zero.
+  Addend addend;
+  // The index of the reloc in the section.  Relocs which are
+  // otherwise the same keep the order in which they were added.
+  size_t index;
+
+  bool
+  operator<(const Output_reloc_sort_key& k) const
+  {
+    if (this->symbol != k.symbol)
+      return this->symbol < k.symbol;
+    if (this->address != k.address)
+      return this->address < k.address;
+    if (this->type != k.type)
+      return this->type < k.type;
+    if (this->addend != k.addend)
+      return this->addend < k.addend;
+    return this->index < k.index;
+  }
+};
+
 template<bool dynamic, int size, bool big_endian>
 class Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>
 {
@@ -1262,18 +1337,10 @@ class Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>
   template<typename Write_rel>
   void write_rel(Write_rel*) const;
 
-  // This is used when sorting dynamic relocs.  Return -1 to sort this
-  // reloc before R2, 0 to sort the same as R2, 1 to sort after R2.
-  int
-  compare(const Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>& r2)
-    const;
-
-  // Return whether this reloc should be sorted before the argument
-  // when sorting dynamic relocs.
-  bool
-  sort_before(const Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>&
-	      r2) const
-  { return this->compare(r2) < 0; }
+  // Set the key used when sorting dynamic relocs.  This does not set
+  // KEY->index.
+  void
+  set_sort_key(Output_reloc_sort_key<size>* key) const;
 
   // Return the symbol index.
   unsigned int
@@ -1478,19 +1545,13 @@ class Output_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>
   void
   write(unsigned char* pov) const;
 
-  // Return whether this reloc should be sorted before the argument
-  // when sorting dynamic relocs.
-  bool
-  sort_before(const Output_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>&
-	      r2) const
-  {
-    int i = this->rel_.compare(r2.rel_);
-    if (i < 0)
-      return true;
-    else if (i > 0)
-      return false;
-    else
-      return this->addend_ < r2.addend_;
+  // Set the key used when sorting dynamic relocs.  Relocs which are
+  // otherwise the same are sorted by addend.
+  void
+  set_sort_key(Output_reloc_sort_key<size>* key) const
+  {
+    this->rel_.set_sort_key(key);
+    key->addend = this->addend_;
   }
 
  private:
@@ -1614,6 +1675,8 @@ class Output_data_reloc_base : public Output_data_reloc_generic
 
   // Generic implementation of do_write, allowing a customized
   // class for writing the output relocation (e.g., for MIPS-64).
+  // With --threads, we compute the sort keys and write the relocations
+  // on several threads, each handling a range of the relocations.
   template<class Output_reloc_writer>
   void
   do_write_generic(Output_file* of)
@@ -1622,23 +1685,33 @@ class Output_data_reloc_base : public Output_data_reloc_generic
     const off_t oview_size = this->data_size();
     unsigned char* const oview = of->get_output_view(off, oview_size);
 
+    const size_t count = this->relocs_.size();
+    gold_assert(static_cast<off_t>(count * reloc_size) == oview_size);
+
+    const size_t min_piece_size = 4096;
+    size_t pieces = Parallel_work::thread_count();
+    if (pieces > 1)
+      pieces *= 4;
+    if (pieces > count / min_piece_size)
+      pieces = count / min_piece_size;
+    if (pieces == 0)
+      pieces = 1;
+    const size_t piece_size = (count + pieces - 1) / pieces;
+
+    std::vector<Sort_key> keys;
     if (this->sort_relocs())
       {
 	gold_assert(dynamic);
-	std::sort(this->relocs_.begin(), this->relocs_.end(),
-		  Sort_relocs_comparison());
-      }
-
-    unsigned char* pov = oview;
-    for (typename Relocs::const_iterator p = this->relocs_.begin();
-	 p != this->relocs_.end();
-	 ++p)
-      {
-	Output_reloc_writer::write(p, pov);
-	pov += reloc_size;
+	keys.resize(count);
+	Sort_key_setter setter(&this->relocs_, &keys, piece_size);
+	setter.run(pieces);
+	parallel_sort(keys.begin(), keys.end(), Sort_key_compare());
       }
 
-    gold_assert(pov - oview == oview_size);
+    Reloc_writer<Output_reloc_writer> writer(&this->relocs_,
+					     keys.empty() ? NULL : &keys,
+					     oview, piece_size);
+    writer.run(pieces);
 
     of->write_output_view(off, oview_size, oview);
 
@@ -1677,13 +1750,76 @@ class Output_data_reloc_base : public Output_data_reloc_generic
 
  private:
   typedef std::vector<Output_reloc_type> Relocs;
+  typedef Output_reloc_sort_key<size> Sort_key;
 
   // The class used to sort the relocations.
-  struct Sort_relocs_comparison
+  struct Sort_key_compare
   {
     bool
-    operator()(const Output_reloc_type& r1, const Output_reloc_type& r2) const
-    { return r1.sort_before(r2); }
+    operator()(const Sort_key& k1, const Sort_key& k2) const
+    { return k1 < k2; }
+  };
+
+  // Set the sort keys for a range of the relocations in each piece.
+  class Sort_key_setter : public Parallel_work
+  {
+   public:
+    Sort_key_setter(const Relocs* relocs, std::vector<Sort_key>* keys,
+		    size_t piece_size)
+      : relocs_(relocs), keys_(keys), piece_size_(piece_size)
+    { }
+
+   protected:
+    void
+    do_run_piece(unsigned int piece)
+    {
+      size_t start = piece * this->piece_size_;
+      size_t end = std::min(start + this->piece_size_, this->relocs_->size());
+      for (size_t i = start; i < end; ++i)
+	{
+	  Sort_key* key = &(*this->keys_)[i];
+	  (*this->relocs_)[i].set_sort_key(key);
+	  key->index = i;
+	}
+    }
+
+   private:
+    const Relocs* relocs_;
+    std::vector<Sort_key>* keys_;
+    size_t piece_size_;
+  };
+
+  // Write a range of the relocations in each piece.  If KEYS is not
+  // NULL, write them in the order of KEYS.
+  template<class Output_reloc_writer>
+  class Reloc_writer : public Parallel_work
+  {
+   public:
+    Reloc_writer(const Relocs* relocs, const std::vector<Sort_key>* keys,
+		 unsigned char* oview, size_t piece_size)
+      : relocs_(relocs), keys_(keys), oview_(oview), piece_size_(piece_size)
+    { }
+
+   protected:
+    void
+    do_run_piece(unsigned int piece)
+    {
+      size_t start = piece * this->piece_size_;
+      size_t end = std::min(start + this->piece_size_, this->relocs_->size());
+      unsigned char* pov = this->oview_ + start * reloc_size;
+      for (size_t i = start; i < end; ++i)
+	{
+	  size_t index = this->keys_ == NULL ? i : (*this->keys_)[i].index;
+	  Output_reloc_writer::write(this->relocs_->begin() + index, pov);
+	  pov += reloc_size;
+	}
+    }
+
+   private:
+    const Relocs* relocs_;
+    const std::vector<Sort_key>* keys_;
+    unsigned char* oview_;
+    size_t piece_size_;
   };
 
   // The relocations in this section.
@@ -2344,6 +2480,129 @@ class Output_data_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>
   }
 };
 
+// Output_data_relr is used to manage a SHT_RELR section, which holds
+// relative dynamic relocs in the packed format used with DT_RELR.
+// The section is a list of words.  An even word is the address of a
+// word to relocate.  An odd word is a bitmap: bit I, counting from
+// 1, says to relocate the I'th word after the start of the bitmap.
+// The first bitmap after an address starts with the next word, and
+// each later bitmap starts SIZE - 1 words after the previous one.
+// The dynamic linker adds the load address to each word, so the
+// section contents must hold the link-time value.  Only relocs for
+// aligned words can be packed; the others must go in the ordinary
+// dynamic reloc section.
+
+// The size of the section depends on the final addresses of the
+// relocs.  A target which uses this section must relax, and call
+// update_entries on each relaxation pass.
+
+template<int size, bool big_endian>
+class Output_data_relr : public Output_section_data
+{
+ public:
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+
+  Output_data_relr()
+    : Output_section_data(size / 8), relocs_(), entries_(),
+      max_entries_(0)
+  { }
+
+  // Return whether a relative reloc for the word at ADDRESS in OD
+  // can be packed.
+  static bool
+  can_pack(const Output_data* od, Address address)
+  { return od->addralign() >= size / 8 && address % (size / 8) == 0; }
+
+  // Return whether a relative reloc for the word at ADDRESS in
+  // section SHNDX of RELOBJ can be packed.
+  static bool
+  can_pack(Sized_relobj<size, big_endian>* relobj, unsigned int shndx,
+	   Address address)
+  {
+    return (relobj->section_addralign(shndx) >= size / 8
+	    && address % (size / 8) == 0
+	    && !relobj->is_output_section_offset_invalid(shndx));
+  }
+
+  // Add a relative reloc for the word at ADDRESS in OD.
+  void
+  add(Output_data* od, Address address)
+  {
+    od->add_dynamic_reloc();
+    this->relocs_.push_back(Relr_reloc(od, NULL, 0, address));
+  }
+
+  // Add a relative reloc for the word at ADDRESS in section SHNDX of
+  // RELOBJ.  OD is the output section.
+  void
+  add(Output_data* od, Sized_relobj<size, big_endian>* relobj,
+      unsigned int shndx, Address address)
+  {
+    od->add_dynamic_reloc();
+    this->relocs_.push_back(Relr_reloc(od, relobj, shndx, address));
+  }
+
+  // Return the number of relocs.
+  size_t
+  reloc_count() const
+  { return this->relocs_.size(); }
+
+  // Compute the section contents from the addresses of the relocs,
+  // which must be set.  Return true if the section must grow, which
+  // means that the sections must be laid out again.  The section
+  // never shrinks, so that relaxation terminates; unused words are
+  // filled with empty bitmaps.
+  bool
+  update_entries();
+
+ protected:
+  void
+  set_final_data_size()
+  { this->set_data_size(this->max_entries_ * (size / 8)); }
+
+  // Write out the data.
+  void
+  do_write(Output_file*);
+
+  // Set the entry size.
+  void
+  do_adjust_output_section(Output_section* os);
+
+  // Write to a map file.
+  void
+  do_print_to_mapfile(Mapfile* mapfile) const
+  { mapfile->print_output_data(this, _("** packed relative relocs")); }
+
+ private:
+  // A relative reloc.  If RELOBJ is NULL, the reloc is at ADDRESS
+  // in OD.  Otherwise it is at ADDRESS in section SHNDX of RELOBJ.
+  struct Relr_reloc
+  {
+    Relr_reloc(Output_data* aod, Sized_relobj<size, big_endian>* arelobj,
+	       unsigned int ashndx, Address aaddress)
+      : od(aod), relobj(arelobj), shndx(ashndx), address(aaddress)
+    { }
+
+    Output_data* od;
+    Sized_relobj<size, big_endian>* relobj;
+    unsigned int shndx;
+    Address address;
+  };
+
+  static const Address invalid_address = static_cast<Address>(0) - 1;
+
+  // Return the final address of a reloc.
+  Address
+  reloc_address(const Relr_reloc&) const;
+
+  // The relocs.
+  std::vector<Relr_reloc> relocs_;
+  // The section contents, as computed by update_entries.
+  std::vector<Address> entries_;
+  // The size of the section in words.
+  size_t max_entries_;
+};
+
 // Output_relocatable_relocs represents a relocation section in a
 // relocatable link.  The actual data is written out in the target
 // hook relocate_relocs.  This just saves space for it.
@@ -2930,13 +3189,17 @@ class Output_symtab_xindex : public Output_section_data
  public:
   Output_symtab_xindex(size_t symcount)
     : Output_section_data(symcount * 4, 4, true),
-      entries_()
+      lock_(), entries_()
   { }
 
-  // Add an entry: symbol number SYMNDX has section SHNDX.
+  // Add an entry: symbol number SYMNDX has section SHNDX.  Symbols
+  // are written on several threads, so this takes a lock.
   void
   add(unsigned int symndx, unsigned int shndx)
-  { this->entries_.push_back(std::make_pair(symndx, shndx)); }
+  {
+    Hold_lock hl(this->lock_);
+    this->entries_.push_back(std::make_pair(symndx, shndx));
+  }
 
  protected:
   void
@@ -2957,6 +3220,8 @@ class Output_symtab_xindex : public Output_section_data
   // and section index.
   typedef std::vector<std::pair<unsigned int, unsigned int> > Xindex_entries;
 
+  // Lock for entries_.
+  Lock lock_;
   // The entries we need.
   Xindex_entries entries_;
 };
@@ -3300,6 +3565,12 @@ class Output_section : public Output_data
   void
   update_section_layout(const Section_layout_order* order_map);
 
+  // Give each input section which does not yet have a section order
+  // index an index starting at FIRST_INDEX, keeping the current order
+  // of those sections, so that they follow the ordered sections.
+  void
+  order_remaining_input_sections(unsigned int first_index);
+
   // Update the output section flags based on input section flags.
   void
   update_flags_for_input_section(elfcpp::Elf_Xword flags);
@@ -4056,6 +4327,17 @@ class Output_section : public Output_data
   const Output_relaxed_input_section*
   find_relaxed_input_section(const Relobj* object, unsigned int shndx) const;
 
+  // Rebuild the maps used by find_relaxed_input_section if they have
+  // been invalidated.  After this, and until the next change to the
+  // input sections, find_relaxed_input_section and output_address
+  // may be called on several threads at once.
+  void
+  validate_lookup_maps() const
+  {
+    if (!this->lookup_maps_->is_valid())
+      this->build_lookup_maps();
+  }
+
   // Whether section offsets need adjustment due to relaxation.
   bool
   section_offsets_need_adjustment() const
@@ -4090,6 +4372,16 @@ class Output_section : public Output_data
   void
   print_merge_stats();
 
+  // Return the number of input sections to print in the map file.
+  size_t
+  mapfile_input_section_count() const
+  { return this->input_sections_.size(); }
+
+  // Print input sections FIRST through LAST - 1 to the map file.
+  void
+  print_input_sections_to_mapfile(Mapfile*, size_t first,
+				  size_t last) const;
+
   // Set a fixed layout for the section.  Used for incremental update links.
   void
   set_fixed_layout(uint64_t sh_addr, off_t sh_offset, off_t sh_size,
@@ -4834,9 +5126,10 @@ class Output_segment
   write_section_headers(const Layout*, const Stringpool*, unsigned char* v,
 			unsigned int* pshndx) const;
 
-  // Print the output sections in the map file.
+  // Add the output sections and data to print in the map file to
+  // *PLIST.
   void
-  print_sections_to_mapfile(Mapfile*) const;
+  get_mapfile_sections(std::vector<const Output_data*>* plist) const;
 
  private:
   typedef std::vector<Output_data*> Output_data_list;
@@ -4883,10 +5176,6 @@ class Output_segment
 			     const Output_data_list*, unsigned char* v,
 			     unsigned int* pshdx) const;
 
-  // Print a section list to the mapfile.
-  void
-  print_section_list_to_mapfile(Mapfile*, const Output_data_list*) const;
-
   // NOTE: We want to use the copy constructor.  Currently, shallow copy
   // works for us so we do not need to write our own copy constructor.
 
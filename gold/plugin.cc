@@ -167,6 +167,15 @@ static enum ld_plugin_status
 get_input_section_size(const struct ld_plugin_section section,
                        uint64_t* secsize);
 
+static enum ld_plugin_status
+set_claim_file_thread_safe();
+
+static enum ld_plugin_status
+reserve_input_files(unsigned int count, unsigned int* first);
+
+static enum ld_plugin_status
+add_reserved_input_file(unsigned int index, const char* pathname);
+
 };
 
 #endif // ENABLE_PLUGINS
@@ -211,7 +220,7 @@ Plugin::load()
   sscanf(ver, "%d.%d", &major, &minor);
 
   // Allocate and populate a transfer vector.
-  const int tv_fixed_size = 29;
+  const int tv_fixed_size = 32;
 
   int tv_size = this->args_.size() + tv_fixed_size;
   ld_plugin_tv* tv = new ld_plugin_tv[tv_size];
@@ -345,6 +354,18 @@ Plugin::load()
   tv[i].tv_tag = LDPT_GET_INPUT_SECTION_SIZE;
   tv[i].tv_u.tv_get_input_section_size = get_input_section_size;
 
+  ++i;
+  tv[i].tv_tag = LDPT_SET_CLAIM_FILE_THREAD_SAFE;
+  tv[i].tv_u.tv_set_claim_file_thread_safe = gold::set_claim_file_thread_safe;
+
+  ++i;
+  tv[i].tv_tag = LDPT_RESERVE_INPUT_FILES;
+  tv[i].tv_u.tv_reserve_input_files = reserve_input_files;
+
+  ++i;
+  tv[i].tv_tag = LDPT_ADD_RESERVED_INPUT_FILE;
+  tv[i].tv_u.tv_add_reserved_input_file = add_reserved_input_file;
+
   ++i;
   tv[i].tv_tag = LDPT_NULL;
   tv[i].tv_u.tv_val = 0;
@@ -437,6 +458,47 @@ class Plugin_rescan : public Task
   Task_token* next_blocker_;
 };
 
+// This task takes the place of a reserved input file which the plugin
+// did not add, so that the input files after it are still processed.
+
+class Plugin_skip_input_file : public Task
+{
+ public:
+  Plugin_skip_input_file(Task_token* this_blocker, Task_token* next_blocker)
+    : this_blocker_(this_blocker), next_blocker_(next_blocker)
+  { }
+
+  ~Plugin_skip_input_file()
+  {
+    if (this->this_blocker_ != NULL)
+      delete this->this_blocker_;
+  }
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->this_blocker_ != NULL && this->this_blocker_->is_blocked())
+      return this->this_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->next_blocker_); }
+
+  void
+  run(Workqueue*)
+  { }
+
+  std::string
+  get_name() const
+  { return "Plugin_skip_input_file"; }
+
+ private:
+  Task_token* this_blocker_;
+  Task_token* next_blocker_;
+};
+
 // Plugin_manager methods.
 
 Plugin_manager::~Plugin_manager()
@@ -452,66 +514,144 @@ Plugin_manager::~Plugin_manager()
     delete *obj;
   this->objects_.clear();
   delete this->lock_;
+  delete this->claim_lock_;
 }
 
 // Load all plugin libraries.
 
 void
-Plugin_manager::load_plugins(Layout* layout)
+Plugin_manager::load_plugins(Layout* layout, const Command_line& cmdline)
 {
   this->layout_ = layout;
   for (this->current_ = this->plugins_.begin();
        this->current_ != this->plugins_.end();
        ++this->current_)
     (*this->current_)->load();
+
+  for (Command_line::const_iterator p = cmdline.begin();
+       p != cmdline.end();
+       ++p)
+    this->allocate_input_handles(&*p);
+}
+
+// Allocate the handles of the files named by INPUT_ARGUMENT.  This
+// is called before any file is read.
+
+void
+Plugin_manager::allocate_input_handles(const Input_argument* input_argument)
+{
+  if (input_argument->is_file())
+    {
+      this->input_handles_[input_argument] = this->objects_.size();
+      this->objects_.push_back(NULL);
+    }
+  else if (input_argument->is_group())
+    {
+      const Input_file_group* group = input_argument->group();
+      for (Input_file_group::const_iterator p = group->begin();
+	   p != group->end();
+	   ++p)
+	this->allocate_input_handles(&*p);
+    }
+  else
+    {
+      const Input_file_lib* lib = input_argument->lib();
+      for (Input_file_lib::const_iterator p = lib->begin();
+	   p != lib->end();
+	   ++p)
+	this->allocate_input_handles(&*p);
+    }
 }
 
 // Call the plugin claim-file handlers in turn to see if any claim the file.
+// This may be called from several threads at once.  The claim-file
+// handlers of plugins which are not thread-safe are called one at a
+// time.
 
 Pluginobj*
 Plugin_manager::claim_file(Input_file* input_file, off_t offset,
-                           off_t filesize, Object* elf_object)
+                           off_t filesize, Object* elf_object,
+			   const Input_argument* input_argument)
 {
-  bool lock_initialized = this->initialize_lock_.initialize();
+  bool lock_initialized = (this->initialize_lock_.initialize()
+			   && this->initialize_claim_lock_.initialize());
 
   gold_assert(lock_initialized);
-  Hold_lock hl(*this->lock_);
-  if (this->in_replacement_phase_)
-    return NULL;
 
-  unsigned int handle = this->objects_.size();
-  this->input_file_ = input_file;
-  this->plugin_input_file_.name = input_file->filename().c_str();
-  this->plugin_input_file_.fd = input_file->file().descriptor();
-  this->plugin_input_file_.offset = offset;
-  this->plugin_input_file_.filesize = filesize;
-  this->plugin_input_file_.handle = reinterpret_cast<void*>(handle);
-  if (elf_object != NULL)
-    this->objects_.push_back(elf_object);
-  this->in_claim_file_handler_ = true;
+  Claim claim;
+  unsigned int handle;
+  {
+    Hold_lock hl(*this->lock_);
+    if (this->in_replacement_phase_)
+      return NULL;
+
+    Input_handle_map::const_iterator p =
+      (input_argument == NULL
+       ? this->input_handles_.end()
+       : this->input_handles_.find(input_argument));
+    if (p != this->input_handles_.end())
+      {
+	handle = p->second;
+	this->objects_[handle] = elf_object;
+      }
+    else
+      {
+	handle = this->objects_.size();
+	this->objects_.push_back(elf_object);
+      }
+    claim.input_file = input_file;
+    claim.plugin_input_file.name = input_file->filename().c_str();
+    claim.plugin_input_file.fd = input_file->file().descriptor();
+    claim.plugin_input_file.offset = offset;
+    claim.plugin_input_file.filesize = filesize;
+    claim.plugin_input_file.handle = reinterpret_cast<void*>(handle);
+    this->claims_[handle] = &claim;
+  }
 
-  for (this->current_ = this->plugins_.begin();
-       this->current_ != this->plugins_.end();
-       ++this->current_)
+  bool claimed = false;
+  for (Plugin_list::iterator p = this->plugins_.begin();
+       p != this->plugins_.end() && !claimed;
+       ++p)
     {
-      if ((*this->current_)->claim_file(&this->plugin_input_file_))
-        {
-	  this->any_claimed_ = true;
-	  this->in_claim_file_handler_ = false;
+      if ((*p)->claim_file_thread_safe())
+	claimed = (*p)->claim_file(&claim.plugin_input_file);
+      else
+	{
+	  Hold_lock hl(*this->claim_lock_);
+	  claimed = (*p)->claim_file(&claim.plugin_input_file);
+	}
+    }
 
-          if (this->objects_.size() > handle
-              && this->objects_[handle]->pluginobj() != NULL)
-            return this->objects_[handle]->pluginobj();
+  Pluginobj* obj = NULL;
+  if (claimed)
+    {
+      Object* elf_or_plugin_obj = this->object(handle);
+      if (elf_or_plugin_obj != NULL)
+	obj = elf_or_plugin_obj->pluginobj();
 
-          // If the plugin claimed the file but did not call the
-          // add_symbols callback, we need to create the Pluginobj now.
-          Pluginobj* obj = this->make_plugin_object(handle);
-          return obj;
-        }
+      // If the plugin claimed the file but did not call the
+      // add_symbols callback, we need to create the Pluginobj now.
+      if (obj == NULL)
+	obj = this->make_plugin_object(handle);
     }
 
-  this->in_claim_file_handler_ = false;
-  return NULL;
+  Hold_lock hl(*this->lock_);
+  this->claims_.erase(handle);
+  if (claimed)
+    this->any_claimed_ = true;
+  return obj;
+}
+
+// Return the claim in progress for HANDLE.
+
+const Plugin_manager::Claim*
+Plugin_manager::find_claim(unsigned int handle) const
+{
+  Hold_optional_lock hl(this->lock_);
+  Claim_map::const_iterator p = this->claims_.find(handle);
+  if (p == this->claims_.end())
+    return NULL;
+  return p->second;
 }
 
 // Save an archive.  This is used so that a plugin can add a file
@@ -557,11 +697,32 @@ Plugin_manager::all_symbols_read(Workqueue* workqueue, Task* task,
   this->mapfile_ = mapfile;
   this->this_blocker_ = NULL;
 
+  // The plugins may add input files from other threads.
+  bool lock_initialized = this->initialize_lock_.initialize();
+  gold_assert(lock_initialized);
+
   for (this->current_ = this->plugins_.begin();
        this->current_ != this->plugins_.end();
        ++this->current_)
     (*this->current_)->all_symbols_read();
 
+  {
+    Hold_lock hl(*this->lock_);
+    this->reserved_input_files_closed_ = true;
+  }
+
+  for (size_t i = 0; i < this->reserved_input_files_.size(); ++i)
+    {
+      const Reserved_input_file& r(this->reserved_input_files_[i]);
+      if (!r.added)
+	{
+	  gold_error(_("plugin did not add reserved input file %u"),
+		     static_cast<unsigned int>(i));
+	  workqueue->queue(new Plugin_skip_input_file(r.this_blocker,
+						      r.next_blocker));
+	}
+    }
+
   if (this->any_added_)
     {
       Task_token* next_blocker = new Task_token(true);
@@ -747,22 +908,26 @@ Plugin_manager::cleanup()
 Pluginobj*
 Plugin_manager::make_plugin_object(unsigned int handle)
 {
+  Hold_optional_lock hl(this->lock_);
+
+  // The file must be up for claim.
+  Claim_map::const_iterator p = this->claims_.find(handle);
+  if (p == this->claims_.end())
+    return NULL;
+
   // Make sure we aren't asked to make an object for the same handle twice.
-  if (this->objects_.size() != handle
+  if (this->objects_[handle] != NULL
       && this->objects_[handle]->pluginobj() != NULL)
     return NULL;
 
-  Pluginobj* obj = make_sized_plugin_object(this->input_file_,
-                                            this->plugin_input_file_.offset,
-                                            this->plugin_input_file_.filesize);
-
+  const Claim* claim = p->second;
+  Pluginobj* obj = make_sized_plugin_object(claim->input_file,
+                                            claim->plugin_input_file.offset,
+                                            claim->plugin_input_file.filesize);
 
-  // If the elf object for this file was pushed into the objects_ vector, delete
-  // it to make room for the Pluginobj as this file is claimed.
-  if (this->objects_.size() != handle)
-    this->objects_.pop_back();
-
-  this->objects_.push_back(obj);
+  // If the elf object for this file was stored in the objects_ vector,
+  // replace it with the Pluginobj as this file is claimed.
+  this->objects_[handle] = obj;
   return obj;
 }
 
@@ -826,13 +991,14 @@ Plugin_manager::get_view(unsigned int handle, const void **viewp)
   off_t offset;
   size_t filesize;
   Input_file *input_file;
-  if (this->in_claim_file_handler_)
+  const Claim* claim = this->find_claim(handle);
+  if (claim != NULL)
     {
       // We are being called from the claim_file hook.
-      const struct ld_plugin_input_file &f = this->plugin_input_file_;
+      const struct ld_plugin_input_file &f = claim->plugin_input_file;
       offset = f.offset;
       filesize = f.filesize;
-      input_file = this->input_file_;
+      input_file = claim->input_file;
     }
   else
     {
@@ -864,6 +1030,79 @@ Plugin_manager::set_extra_library_path(const char* path)
 
 ld_plugin_status
 Plugin_manager::add_input_file(const char* pathname, bool is_lib)
+{
+  Task_token* next_blocker = new Task_token(true);
+  next_blocker->add_blocker();
+  Task_token* this_blocker;
+  {
+    Hold_optional_lock hl(this->lock_);
+    this_blocker = this->this_blocker_;
+    this->this_blocker_ = next_blocker;
+    this->any_added_ = true;
+  }
+  this->queue_input_file(pathname, is_lib, this_blocker, next_blocker);
+  return LDPS_OK;
+}
+
+// Reserve COUNT positions for input files, after any files already
+// added.  This lets a plugin add each file as soon as it is ready,
+// in any order, while the files are still processed in the order of
+// their positions, so that the output does not depend on the order
+// in which they became ready.
+
+ld_plugin_status
+Plugin_manager::reserve_input_files(unsigned int count, unsigned int* first)
+{
+  Hold_optional_lock hl(this->lock_);
+  if (!this->in_replacement_phase_ || this->reserved_input_files_closed_)
+    return LDPS_ERR;
+
+  *first = this->reserved_input_files_.size();
+  for (unsigned int i = 0; i < count; ++i)
+    {
+      Task_token* next_blocker = new Task_token(true);
+      next_blocker->add_blocker();
+      this->reserved_input_files_.push_back(
+	  Reserved_input_file(this->this_blocker_, next_blocker));
+      this->this_blocker_ = next_blocker;
+    }
+  if (count > 0)
+    this->any_added_ = true;
+  return LDPS_OK;
+}
+
+// Add the input file for the reserved position INDEX.  We start
+// reading the file right away; adding its symbols waits for the files
+// in the earlier positions.  This may be called from a thread started
+// by the plugin.
+
+ld_plugin_status
+Plugin_manager::add_reserved_input_file(unsigned int index,
+					const char* pathname)
+{
+  Task_token* this_blocker;
+  Task_token* next_blocker;
+  {
+    Hold_optional_lock hl(this->lock_);
+    if (this->reserved_input_files_closed_
+	|| index >= this->reserved_input_files_.size()
+	|| this->reserved_input_files_[index].added)
+      return LDPS_ERR;
+    Reserved_input_file* r = &this->reserved_input_files_[index];
+    r->added = true;
+    this_blocker = r->this_blocker;
+    next_blocker = r->next_blocker;
+  }
+  this->queue_input_file(pathname, false, this_blocker, next_blocker);
+  return LDPS_OK;
+}
+
+// Queue a Read_symbols task for an input file added by a plugin.
+
+void
+Plugin_manager::queue_input_file(const char* pathname, bool is_lib,
+				 Task_token* this_blocker,
+				 Task_token* next_blocker)
 {
   Input_file_argument file(pathname,
                            (is_lib
@@ -875,8 +1114,6 @@ Plugin_manager::add_input_file(const char* pathname, bool is_lib)
                            false,
                            this->options_);
   Input_argument* input_argument = new Input_argument(file);
-  Task_token* next_blocker = new Task_token(true);
-  next_blocker->add_blocker();
   if (parameters->incremental())
     gold_error(_("input files added by plug-ins in --incremental mode not "
 		 "supported yet"));
@@ -889,11 +1126,8 @@ Plugin_manager::add_input_file(const char* pathname, bool is_lib)
                                                 input_argument,
                                                 NULL,
                                                 NULL,
-                                                this->this_blocker_,
+                                                this_blocker,
                                                 next_blocker));
-  this->this_blocker_ = next_blocker;
-  this->any_added_ = true;
-  return LDPS_OK;
 }
 
 // Class Pluginobj.
@@ -1085,6 +1319,10 @@ Sized_pluginobj<size, big_endian>::do_add_symbols(Symbol_table* symtab,
   elfcpp::Sym<size, big_endian> sym(symbuf);
   elfcpp::Sym_write<size, big_endian> osym(symbuf);
 
+  // The regular objects after this one are laid out after the
+  // replacement files.
+  parameters->options().plugins()->set_claimed_added();
+
   this->symbols_.resize(this->nsyms_);
 
   for (int i = 0; i < this->nsyms_; ++i)
@@ -1656,7 +1894,7 @@ get_input_section_count(const void* handle, unsigned int* count)
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(handle))
     return LDPS_ERR;
 
   Object* obj = parameters->options().plugins()->get_elf_object(handle);
@@ -1678,7 +1916,8 @@ get_input_section_type(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(
+          section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1701,7 +1940,8 @@ get_input_section_name(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(
+          section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1730,7 +1970,8 @@ get_input_section_contents(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(
+          section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1759,7 +2000,8 @@ get_input_section_alignment(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(
+          section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1782,7 +2024,8 @@ get_input_section_size(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(
+          section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1796,6 +2039,36 @@ get_input_section_size(const struct ld_plugin_section section,
 }
 
 
+// Record that the claim-file handler of the plugin being loaded may be
+// called from several threads at once.
+
+static enum ld_plugin_status
+set_claim_file_thread_safe()
+{
+  gold_assert(parameters->options().has_plugins());
+  parameters->options().plugins()->set_claim_file_thread_safe();
+  return LDPS_OK;
+}
+
+// Reserve positions for input files which the plugin will add later.
+
+static enum ld_plugin_status
+reserve_input_files(unsigned int count, unsigned int* first)
+{
+  gold_assert(parameters->options().has_plugins());
+  return parameters->options().plugins()->reserve_input_files(count, first);
+}
+
+// Add the input file for a reserved position.
+
+static enum ld_plugin_status
+add_reserved_input_file(unsigned int index, const char* pathname)
+{
+  gold_assert(parameters->options().has_plugins());
+  return parameters->options().plugins()->add_reserved_input_file(index,
+								  pathname);
+}
+
 // Specify the ordering of sections in the final layout. The sections are
 // specified as (handle,shndx) pairs in the two arrays in the order in
 // which they should appear in the final layout.
@@ -24,6 +24,7 @@
 #define GOLD_PLUGIN_H
 
 #include <list>
+#include <map>
 #include <string>
 
 #include "object.h"
@@ -34,6 +35,8 @@ namespace gold
 {
 
 class General_options;
+class Command_line;
+class Input_argument;
 class Input_file;
 class Input_objects;
 class Archive;
@@ -60,6 +63,7 @@ class Plugin
       claim_file_handler_(NULL),
       all_symbols_read_handler_(NULL),
       cleanup_handler_(NULL),
+      claim_file_thread_safe_(false),
       cleanup_done_(false)
   { }
 
@@ -97,6 +101,18 @@ class Plugin
   set_cleanup_handler(ld_plugin_cleanup_handler handler)
   { this->cleanup_handler_ = handler; }
 
+  // Record that the claim-file handler may be called from several
+  // threads at once.
+  void
+  set_claim_file_thread_safe()
+  { this->claim_file_thread_safe_ = true; }
+
+  // Return whether the claim-file handler may be called from several
+  // threads at once.
+  bool
+  claim_file_thread_safe() const
+  { return this->claim_file_thread_safe_; }
+
   // Add an argument
   void
   add_option(const char* arg)
@@ -118,6 +134,8 @@ class Plugin
   ld_plugin_claim_file_handler claim_file_handler_;
   ld_plugin_all_symbols_read_handler all_symbols_read_handler_;
   ld_plugin_cleanup_handler cleanup_handler_;
+  // TRUE if the claim-file handler is thread-safe.
+  bool claim_file_thread_safe_;
   // TRUE if the cleanup handlers have been called.
   bool cleanup_done_;
 };
@@ -128,14 +146,17 @@ class Plugin_manager
 {
  public:
   Plugin_manager(const General_options& options)
-    : plugins_(), objects_(), deferred_layout_objects_(), input_file_(NULL),
-      plugin_input_file_(), rescannable_(), undefined_symbols_(),
-      any_claimed_(false), in_replacement_phase_(false), any_added_(false),
-      in_claim_file_handler_(false),
+    : plugins_(), objects_(), input_handles_(), deferred_layout_objects_(),
+      claims_(),
+      rescannable_(), undefined_symbols_(),
+      any_claimed_(false), any_claimed_added_(false),
+      in_replacement_phase_(false), any_added_(false),
+      reserved_input_files_(), reserved_input_files_closed_(false),
       options_(options), workqueue_(NULL), task_(NULL), input_objects_(NULL),
       symtab_(NULL), layout_(NULL), dirpath_(NULL), mapfile_(NULL),
       this_blocker_(NULL), extra_search_path_(), lock_(NULL),
-      initialize_lock_(&lock_)
+      initialize_lock_(&lock_), claim_lock_(NULL),
+      initialize_claim_lock_(&claim_lock_)
   { this->current_ = plugins_.end(); }
 
   ~Plugin_manager();
@@ -153,24 +174,31 @@ class Plugin_manager
     last->add_option(opt);
   }
 
-  // Load all plugin libraries.
+  // Load all plugin libraries, and allocate the handles of the input
+  // files named in CMDLINE.
   void
-  load_plugins(Layout* layout);
+  load_plugins(Layout* layout, const Command_line& cmdline);
 
   // Call the plugin claim-file handlers in turn to see if any claim the file.
+  // INPUT_ARGUMENT is the argument which named the file, or NULL for an
+  // archive member.
   Pluginobj*
   claim_file(Input_file* input_file, off_t offset, off_t filesize,
-             Object* elf_object);
+             Object* elf_object, const Input_argument* input_argument);
 
   // Get the object associated with the handle and check if it is an elf object.
   // If it is not a Pluginobj, it is an elf object.
   Object*
   get_elf_object(const void* handle);
 
-  // True if the claim_file handler of the plugins is being called.
+  // True if the claim_file handler of the plugins is being called
+  // for the file with handle HANDLE.
   bool
-  in_claim_file_handler()
-  { return in_claim_file_handler_; }
+  in_claim_file_handler(const void* handle)
+  {
+    return this->find_claim(
+        static_cast<unsigned int>(reinterpret_cast<intptr_t>(handle))) != NULL;
+  }
 
   // Let the plugin manager save an archive for later rescanning.
   // This takes ownership of the Archive pointer.
@@ -226,6 +254,15 @@ class Plugin_manager
     (*this->current_)->set_cleanup_handler(handler);
   }
 
+  // Record that the claim-file handler of the current plugin is
+  // thread-safe.
+  void
+  set_claim_file_thread_safe()
+  {
+    gold_assert(this->current_ != plugins_.end());
+    (*this->current_)->set_claim_file_thread_safe();
+  }
+
   // Make a new Pluginobj object.  This is called when the plugin calls
   // the add_symbols API.
   Pluginobj*
@@ -235,16 +272,25 @@ class Plugin_manager
   Object*
   object(unsigned int handle) const
   {
+    Hold_optional_lock hl(this->lock_);
     if (handle >= this->objects_.size())
       return NULL;
     return this->objects_[handle];
   }
 
-  // Return TRUE if any input files have been claimed by a plugin
-  // and we are still in the initial input phase.
+  // Return TRUE if the symbols of any input file claimed by a plugin
+  // have been added and we are still in the initial input phase.
+  // Symbols are added in input order, so this does not depend on the
+  // order in which the files were claimed when reading them in
+  // parallel.
   bool
   should_defer_layout() const
-  { return this->any_claimed_ && !this->in_replacement_phase_; }
+  { return this->any_claimed_added_ && !this->in_replacement_phase_; }
+
+  // Record that the symbols of a claimed input file have been added.
+  void
+  set_claimed_added()
+  { this->any_claimed_added_ = true; }
 
   // Add a regular object to the deferred layout list.  These are
   // objects whose layout has been deferred until after the
@@ -269,6 +315,15 @@ class Plugin_manager
   ld_plugin_status
   add_input_file(const char* pathname, bool is_lib);
 
+  // Reserve COUNT positions for input files which will be added
+  // later.  Set *FIRST to the index of the first one.
+  ld_plugin_status
+  reserve_input_files(unsigned int count, unsigned int* first);
+
+  // Add the input file for the reserved position INDEX.
+  ld_plugin_status
+  add_reserved_input_file(unsigned int index, const char* pathname);
+
   // Set the extra library path.
   ld_plugin_status
   set_extra_library_path(const char* path);
@@ -317,11 +372,52 @@ class Plugin_manager
     { this->u.input_group = input_group; }
   };
 
+  // The file up for claim by the plugins in a call to claim_file.
+  struct Claim
+  {
+    Input_file* input_file;
+    struct ld_plugin_input_file plugin_input_file;
+  };
+
   typedef std::list<Plugin*> Plugin_list;
   typedef std::vector<Object*> Object_list;
   typedef std::vector<Relobj*> Deferred_layout_list;
   typedef std::vector<Rescannable> Rescannable_list;
   typedef std::vector<Symbol*> Undefined_symbol_list;
+  typedef std::map<unsigned int, const Claim*> Claim_map;
+  typedef std::map<const Input_argument*, unsigned int> Input_handle_map;
+
+  // A position reserved for an input file by reserve_input_files.
+  struct Reserved_input_file
+  {
+    Reserved_input_file(Task_token* athis_blocker, Task_token* anext_blocker)
+      : this_blocker(athis_blocker), next_blocker(anext_blocker),
+	added(false)
+    { }
+
+    // The blockers to pass to the Read_symbols task for the file.
+    Task_token* this_blocker;
+    Task_token* next_blocker;
+    // Whether the file has been added.
+    bool added;
+  };
+
+  typedef std::vector<Reserved_input_file> Reserved_input_file_list;
+
+  // Queue a task to read the input file PATHNAME.
+  void
+  queue_input_file(const char* pathname, bool is_lib,
+		   Task_token* this_blocker, Task_token* next_blocker);
+
+  // Allocate the handles of the files named by INPUT_ARGUMENT, which
+  // may be a group or a lib, in order.
+  void
+  allocate_input_handles(const Input_argument* input_argument);
+
+  // Return the claim in progress for the file with handle HANDLE, or
+  // NULL if there is none.
+  const Claim*
+  find_claim(unsigned int handle) const;
 
   // Rescan archives for undefined symbols.
   void
@@ -337,15 +433,24 @@ class Plugin_manager
   Plugin_list::iterator current_;
 
   // The list of plugin objects.  The index of an item in this list
-  // serves as the "handle" that we pass to the plugins.
+  // serves as the "handle" that we pass to the plugins.  The files
+  // named on the command line take the first handles, in command line
+  // order, so the handle of a file does not depend on the order in
+  // which the files are read.  Other files, such as archive members,
+  // are given the next handle when they are offered to the plugins.
+  // An entry is NULL if its file is neither an ELF object nor claimed.
   Object_list objects_;
 
+  // The handles of the files named on the command line.
+  Input_handle_map input_handles_;
+
   // The list of regular objects whose layout has been deferred.
   Deferred_layout_list deferred_layout_objects_;
 
-  // The file currently up for claim by the plugins.
-  Input_file* input_file_;
-  struct ld_plugin_input_file plugin_input_file_;
+  // The files currently up for claim by the plugins, indexed by
+  // handle.  There is more than one only if a claim-file handler is
+  // thread-safe.
+  Claim_map claims_;
 
   // A list of archives and input groups being saved for possible
   // later rescanning.
@@ -357,6 +462,11 @@ class Plugin_manager
   // Whether any input files have been claimed by a plugin.
   bool any_claimed_;
 
+  // Whether the symbols of any claimed input file have been added.
+  // This is only used by the tasks which add symbols, which run one
+  // at a time in input order.
+  bool any_claimed_added_;
+
   // Set to true after the all symbols read event; indicates that we
   // are processing replacement files whose symbols should replace the
   // placeholder symbols from the Pluginobj objects.
@@ -365,8 +475,12 @@ class Plugin_manager
   // Whether any input files or libraries were added by a plugin.
   bool any_added_;
 
-  // Set to true when the claim_file handler of a plugin is called.
-  bool in_claim_file_handler_;
+  // The positions reserved for input files by the plugins.
+  Reserved_input_file_list reserved_input_files_;
+
+  // Set to true after the all-symbols-read handlers return, when no
+  // more reserved input files may be added.
+  bool reserved_input_files_closed_;
 
   const General_options& options_;
   Workqueue* workqueue_;
@@ -381,8 +495,14 @@ class Plugin_manager
   // An extra directory to search for the libraries passed by
   // add_input_library.
   std::string extra_search_path_;
+  // Protects objects_, claims_, any_claimed_, and, in the
+  // replacement phase, this_blocker_, any_added_ and
+  // reserved_input_files_.
   Lock* lock_;
   Initialize_lock initialize_lock_;
+  // Held while calling a claim-file handler which is not thread-safe.
+  Lock* claim_lock_;
+  Initialize_lock initialize_claim_lock_;
 };
 
 
@@ -2070,8 +2070,11 @@ Powerpc_relobj<size, big_endian>::do_read_relocs(Read_relocs_data* rd)
 	      gold_assert(opd_size == static_cast<size_t>(opd_size));
 	      if (opd_size != 0)
 		{
+		  std::vector<unsigned char> buf;
 		  this->init_opd(opd_size);
-		  this->scan_opd_relocs(p->reloc_count, p->contents->data(),
+		  this->scan_opd_relocs(p->reloc_count,
+					this->section_relocs_contents(*p,
+								      &buf),
 					rd->local_symbols->data());
 		}
 	      break;
@@ -0,0 +1,561 @@
+// prefetch.cc -- read ahead the input files for gold
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef ENABLE_THREADS
+#include <pthread.h>
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include "filenames.h"
+#include "elfcpp.h"
+
+#include "parameters.h"
+#include "options.h"
+#include "gold-threads.h"
+#include "prefetch.h"
+
+// O_CLOEXEC is only available on newer systems.
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+namespace gold
+{
+
+// An input file being prefetched.
+
+struct Input_prefetcher::File
+{
+  File(const std::string& name)
+    : name(name), descriptor(-1), file_size(0), elfclass(0),
+      big_endian(false), shoff(0), shsize(0), over_budget(false)
+  { }
+
+  // The name of the file.
+  std::string name;
+  // The descriptor, or -1 if we are done with the file.
+  int descriptor;
+  // The size of the file.
+  off_t file_size;
+  // The ELF class, or 0 if this is not an ELF file.
+  int elfclass;
+  // Whether the ELF file is big-endian.
+  bool big_endian;
+  // The offset and size of the ELF section headers.
+  off_t shoff;
+  off_t shsize;
+  // Whether we left out part of the file to stay within the budget.
+  bool over_budget;
+};
+
+// The number of files we open at once.  All the files in a batch are
+// advised before we wait for any of them, so that the kernel can read
+// them together.
+
+static const size_t prefetch_batch_size = 64;
+
+// The number of bytes we prefetch at the start of each file.  This
+// covers the ELF header or the archive header.
+
+static const off_t prefetch_header_size = 4096;
+
+Input_prefetcher* Input_prefetcher::prefetcher_;
+
+#ifdef ENABLE_THREADS
+// The prefetching thread, if prefetching_thread_started is true.
+static pthread_t prefetching_thread;
+static bool prefetching_thread_started;
+#endif
+
+// Start prefetching.  We find the input files here, so that the
+// prefetching thread does not look at the command line while the link
+// is running.
+
+void
+Input_prefetcher::start(Command_line* command_line)
+{
+  const General_options& options(command_line->options());
+  if (!options.prefetch_inputs())
+    return;
+
+#ifndef POSIX_FADV_WILLNEED
+  gold_warning(_("--prefetch-inputs is not supported on this host"));
+#else
+  Input_prefetcher* prefetcher =
+    new Input_prefetcher(options.prefetch_budget());
+  prefetcher->add_inputs(&command_line->inputs());
+  Input_prefetcher::prefetcher_ = prefetcher;
+
+#ifdef ENABLE_THREADS
+  if (options.threads())
+    {
+      int err = pthread_create(&prefetching_thread, NULL,
+			       &Input_prefetcher::thread_body,
+			       reinterpret_cast<void*>(prefetcher));
+      if (err == 0)
+	{
+	  prefetching_thread_started = true;
+	  return;
+	}
+    }
+#endif
+
+  prefetcher->run();
+#endif // defined(POSIX_FADV_WILLNEED)
+}
+
+// Wait for the prefetching thread.
+
+void
+Input_prefetcher::finish()
+{
+#ifdef ENABLE_THREADS
+  if (prefetching_thread_started)
+    {
+      int err = pthread_join(prefetching_thread, NULL);
+      if (err != 0)
+	gold_fatal(_("pthread_join failed: %s"), strerror(err));
+      prefetching_thread_started = false;
+    }
+#endif
+}
+
+// Passed to pthread_create.
+
+extern "C"
+void*
+Input_prefetcher::thread_body(void* arg)
+{
+  reinterpret_cast<Input_prefetcher*>(arg)->run();
+  return NULL;
+}
+
+// Add the files in INPUTS, including those in groups and libs.
+
+void
+Input_prefetcher::add_inputs(const Input_arguments* inputs)
+{
+  for (Input_arguments::const_iterator p = inputs->begin();
+       p != inputs->end();
+       ++p)
+    {
+      if (p->is_file())
+	this->add_input(p->file());
+      else if (p->is_group())
+	{
+	  const Input_file_group* group = p->group();
+	  for (Input_file_group::const_iterator q = group->begin();
+	       q != group->end();
+	       ++q)
+	    this->add_input(q->file());
+	}
+      else
+	{
+	  const Input_file_lib* lib = p->lib();
+	  for (Input_file_lib::const_iterator q = lib->begin();
+	       q != lib->end();
+	       ++q)
+	    this->add_input(q->file());
+	}
+    }
+}
+
+// Add the file for INPUT_ARGUMENT.  This follows the search rules of
+// Input_file::find_file, but only looks for the first match in the
+// library path; we do not need to be exact, and any file we miss will
+// simply be read when it is needed.
+
+void
+Input_prefetcher::add_input(const Input_file_argument& input_argument)
+{
+  if (input_argument.just_symbols())
+    return;
+
+  if (IS_ABSOLUTE_PATH(input_argument.name())
+      || (!input_argument.is_lib()
+	  && !input_argument.is_searched_file()
+	  && input_argument.extra_search_path() == NULL))
+    {
+      this->names_.push_back(input_argument.name());
+      return;
+    }
+
+  std::vector<std::string> names;
+  if (!input_argument.is_lib())
+    names.push_back(input_argument.name());
+  else
+    {
+      std::string prefix = "lib";
+      prefix += input_argument.name();
+      if (!parameters->options().is_static()
+	  && input_argument.options().Bdynamic())
+	names.push_back(prefix + ".so");
+      names.push_back(prefix + ".a");
+    }
+
+  std::vector<std::string> dirs;
+  if (input_argument.extra_search_path() != NULL)
+    dirs.push_back(input_argument.extra_search_path());
+  const General_options::Dir_list& library_path =
+    parameters->options().library_path();
+  for (General_options::Dir_list::const_iterator p = library_path.begin();
+       p != library_path.end();
+       ++p)
+    dirs.push_back(p->name());
+
+  for (std::vector<std::string>::const_iterator d = dirs.begin();
+       d != dirs.end();
+       ++d)
+    {
+      for (std::vector<std::string>::const_iterator n = names.begin();
+	   n != names.end();
+	   ++n)
+	{
+	  std::string name = *d;
+	  if (!IS_DIR_SEPARATOR(name[name.length() - 1]))
+	    name += '/';
+	  name += *n;
+	  struct stat st;
+	  if (::stat(name.c_str(), &st) == 0)
+	    {
+	      this->names_.push_back(name);
+	      return;
+	    }
+	}
+    }
+}
+
+// Prefetch the files in batches.
+
+void
+Input_prefetcher::run()
+{
+  std::vector<File> batch;
+  batch.reserve(prefetch_batch_size);
+  for (std::vector<std::string>::const_iterator p = this->names_.begin();
+       p != this->names_.end();
+       ++p)
+    {
+      batch.push_back(File(*p));
+      if (batch.size() == prefetch_batch_size)
+	{
+	  this->prefetch_batch(&batch);
+	  batch.clear();
+	}
+    }
+  if (!batch.empty())
+    this->prefetch_batch(&batch);
+}
+
+// Prefetch a batch of files.  Each step only reads data which the
+// previous step asked for, so all the files in the batch are read in
+// parallel.
+
+void
+Input_prefetcher::prefetch_batch(std::vector<File>* batch)
+{
+  for (std::vector<File>::iterator p = batch->begin();
+       p != batch->end();
+       ++p)
+    {
+      int o = ::open(p->name.c_str(), O_RDONLY | O_CLOEXEC);
+      if (o < 0)
+	continue;
+      struct stat st;
+      if (::fstat(o, &st) < 0 || !S_ISREG(st.st_mode))
+	{
+	  ::close(o);
+	  continue;
+	}
+      p->descriptor = o;
+      p->file_size = st.st_size;
+      if (this->advise(&*p, 0, prefetch_header_size))
+	++this->files_;
+      else
+	{
+	  ++this->files_over_budget_;
+	  ::close(o);
+	  p->descriptor = -1;
+	}
+    }
+
+  for (std::vector<File>::iterator p = batch->begin();
+       p != batch->end();
+       ++p)
+    if (p->descriptor >= 0)
+      this->read_header(&*p);
+
+  for (std::vector<File>::iterator p = batch->begin();
+       p != batch->end();
+       ++p)
+    {
+      if (p->descriptor < 0)
+	continue;
+      if (p->shsize > 0)
+	{
+	  if (p->elfclass == elfcpp::ELFCLASS32)
+	    {
+#if defined(HAVE_TARGET_32_LITTLE) || defined(HAVE_TARGET_32_BIG)
+	      if (p->big_endian)
+		this->read_section_headers<32, true>(&*p);
+	      else
+		this->read_section_headers<32, false>(&*p);
+#endif
+	    }
+	  else
+	    {
+#if defined(HAVE_TARGET_64_LITTLE) || defined(HAVE_TARGET_64_BIG)
+	      if (p->big_endian)
+		this->read_section_headers<64, true>(&*p);
+	      else
+		this->read_section_headers<64, false>(&*p);
+#endif
+	    }
+	}
+      if (p->over_budget)
+	++this->files_over_budget_;
+      ::close(p->descriptor);
+      p->descriptor = -1;
+    }
+}
+
+// Read the header of FILE.  For an ELF file, prefetch the section
+// headers.  For an archive, prefetch the symbol table and the
+// extended name table, which immediately follows it.
+
+void
+Input_prefetcher::read_header(File* file)
+{
+  unsigned char buf[elfcpp::Elf_sizes<64>::ehdr_size];
+  ssize_t got = ::pread(file->descriptor, buf, sizeof buf, 0);
+  if (got < static_cast<ssize_t>(elfcpp::EI_NIDENT))
+    return;
+
+  if (buf[elfcpp::EI_MAG0] == elfcpp::ELFMAG0
+      && buf[elfcpp::EI_MAG1] == elfcpp::ELFMAG1
+      && buf[elfcpp::EI_MAG2] == elfcpp::ELFMAG2
+      && buf[elfcpp::EI_MAG3] == elfcpp::ELFMAG3)
+    {
+      int elfclass = buf[elfcpp::EI_CLASS];
+      bool big_endian = buf[elfcpp::EI_DATA] == elfcpp::ELFDATA2MSB;
+      off_t shoff = 0;
+      off_t shnum = 0;
+      if (elfclass == elfcpp::ELFCLASS32
+	  && got >= elfcpp::Elf_sizes<32>::ehdr_size)
+	{
+	  if (big_endian)
+	    {
+	      elfcpp::Ehdr<32, true> ehdr(buf);
+	      shoff = ehdr.get_e_shoff();
+	      shnum = ehdr.get_e_shnum();
+	    }
+	  else
+	    {
+	      elfcpp::Ehdr<32, false> ehdr(buf);
+	      shoff = ehdr.get_e_shoff();
+	      shnum = ehdr.get_e_shnum();
+	    }
+	  file->shsize = shnum * elfcpp::Elf_sizes<32>::shdr_size;
+	}
+      else if (elfclass == elfcpp::ELFCLASS64
+	       && got >= elfcpp::Elf_sizes<64>::ehdr_size)
+	{
+	  if (big_endian)
+	    {
+	      elfcpp::Ehdr<64, true> ehdr(buf);
+	      shoff = ehdr.get_e_shoff();
+	      shnum = ehdr.get_e_shnum();
+	    }
+	  else
+	    {
+	      elfcpp::Ehdr<64, false> ehdr(buf);
+	      shoff = ehdr.get_e_shoff();
+	      shnum = ehdr.get_e_shnum();
+	    }
+	  file->shsize = shnum * elfcpp::Elf_sizes<64>::shdr_size;
+	}
+      else
+	return;
+
+      // With more than SHN_LORESERVE sections, e_shnum is zero and
+      // the count is in the first section header.  We only read
+      // that one here; read_section_headers will find the rest.
+      if (shoff == 0)
+	file->shsize = 0;
+      else if (shnum == 0)
+	file->shsize = (elfclass == elfcpp::ELFCLASS32
+			? elfcpp::Elf_sizes<32>::shdr_size
+			: elfcpp::Elf_sizes<64>::shdr_size);
+      file->elfclass = elfclass;
+      file->big_endian = big_endian;
+      file->shoff = shoff;
+      if (file->shsize > 0
+	  && !this->advise(file, file->shoff, file->shsize))
+	file->shsize = 0;
+      return;
+    }
+
+  // An archive starts with the archive magic string, followed by
+  // the header of the symbol table member.  The member size is a
+  // decimal number in bytes 48 to 57 of the header.
+  static const char armag[] = "!<arch>\n";
+  static const off_t armag_size = sizeof armag - 1;
+  static const off_t arhdr_size = 60;
+  unsigned char hdr[arhdr_size + 1];
+  if (got < armag_size || memcmp(buf, armag, armag_size) != 0)
+    return;
+  if (::pread(file->descriptor, hdr, arhdr_size, armag_size) != arhdr_size)
+    return;
+  if (memcmp(hdr, "/ ", 2) != 0 && memcmp(hdr, "/SYM64/ ", 8) != 0)
+    return;
+  hdr[58] = '\0';
+  off_t symtab_size = strtol(reinterpret_cast<char*>(hdr + 48), NULL, 10);
+  off_t off = armag_size + arhdr_size;
+  // The extended name table is usually small, so we prefetch a little
+  // past the end of the symbol table rather than look for it.
+  this->advise(file, off, symtab_size + prefetch_header_size);
+}
+
+// Read the section headers of FILE, and prefetch the section name
+// string table, the symbol tables and their string tables.
+
+template<int size, bool big_endian>
+void
+Input_prefetcher::read_section_headers(File* file)
+{
+  const int shdr_size = elfcpp::Elf_sizes<size>::shdr_size;
+  std::vector<unsigned char> buf(file->shsize);
+  if (::pread(file->descriptor, &buf[0], file->shsize, file->shoff)
+      != file->shsize)
+    return;
+
+  if (file->shsize == shdr_size)
+    {
+      // The real count of sections is in the first section header.
+      elfcpp::Shdr<size, big_endian> shdr0(&buf[0]);
+      off_t shsize = shdr0.get_sh_size() * shdr_size;
+      if (shsize <= shdr_size
+	  || shsize > file->file_size
+	  || !this->advise(file, file->shoff, shsize))
+	return;
+      buf.resize(shsize);
+      if (::pread(file->descriptor, &buf[0], shsize, file->shoff) != shsize)
+	return;
+      file->shsize = shsize;
+    }
+
+  unsigned int shnum = file->shsize / shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i)
+    {
+      elfcpp::Shdr<size, big_endian> shdr(&buf[i * shdr_size]);
+      unsigned int sh_type = shdr.get_sh_type();
+      if (sh_type != elfcpp::SHT_SYMTAB
+	  && sh_type != elfcpp::SHT_DYNSYM
+	  && sh_type != elfcpp::SHT_STRTAB)
+	continue;
+      // Other string tables are almost always the section names or the
+      // names for a symbol table, which we want; the ones which are not
+      // are small.
+      if (!this->advise(file, shdr.get_sh_offset(), shdr.get_sh_size()))
+	return;
+    }
+}
+
+// Ask the kernel to read LEN bytes at OFFSET in FILE, unless that
+// would exceed the budget.  When we can, we count the pages which are
+// not already in the page cache, for --stats.
+
+bool
+Input_prefetcher::advise(File* file, off_t offset, off_t len)
+{
+  if (offset >= file->file_size || len <= 0)
+    return true;
+  if (len > file->file_size - offset)
+    len = file->file_size - offset;
+  if (this->bytes_ + len > this->budget_)
+    {
+      file->over_budget = true;
+      return false;
+    }
+  this->bytes_ += len;
+
+#if defined(HAVE_MMAP) && defined(__linux__)
+  static const off_t page_size = ::sysconf(_SC_PAGESIZE);
+  off_t start = offset & ~(page_size - 1);
+  size_t map_len = offset + len - start;
+  void* p = ::mmap(NULL, map_len, PROT_READ, MAP_SHARED, file->descriptor,
+		   start);
+  if (p != MAP_FAILED)
+    {
+      size_t pages = (map_len + page_size - 1) / page_size;
+      std::vector<unsigned char> vec(pages);
+      if (::mincore(p, map_len, &vec[0]) == 0)
+	{
+	  for (size_t i = 0; i < pages; ++i)
+	    if ((vec[i] & 1) == 0)
+	      ++this->pages_not_cached_;
+	}
+      ::munmap(p, map_len);
+    }
+#endif
+
+#ifdef POSIX_FADV_WILLNEED
+  ::posix_fadvise(file->descriptor, offset, len, POSIX_FADV_WILLNEED);
+#endif
+
+  return true;
+}
+
+// Print statistics.
+
+void
+Input_prefetcher::print_stats()
+{
+  Input_prefetcher* prefetcher = Input_prefetcher::prefetcher_;
+  if (prefetcher == NULL)
+    return;
+  fprintf(stderr, _("%s: input files prefetched: %u\n"),
+	  program_name, prefetcher->files_);
+  fprintf(stderr, _("%s: input files not fully prefetched, "
+		    "over budget: %u\n"),
+	  program_name, prefetcher->files_over_budget_);
+  fprintf(stderr, _("%s: input bytes prefetched: %llu\n"),
+	  program_name,
+	  static_cast<unsigned long long>(prefetcher->bytes_));
+  fprintf(stderr, _("%s: input pages not cached before prefetching: %llu\n"),
+	  program_name,
+	  static_cast<unsigned long long>(prefetcher->pages_not_cached_));
+}
+
+} // End namespace gold.
@@ -0,0 +1,127 @@
+// prefetch.h -- read ahead the input files for gold   -*- C++ -*-
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#ifndef GOLD_PREFETCH_H
+#define GOLD_PREFETCH_H
+
+#include <string>
+#include <vector>
+
+namespace gold
+{
+
+class Command_line;
+class Input_arguments;
+class Input_file_argument;
+
+// Prefetch the parts of the input files which gold reads first, as
+// requested by --prefetch-inputs.  As soon as the options have been
+// parsed, we walk the input files named on the command line, in
+// order, and ask the kernel to read in the ELF header, the section
+// headers, the symbol tables and their string tables, and the archive
+// symbol tables.  The kernel reads them asynchronously, so that when
+// the Read_symbols tasks get to the files they usually find the data
+// already in the page cache.  The total amount is limited by
+// --prefetch-budget.  When using threads this is done on a thread of
+// its own; otherwise it is done before the link starts.
+
+class Input_prefetcher
+{
+ public:
+  // Start prefetching the input files on COMMAND_LINE, if
+  // --prefetch-inputs was used.
+  static void
+  start(Command_line* command_line);
+
+  // Wait for prefetching to complete.
+  static void
+  finish();
+
+  // Print statistics.
+  static void
+  print_stats();
+
+ private:
+  // An input file being prefetched.
+  struct File;
+
+  Input_prefetcher(uint64_t budget)
+    : names_(), budget_(budget), files_(0), files_over_budget_(0),
+      bytes_(0), pages_not_cached_(0)
+  { }
+
+  // This class can not be copied.
+  Input_prefetcher(const Input_prefetcher&);
+  Input_prefetcher& operator=(const Input_prefetcher&);
+
+  // Add the files in INPUTS to the list of files to prefetch.
+  void
+  add_inputs(const Input_arguments*);
+
+  // Add the file for INPUT_ARGUMENT to the list.
+  void
+  add_input(const Input_file_argument&);
+
+  // Prefetch all the files in the list.
+  void
+  run();
+
+  // A function to pass to pthread_create.
+  static void*
+  thread_body(void*);
+
+  // Prefetch a batch of files, one step at a time.
+  void
+  prefetch_batch(std::vector<File>*);
+
+  // Read the ELF header or archive header of FILE, and prefetch the
+  // ELF section headers or the archive symbol table.
+  void
+  read_header(File*);
+
+  // Read the ELF section headers of FILE, and prefetch the sections
+  // we need.
+  template<int size, bool big_endian>
+  void
+  read_section_headers(File*);
+
+  // Ask the kernel to read LEN bytes at OFFSET in FILE.  Return false
+  // if that would exceed the budget.
+  bool
+  advise(File*, off_t offset, off_t len);
+
+  // The prefetcher for this link, or NULL if there is none.
+  static Input_prefetcher* prefetcher_;
+
+  // The names of the files to prefetch, in command line order.
+  std::vector<std::string> names_;
+  // The maximum number of bytes to prefetch.
+  uint64_t budget_;
+  // Statistics.  These are only changed by the prefetching thread.
+  unsigned int files_;
+  unsigned int files_over_budget_;
+  uint64_t bytes_;
+  uint64_t pages_not_cached_;
+};
+
+} // End namespace gold.
+
+#endif // !defined(GOLD_PREFETCH_H)
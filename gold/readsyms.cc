@@ -340,9 +340,10 @@ Read_symbols::do_read_symbols(Workqueue* workqueue)
 
   if (parameters->options().has_plugins())
     {
-      Pluginobj* obj = parameters->options().plugins()->claim_file(input_file,
-                                                                   0, filesize,
-								   elf_obj);
+      Pluginobj* obj =
+	parameters->options().plugins()->claim_file(input_file, 0, filesize,
+						    elf_obj,
+						    this->input_argument_);
       if (obj != NULL)
         {
 	  // Delete the elf_obj, this file has been claimed.
@@ -399,6 +400,7 @@ Read_symbols::do_read_symbols(Workqueue* workqueue)
 
       Read_symbols_data* sd = new Read_symbols_data;
       elf_obj->read_symbols(sd);
+      elf_obj->find_comdat_groups(this->layout_, sd);
 
       // Opening the file locked it, so now we need to unlock it.  We
       // need to unlock it before queuing the Add_symbols task,
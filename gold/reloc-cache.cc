@@ -0,0 +1,347 @@
+// reloc-cache.cc -- cache of relocated section contents
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#include "libiberty.h"
+#include "binary-io.h"
+
+#include "parameters.h"
+#include "options.h"
+#include "target.h"
+#include "gold-threads.h"
+#include "reloc-cache.h"
+
+namespace gold
+{
+
+// Class Reloc_cache_key.
+
+// The key starts with the version of gold and the target, so that
+// entries are never shared between different linkers or targets.
+// FORMAT_VERSION must be changed when the way a target computes its
+// keys changes.
+
+Reloc_cache_key::Reloc_cache_key()
+{
+  static const char format_version[] = "gold reloc cache 1";
+  sha1_init_ctx(&this->ctx_);
+  this->add(format_version, sizeof format_version);
+  const char* version = get_version_string();
+  this->add(version, strlen(version) + 1);
+  const Target& target(parameters->target());
+  this->add_uint64(target.machine_code());
+  this->add_uint64(target.get_size());
+  this->add_uint64(target.is_big_endian());
+}
+
+// Add a number to the key.
+
+void
+Reloc_cache_key::add_uint64(uint64_t val)
+{
+  unsigned char buf[8];
+  for (int i = 0; i < 8; ++i)
+    {
+      buf[i] = val & 0xff;
+      val >>= 8;
+    }
+  this->add(buf, sizeof buf);
+}
+
+// Finish the key.
+
+std::string
+Reloc_cache_key::finish()
+{
+  unsigned char digest[20];
+  sha1_finish_ctx(&this->ctx_, digest);
+  static const char hex[] = "0123456789abcdef";
+  std::string ret;
+  ret.reserve(2 * sizeof digest);
+  for (size_t i = 0; i < sizeof digest; ++i)
+    {
+      ret += hex[digest[i] >> 4];
+      ret += hex[digest[i] & 0xf];
+    }
+  return ret;
+}
+
+// Class Reloc_cache.
+
+// Each entry in the cache starts with this magic string, followed by
+// the length of the data as an 8 byte little-endian number.
+
+static const char reloc_cache_magic[8] = { 'G', 'R', 'C', 'A', 'C', 'H',
+					   'E', '1' };
+static const size_t reloc_cache_header_size = 16;
+
+// The cache for this link.
+
+Reloc_cache* Reloc_cache::cache_ = NULL;
+
+Reloc_cache::Reloc_cache(const char* dirname, uint64_t max_size)
+  : dirname_(dirname), max_size_(max_size), lock_(new Lock()),
+    hits_(0), misses_(0), stores_(0), store_failures_(0), bytes_hit_(0),
+    pruned_(0)
+{
+}
+
+// Set up the cache, creating the directory if needed.  If we can't,
+// warn and link without the cache.
+
+void
+Reloc_cache::initialize()
+{
+  const char* dirname = parameters->options().reloc_cache();
+  if (dirname == NULL || *dirname == '\0')
+    return;
+  if (::mkdir(dirname, 0777) < 0 && errno != EEXIST)
+    {
+      gold_warning(_("cannot create relocation cache %s: %s"),
+		   dirname, strerror(errno));
+      return;
+    }
+  Reloc_cache::cache_ =
+    new Reloc_cache(dirname, parameters->options().reloc_cache_size());
+}
+
+// Trim the cache at the end of the link.  We only need to do this if
+// we added anything to it.
+
+void
+Reloc_cache::finish()
+{
+  Reloc_cache* cache = Reloc_cache::cache_;
+  if (cache != NULL && cache->stores_ > 0)
+    cache->prune();
+}
+
+// Look up KEY in the cache.  We read the whole entry before copying
+// it to VIEW, so that VIEW is unchanged if the entry turns out to be
+// unusable.  An entry is never changed once it is in place, and
+// removing an entry does not affect a reader which has it open.
+
+bool
+Reloc_cache::lookup(const std::string& key, unsigned char* view, size_t len)
+{
+  std::string filename = this->dirname_ + '/' + key;
+  bool found = false;
+  int o = ::open(filename.c_str(), O_RDONLY | O_BINARY);
+  if (o >= 0)
+    {
+      std::vector<unsigned char> buf(reloc_cache_header_size + len + 1);
+      size_t got = 0;
+      while (got < buf.size())
+	{
+	  ssize_t r = ::read(o, &buf[got], buf.size() - got);
+	  if (r <= 0)
+	    break;
+	  got += r;
+	}
+      ::close(o);
+
+      uint64_t entry_len = 0;
+      for (int i = 7; i >= 0; --i)
+	entry_len = (entry_len << 8) | buf[8 + i];
+      if (got == reloc_cache_header_size + len
+	  && memcmp(&buf[0], reloc_cache_magic, sizeof reloc_cache_magic) == 0
+	  && entry_len == len)
+	{
+	  memcpy(view, &buf[reloc_cache_header_size], len);
+	  found = true;
+	  // Record the use, so that pruning keeps the entry.
+	  ::utime(filename.c_str(), NULL);
+	}
+    }
+
+  Hold_lock hl(*this->lock_);
+  if (found)
+    {
+      ++this->hits_;
+      this->bytes_hit_ += len;
+    }
+  else
+    ++this->misses_;
+  return found;
+}
+
+// Add an entry to the cache.  We write it to a temporary file and
+// rename it into place, so that other links never see a partial
+// entry.  Failures are not errors; the entry is simply not added.
+
+void
+Reloc_cache::store(const std::string& key, const unsigned char* view,
+		   size_t len)
+{
+  std::string filename = this->dirname_ + '/' + key;
+  std::string tmpl = this->dirname_ + "/tmp.XXXXXX";
+  std::vector<char> tmpname(tmpl.begin(), tmpl.end());
+  tmpname.push_back('\0');
+
+  bool ok = false;
+  int o = mkstemps(&tmpname[0], 0);
+  if (o >= 0)
+    {
+      unsigned char header[reloc_cache_header_size];
+      memcpy(header, reloc_cache_magic, sizeof reloc_cache_magic);
+      uint64_t v = len;
+      for (int i = 0; i < 8; ++i)
+	{
+	  header[8 + i] = v & 0xff;
+	  v >>= 8;
+	}
+      ok = (::write(o, header, sizeof header)
+	    == static_cast<ssize_t>(sizeof header));
+      size_t done = 0;
+      while (ok && done < len)
+	{
+	  ssize_t w = ::write(o, view + done, len - done);
+	  if (w <= 0)
+	    ok = false;
+	  else
+	    done += w;
+	}
+      if (::close(o) < 0)
+	ok = false;
+      if (ok)
+	ok = ::rename(&tmpname[0], filename.c_str()) == 0;
+      if (!ok)
+	::unlink(&tmpname[0]);
+    }
+
+  Hold_lock hl(*this->lock_);
+  if (ok)
+    ++this->stores_;
+  else
+    ++this->store_failures_;
+}
+
+// An entry found while pruning the cache.
+
+struct Reloc_cache_entry
+{
+  Reloc_cache_entry(const std::string& aname, time_t amtime, off_t asize)
+    : name(aname), mtime(amtime), size(asize)
+  { }
+
+  std::string name;
+  time_t mtime;
+  off_t size;
+};
+
+// Sort entries from least to most recently used.
+
+struct Reloc_cache_entry_compare
+{
+  bool
+  operator()(const Reloc_cache_entry& a, const Reloc_cache_entry& b) const
+  {
+    if (a.mtime != b.mtime)
+      return a.mtime < b.mtime;
+    return a.name < b.name;
+  }
+};
+
+// Remove the least recently used entries until the cache fits in
+// max_size_.  Another link may be pruning the cache at the same time,
+// so an entry may disappear under us.  We also remove temporary files
+// left behind by links which were killed, once they are a day old.
+
+void
+Reloc_cache::prune()
+{
+  DIR* d = ::opendir(this->dirname_.c_str());
+  if (d == NULL)
+    return;
+
+  const time_t now = ::time(NULL);
+  std::vector<Reloc_cache_entry> entries;
+  uint64_t total = 0;
+  struct dirent* de;
+  while ((de = ::readdir(d)) != NULL)
+    {
+      if (de->d_name[0] == '.')
+	continue;
+      std::string filename = this->dirname_ + '/' + de->d_name;
+      struct stat st;
+      if (::stat(filename.c_str(), &st) < 0 || !S_ISREG(st.st_mode))
+	continue;
+      if (strncmp(de->d_name, "tmp.", 4) == 0)
+	{
+	  if (now - st.st_mtime > 24 * 60 * 60)
+	    ::unlink(filename.c_str());
+	  continue;
+	}
+      entries.push_back(Reloc_cache_entry(filename, st.st_mtime,
+					  st.st_size));
+      total += st.st_size;
+    }
+  ::closedir(d);
+
+  if (total <= this->max_size_)
+    return;
+
+  std::sort(entries.begin(), entries.end(), Reloc_cache_entry_compare());
+  for (std::vector<Reloc_cache_entry>::const_iterator p = entries.begin();
+       p != entries.end() && total > this->max_size_;
+       ++p)
+    {
+      if (::unlink(p->name.c_str()) == 0)
+	++this->pruned_;
+      total -= p->size;
+    }
+}
+
+// Print statistics.
+
+void
+Reloc_cache::print_stats()
+{
+  Reloc_cache* cache = Reloc_cache::cache_;
+  if (cache == NULL)
+    return;
+  fprintf(stderr, _("%s: relocation cache hits: %u (%llu bytes)\n"),
+	  program_name, cache->hits_,
+	  static_cast<unsigned long long>(cache->bytes_hit_));
+  fprintf(stderr, _("%s: relocation cache misses: %u\n"),
+	  program_name, cache->misses_);
+  fprintf(stderr, _("%s: relocation cache entries added: %u\n"),
+	  program_name, cache->stores_);
+  fprintf(stderr, _("%s: relocation cache entries not added: %u\n"),
+	  program_name, cache->store_failures_);
+  fprintf(stderr, _("%s: relocation cache entries removed: %u\n"),
+	  program_name, cache->pruned_);
+}
+
+} // End namespace gold.
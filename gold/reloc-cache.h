@@ -0,0 +1,134 @@
+// reloc-cache.h -- cache of relocated section contents  -*- C++ -*-
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#ifndef GOLD_RELOC_CACHE_H
+#define GOLD_RELOC_CACHE_H
+
+#include <string>
+
+#include "sha1.h"
+
+namespace gold
+{
+
+class Lock;
+
+// The key of an entry in the relocation cache.  This is a SHA-1
+// digest of everything the relocated contents of a section depend
+// on.  The target adds the data; see Sized_target::relocation_cache_key.
+
+class Reloc_cache_key
+{
+ public:
+  Reloc_cache_key();
+
+  // Add LEN bytes at DATA to the key.
+  void
+  add(const void* data, size_t len)
+  { sha1_process_bytes(data, len, &this->ctx_); }
+
+  // Add the number VAL to the key.  This does not depend on the
+  // byte order of the host.
+  void
+  add_uint64(uint64_t val);
+
+  // Finish the key and return it as a string of hex digits.
+  std::string
+  finish();
+
+ private:
+  Reloc_cache_key(const Reloc_cache_key&);
+  Reloc_cache_key& operator=(const Reloc_cache_key&);
+
+  sha1_ctx ctx_;
+};
+
+// A directory holding the relocated contents of input sections from
+// earlier links, as requested by --reloc-cache.  Each entry is a file
+// named by its key.  Entries are written to a temporary file and then
+// renamed, so several links may share the cache at once.  After a link
+// which added entries, the least recently used entries are removed to
+// keep the cache within --reloc-cache-size.
+
+class Reloc_cache
+{
+ public:
+  // Return the cache for this link, or NULL if there is none.
+  static Reloc_cache*
+  cache()
+  { return Reloc_cache::cache_; }
+
+  // Set up the cache if --reloc-cache was used.  This is called
+  // before any tasks run.
+  static void
+  initialize();
+
+  // Trim the cache to its maximum size.  This is called at the end of
+  // the link.
+  static void
+  finish();
+
+  // Look up KEY.  If the cache has an entry of LEN bytes for it,
+  // copy the entry to VIEW and return true.
+  bool
+  lookup(const std::string& key, unsigned char* view, size_t len);
+
+  // Add VIEW, of length LEN, to the cache as the entry for KEY.
+  void
+  store(const std::string& key, const unsigned char* view, size_t len);
+
+  // Print statistics.
+  static void
+  print_stats();
+
+ private:
+  Reloc_cache(const char* dirname, uint64_t max_size);
+
+  // This class can not be copied.
+  Reloc_cache(const Reloc_cache&);
+  Reloc_cache& operator=(const Reloc_cache&);
+
+  // Remove the least recently used entries until the cache is no
+  // larger than max_size_.
+  void
+  prune();
+
+  // The cache for this link.
+  static Reloc_cache* cache_;
+
+  // The directory holding the cache.
+  std::string dirname_;
+  // The maximum total size of the entries.
+  uint64_t max_size_;
+  // Lock for the statistics.
+  Lock* lock_;
+  // Statistics.
+  unsigned int hits_;
+  unsigned int misses_;
+  unsigned int stores_;
+  unsigned int store_failures_;
+  uint64_t bytes_hit_;
+  unsigned int pruned_;
+};
+
+} // End namespace gold.
+
+#endif // !defined(GOLD_RELOC_CACHE_H)
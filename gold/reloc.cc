@@ -35,10 +35,62 @@
 #include "icf.h"
 #include "compressed_output.h"
 #include "incremental.h"
+#include "reloc-cache.h"
 
 namespace gold
 {
 
+// When --reloc-memory-budget is used, the number of bytes of
+// relocations which have been read by Read_relocs tasks and not yet
+// freed by Scan_relocs tasks.  Read_relocs tasks run in parallel, so
+// this is protected by a lock.
+
+static uint64_t resident_reloc_bytes;
+static Lock* resident_reloc_bytes_lock = NULL;
+static Initialize_lock
+resident_reloc_bytes_initialize_lock(&resident_reloc_bytes_lock);
+
+// Return true if we may read SIZE bytes of relocations ahead of
+// scanning them, and count them against the budget.  Return false if
+// the relocations should be read one section at a time as they are
+// processed.
+
+static bool
+reserve_reloc_memory(uint64_t size)
+{
+  uint64_t budget = parameters->options().reloc_memory_budget();
+  if (budget == 0)
+    return true;
+
+  resident_reloc_bytes_initialize_lock.initialize();
+  Hold_optional_lock hl(resident_reloc_bytes_lock);
+  if (resident_reloc_bytes + size > budget)
+    return false;
+  resident_reloc_bytes += size;
+  return true;
+}
+
+// Free the contents of the reloc section SR, if they were read by
+// Read_relocs, and give back their memory to the budget.
+
+static void
+free_reloc_contents(Section_relocs* sr)
+{
+  if (sr->contents == NULL)
+    return;
+
+  delete sr->contents;
+  sr->contents = NULL;
+
+  if (parameters->options().reloc_memory_budget() != 0)
+    {
+      resident_reloc_bytes_initialize_lock.initialize();
+      Hold_optional_lock hl(resident_reloc_bytes_lock);
+      gold_assert(resident_reloc_bytes >= sr->contents_size);
+      resident_reloc_bytes -= sr->contents_size;
+    }
+}
+
 // Read_relocs methods.
 
 // These tasks just read the relocation information from the file.
@@ -267,6 +319,7 @@ Sized_relobj_file<size, big_endian>::do_read_relocs(Read_relocs_data* rd)
     return;
 
   rd->relocs.reserve(shnum / 2);
+  uint64_t total_size = 0;
 
   const Output_sections& out_sections(this->output_sections());
   const std::vector<Address>& out_offsets(this->section_offsets());
@@ -350,13 +403,26 @@ Sized_relobj_file<size, big_endian>::do_read_relocs(Read_relocs_data* rd)
       Section_relocs& sr(rd->relocs.back());
       sr.reloc_shndx = i;
       sr.data_shndx = shndx;
-      sr.contents = this->get_lasting_view(shdr.get_sh_offset(), sh_size,
-					   true, true);
       sr.sh_type = sh_type;
+      sr.contents_offset = shdr.get_sh_offset();
+      sr.contents_size = sh_size;
       sr.reloc_count = reloc_count;
       sr.output_section = os;
       sr.needs_special_offset_handling = out_offsets[shndx] == invalid_address;
       sr.is_data_section_allocated = is_section_allocated;
+      total_size += sh_size;
+    }
+
+  // Read the relocs now, unless that would take us over the
+  // --reloc-memory-budget.  In that case the relocs are read one
+  // section at a time as they are processed.
+  if (reserve_reloc_memory(total_size))
+    {
+      for (Read_relocs_data::Relocs_list::iterator p = rd->relocs.begin();
+	   p != rd->relocs.end();
+	   ++p)
+	p->contents = this->get_lasting_view(p->contents_offset,
+					     p->contents_size, true, true);
     }
 
   // Read the local symbols.
@@ -396,6 +462,7 @@ Sized_relobj_file<size, big_endian>::do_gc_process_relocs(Symbol_table* symtab,
   else
     local_symbols = rd->local_symbols->data();
 
+  std::vector<unsigned char> buf;
   for (Read_relocs_data::Relocs_list::iterator p = rd->relocs.begin();
        p != rd->relocs.end();
        ++p)
@@ -408,7 +475,9 @@ Sized_relobj_file<size, big_endian>::do_gc_process_relocs(Symbol_table* symtab,
 	    if (p->is_data_section_allocated)
               target->gc_process_relocs(symtab, layout, this, 
                                         p->data_shndx, p->sh_type, 
-                                        p->contents->data(), p->reloc_count, 
+                                        this->section_relocs_contents(*p,
+								      &buf),
+                                        p->reloc_count, 
                                         p->output_section,
                                         p->needs_special_offset_handling,
                                         this->local_symbol_count_, 
@@ -440,6 +509,7 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
   if (layout->incremental_inputs() != NULL)
     this->allocate_incremental_reloc_counts();
 
+  std::vector<unsigned char> buf;
   for (Read_relocs_data::Relocs_list::iterator p = rd->relocs.begin();
        p != rd->relocs.end();
        ++p)
@@ -451,8 +521,12 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
 	  || parameters->options().icf_enabled())
         {
           if (p->output_section == NULL)
-            continue;
+	    {
+	      free_reloc_contents(&*p);
+	      continue;
+	    }
         }
+      const unsigned char* prelocs = this->section_relocs_contents(*p, &buf);
       if (!parameters->options().relocatable())
 	{
 	  // As noted above, when not generating an object file, we
@@ -460,15 +534,15 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
 	  // section here if we are emitting relocs.
 	  if (p->is_data_section_allocated)
 	    target->scan_relocs(symtab, layout, this, p->data_shndx,
-				p->sh_type, p->contents->data(),
+				p->sh_type, prelocs,
 				p->reloc_count, p->output_section,
 				p->needs_special_offset_handling,
 				this->local_symbol_count_,
 				local_symbols);
 	  if (parameters->options().emit_relocs())
-	    this->emit_relocs_scan(symtab, layout, local_symbols, p);
+	    this->emit_relocs_scan(symtab, layout, local_symbols, p, prelocs);
 	  if (layout->incremental_inputs() != NULL)
-	    this->incremental_relocs_scan(p);
+	    this->incremental_relocs_scan(p, prelocs);
 	}
       else
 	{
@@ -477,7 +551,7 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
 	  rr->set_reloc_count(p->reloc_count);
 	  target->scan_relocatable_relocs(symtab, layout, this,
 					  p->data_shndx, p->sh_type,
-					  p->contents->data(),
+					  prelocs,
 					  p->reloc_count,
 					  p->output_section,
 					  p->needs_special_offset_handling,
@@ -486,8 +560,7 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
 					  rr);
 	}
 
-      delete p->contents;
-      p->contents = NULL;
+      free_reloc_contents(&*p);
     }
 
   // For incremental links, finalize the allocation of relocations.
@@ -509,7 +582,8 @@ Sized_relobj_file<size, big_endian>::emit_relocs_scan(
     Symbol_table* symtab,
     Layout* layout,
     const unsigned char* plocal_syms,
-    const Read_relocs_data::Relocs_list::iterator& p)
+    const Read_relocs_data::Relocs_list::iterator& p,
+    const unsigned char* prelocs)
 {
   Sized_target<size, big_endian>* target =
       parameters->sized_target<size, big_endian>();
@@ -523,7 +597,7 @@ Sized_relobj_file<size, big_endian>::emit_relocs_scan(
     this,
     p->data_shndx,
     p->sh_type,
-    p->contents->data(),
+    prelocs,
     p->reloc_count,
     p->output_section,
     p->needs_special_offset_handling,
@@ -537,14 +611,15 @@ Sized_relobj_file<size, big_endian>::emit_relocs_scan(
 template<int size, bool big_endian>
 void
 Sized_relobj_file<size, big_endian>::incremental_relocs_scan(
-    const Read_relocs_data::Relocs_list::iterator& p)
+    const Read_relocs_data::Relocs_list::iterator& p,
+    const unsigned char* prelocs)
 {
   if (p->sh_type == elfcpp::SHT_REL)
-    this->incremental_relocs_scan_reltype<elfcpp::SHT_REL>(p);
+    this->incremental_relocs_scan_reltype<elfcpp::SHT_REL>(p, prelocs);
   else
     {
       gold_assert(p->sh_type == elfcpp::SHT_RELA);
-      this->incremental_relocs_scan_reltype<elfcpp::SHT_RELA>(p);
+      this->incremental_relocs_scan_reltype<elfcpp::SHT_RELA>(p, prelocs);
     }
 }
 
@@ -555,11 +630,11 @@ template<int size, bool big_endian>
 template<int sh_type>
 void
 Sized_relobj_file<size, big_endian>::incremental_relocs_scan_reltype(
-    const Read_relocs_data::Relocs_list::iterator& p)
+    const Read_relocs_data::Relocs_list::iterator& p,
+    const unsigned char* prelocs)
 {
   typedef typename Reloc_types<sh_type, size, big_endian>::Reloc Reltype;
   const int reloc_size = Reloc_types<sh_type, size, big_endian>::reloc_size;
-  const unsigned char* prelocs = p->contents->data();
   size_t reloc_count = p->reloc_count;
 
   for (size_t i = 0; i < reloc_count; ++i, prelocs += reloc_size)
@@ -604,10 +679,6 @@ Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
 
   this->write_sections(layout, pshdrs, of, &views);
 
-  // To speed up relocations, we set up hash tables for fast lookup of
-  // input offsets to output addresses.
-  this->initialize_input_to_output_maps();
-
   // Make the views available through get_output_view() for the duration
   // of this routine.  This RAII class will reset output_views_ to NULL
   // when the views go out of scope.
@@ -630,10 +701,6 @@ Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
 
   this->relocate_sections(symtab, layout, pshdrs, of, &views);
 
-  // After we've done the relocations, we release the hash tables,
-  // since we no longer need them.
-  this->free_input_to_output_maps();
-
   // Write out the accumulated views.
   for (unsigned int i = 1; i < shnum; ++i)
     {
@@ -906,6 +973,13 @@ Sized_relobj_file<size, big_endian>::relocate_section_range(
   relinfo.layout = layout;
   relinfo.object = this;
 
+  // With --reloc-memory-budget we read the relocs for each section
+  // into BUF, and so only hold one section's relocs at a time.
+  // Otherwise we use a view, which is kept until the object is
+  // released.
+  const bool stream_relocs = parameters->options().reloc_memory_budget() != 0;
+  std::vector<unsigned char> buf;
+
   const unsigned char* p = pshdrs + start_shndx * This::shdr_size;
   for (unsigned int i = start_shndx; i <= end_shndx; ++i, p += This::shdr_size)
     {
@@ -948,8 +1022,15 @@ Sized_relobj_file<size, big_endian>::relocate_section_range(
 	  continue;
 	}
 
-      const unsigned char* prelocs = this->get_view(shdr.get_sh_offset(),
-						    sh_size, true, false);
+      const unsigned char* prelocs;
+      if (!stream_relocs)
+	prelocs = this->get_view(shdr.get_sh_offset(), sh_size, true, false);
+      else
+	{
+	  buf.resize(sh_size);
+	  this->read(shdr.get_sh_offset(), sh_size, &buf[0]);
+	  prelocs = &buf[0];
+	}
 
       unsigned int reloc_size;
       if (sh_type == elfcpp::SHT_REL)
@@ -1002,9 +1083,33 @@ Sized_relobj_file<size, big_endian>::relocate_section_range(
 
       if (!parameters->options().relocatable())
 	{
+	  // With --reloc-cache, reuse the relocated contents from an
+	  // earlier link if the target can tell us everything they
+	  // depend on.
+	  Reloc_cache* cache = Reloc_cache::cache();
+	  std::string cache_key;
+	  if (cache != NULL
+	      && output_offset != invalid_address
+	      && reloc_map == NULL
+	      && !parameters->options().emit_relocs()
+	      && !parameters->incremental())
+	    {
+	      Reloc_cache_key key;
+	      if (target->relocation_cache_key(&relinfo, sh_type, prelocs,
+					       reloc_count, view, address,
+					       view_size, &key))
+		{
+		  cache_key = key.finish();
+		  if (cache->lookup(cache_key, view, view_size))
+		    continue;
+		}
+	    }
+
 	  target->relocate_section(&relinfo, sh_type, prelocs, reloc_count, os,
 				   output_offset == invalid_address,
 				   view, address, view_size, reloc_map);
+	  if (!cache_key.empty())
+	    cache->store(cache_key, view, view_size);
 	  if (parameters->options().emit_relocs())
 	    target->relocate_relocs(&relinfo, sh_type, prelocs, reloc_count,
 				    os, output_offset,
@@ -1161,35 +1266,6 @@ Sized_relobj_file<size, big_endian>::incremental_relocs_write_reltype(
     }
 }
 
-// Create merge hash tables for the local symbols.  These are used to
-// speed up relocations.
-
-template<int size, bool big_endian>
-void
-Sized_relobj_file<size, big_endian>::initialize_input_to_output_maps()
-{
-  const unsigned int loccount = this->local_symbol_count_;
-  for (unsigned int i = 1; i < loccount; ++i)
-    {
-      Symbol_value<size>& lv(this->local_values_[i]);
-      lv.initialize_input_to_output_map(this);
-    }
-}
-
-// Free merge hash tables for the local symbols.
-
-template<int size, bool big_endian>
-void
-Sized_relobj_file<size, big_endian>::free_input_to_output_maps()
-{
-  const unsigned int loccount = this->local_symbol_count_;
-  for (unsigned int i = 1; i < loccount; ++i)
-    {
-      Symbol_value<size>& lv(this->local_values_[i]);
-      lv.free_input_to_output_map();
-    }
-}
-
 // If an object was compiled with -fsplit-stack, this is called to
 // check whether any relocations refer to functions defined in objects
 // which were not compiled with -fsplit-stack.  If they were, then we
@@ -1463,19 +1539,7 @@ Sized_relobj_file<size, big_endian>::reverse_words(unsigned char* view,
 
 // Class Merged_symbol_value.
 
-template<int size>
-void
-Merged_symbol_value<size>::initialize_input_to_output_map(
-    const Relobj* object,
-    unsigned int input_shndx)
-{
-  object->initialize_input_to_output_map<size>(input_shndx,
-					       this->output_start_address_,
-					       &this->output_addresses_);
-}
-
-// Get the output value corresponding to an input offset if we
-// couldn't find it in the hash table.
+// Get the output value corresponding to an input offset.
 
 template<int size>
 typename elfcpp::Elf_types<size>::Elf_Addr
@@ -1842,46 +1906,6 @@ Sized_relobj_file<64, true>::do_get_output_view(
     section_size_type* plen) const;
 #endif
 
-#ifdef HAVE_TARGET_32_LITTLE
-template
-void
-Sized_relobj_file<32, false>::initialize_input_to_output_maps();
-
-template
-void
-Sized_relobj_file<32, false>::free_input_to_output_maps();
-#endif
-
-#ifdef HAVE_TARGET_32_BIG
-template
-void
-Sized_relobj_file<32, true>::initialize_input_to_output_maps();
-
-template
-void
-Sized_relobj_file<32, true>::free_input_to_output_maps();
-#endif
-
-#ifdef HAVE_TARGET_64_LITTLE
-template
-void
-Sized_relobj_file<64, false>::initialize_input_to_output_maps();
-
-template
-void
-Sized_relobj_file<64, false>::free_input_to_output_maps();
-#endif
-
-#ifdef HAVE_TARGET_64_BIG
-template
-void
-Sized_relobj_file<64, true>::initialize_input_to_output_maps();
-
-template
-void
-Sized_relobj_file<64, true>::free_input_to_output_maps();
-#endif
-
 #if defined(HAVE_TARGET_32_LITTLE) || defined(HAVE_TARGET_32_BIG)
 template
 class Merged_symbol_value<32>;
@@ -590,6 +590,91 @@ Orphan_section_placement::last_place() const
   return this->places_[PLACE_LAST].location;
 }
 
+// Find the output section for an input section when there is a
+// SECTIONS clause.  Asking each output section definition in turn is
+// slow for a large script, so we index the section name patterns of
+// the input section specs: a table of the names with no wildcards,
+// and a table of the literal prefixes of the patterns with wildcards.
+// Looking up a section name in these tables gives the few output
+// section definitions which may match it, and we only ask those.  If
+// no input section spec looks at the file name, the result depends
+// only on the section name, and we remember it for each section name.
+
+class Input_section_matcher
+{
+ public:
+  Input_section_matcher(const Script_sections::Sections_elements*);
+
+  // Record that element INDEX has an input section spec with the
+  // section name pattern PATTERN.
+  void
+  add_pattern(const std::string& pattern, unsigned int index);
+
+  // Record that element INDEX has an input section spec which
+  // matches all section names.
+  void
+  add_match_all(unsigned int index);
+
+  // Record that an input section spec has a file name pattern or
+  // excludes some files.
+  void
+  set_uses_file_names()
+  { this->uses_file_names_ = true; }
+
+  // Return the output section name to use for FILE_NAME and
+  // SECTION_NAME, or NULL if no output section definition matches.
+  // This is Script_sections::output_section_name for an input
+  // section, without the handling of /DISCARD/ and orphans.
+  const char*
+  output_section_name(const char* file_name, const char* section_name,
+		      Output_section*** output_section_slot,
+		      Script_sections::Section_type* psection_type,
+		      bool* keep);
+
+ private:
+  typedef std::vector<unsigned int> Indexes;
+  typedef Unordered_map<std::string, Indexes> Pattern_table;
+
+  // The result for an input section.
+  struct Result
+  {
+    const char* name;
+    Output_section** output_section_slot;
+    Script_sections::Section_type section_type;
+    bool keep;
+  };
+
+  // Maps a section name to its result.
+  typedef Unordered_map<std::string, Result> Cache;
+
+  // Set *CANDIDATES to the elements which may match SECTION_NAME, in
+  // script order.
+  void
+  find_candidates(const char* section_name, Indexes* candidates) const;
+
+  // Find the result for FILE_NAME and SECTION_NAME.
+  void
+  find(const char* file_name, const char* section_name, Result*) const;
+
+  // The elements of the SECTIONS clause, in script order.
+  std::vector<Sections_element*> elements_;
+  // The elements which match all section names.
+  Indexes match_all_;
+  // Maps a section name with no wildcards to the elements which use
+  // it.
+  Pattern_table names_;
+  // Maps the literal prefix of a pattern with wildcards to the
+  // elements which use it.
+  Pattern_table prefixes_;
+  // The lengths of the prefixes in PREFIXES_.
+  std::vector<size_t> prefix_lengths_;
+  // Whether any input section spec looks at the file name.
+  bool uses_file_names_;
+  // The results we have already found.  This is only used if
+  // USES_FILE_NAMES_ is false.
+  Cache cache_;
+};
+
 // An element in a SECTIONS clause.
 
 class Sections_element
@@ -635,6 +720,13 @@ class Sections_element
 		      Script_sections::Section_type*, bool*, bool)
   { return NULL; }
 
+  // Add the input section name patterns to MATCHER, as element
+  // INDEX.  This only real implementation is in
+  // Output_section_definition.
+  virtual void
+  add_input_section_patterns(Input_section_matcher*, unsigned int) const
+  { }
+
   // Initialize OSP with an output section.
   virtual void
   orphan_section_init(Orphan_section_placement*,
@@ -853,6 +945,13 @@ class Output_section_element
   match_name(const char*, const char*, bool *) const
   { return false; }
 
+  // Add the section name patterns to MATCHER, as part of element
+  // INDEX of the SECTIONS clause.  The only real implementation is in
+  // Output_section_element_input.
+  virtual void
+  add_input_section_patterns(Input_section_matcher*, unsigned int) const
+  { }
+
   // Set section addresses.  This includes applying assignments if the
   // expression is an absolute value.
   virtual void
@@ -1293,6 +1392,11 @@ class Output_section_element_input : public Output_section_element
   bool
   match_name(const char* file_name, const char* section_name, bool* keep) const;
 
+  // Add the section name patterns to MATCHER.
+  void
+  add_input_section_patterns(Input_section_matcher* matcher,
+			     unsigned int index) const;
+
   // Set the section address.
   void
   set_section_addresses(Symbol_table* symtab, Layout* layout, Output_section*,
@@ -1305,35 +1409,70 @@ class Output_section_element_input : public Output_section_element
   print(FILE* f) const;
 
  private:
+  // How to match a pattern.  Most patterns in scripts are either
+  // plain names, or a name followed or preceded by a single '*', so
+  // we handle those without calling fnmatch.
+  enum Match_kind
+  {
+    // No wildcards: compare the whole string.
+    MATCH_EXACT,
+    // "PREFIX*": compare the start of the string.
+    MATCH_PREFIX,
+    // "*SUFFIX": compare the end of the string.
+    MATCH_SUFFIX,
+    // Anything else: use fnmatch.
+    MATCH_WILDCARD
+  };
+
+  // Return how to match PATTERN.
+  static Match_kind
+  match_kind(const std::string& pattern);
+
   // An input section pattern.
   struct Input_section_pattern
   {
     std::string pattern;
-    bool pattern_is_wildcard;
+    Match_kind kind;
     Sort_wildcard sort;
 
     Input_section_pattern(const char* patterna, size_t patternlena,
 			  Sort_wildcard sorta)
       : pattern(patterna, patternlena),
-	pattern_is_wildcard(is_wildcard_string(this->pattern.c_str())),
+	kind(match_kind(this->pattern)),
 	sort(sorta)
     { }
   };
 
   typedef std::vector<Input_section_pattern> Input_section_patterns;
 
-  // Filename_exclusions is a pair of filename pattern and a bool
-  // indicating whether the filename is a wildcard.
-  typedef std::vector<std::pair<std::string, bool> > Filename_exclusions;
+  // Filename_exclusions is a pair of filename pattern and how to
+  // match it.
+  typedef std::vector<std::pair<std::string, Match_kind> >
+    Filename_exclusions;
 
-  // Return whether STRING matches PATTERN, where IS_WILDCARD_PATTERN
-  // indicates whether this is a wildcard pattern.
+  // Return whether STRING matches PATTERN, which is matched as KIND.
   static inline bool
-  match(const char* string, const char* pattern, bool is_wildcard_pattern)
+  match(const char* string, const std::string& pattern, Match_kind kind)
   {
-    return (is_wildcard_pattern
-	    ? fnmatch(pattern, string, 0) == 0
-	    : strcmp(string, pattern) == 0);
+    switch (kind)
+      {
+      case MATCH_EXACT:
+	return strcmp(string, pattern.c_str()) == 0;
+      case MATCH_PREFIX:
+	return strncmp(string, pattern.c_str(), pattern.length() - 1) == 0;
+      case MATCH_SUFFIX:
+	{
+	  size_t len = strlen(string);
+	  size_t suffixlen = pattern.length() - 1;
+	  return (len >= suffixlen
+		  && memcmp(string + len - suffixlen, pattern.c_str() + 1,
+			    suffixlen) == 0);
+	}
+      case MATCH_WILDCARD:
+	return fnmatch(pattern.c_str(), string, 0) == 0;
+      default:
+	gold_unreachable();
+      }
   }
 
   // See if we match a file name.
@@ -1343,8 +1482,8 @@ class Output_section_element_input : public Output_section_element
   // The file name pattern.  If this is the empty string, we match all
   // files.
   std::string filename_pattern_;
-  // Whether the file name pattern is a wildcard.
-  bool filename_is_wildcard_;
+  // How to match the file name pattern.
+  Match_kind filename_kind_;
   // How the file names should be sorted.  This may only be
   // SORT_WILDCARD_NONE or SORT_WILDCARD_BY_NAME.
   Sort_wildcard filename_sort_;
@@ -1369,7 +1508,7 @@ Output_section_element_input::Output_section_element_input(
     const Input_section_spec* spec,
     bool keep)
   : filename_pattern_(),
-    filename_is_wildcard_(false),
+    filename_kind_(MATCH_EXACT),
     filename_sort_(spec->file.sort),
     filename_exclusions_(),
     input_section_patterns_(),
@@ -1382,7 +1521,7 @@ Output_section_element_input::Output_section_element_input(
   if (spec->file.name.length != 1 || spec->file.name.value[0] != '*')
     this->filename_pattern_.assign(spec->file.name.value,
 				   spec->file.name.length);
-  this->filename_is_wildcard_ = is_wildcard_string(this->filename_pattern_.c_str());
+  this->filename_kind_ = match_kind(this->filename_pattern_);
 
   if (spec->input_sections.exclude != NULL)
     {
@@ -1390,11 +1529,8 @@ Output_section_element_input::Output_section_element_input(
 	     spec->input_sections.exclude->begin();
 	   p != spec->input_sections.exclude->end();
 	   ++p)
-	{
-	  bool is_wildcard = is_wildcard_string((*p).c_str());
-	  this->filename_exclusions_.push_back(std::make_pair(*p,
-							      is_wildcard));
-	}
+	this->filename_exclusions_.push_back(std::make_pair(*p,
+							    match_kind(*p)));
     }
 
   if (spec->input_sections.sections != NULL)
@@ -1409,6 +1545,25 @@ Output_section_element_input::Output_section_element_input(
     }
 }
 
+// Return how to match PATTERN.  A backslash quotes the next
+// character for fnmatch, so we leave patterns with a backslash to
+// fnmatch unless they have no wildcards at all.
+
+Output_section_element_input::Match_kind
+Output_section_element_input::match_kind(const std::string& pattern)
+{
+  const char* p = pattern.c_str();
+  if (!is_wildcard_string(p))
+    return MATCH_EXACT;
+  size_t len = pattern.length();
+  size_t special = strcspn(p, "?*[\\");
+  if (special == len - 1 && p[special] == '*')
+    return MATCH_PREFIX;
+  if (special == 0 && p[0] == '*' && strcspn(p + 1, "?*[\\") == len - 1)
+    return MATCH_SUFFIX;
+  return MATCH_WILDCARD;
+}
+
 // See whether we match FILE_NAME.
 
 bool
@@ -1421,8 +1576,7 @@ Output_section_element_input::match_file_name(const char* file_name) const
       if (file_name == NULL)
 	return false;
 
-      if (!match(file_name, this->filename_pattern_.c_str(),
-		 this->filename_is_wildcard_))
+      if (!match(file_name, this->filename_pattern_, this->filename_kind_))
 	return false;
     }
 
@@ -1435,7 +1589,7 @@ Output_section_element_input::match_file_name(const char* file_name) const
 	   p != this->filename_exclusions_.end();
 	   ++p)
 	{
-	  if (match(file_name, p->first.c_str(), p->second))
+	  if (match(file_name, p->first, p->second))
 	    return false;
 	}
     }
@@ -1466,7 +1620,7 @@ Output_section_element_input::match_name(const char* file_name,
        p != this->input_section_patterns_.end();
        ++p)
     {
-      if (match(section_name, p->pattern.c_str(), p->pattern_is_wildcard))
+      if (match(section_name, p->pattern, p->kind))
 	return true;
     }
 
@@ -1474,6 +1628,28 @@ Output_section_element_input::match_name(const char* file_name,
   return false;
 }
 
+// Add the section name patterns to MATCHER.
+
+void
+Output_section_element_input::add_input_section_patterns(
+    Input_section_matcher* matcher,
+    unsigned int index) const
+{
+  if (!this->filename_pattern_.empty() || !this->filename_exclusions_.empty())
+    matcher->set_uses_file_names();
+
+  if (this->input_section_patterns_.empty())
+    matcher->add_match_all(index);
+  else
+    {
+      for (Input_section_patterns::const_iterator p =
+	     this->input_section_patterns_.begin();
+	   p != this->input_section_patterns_.end();
+	   ++p)
+	matcher->add_pattern(p->pattern, index);
+    }
+}
+
 // Information we use to sort the input sections.
 
 class Input_section_info
@@ -1742,8 +1918,7 @@ Output_section_element_input::set_section_addresses(
 	    {
 	      const Input_section_pattern&
 		isp(this->input_section_patterns_[i]);
-	      if (match(isi.section_name().c_str(), isp.pattern.c_str(),
-			isp.pattern_is_wildcard))
+	      if (match(isi.section_name().c_str(), isp.pattern, isp.kind))
 		break;
 	    }
 
@@ -2005,6 +2180,11 @@ class Output_section_definition : public Sections_element
 		      Output_section***, Script_sections::Section_type*,
 		      bool*, bool);
 
+  // Add the input section name patterns to MATCHER.
+  void
+  add_input_section_patterns(Input_section_matcher* matcher,
+			     unsigned int index) const;
+
   // Initialize OSP with an output section.
   void
   orphan_section_init(Orphan_section_placement* osp,
@@ -2322,6 +2502,19 @@ Output_section_definition::output_section_name(
   return NULL;
 }
 
+// Add the input section name patterns to MATCHER.
+
+void
+Output_section_definition::add_input_section_patterns(
+    Input_section_matcher* matcher,
+    unsigned int index) const
+{
+  for (Output_section_elements::const_iterator p = this->elements_.begin();
+       p != this->elements_.end();
+       ++p)
+    (*p)->add_input_section_patterns(matcher, index);
+}
+
 // Return true if memory from START to START + LENGTH is contained
 // within a memory region.
 
@@ -3333,6 +3526,145 @@ Script_sections::set_memory_region(Memory_region* mr, bool set_vma)
   this->sections_elements_->back()->set_memory_region(mr, set_vma);
 }
 
+// Class Input_section_matcher.
+
+// Build the tables for the elements of a SECTIONS clause.
+
+Input_section_matcher::Input_section_matcher(
+    const Script_sections::Sections_elements* sections_elements)
+  : elements_(sections_elements->begin(), sections_elements->end()),
+    match_all_(), names_(), prefixes_(), prefix_lengths_(),
+    uses_file_names_(false), cache_()
+{
+  for (unsigned int i = 0; i < this->elements_.size(); ++i)
+    this->elements_[i]->add_input_section_patterns(this, i);
+  std::sort(this->prefix_lengths_.begin(), this->prefix_lengths_.end());
+}
+
+// Record that element INDEX uses PATTERN.  Elements are added in
+// order, so each list of indexes stays sorted.
+
+void
+Input_section_matcher::add_pattern(const std::string& pattern,
+				   unsigned int index)
+{
+  Indexes* indexes;
+  if (!is_wildcard_string(pattern.c_str()))
+    indexes = &this->names_[pattern];
+  else
+    {
+      std::string prefix(pattern, 0, strcspn(pattern.c_str(), "?*[\\"));
+      std::pair<Pattern_table::iterator, bool> ins =
+	this->prefixes_.insert(std::make_pair(prefix, Indexes()));
+      if (ins.second)
+	this->prefix_lengths_.push_back(prefix.length());
+      indexes = &ins.first->second;
+    }
+  if (indexes->empty() || indexes->back() != index)
+    indexes->push_back(index);
+}
+
+// Record that element INDEX matches all section names.
+
+void
+Input_section_matcher::add_match_all(unsigned int index)
+{
+  if (this->match_all_.empty() || this->match_all_.back() != index)
+    this->match_all_.push_back(index);
+}
+
+// Set *CANDIDATES to the elements which may match SECTION_NAME.
+
+void
+Input_section_matcher::find_candidates(const char* section_name,
+				       Indexes* candidates) const
+{
+  candidates->insert(candidates->end(), this->match_all_.begin(),
+		     this->match_all_.end());
+
+  Pattern_table::const_iterator p = this->names_.find(section_name);
+  if (p != this->names_.end())
+    candidates->insert(candidates->end(), p->second.begin(),
+		       p->second.end());
+
+  size_t len = strlen(section_name);
+  std::string prefix;
+  for (std::vector<size_t>::const_iterator pl = this->prefix_lengths_.begin();
+       pl != this->prefix_lengths_.end() && *pl <= len;
+       ++pl)
+    {
+      prefix.assign(section_name, *pl);
+      p = this->prefixes_.find(prefix);
+      if (p != this->prefixes_.end())
+	candidates->insert(candidates->end(), p->second.begin(),
+			   p->second.end());
+    }
+
+  std::sort(candidates->begin(), candidates->end());
+  candidates->erase(std::unique(candidates->begin(), candidates->end()),
+		    candidates->end());
+}
+
+// Ask each element which may match, in script order, for the output
+// section for FILE_NAME and SECTION_NAME.
+
+void
+Input_section_matcher::find(const char* file_name, const char* section_name,
+			    Result* result) const
+{
+  result->name = NULL;
+  result->output_section_slot = NULL;
+  result->section_type = Script_sections::ST_NONE;
+  result->keep = false;
+
+  Indexes candidates;
+  this->find_candidates(section_name, &candidates);
+  for (Indexes::const_iterator p = candidates.begin();
+       p != candidates.end();
+       ++p)
+    {
+      result->name =
+	this->elements_[*p]->output_section_name(file_name, section_name,
+						 &result->output_section_slot,
+						 &result->section_type,
+						 &result->keep, true);
+      if (result->name != NULL)
+	return;
+    }
+}
+
+// Return the output section name to use for an input section.
+
+const char*
+Input_section_matcher::output_section_name(
+    const char* file_name,
+    const char* section_name,
+    Output_section*** output_section_slot,
+    Script_sections::Section_type* psection_type,
+    bool* keep)
+{
+  Result result;
+  if (this->uses_file_names_)
+    this->find(file_name, section_name, &result);
+  else
+    {
+      std::pair<Cache::iterator, bool> ins =
+	this->cache_.insert(std::make_pair(std::string(section_name),
+					   Result()));
+      if (ins.second)
+	this->find(file_name, section_name, &ins.first->second);
+      result = ins.first->second;
+    }
+
+  if (result.name != NULL)
+    {
+      *output_section_slot = result.output_section_slot;
+      *psection_type = result.section_type;
+      *keep = result.keep;
+    }
+  return result.name;
+}
+
 // Class Script_sections.
 
 Script_sections::Script_sections()
@@ -3343,6 +3675,7 @@ Script_sections::Script_sections()
     memory_regions_(NULL),
     phdrs_elements_(NULL),
     orphan_section_placement_(NULL),
+    input_section_matcher_(NULL),
     data_segment_align_start_(),
     saw_data_segment_align_(false),
     saw_relro_end_(false),
@@ -3482,6 +3815,11 @@ Script_sections::add_input_section(const Input_section_spec* spec, bool keep)
 {
   gold_assert(this->output_section_ != NULL);
   this->output_section_->add_input_section(spec, keep);
+
+  // Any tables we built for matching input sections are now out of
+  // date.
+  delete this->input_section_matcher_;
+  this->input_section_matcher_ = NULL;
 }
 
 // This is called when we see DATA_SEGMENT_ALIGN.  It means that any
@@ -3572,27 +3910,43 @@ Script_sections::output_section_name(
     bool* keep,
     bool is_input_section)
 {
-  for (Sections_elements::const_iterator p = this->sections_elements_->begin();
-       p != this->sections_elements_->end();
-       ++p)
+  const char* ret = NULL;
+  if (is_input_section)
+    {
+      if (this->input_section_matcher_ == NULL)
+	this->input_section_matcher_ =
+	  new Input_section_matcher(this->sections_elements_);
+      Input_section_matcher* matcher = this->input_section_matcher_;
+      ret = matcher->output_section_name(file_name, section_name,
+					 output_section_slot, psection_type,
+					 keep);
+    }
+  else
     {
-      const char* ret = (*p)->output_section_name(file_name, section_name,
-						  output_section_slot,
-						  psection_type, keep,
-						  is_input_section);
+      for (Sections_elements::const_iterator p =
+	     this->sections_elements_->begin();
+	   p != this->sections_elements_->end();
+	   ++p)
+	{
+	  ret = (*p)->output_section_name(file_name, section_name,
+					  output_section_slot, psection_type,
+					  keep, false);
+	  if (ret != NULL)
+	    break;
+	}
+    }
 
-      if (ret != NULL)
+  if (ret != NULL)
+    {
+      // The special name /DISCARD/ means that the input section
+      // should be discarded.
+      if (strcmp(ret, "/DISCARD/") == 0)
 	{
-	  // The special name /DISCARD/ means that the input section
-	  // should be discarded.
-	  if (strcmp(ret, "/DISCARD/") == 0)
-	    {
-	      *output_section_slot = NULL;
-	      *psection_type = Script_sections::ST_NONE;
-	      return NULL;
-	    }
-	  return ret;
+	  *output_section_slot = NULL;
+	  *psection_type = Script_sections::ST_NONE;
+	  return NULL;
 	}
+      return ret;
     }
 
   // We have an orphan section.
@@ -44,6 +44,7 @@ class Output_section_definition;
 class Output_section;
 class Output_segment;
 class Orphan_section_placement;
+class Input_section_matcher;
 
 class Script_sections
 {
@@ -313,6 +314,9 @@ class Script_sections
   Phdrs_elements* phdrs_elements_;
   // Where to put orphan sections.
   Orphan_section_placement* orphan_section_placement_;
+  // Used to find the output section for an input section.  This is
+  // built when first needed.
+  Input_section_matcher* input_section_matcher_;
   // A pointer to the last Sections_element when we see
   // DATA_SEGMENT_ALIGN.
   Sections_elements::iterator data_segment_align_start_;
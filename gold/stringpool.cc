@@ -274,13 +274,22 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
       return p->first.string;
     }
 
+  return this->add_hashkey(Hashkey(s, length), pkey);
+}
+
+template<typename Stringpool_char>
+const Stringpool_char*
+Stringpool_template<Stringpool_char>::add_hashkey(const Hashkey& hk_in,
+						  Key* pkey)
+{
+  typedef std::pair<typename String_set_type::iterator, bool> Insert_type;
+
   // When we have to copy the string, we look it up twice in the hash
   // table.  The problem is that we can't insert S before we
   // canonicalize it by copying it into the canonical list. The hash
   // code will only be computed once.
 
-  Hashkey hk(s, length);
-  typename String_set_type::const_iterator p = this->string_set_.find(hk);
+  typename String_set_type::const_iterator p = this->string_set_.find(hk_in);
   if (p != this->string_set_.end())
     {
       if (pkey != NULL)
@@ -288,9 +297,11 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
       return p->first.string;
     }
 
-  this->new_key_offset(length);
+  const Key k = this->key_to_offset_.size() + 1;
+  this->new_key_offset(hk_in.length);
 
-  hk.string = this->add_string(s, length);
+  Hashkey hk(hk_in);
+  hk.string = this->add_string(hk_in.string, hk_in.length);
   // The contents of the string stay the same, so we don't need to
   // adjust hk.hash_code or hk.length.
 
@@ -304,6 +315,29 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   return hk.string;
 }
 
+// Add the strings in FROM to the pool.  The key of a string is one
+// more than the number of strings added before it, so we can put the
+// strings back in order without sorting.
+
+template<typename Stringpool_char>
+void
+Stringpool_template<Stringpool_char>::add_pool(const Stringpool_template& from)
+{
+  const size_t count = from.string_set_.size();
+  gold_assert(count == from.key_to_offset_.size());
+  if (count == 0)
+    return;
+
+  std::vector<const Hashkey*> strings(count);
+  for (typename String_set_type::const_iterator p = from.string_set_.begin();
+       p != from.string_set_.end();
+       ++p)
+    strings[p->second - 1] = &p->first;
+
+  for (size_t i = 0; i < count; ++i)
+    this->add_hashkey(*strings[i], NULL);
+}
+
 template<typename Stringpool_char>
 const Stringpool_char*
 Stringpool_template<Stringpool_char>::find(const Stringpool_char* s,
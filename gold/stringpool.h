@@ -229,6 +229,14 @@ class Stringpool_template
   const Stringpool_char*
   add_with_length(const Stringpool_char* s, size_t len, bool copy, Key* pkey);
 
+  // Add all the strings in FROM to the pool, copying them, in the
+  // order in which they were added to FROM.  This lets several
+  // threads add strings to pools of their own, which are then
+  // combined in a fixed order.  The hash codes computed for FROM are
+  // reused.
+  void
+  add_pool(const Stringpool_template& from);
+
   // If the string S is present in the pool, return the canonical
   // string pointer.  Otherwise, return NULL.  If PKEY is not NULL,
   // set *PKEY to the key.
@@ -378,6 +386,11 @@ class Stringpool_template
   typedef Unordered_map<Hashkey, Hashval, Stringpool_hash,
 			Stringpool_eq> String_set_type;
 
+  // Add a copy of the string in HK, whose hash code has been
+  // computed, to the pool.
+  const Stringpool_char*
+  add_hashkey(const Hashkey& hk, Key* pkey);
+
   // Comparison routine used when sorting into a string table.
 
   typedef typename String_set_type::iterator Stringpool_sort_info;
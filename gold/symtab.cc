@@ -25,6 +25,7 @@
 #include <cstring>
 #include <stdint.h>
 #include <algorithm>
+#include <new>
 #include <set>
 #include <string>
 #include <utility>
@@ -41,6 +42,7 @@
 #include "script.h"
 #include "plugin.h"
 #include "incremental.h"
+#include "gold-threads.h"
 
 namespace gold
 {
@@ -56,11 +58,10 @@ Symbol::init_fields(const char* name, const char* version,
 		    elfcpp::STV visibility, unsigned char nonvis)
 {
   this->name_ = name;
-  this->version_ = version;
+  this->cold_index_ = 0;
+  this->set_version(version);
   this->symtab_index_ = 0;
-  this->dynsym_index_ = 0;
-  this->got_offsets_.init();
-  this->plt_offset_ = -1U;
+  this->has_dynsym_index_ = false;
   this->type_ = type;
   this->binding_ = binding;
   this->visibility_ = visibility;
@@ -119,8 +120,8 @@ Symbol::init_base_object(const char* name, const char* version, Object* object,
 {
   this->init_fields(name, version, sym.get_st_type(), sym.get_st_bind(),
 		    sym.get_st_visibility(), sym.get_st_nonvis());
-  this->u_.from_object.object = object;
-  this->u_.from_object.shndx = st_shndx;
+  this->u1_.object = object;
+  this->u2_.shndx = st_shndx;
   this->is_ordinary_shndx_ = is_ordinary;
   this->source_ = FROM_OBJECT;
   this->in_reg_ = !object->is_dynamic();
@@ -139,8 +140,8 @@ Symbol::init_base_output_data(const char* name, const char* version,
 			      bool is_predefined)
 {
   this->init_fields(name, version, type, binding, visibility, nonvis);
-  this->u_.in_output_data.output_data = od;
-  this->u_.in_output_data.offset_is_from_end = offset_is_from_end;
+  this->u1_.output_data = od;
+  this->u2_.offset_is_from_end = offset_is_from_end;
   this->source_ = IN_OUTPUT_DATA;
   this->in_reg_ = true;
   this->in_real_elf_ = true;
@@ -159,8 +160,8 @@ Symbol::init_base_output_segment(const char* name, const char* version,
 				 bool is_predefined)
 {
   this->init_fields(name, version, type, binding, visibility, nonvis);
-  this->u_.in_output_segment.output_segment = os;
-  this->u_.in_output_segment.offset_base = offset_base;
+  this->u1_.output_segment = os;
+  this->u2_.offset_base = offset_base;
   this->source_ = IN_OUTPUT_SEGMENT;
   this->in_reg_ = true;
   this->in_real_elf_ = true;
@@ -192,7 +193,7 @@ Symbol::init_base_undefined(const char* name, const char* version,
 			    elfcpp::STV visibility, unsigned char nonvis)
 {
   this->init_fields(name, version, type, binding, visibility, nonvis);
-  this->dynsym_index_ = -1U;
+  this->has_dynsym_index_ = true;
   this->source_ = IS_UNDEFINED;
   this->in_reg_ = true;
   this->in_real_elf_ = true;
@@ -205,8 +206,8 @@ Symbol::allocate_base_common(Output_data* od)
 {
   gold_assert(this->is_common());
   this->source_ = IN_OUTPUT_DATA;
-  this->u_.in_output_data.output_data = od;
-  this->u_.in_output_data.offset_is_from_end = false;
+  this->u1_.output_data = od;
+  this->u2_.offset_is_from_end = false;
 }
 
 // Initialize the fields in Sized_symbol for SYM in OBJECT.
@@ -301,15 +302,35 @@ Sized_symbol<size>::init_undefined(const char* name, const char* version,
 std::string
 Symbol::versioned_name() const
 {
-  gold_assert(this->version_ != NULL);
+  const char* version = this->version();
+  gold_assert(version != NULL);
   std::string ret = this->name_;
   ret.push_back('@');
   if (this->is_def_)
     ret.push_back('@');
-  ret += this->version_;
+  ret += version;
   return ret;
 }
 
+// The out of line fields of all symbols.
+
+Symbol::Cold_fields_table Symbol::cold_fields_;
+bool Symbol::cold_fields_frozen_;
+
+// Create the out of line fields for this symbol.
+
+void
+Symbol::add_cold_fields()
+{
+  gold_assert(this->cold_index_ == 0 && !Symbol::cold_fields_frozen_);
+  size_t index = Symbol::cold_fields_.size() + 1;
+  this->cold_index_ = index;
+  if (static_cast<size_t>(this->cold_index_) != index)
+    gold_fatal(_("too many symbols with versions, GOT or PLT entries, "
+		 "or dynamic symbol table entries"));
+  Symbol::cold_fields_.push_back(Cold_fields());
+}
+
 // Return true if SHNDX represents a common symbol.
 
 bool
@@ -487,19 +508,19 @@ Symbol::output_section() const
     {
     case FROM_OBJECT:
       {
-	unsigned int shndx = this->u_.from_object.shndx;
+	unsigned int shndx = this->u2_.shndx;
 	if (shndx != elfcpp::SHN_UNDEF && this->is_ordinary_shndx_)
 	  {
-	    gold_assert(!this->u_.from_object.object->is_dynamic());
-	    gold_assert(this->u_.from_object.object->pluginobj() == NULL);
-	    Relobj* relobj = static_cast<Relobj*>(this->u_.from_object.object);
+	    gold_assert(!this->u1_.object->is_dynamic());
+	    gold_assert(this->u1_.object->pluginobj() == NULL);
+	    Relobj* relobj = static_cast<Relobj*>(this->u1_.object);
 	    return relobj->output_section(shndx);
 	  }
 	return NULL;
       }
 
     case IN_OUTPUT_DATA:
-      return this->u_.in_output_data.output_data->output_section();
+      return this->u1_.output_data->output_section();
 
     case IN_OUTPUT_SEGMENT:
     case IS_CONSTANT:
@@ -526,8 +547,8 @@ Symbol::set_output_section(Output_section* os)
       break;
     case IS_CONSTANT:
       this->source_ = IN_OUTPUT_DATA;
-      this->u_.in_output_data.output_data = os;
-      this->u_.in_output_data.offset_is_from_end = false;
+      this->u1_.output_data = os;
+      this->u2_.offset_is_from_end = false;
       break;
     case IN_OUTPUT_SEGMENT:
     case IS_UNDEFINED:
@@ -545,8 +566,8 @@ Symbol::set_output_segment(Output_segment* os, Segment_offset_base base)
 {
   gold_assert(this->is_predefined_);
   this->source_ = IN_OUTPUT_SEGMENT;
-  this->u_.in_output_segment.output_segment = os;
-  this->u_.in_output_segment.offset_base = base;
+  this->u1_.output_segment = os;
+  this->u2_.offset_base = base;
 }
 
 // Set the symbol to undefined.  This is used for pre-defined
@@ -560,6 +581,66 @@ Symbol::set_undefined()
   this->is_predefined_ = false;
 }
 
+// Class Symbol_arena.
+
+Symbol_arena::~Symbol_arena()
+{
+  for (std::vector<unsigned char*>::iterator p = this->blocks_.begin();
+       p != this->blocks_.end();
+       ++p)
+    delete[] *p;
+}
+
+// Return memory for a symbol of SIZE bytes.
+
+void*
+Symbol_arena::allocate(size_t size)
+{
+  ++this->count_;
+
+  if (this->free_list_ != NULL && size == this->free_size_)
+    {
+      Free_symbol* ret = this->free_list_;
+      this->free_list_ = ret->next;
+      return ret;
+    }
+
+  // Keep the symbols aligned for the pointers they hold.
+  const size_t align = sizeof(void*);
+  size = (size + align - 1) & ~(align - 1);
+  gold_assert(size <= block_size);
+
+  if (size > this->left_)
+    {
+      this->next_ = new unsigned char[block_size];
+      this->left_ = block_size;
+      this->blocks_.push_back(this->next_);
+    }
+
+  void* ret = this->next_;
+  this->next_ += size;
+  this->left_ -= size;
+  return ret;
+}
+
+// Give back the memory for a symbol of SIZE bytes at P.
+
+void
+Symbol_arena::deallocate(void* p, size_t size)
+{
+  gold_assert(this->count_ > 0);
+  --this->count_;
+
+  // All the symbols in a link are the same size, so we only keep a
+  // free list for one size.
+  gold_assert(this->free_list_ == NULL || size == this->free_size_);
+  gold_assert(size >= sizeof(Free_symbol));
+  Free_symbol* f = static_cast<Free_symbol*>(p);
+  f->next = this->free_list_;
+  this->free_list_ = f;
+  this->free_size_ = size;
+}
+
 // Class Symbol_table.
 
 Symbol_table::Symbol_table(unsigned int count,
@@ -577,6 +658,31 @@ Symbol_table::~Symbol_table()
 {
 }
 
+// Create a new symbol.
+
+template<int size>
+Sized_symbol<size>*
+Symbol_table::make_sized_symbol()
+{
+  void* p = this->symbol_arena_.allocate(sizeof(Sized_symbol<size>));
+  return new(p) Sized_symbol<size>();
+}
+
+// Free a symbol which we decided not to use.
+
+template<int size>
+void
+Symbol_table::free_sized_symbol(Sized_symbol<size>* sym)
+{
+  if (parameters->target().has_make_symbol())
+    delete sym;
+  else
+    {
+      sym->~Sized_symbol<size>();
+      this->symbol_arena_.deallocate(sym, sizeof(Sized_symbol<size>));
+    }
+}
+
 // The symbol table key equality function.  This is called with
 // Stringpool keys.
 
@@ -1066,7 +1172,7 @@ Symbol_table::add_from_object(Object* object,
 	  Sized_target<size, big_endian>* target =
 	    parameters->sized_target<size, big_endian>();
 	  if (!target->has_make_symbol())
-	    ret = new Sized_symbol<size>();
+	    ret = this->make_sized_symbol<size>();
 	  else
 	    {
 	      ret = target->make_symbol(name, sym.get_st_type(), object,
@@ -1877,7 +1983,7 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
 
   const Target& target = parameters->target();
   if (!target.has_make_symbol())
-    sym = new Sized_symbol<size>();
+    sym = this->make_sized_symbol<size>();
   else
     {
       Sized_target<size, big_endian>* sized_target =
@@ -2017,7 +2123,7 @@ Symbol_table::do_define_in_output_data(
       if (defined == PREDEFINED
 	  && (is_forced_local || this->version_script_.symbol_is_local(name)))
 	this->force_local(oldsym);
-      delete sym;
+      this->free_sized_symbol(sym);
       return oldsym;
     }
 }
@@ -2135,7 +2241,7 @@ Symbol_table::do_define_in_output_segment(
     {
       if (is_forced_local || this->version_script_.symbol_is_local(name))
 	this->force_local(oldsym);
-      delete sym;
+      this->free_sized_symbol(sym);
       return oldsym;
     }
 }
@@ -2258,7 +2364,7 @@ Symbol_table::do_define_as_constant(
     {
       if (is_forced_local || this->version_script_.symbol_is_local(name))
 	this->force_local(oldsym);
-      delete sym;
+      this->free_sized_symbol(sym);
       return oldsym;
     }
 }
@@ -2589,6 +2695,9 @@ Symbol_table::set_dynsym_indexes(unsigned int index,
 	sym->clear_version();
     }
 
+  if (parameters->target().packs_relative_relocs())
+    versions->record_dt_relr_version(this, dynpool);
+
   // Finish up the versions.  In some cases this may add new dynamic
   // symbols.
   index = versions->finalize(this, index, syms);
@@ -2654,6 +2763,10 @@ Symbol_table::finalize(off_t off, off_t dynoff, size_t dyn_global_index,
   // which symbols should get warnings.
   this->warnings_.note_warnings(this);
 
+  // The relocation tasks, which run in parallel, may read the out of
+  // line fields of the symbols, so they must not grow from now on.
+  Symbol::freeze_cold_fields();
+
   return ret;
 }
 
@@ -2674,6 +2787,85 @@ Symbol_table::add_to_final_symtab(Symbol* sym, Stringpool* pool,
   *poff += elfcpp::Elf_sizes<size>::sym_size;
 }
 
+// Return whether the final value of SYM may be computed on any
+// thread.  The value of a symbol in a section which needs special
+// handling, such as a merged section, is found using a map which is
+// not safe to use on more than one thread at a time.
+
+static bool
+final_value_is_thread_safe(const Symbol_table* symtab, const Symbol* sym)
+{
+  if (sym->source() != Symbol::FROM_OBJECT)
+    return true;
+  bool is_ordinary;
+  unsigned int shndx = sym->shndx(&is_ordinary);
+  Object* object = sym->object();
+  if (!is_ordinary
+      || shndx == elfcpp::SHN_UNDEF
+      || object->is_dynamic()
+      || object->pluginobj() != NULL)
+    return true;
+  Relobj* relobj = static_cast<Relobj*>(object);
+  return (!symtab->is_section_folded(relobj, shndx)
+	  && relobj->output_section_offset(shndx) != -1ULL);
+}
+
+// Compute the final values of some global symbols.  Piece I handles
+// the symbols I * PIECE_SIZE up to (I + 1) * PIECE_SIZE.  This only
+// reads the symbols; Symbol_table::sized_finalize_symbol stores the
+// values, in order.  Symbols which won't be added to the symbol table,
+// or whose values are not safe to compute here, are left for
+// sized_finalize_symbol.
+
+template<int size>
+class Final_value_computer : public Parallel_work
+{
+ public:
+  typedef typename Sized_symbol<size>::Value_type Value_type;
+
+  Final_value_computer(const Symbol_table* symtab,
+		       const std::vector<Symbol*>* syms,
+		       std::vector<Value_type>* values,
+		       std::vector<unsigned char>* statuses, size_t piece_size)
+    : symtab_(symtab), syms_(syms), values_(values), statuses_(statuses),
+      piece_size_(piece_size)
+  { }
+
+  // The status of a symbol whose value was not computed.
+  static const unsigned char NOT_COMPUTED = 0xff;
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    size_t start = piece * this->piece_size_;
+    size_t end = std::min(start + this->piece_size_, this->syms_->size());
+    for (size_t i = start; i < end; ++i)
+      {
+	const Sized_symbol<size>* sym =
+	  static_cast<const Sized_symbol<size>*>((*this->syms_)[i]);
+	if (sym->has_symtab_index()
+	    || !sym->in_reg()
+	    || !sym->in_real_elf()
+	    || !final_value_is_thread_safe(this->symtab_, sym))
+	  {
+	    (*this->statuses_)[i] = NOT_COMPUTED;
+	    continue;
+	  }
+	Symbol_table::Compute_final_value_status status;
+	(*this->values_)[i] = this->symtab_->compute_final_value(sym, &status);
+	(*this->statuses_)[i] = status;
+      }
+  }
+
+ private:
+  const Symbol_table* symtab_;
+  const std::vector<Symbol*>* syms_;
+  std::vector<Value_type>* values_;
+  std::vector<unsigned char>* statuses_;
+  size_t piece_size_;
+};
+
 // Set the final value for all the symbols.  This is called after
 // Layout::finalize, so all the output sections have their final
 // address.
@@ -2697,21 +2889,63 @@ Symbol_table::sized_finalize(off_t off, Stringpool* pool,
     {
       Symbol* sym = *p;
       gold_assert(sym->is_forced_local());
-      if (this->sized_finalize_symbol<size>(sym))
+      if (this->sized_finalize_symbol<size>(sym, NULL, CFVS_OK))
 	{
 	  this->add_to_final_symtab<size>(sym, pool, &index, &off);
 	  ++*plocal_symcount;
 	}
     }
 
-  // Now do all the remaining symbols.
-  for (Symbol_table_type::iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
+  // Now do all the remaining symbols.  With --threads, we compute most
+  // of the final values on several threads first.  The symbol table
+  // indexes are always assigned in the order of the table, so that
+  // the output does not depend on the number of threads.
+  const size_t min_piece_size = 4096;
+  size_t pieces = Parallel_work::thread_count();
+  if (pieces > 1)
+    pieces *= 4;
+  if (pieces > this->table_.size() / min_piece_size)
+    pieces = this->table_.size() / min_piece_size;
+  if (pieces <= 1)
     {
-      Symbol* sym = p->second;
-      if (this->sized_finalize_symbol<size>(sym))
-	this->add_to_final_symtab<size>(sym, pool, &index, &off);
+      for (Symbol_table_type::iterator p = this->table_.begin();
+	   p != this->table_.end();
+	   ++p)
+	{
+	  Symbol* sym = p->second;
+	  if (this->sized_finalize_symbol<size>(sym, NULL, CFVS_OK))
+	    this->add_to_final_symtab<size>(sym, pool, &index, &off);
+	}
+    }
+  else
+    {
+      typedef typename Sized_symbol<size>::Value_type Value_type;
+      std::vector<Symbol*> syms;
+      syms.reserve(this->table_.size());
+      for (Symbol_table_type::iterator p = this->table_.begin();
+	   p != this->table_.end();
+	   ++p)
+	syms.push_back(p->second);
+
+      std::vector<Value_type> values(syms.size());
+      std::vector<unsigned char> statuses(syms.size());
+      const size_t piece_size = (syms.size() + pieces - 1) / pieces;
+      Final_value_computer<size> computer(this, &syms, &values, &statuses,
+					  piece_size);
+      computer.run(pieces);
+
+      for (size_t i = 0; i < syms.size(); ++i)
+	{
+	  const Value_type* pvalue = NULL;
+	  Compute_final_value_status status = CFVS_OK;
+	  if (statuses[i] != Final_value_computer<size>::NOT_COMPUTED)
+	    {
+	      pvalue = &values[i];
+	      status = static_cast<Compute_final_value_status>(statuses[i]);
+	    }
+	  if (this->sized_finalize_symbol<size>(syms[i], pvalue, status))
+	    this->add_to_final_symtab<size>(syms[i], pool, &index, &off);
+	}
     }
 
   // Now do target-specific symbols.
@@ -2881,11 +3115,15 @@ Symbol_table::compute_final_value(
 }
 
 // Finalize the symbol SYM.  This returns true if the symbol should be
-// added to the symbol table, false otherwise.
+// added to the symbol table, false otherwise.  If PVALUE is not NULL,
+// the final value has already been computed.
 
 template<int size>
 bool
-Symbol_table::sized_finalize_symbol(Symbol* unsized_sym)
+Symbol_table::sized_finalize_symbol(
+    Symbol* unsized_sym,
+    const typename Sized_symbol<size>::Value_type* pvalue,
+    Compute_final_value_status status)
 {
   typedef typename Sized_symbol<size>::Value_type Value_type;
 
@@ -2914,8 +3152,11 @@ Symbol_table::sized_finalize_symbol(Symbol* unsized_sym)
     }
 
   // Compute final symbol value.
-  Compute_final_value_status status;
-  Value_type value = this->compute_final_value(sym, &status);
+  Value_type value;
+  if (pvalue != NULL)
+    value = *pvalue;
+  else
+    value = this->compute_final_value(sym, &status);
 
   switch (status)
     {
@@ -2948,6 +3189,53 @@ Symbol_table::sized_finalize_symbol(Symbol* unsized_sym)
   return true;
 }
 
+// Write some of the global symbols.  Piece I handles the symbols at
+// output indexes I * PIECE_SIZE up to (I + 1) * PIECE_SIZE.
+
+template<int size, bool big_endian>
+class Symbol_table::Global_symbol_writer : public Parallel_work
+{
+ public:
+  Global_symbol_writer(const Symbol_table* symtab,
+		       const std::vector<Sized_symbol<size>*>* syms,
+		       const Stringpool* sympool, const Stringpool* dynpool,
+		       Output_symtab_xindex* symtab_xindex,
+		       Output_symtab_xindex* dynsym_xindex,
+		       unsigned char* psyms, unsigned char* dynamic_view,
+		       size_t piece_size)
+    : symtab_(symtab), syms_(syms), sympool_(sympool), dynpool_(dynpool),
+      symtab_xindex_(symtab_xindex), dynsym_xindex_(dynsym_xindex),
+      psyms_(psyms), dynamic_view_(dynamic_view), piece_size_(piece_size)
+  { }
+
+ protected:
+  void
+  do_run_piece(unsigned int piece)
+  {
+    size_t start = piece * this->piece_size_;
+    size_t end = std::min(start + this->piece_size_, this->syms_->size());
+    for (size_t i = start; i < end; ++i)
+      {
+	Sized_symbol<size>* sym = (*this->syms_)[i];
+	if (sym != NULL)
+	  this->symtab_->template sized_write_global<size, big_endian>(
+	      sym, this->sympool_, this->dynpool_, this->symtab_xindex_,
+	      this->dynsym_xindex_, this->psyms_, this->dynamic_view_);
+      }
+  }
+
+ private:
+  const Symbol_table* symtab_;
+  const std::vector<Sized_symbol<size>*>* syms_;
+  const Stringpool* sympool_;
+  const Stringpool* dynpool_;
+  Output_symtab_xindex* symtab_xindex_;
+  Output_symtab_xindex* dynsym_xindex_;
+  unsigned char* psyms_;
+  unsigned char* dynamic_view_;
+  size_t piece_size_;
+};
+
 // Write out the global symbols.
 
 void
@@ -2998,8 +3286,6 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
 				  Output_symtab_xindex* dynsym_xindex,
 				  Output_file* of) const
 {
-  const Target& target = parameters->target();
-
   const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
 
   const unsigned int output_count = this->output_count_;
@@ -3021,6 +3307,12 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
   else
     dynamic_view = of->get_output_view(this->dynamic_offset_, dynamic_size);
 
+  // Collect the symbols to write, indexed by their output index, so
+  // that we can write them on several threads.  The default version
+  // of a symbol appears twice in the table, but only once here.
+  // Symbols which are only in the dynamic symbol table follow the
+  // others.
+  std::vector<Sized_symbol<size>*> syms(output_count + dynamic_count);
   for (Symbol_table_type::const_iterator p = this->table_.begin();
        p != this->table_.end();
        ++p)
@@ -3037,171 +3329,35 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
       else
 	dynsym_index = sym->dynsym_index();
 
-      if (sym_index == -1U && dynsym_index == -1U)
-	{
-	  // This symbol is not included in the output file.
-	  continue;
-	}
-
-      unsigned int shndx;
-      typename elfcpp::Elf_types<size>::Elf_Addr sym_value = sym->value();
-      typename elfcpp::Elf_types<size>::Elf_Addr dynsym_value = sym_value;
-      elfcpp::STB binding = sym->binding();
-
-      // If --weak-unresolved-symbols is set, change binding of unresolved
-      // global symbols to STB_WEAK.
-      if (parameters->options().weak_unresolved_symbols()
-	  && binding == elfcpp::STB_GLOBAL
-	  && sym->is_undefined())
-	binding = elfcpp::STB_WEAK;
-
-      // If --no-gnu-unique is set, change STB_GNU_UNIQUE to STB_GLOBAL.
-      if (binding == elfcpp::STB_GNU_UNIQUE
-	  && !parameters->options().gnu_unique())
-	binding = elfcpp::STB_GLOBAL;
-
-      switch (sym->source())
-	{
-	case Symbol::FROM_OBJECT:
-	  {
-	    bool is_ordinary;
-	    unsigned int in_shndx = sym->shndx(&is_ordinary);
-
-	    if (!is_ordinary
-		&& in_shndx != elfcpp::SHN_ABS
-		&& !Symbol::is_common_shndx(in_shndx))
-	      {
-		gold_error(_("%s: unsupported symbol section 0x%x"),
-			   sym->demangled_name().c_str(), in_shndx);
-		shndx = in_shndx;
-	      }
-	    else
-	      {
-		Object* symobj = sym->object();
-		if (symobj->is_dynamic())
-		  {
-		    if (sym->needs_dynsym_value())
-		      dynsym_value = target.dynsym_value(sym);
-		    shndx = elfcpp::SHN_UNDEF;
-		    if (sym->is_undef_binding_weak())
-		      binding = elfcpp::STB_WEAK;
-		    else
-		      binding = elfcpp::STB_GLOBAL;
-		  }
-		else if (symobj->pluginobj() != NULL)
-		  shndx = elfcpp::SHN_UNDEF;
-		else if (in_shndx == elfcpp::SHN_UNDEF
-			 || (!is_ordinary
-			     && (in_shndx == elfcpp::SHN_ABS
-				 || Symbol::is_common_shndx(in_shndx))))
-		  shndx = in_shndx;
-		else
-		  {
-		    Relobj* relobj = static_cast<Relobj*>(symobj);
-		    Output_section* os = relobj->output_section(in_shndx);
-                    if (this->is_section_folded(relobj, in_shndx))
-                      {
-                        // This global symbol must be written out even though
-                        // it is folded.
-                        // Get the os of the section it is folded onto.
-                        Section_id folded =
-                             this->icf_->get_folded_section(relobj, in_shndx);
-                        gold_assert(folded.first !=NULL);
-                        Relobj* folded_obj = 
-                          reinterpret_cast<Relobj*>(folded.first);
-                        os = folded_obj->output_section(folded.second);  
-                        gold_assert(os != NULL);
-                      }
-		    gold_assert(os != NULL);
-		    shndx = os->out_shndx();
-
-		    if (shndx >= elfcpp::SHN_LORESERVE)
-		      {
-			if (sym_index != -1U)
-			  symtab_xindex->add(sym_index, shndx);
-			if (dynsym_index != -1U)
-			  dynsym_xindex->add(dynsym_index, shndx);
-			shndx = elfcpp::SHN_XINDEX;
-		      }
-
-		    // In object files symbol values are section
-		    // relative.
-		    if (parameters->options().relocatable())
-		      sym_value -= os->address();
-		  }
-	      }
-	  }
-	  break;
-
-	case Symbol::IN_OUTPUT_DATA:
-	  {
-	    Output_data* od = sym->output_data();
-
-	    shndx = od->out_shndx();
-	    if (shndx >= elfcpp::SHN_LORESERVE)
-	      {
-		if (sym_index != -1U)
-		  symtab_xindex->add(sym_index, shndx);
-		if (dynsym_index != -1U)
-		  dynsym_xindex->add(dynsym_index, shndx);
-		shndx = elfcpp::SHN_XINDEX;
-	      }
-
-	    // In object files symbol values are section
-	    // relative.
-	    if (parameters->options().relocatable())
-	      {
-		Output_section* os = od->output_section();
-		gold_assert(os != NULL);
-		sym_value -= os->address();
-	      }
-	  }
-	  break;
-
-	case Symbol::IN_OUTPUT_SEGMENT:
-	  {
-	    Output_segment* oseg = sym->output_segment();
-	    Output_section* osect = oseg->first_section();
-	    if (osect == NULL)
-	      shndx = elfcpp::SHN_ABS;
-	    else
-	      shndx = osect->out_shndx();
-	  }
-	  break;
-
-	case Symbol::IS_CONSTANT:
-	  shndx = elfcpp::SHN_ABS;
-	  break;
-
-	case Symbol::IS_UNDEFINED:
-	  shndx = elfcpp::SHN_UNDEF;
-	  break;
-
-	default:
-	  gold_unreachable();
-	}
-
       if (sym_index != -1U)
 	{
 	  sym_index -= first_global_index;
 	  gold_assert(sym_index < output_count);
-	  unsigned char* ps = psyms + (sym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, sym_value, shndx,
-						     binding, sympool, ps);
+	  syms[sym_index] = sym;
 	}
-
-      if (dynsym_index != -1U)
+      else if (dynsym_index != -1U)
 	{
 	  dynsym_index -= first_dynamic_global_index;
 	  gold_assert(dynsym_index < dynamic_count);
-	  unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, dynsym_value, shndx,
-						     binding, dynpool, pd);
-          // Allow a target to adjust dynamic symbol value.
-          parameters->target().adjust_dyn_symbol(sym, pd);
+	  syms[output_count + dynsym_index] = sym;
 	}
     }
 
+  const size_t min_piece_size = 4096;
+  size_t pieces = Parallel_work::thread_count();
+  if (pieces > 1)
+    pieces *= 4;
+  if (pieces > syms.size() / min_piece_size)
+    pieces = syms.size() / min_piece_size;
+  if (pieces == 0)
+    pieces = 1;
+  const size_t piece_size = (syms.size() + pieces - 1) / pieces;
+  Global_symbol_writer<size, big_endian> writer(this, &syms, sympool, dynpool,
+						symtab_xindex, dynsym_xindex,
+						psyms, dynamic_view,
+						piece_size);
+  writer.run(pieces);
+
   // Write the target-specific symbols.
   for (std::vector<Symbol*>::const_iterator p = this->target_symbols_.begin();
        p != this->target_symbols_.end();
@@ -3255,6 +3411,194 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
     of->write_output_view(this->dynamic_offset_, dynamic_size, dynamic_view);
 }
 
+// Write out the global symbol SYM to the symbol table at PSYMS and the
+// dynamic symbol table at DYNAMIC_VIEW.  This may be called on several
+// threads at once for different symbols.
+
+template<int size, bool big_endian>
+void
+Symbol_table::sized_write_global(Sized_symbol<size>* sym,
+				 const Stringpool* sympool,
+				 const Stringpool* dynpool,
+				 Output_symtab_xindex* symtab_xindex,
+				 Output_symtab_xindex* dynsym_xindex,
+				 unsigned char* psyms,
+				 unsigned char* dynamic_view) const
+{
+  const Target& target = parameters->target();
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+  const unsigned int output_count = this->output_count_;
+  const unsigned int first_global_index = this->first_global_index_;
+  const unsigned int dynamic_count = this->dynamic_count_;
+  const unsigned int first_dynamic_global_index =
+    this->first_dynamic_global_index_;
+
+  unsigned int sym_index = sym->symtab_index();
+  unsigned int dynsym_index;
+  if (dynamic_view == NULL)
+    dynsym_index = -1U;
+  else
+    dynsym_index = sym->dynsym_index();
+
+  unsigned int shndx;
+  typename elfcpp::Elf_types<size>::Elf_Addr sym_value = sym->value();
+  typename elfcpp::Elf_types<size>::Elf_Addr dynsym_value = sym_value;
+  elfcpp::STB binding = sym->binding();
+
+  // If --weak-unresolved-symbols is set, change binding of unresolved
+  // global symbols to STB_WEAK.
+  if (parameters->options().weak_unresolved_symbols()
+      && binding == elfcpp::STB_GLOBAL
+      && sym->is_undefined())
+    binding = elfcpp::STB_WEAK;
+
+  // If --no-gnu-unique is set, change STB_GNU_UNIQUE to STB_GLOBAL.
+  if (binding == elfcpp::STB_GNU_UNIQUE
+      && !parameters->options().gnu_unique())
+    binding = elfcpp::STB_GLOBAL;
+
+  switch (sym->source())
+    {
+    case Symbol::FROM_OBJECT:
+      {
+	bool is_ordinary;
+	unsigned int in_shndx = sym->shndx(&is_ordinary);
+
+	if (!is_ordinary
+	    && in_shndx != elfcpp::SHN_ABS
+	    && !Symbol::is_common_shndx(in_shndx))
+	  {
+	    gold_error(_("%s: unsupported symbol section 0x%x"),
+		       sym->demangled_name().c_str(), in_shndx);
+	    shndx = in_shndx;
+	  }
+	else
+	  {
+	    Object* symobj = sym->object();
+	    if (symobj->is_dynamic())
+	      {
+		if (sym->needs_dynsym_value())
+		  dynsym_value = target.dynsym_value(sym);
+		shndx = elfcpp::SHN_UNDEF;
+		if (sym->is_undef_binding_weak())
+		  binding = elfcpp::STB_WEAK;
+		else
+		  binding = elfcpp::STB_GLOBAL;
+	      }
+	    else if (symobj->pluginobj() != NULL)
+	      shndx = elfcpp::SHN_UNDEF;
+	    else if (in_shndx == elfcpp::SHN_UNDEF
+		     || (!is_ordinary
+			 && (in_shndx == elfcpp::SHN_ABS
+			     || Symbol::is_common_shndx(in_shndx))))
+	      shndx = in_shndx;
+	    else
+	      {
+		Relobj* relobj = static_cast<Relobj*>(symobj);
+		Output_section* os = relobj->output_section(in_shndx);
+		if (this->is_section_folded(relobj, in_shndx))
+		  {
+		    // This global symbol must be written out even though
+		    // it is folded.
+		    // Get the os of the section it is folded onto.
+		    Section_id folded =
+			 this->icf_->get_folded_section(relobj, in_shndx);
+		    gold_assert(folded.first !=NULL);
+		    Relobj* folded_obj = 
+		      reinterpret_cast<Relobj*>(folded.first);
+		    os = folded_obj->output_section(folded.second);  
+		    gold_assert(os != NULL);
+		  }
+		gold_assert(os != NULL);
+		shndx = os->out_shndx();
+
+		if (shndx >= elfcpp::SHN_LORESERVE)
+		  {
+		    if (sym_index != -1U)
+		      symtab_xindex->add(sym_index, shndx);
+		    if (dynsym_index != -1U)
+		      dynsym_xindex->add(dynsym_index, shndx);
+		    shndx = elfcpp::SHN_XINDEX;
+		  }
+
+		// In object files symbol values are section
+		// relative.
+		if (parameters->options().relocatable())
+		  sym_value -= os->address();
+	      }
+	  }
+      }
+      break;
+
+    case Symbol::IN_OUTPUT_DATA:
+      {
+	Output_data* od = sym->output_data();
+
+	shndx = od->out_shndx();
+	if (shndx >= elfcpp::SHN_LORESERVE)
+	  {
+	    if (sym_index != -1U)
+	      symtab_xindex->add(sym_index, shndx);
+	    if (dynsym_index != -1U)
+	      dynsym_xindex->add(dynsym_index, shndx);
+	    shndx = elfcpp::SHN_XINDEX;
+	  }
+
+	// In object files symbol values are section
+	// relative.
+	if (parameters->options().relocatable())
+	  {
+	    Output_section* os = od->output_section();
+	    gold_assert(os != NULL);
+	    sym_value -= os->address();
+	  }
+      }
+      break;
+
+    case Symbol::IN_OUTPUT_SEGMENT:
+      {
+	Output_segment* oseg = sym->output_segment();
+	Output_section* osect = oseg->first_section();
+	if (osect == NULL)
+	  shndx = elfcpp::SHN_ABS;
+	else
+	  shndx = osect->out_shndx();
+      }
+      break;
+
+    case Symbol::IS_CONSTANT:
+      shndx = elfcpp::SHN_ABS;
+      break;
+
+    case Symbol::IS_UNDEFINED:
+      shndx = elfcpp::SHN_UNDEF;
+      break;
+
+    default:
+      gold_unreachable();
+    }
+
+  if (sym_index != -1U)
+    {
+      sym_index -= first_global_index;
+      gold_assert(sym_index < output_count);
+      unsigned char* ps = psyms + (sym_index * sym_size);
+      this->sized_write_symbol<size, big_endian>(sym, sym_value, shndx,
+						 binding, sympool, ps);
+    }
+
+  if (dynsym_index != -1U)
+    {
+      dynsym_index -= first_dynamic_global_index;
+      gold_assert(dynsym_index < dynamic_count);
+      unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
+      this->sized_write_symbol<size, big_endian>(sym, dynsym_value, shndx,
+						 binding, dynpool, pd);
+      // Allow a target to adjust dynamic symbol value.
+      parameters->target().adjust_dyn_symbol(sym, pd);
+    }
+}
+
 // Write out the symbol SYM, in section SHNDX, to P.  POOL is the
 // strtab holding the name.
 
@@ -3410,6 +3754,16 @@ Symbol_table::print_stats() const
 	  program_name, this->table_.size());
 #endif
   this->namepool_.print_stats("symbol table stringpool");
+  fprintf(stderr, _("%s: symbols: %zu; symbol memory: %zu bytes\n"),
+	  program_name, this->symbol_arena_.count(),
+	  this->symbol_arena_.allocated_bytes());
+  fprintf(stderr,
+	  _("%s: symbols with out of line fields: %zu; "
+	    "out of line field memory: %zu bytes\n"),
+	  program_name, Symbol::cold_fields_count(),
+	  Symbol::cold_fields_count() * Symbol::cold_fields_size());
+  fprintf(stderr, _("%s: symbol forwarders: %zu; weak aliases: %zu\n"),
+	  program_name, this->forwarders_.size(), this->weak_aliases_.size());
 }
 
 // We check for ODR violations by looking for symbols with the same
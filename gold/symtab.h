@@ -26,6 +26,7 @@
 #ifndef GOLD_SYMTAB_H
 #define GOLD_SYMTAB_H
 
+#include <deque>
 #include <string>
 #include <utility>
 #include <vector>
@@ -119,11 +120,17 @@ class Symbol
   // unversioned symbol.
   const char*
   version() const
-  { return this->version_; }
+  {
+    const Cold_fields* cold = this->find_cold_fields();
+    return cold == NULL ? NULL : cold->version;
+  }
 
   void
   clear_version()
-  { this->version_ = NULL; }
+  {
+    if (this->cold_index_ != 0)
+      this->cold_fields()->version = NULL;
+  }
 
   // Return whether this version is the default for this symbol name
   // (eg, "foo@@V2" is a default version; "foo@V1" is not).  Only
@@ -131,7 +138,7 @@ class Symbol
   bool
   is_default() const
   {
-    gold_assert(this->version_ != NULL);
+    gold_assert(this->version() != NULL);
     return this->is_def_;
   }
 
@@ -159,7 +166,7 @@ class Symbol
   object() const
   {
     gold_assert(this->source_ == FROM_OBJECT);
-    return this->u_.from_object.object;
+    return this->u1_.object;
   }
 
   // Return the index of the section in the input relocatable or
@@ -169,7 +176,7 @@ class Symbol
   {
     gold_assert(this->source_ == FROM_OBJECT);
     *is_ordinary = this->is_ordinary_shndx_;
-    return this->u_.from_object.shndx;
+    return this->u2_.shndx;
   }
 
   // Return the output data section with which this symbol is
@@ -179,7 +186,7 @@ class Symbol
   output_data() const
   {
     gold_assert(this->source_ == IN_OUTPUT_DATA);
-    return this->u_.in_output_data.output_data;
+    return this->u1_.output_data;
   }
 
   // If this symbol was defined with respect to an output data
@@ -188,7 +195,7 @@ class Symbol
   offset_is_from_end() const
   {
     gold_assert(this->source_ == IN_OUTPUT_DATA);
-    return this->u_.in_output_data.offset_is_from_end;
+    return this->u2_.offset_is_from_end;
   }
 
   // Return the output segment with which this symbol is associated,
@@ -198,7 +205,7 @@ class Symbol
   output_segment() const
   {
     gold_assert(this->source_ == IN_OUTPUT_SEGMENT);
-    return this->u_.in_output_segment.output_segment;
+    return this->u1_.output_segment;
   }
 
   // If this symbol was defined with respect to an output segment,
@@ -207,7 +214,7 @@ class Symbol
   offset_base() const
   {
     gold_assert(this->source_ == IN_OUTPUT_SEGMENT);
-    return this->u_.in_output_segment.offset_base;
+    return this->u2_.offset_base;
   }
 
   // Return the symbol binding.
@@ -397,8 +404,9 @@ class Symbol
   unsigned int
   dynsym_index() const
   {
-    gold_assert(this->dynsym_index_ != 0);
-    return this->dynsym_index_;
+    gold_assert(this->has_dynsym_index_);
+    const Cold_fields* cold = this->find_cold_fields();
+    return cold == NULL ? -1U : cold->dynsym_index;
   }
 
   // Set the index of the symbol in the dynamic symbol table.
@@ -406,26 +414,33 @@ class Symbol
   set_dynsym_index(unsigned int index)
   {
     gold_assert(index != 0);
-    this->dynsym_index_ = index;
+    this->has_dynsym_index_ = true;
+    if (index != -1U || this->cold_index_ != 0)
+      this->cold_fields()->dynsym_index = index;
   }
 
   // Return whether this symbol already has an index in the dynamic
   // symbol table.
   bool
   has_dynsym_index() const
-  { return this->dynsym_index_ != 0; }
+  { return this->has_dynsym_index_; }
 
   // Return whether this symbol has an entry in the GOT section.
   // For a TLS symbol, this GOT entry will hold its tp-relative offset.
   bool
   has_got_offset(unsigned int got_type) const
-  { return this->got_offsets_.get_offset(got_type) != -1U; }
+  {
+    const Cold_fields* cold = this->find_cold_fields();
+    return cold != NULL && cold->got_offsets.get_offset(got_type) != -1U;
+  }
 
   // Return the offset into the GOT section of this symbol.
   unsigned int
   got_offset(unsigned int got_type) const
   {
-    unsigned int got_offset = this->got_offsets_.get_offset(got_type);
+    const Cold_fields* cold = this->find_cold_fields();
+    gold_assert(cold != NULL);
+    unsigned int got_offset = cold->got_offsets.get_offset(got_type);
     gold_assert(got_offset != -1U);
     return got_offset;
   }
@@ -433,24 +448,30 @@ class Symbol
   // Set the GOT offset of this symbol.
   void
   set_got_offset(unsigned int got_type, unsigned int got_offset)
-  { this->got_offsets_.set_offset(got_type, got_offset); }
+  { this->cold_fields()->got_offsets.set_offset(got_type, got_offset); }
 
   // Return the GOT offset list.
   const Got_offset_list*
   got_offset_list() const
-  { return this->got_offsets_.get_list(); }
+  {
+    const Cold_fields* cold = this->find_cold_fields();
+    return cold == NULL ? NULL : cold->got_offsets.get_list();
+  }
 
   // Return whether this symbol has an entry in the PLT section.
   bool
   has_plt_offset() const
-  { return this->plt_offset_ != -1U; }
+  {
+    const Cold_fields* cold = this->find_cold_fields();
+    return cold != NULL && cold->plt_offset != -1U;
+  }
 
   // Return the offset into the PLT section of this symbol.
   unsigned int
   plt_offset() const
   {
     gold_assert(this->has_plt_offset());
-    return this->plt_offset_;
+    return this->find_cold_fields()->plt_offset;
   }
 
   // Set the PLT offset of this symbol.
@@ -458,7 +479,7 @@ class Symbol
   set_plt_offset(unsigned int plt_offset)
   {
     gold_assert(plt_offset != -1U);
-    this->plt_offset_ = plt_offset;
+    this->cold_fields()->plt_offset = plt_offset;
   }
 
   // Return whether this dynamic symbol needs a special value in the
@@ -883,6 +904,24 @@ class Symbol
   set_is_protected()
   { this->is_protected_ = true; }
 
+  // Return the number of symbols with out of line fields, for
+  // statistics.
+  static size_t
+  cold_fields_count()
+  { return Symbol::cold_fields_.size(); }
+
+  // Return the size of the out of line fields of a symbol, for
+  // statistics.
+  static size_t
+  cold_fields_size()
+  { return sizeof(Cold_fields); }
+
+  // Stop the out of line fields from being added to.  This is called
+  // when the symbol table is finalized.
+  static void
+  freeze_cold_fields()
+  { Symbol::cold_fields_frozen_ = true; }
+
  protected:
   // Instances of this class should always be created at a specific
   // size.
@@ -955,46 +994,117 @@ class Symbol
   Symbol(const Symbol&);
   Symbol& operator=(const Symbol&);
 
+  // Fields which most symbols do not need: the version, the dynamic
+  // symbol table index, and the GOT and PLT offsets.  Since a large
+  // link can have tens of millions of symbols, keeping these in every
+  // symbol would waste a lot of memory, so they are kept out of line
+  // in the table COLD_FIELDS_, and only created for a symbol when one
+  // of them is set.  Entries are added by symbol resolution,
+  // relocation scanning and Layout::finalize, all of which run
+  // serially, so the table never changes while it is being read by
+  // tasks running in parallel.  Symbol_table::finalize freezes the
+  // table before the relocation tasks run, and adding an entry after
+  // that is an internal error.
+  struct Cold_fields
+  {
+    Cold_fields()
+      : version(NULL), dynsym_index(-1U), plt_offset(-1U), got_offsets()
+    { }
+
+    // Symbol version (expected to point into a Stringpool).  This
+    // may be NULL.
+    const char* version;
+    // The index of this symbol in the dynamic symbol table, or -1U.
+    // This is only meaningful if HAS_DYNSYM_INDEX_ is set.
+    unsigned int dynsym_index;
+    // If this symbol has an entry in the PLT section, then this is
+    // the offset from the start of the PLT section.  This is -1U if
+    // there is no PLT entry.
+    unsigned int plt_offset;
+    // The GOT section entries for this symbol.  A symbol may have
+    // more than one GOT offset (e.g., when mixing modules compiled
+    // with two different TLS models), but will usually have at most
+    // one.
+    Got_offset_list got_offsets;
+  };
+
+  // We use a deque so that adding an entry never moves the existing
+  // ones: a Got_offset_list can not be safely copied once it has
+  // more than one entry, and we hand out pointers to it.
+  typedef std::deque<Cold_fields> Cold_fields_table;
+
+  // Return the out of line fields for this symbol, or NULL if it
+  // does not have any.
+  const Cold_fields*
+  find_cold_fields() const
+  {
+    if (this->cold_index_ == 0)
+      return NULL;
+    return &Symbol::cold_fields_[this->cold_index_ - 1];
+  }
+
+  // Return the out of line fields for this symbol, creating them if
+  // necessary.
+  Cold_fields*
+  cold_fields()
+  {
+    if (this->cold_index_ == 0)
+      this->add_cold_fields();
+    return &Symbol::cold_fields_[this->cold_index_ - 1];
+  }
+
+  // Create the out of line fields for this symbol.
+  void
+  add_cold_fields();
+
+  // Set the symbol version.
+  void
+  set_version(const char* version)
+  {
+    if (version != NULL || this->cold_index_ != 0)
+      this->cold_fields()->version = version;
+  }
+
+  // The out of line fields of all symbols, indexed by COLD_INDEX_ - 1.
+  static Cold_fields_table cold_fields_;
+
+  // Whether COLD_FIELDS_ may no longer grow.
+  static bool cold_fields_frozen_;
+
   // Symbol name (expected to point into a Stringpool).
   const char* name_;
-  // Symbol version (expected to point into a Stringpool).  This may
-  // be NULL.
-  const char* version_;
 
+  // Where the symbol is defined.  The field used depends on SOURCE_:
+  // OBJECT if FROM_OBJECT, OUTPUT_DATA if IN_OUTPUT_DATA,
+  // OUTPUT_SEGMENT if IN_OUTPUT_SEGMENT.
   union
   {
-    // This struct is used if SOURCE_ == FROM_OBJECT.
-    struct
-    {
-      // Object in which symbol is defined, or in which it was first
-      // seen.
-      Object* object;
-      // Section number in object_ in which symbol is defined.
-      unsigned int shndx;
-    } from_object;
-
-    // This struct is used if SOURCE_ == IN_OUTPUT_DATA.
-    struct
-    {
-      // Output_data in which symbol is defined.  Before
-      // Layout::finalize the symbol's value is an offset within the
-      // Output_data.
-      Output_data* output_data;
-      // True if the offset is from the end, false if the offset is
-      // from the beginning.
-      bool offset_is_from_end;
-    } in_output_data;
-
-    // This struct is used if SOURCE_ == IN_OUTPUT_SEGMENT.
-    struct
-    {
-      // Output_segment in which the symbol is defined.  Before
-      // Layout::finalize the symbol's value is an offset.
-      Output_segment* output_segment;
-      // The base to use for the offset before Layout::finalize.
-      Segment_offset_base offset_base;
-    } in_output_segment;
-  } u_;
+    // Object in which symbol is defined, or in which it was first
+    // seen.
+    Object* object;
+    // Output_data in which symbol is defined.  Before
+    // Layout::finalize the symbol's value is an offset within the
+    // Output_data.
+    Output_data* output_data;
+    // Output_segment in which the symbol is defined.  Before
+    // Layout::finalize the symbol's value is an offset.
+    Output_segment* output_segment;
+  } u1_;
+
+  // Further information about where the symbol is defined, kept
+  // separate from U1_ so that the two unions pack without padding.
+  union
+  {
+    // Section number in object in which symbol is defined, if
+    // SOURCE_ == FROM_OBJECT.
+    unsigned int shndx;
+    // True if the offset is from the end, false if the offset is
+    // from the beginning, if SOURCE_ == IN_OUTPUT_DATA.
+    bool offset_is_from_end;
+    // The base to use for the offset before Layout::finalize, if
+    // SOURCE_ == IN_OUTPUT_SEGMENT.
+    Segment_offset_base offset_base;
+  } u2_;
 
   // The index of this symbol in the output file.  If the symbol is
   // not going into the output file, this value is -1U.  This field
@@ -1002,22 +1112,6 @@ class Symbol
   // Symbol_table::finalize.
   unsigned int symtab_index_;
 
-  // The index of this symbol in the dynamic symbol table.  If the
-  // symbol is not going into the dynamic symbol table, this value is
-  // -1U.  This field starts as always holding zero.  It is set to a
-  // non-zero value during Layout::finalize.
-  unsigned int dynsym_index_;
-
-  // The GOT section entries for this symbol.  A symbol may have more
-  // than one GOT offset (e.g., when mixing modules compiled with two
-  // different TLS models), but will usually have at most one.
-  Got_offset_list got_offsets_;
-
-  // If this symbol has an entry in the PLT section, then this is the
-  // offset from the start of the PLT section.  This is -1U if there
-  // is no PLT entry.
-  unsigned int plt_offset_;
-
   // Symbol type (bits 0 to 3).
   elfcpp::STT type_ : 4;
   // Symbol binding (bits 4 to 7).
@@ -1059,9 +1153,9 @@ class Symbol
   // True if this symbol was forced to local visibility by a version
   // script (bit 28).
   bool is_forced_local_ : 1;
-  // True if the field u_.from_object.shndx is an ordinary section
-  // index, not one of the special codes from SHN_LORESERVE to
-  // SHN_HIRESERVE (bit 29).
+  // True if the field u2_.shndx is an ordinary section index, not
+  // one of the special codes from SHN_LORESERVE to SHN_HIRESERVE (bit
+  // 29).
   bool is_ordinary_shndx_ : 1;
   // True if we've seen this symbol in a "real" ELF object (bit 30).
   // If the symbol has been seen in a relocatable, non-IR, object file,
@@ -1084,6 +1178,14 @@ class Symbol
   // The visibility_ field will be STV_DEFAULT in this case because we
   // must treat it as such from outside the shared object.
   bool is_protected_  : 1;
+  // True if the index of this symbol in the dynamic symbol table has
+  // been set, by Layout::finalize or because the symbol will never be
+  // in the dynamic symbol table (bit 36).  The index itself is in the
+  // out of line fields; if the symbol has none, the index is -1U.
+  bool has_dynsym_index_ : 1;
+  // One more than the index in COLD_FIELDS_ of the out of line
+  // fields of this symbol, or zero if it has none (bits 37 to 63).
+  unsigned int cold_index_ : 27;
 };
 
 // The parts of a symbol which are size specific.  Using a template
@@ -1342,6 +1444,69 @@ class Warnings
   Warning_table warnings_;
 };
 
+// An allocator for symbols.  A large link creates tens of millions
+// of symbols, which are almost never freed, so rather than
+// allocating each one with new we carve them out of large blocks.
+// This saves the malloc overhead of each symbol, and keeps symbols
+// which are created together next to each other in memory.  All the
+// symbols in a link have the same size, so freed symbols are kept on
+// a simple free list.
+
+class Symbol_arena
+{
+ public:
+  Symbol_arena()
+    : blocks_(), next_(NULL), left_(0), free_list_(NULL), free_size_(0),
+      count_(0)
+  { }
+
+  ~Symbol_arena();
+
+  // Return memory for a symbol of SIZE bytes.
+  void*
+  allocate(size_t size);
+
+  // Give back the memory for a symbol of SIZE bytes at P.
+  void
+  deallocate(void* p, size_t size);
+
+  // Return the number of symbols in use.
+  size_t
+  count() const
+  { return this->count_; }
+
+  // Return the number of bytes allocated for symbols.
+  size_t
+  allocated_bytes() const
+  { return this->blocks_.size() * block_size; }
+
+ private:
+  Symbol_arena(const Symbol_arena&);
+  Symbol_arena& operator=(const Symbol_arena&);
+
+  // The size of the blocks which we allocate.
+  static const size_t block_size = 256 * 1024;
+
+  // A freed symbol on the free list.
+  struct Free_symbol
+  {
+    Free_symbol* next;
+  };
+
+  // The blocks we have allocated.
+  std::vector<unsigned char*> blocks_;
+  // The next free byte in the current block.
+  unsigned char* next_;
+  // The number of free bytes left in the current block.
+  size_t left_;
+  // The list of freed symbols.
+  Free_symbol* free_list_;
+  // The size of the symbols on the free list.
+  size_t free_size_;
+  // The number of symbols in use.
+  size_t count_;
+};
+
 // The main linker symbol table.
 
 class Symbol_table
@@ -1669,6 +1834,17 @@ class Symbol_table
   Symbol_table(const Symbol_table&);
   Symbol_table& operator=(const Symbol_table&);
 
+  // Create a new symbol, for a target which does not make its own.
+  template<int size>
+  Sized_symbol<size>*
+  make_sized_symbol();
+
+  // Free a symbol created by make_sized_symbol or by the target which we
+  // decided not to use after all.
+  template<int size>
+  void
+  free_sized_symbol(Sized_symbol<size>*);
+
   // The type of the list of common symbols.
   typedef std::vector<Symbol*> Commons_type;
 
@@ -1875,10 +2051,13 @@ class Symbol_table
   sized_finalize(off_t, Stringpool*, unsigned int*);
 
   // Finalize a symbol.  Return whether it should be added to the
-  // symbol table.
+  // symbol table.  If PVALUE is not NULL, it points to the final
+  // value of the symbol, already computed with status STATUS.
   template<int size>
   bool
-  sized_finalize_symbol(Symbol*);
+  sized_finalize_symbol(Symbol*,
+			const typename Sized_symbol<size>::Value_type* pvalue,
+			Compute_final_value_status status);
 
   // Add a symbol the final symtab by setting its index.
   template<int size>
@@ -1892,6 +2071,19 @@ class Symbol_table
 		      Output_symtab_xindex*, Output_symtab_xindex*,
 		      Output_file*) const;
 
+  // Writes global symbols on several threads.
+  template<int size, bool big_endian>
+  class Global_symbol_writer;
+
+  // Write out a global symbol to the symbol table at PSYMS and the
+  // dynamic symbol table at DYNAMIC_VIEW.
+  template<int size, bool big_endian>
+  void
+  sized_write_global(Sized_symbol<size>*, const Stringpool*,
+		     const Stringpool*, Output_symtab_xindex*,
+		     Output_symtab_xindex*, unsigned char* psyms,
+		     unsigned char* dynamic_view) const;
+
   // Write out a symbol to P.
   template<int size, bool big_endian>
   void
@@ -1940,6 +2132,8 @@ class Symbol_table
   // A pool of symbol names.  This is used for all global symbols.
   // Entries in the hash table point into this pool.
   Stringpool namepool_;
+  // The memory holding the symbols.
+  Symbol_arena symbol_arena_;
   // Forwarding symbols.
   Unordered_map<const Symbol*, Symbol*> forwarders_;
   // Weak aliases.  A symbol in this list points to the next alias.
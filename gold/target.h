@@ -52,6 +52,7 @@ class Relocatable_relocs;
 template<int size, bool big_endian>
 struct Relocate_info;
 class Reloc_symbol_changes;
+class Reloc_cache_key;
 class Symbol;
 template<int size>
 class Sized_symbol;
@@ -395,6 +396,12 @@ class Target
     return this->do_relax(pass, input_objects, symtab, layout, task);
   }
 
+  // Return whether relative dynamic relocs are packed into a SHT_RELR
+  // section, as requested by -z pack-relative-relocs.
+  bool
+  packs_relative_relocs() const
+  { return this->do_packs_relative_relocs(); }
+
   // Return the target-specific name of attributes section.  This is
   // NULL if a target does not use attributes section or if it uses
   // the default section name ".gnu.attributes".
@@ -737,6 +744,11 @@ class Target
   do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*)
   { return false; }
 
+  // Virtual function which may be overridden by the child class.
+  virtual bool
+  do_packs_relative_relocs() const
+  { return false; }
+
   // A function for targets to call.  Return whether BYTES/LEN matches
   // VIEW/VIEW_SIZE at OFFSET.
   bool
@@ -922,6 +934,25 @@ class Sized_target : public Target
 		   section_size_type view_size,
 		   const Reloc_symbol_changes*) = 0;
 
+  // Compute the key under which the relocated contents of a section
+  // are stored in the --reloc-cache.  The arguments are as for
+  // relocate_section, with no special offset handling; VIEW holds the
+  // contents of the section before relocation.  Add everything the
+  // relocated contents depend on to KEY, and return true.  Return
+  // false if the section should not be cached, for instance because
+  // relocating it may report a diagnostic.  By default no section is
+  // cached.
+  virtual bool
+  relocation_cache_key(const Relocate_info<size, big_endian>*,
+		       unsigned int /* sh_type */,
+		       const unsigned char* /* prelocs */,
+		       size_t /* reloc_count */,
+		       const unsigned char* /* view */,
+		       typename elfcpp::Elf_types<size>::Elf_Addr,
+		       section_size_type /* view_size */,
+		       Reloc_cache_key*)
+  { return false; }
+
   // Scan the relocs during a relocatable link.  The parameters are
   // like scan_relocs, with an additional Relocatable_relocs
   // parameter, used to record the disposition of the relocs.
@@ -0,0 +1,53 @@
+#!/bin/sh
+
+# batch_relocs_test.sh -- test --no-batch-relocs.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# batch_relocs_test, batch_relocs_test_pie and batch_relocs_test.so
+# were linked with relocations applied in batches, and the *_nobatch
+# files were linked the same way with --no-batch-relocs.  They must be
+# identical.  The executables check that the relocations are right.
+
+check_cmp()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$1 and $2 differ"
+	exit 1
+    fi
+}
+
+check_run()
+{
+    if ! ./"$1"
+    then
+	echo "$1 failed"
+	exit 1
+    fi
+}
+
+check_run batch_relocs_test
+check_run batch_relocs_test_pie
+check_cmp batch_relocs_test batch_relocs_test_nobatch
+check_cmp batch_relocs_test_pie batch_relocs_test_pie_nobatch
+check_cmp batch_relocs_test.so batch_relocs_test_nobatch.so
+
+exit 0
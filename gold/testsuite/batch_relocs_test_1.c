@@ -0,0 +1,95 @@
+/* batch_relocs_test_1.c -- test --no-batch-relocs.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   This file is compiled with -fpic, without -ffunction-sections, so
+   that its text and data sections have enough relocations to be
+   relocated in batches.  The relocations are a mix of the kinds the
+   batched code applies itself (R_X86_64_PC32, R_X86_64_PLT32 and
+   R_X86_64_64) and the kinds it leaves to the general code: GOTPCRELX
+   relocations, which the linker may relax, and the relocations of
+   the dynamic and initial exec TLS models, which it may optimize in
+   an executable.  */
+
+extern int batch_relocs_value (int);
+extern int batch_relocs_data;
+extern __thread int batch_relocs_tls;
+extern __thread int batch_relocs_tls_ie
+  __attribute__ ((tls_model ("initial-exec")));
+
+static __thread int batch_relocs_tls_local;
+static __thread int batch_relocs_tls_local2;
+
+static int batch_relocs_local_data[4] = { 1, 2, 3, 4 };
+
+/* Each function calls through the PLT, reads data through the GOT
+   and reads a TLS variable.  */
+
+#define F(n)							\
+  __attribute__ ((noinline)) int				\
+  batch_relocs_f##n (void)					\
+  {								\
+    return (batch_relocs_value (n)				\
+	    + batch_relocs_data					\
+	    + batch_relocs_local_data[n & 3]			\
+	    + batch_relocs_tls					\
+	    + batch_relocs_tls_ie				\
+	    + batch_relocs_tls_local				\
+	    + batch_relocs_tls_local2);				\
+  }
+
+F(0) F(1) F(2) F(3) F(4) F(5) F(6) F(7)
+F(8) F(9) F(10) F(11) F(12) F(13) F(14) F(15)
+
+/* A table of pointers, for R_X86_64_64.  */
+
+typedef int (*batch_relocs_fn) (void);
+
+batch_relocs_fn batch_relocs_table[] =
+{
+  batch_relocs_f0, batch_relocs_f1, batch_relocs_f2, batch_relocs_f3,
+  batch_relocs_f4, batch_relocs_f5, batch_relocs_f6, batch_relocs_f7,
+  batch_relocs_f8, batch_relocs_f9, batch_relocs_f10, batch_relocs_f11,
+  batch_relocs_f12, batch_relocs_f13, batch_relocs_f14, batch_relocs_f15
+};
+
+/* Call every function in the table, directly and indirectly.  The
+   local TLS variables are set here so that the compiler can not fold
+   them into the functions.  */
+
+int
+batch_relocs_sum (void)
+{
+  int sum = 0;
+  unsigned int i;
+
+  batch_relocs_tls_local = 5;
+  batch_relocs_tls_local2 = 7;
+  for (i = 0; i < sizeof batch_relocs_table / sizeof batch_relocs_table[0];
+       ++i)
+    sum += batch_relocs_table[i] ();
+  return (sum
+	  + batch_relocs_f0 () + batch_relocs_f1 () + batch_relocs_f2 ()
+	  + batch_relocs_f3 () + batch_relocs_f4 () + batch_relocs_f5 ()
+	  + batch_relocs_f6 () + batch_relocs_f7 () + batch_relocs_f8 ()
+	  + batch_relocs_f9 () + batch_relocs_f10 () + batch_relocs_f11 ()
+	  + batch_relocs_f12 () + batch_relocs_f13 () + batch_relocs_f14 ()
+	  + batch_relocs_f15 ());
+}
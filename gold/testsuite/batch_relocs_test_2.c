@@ -0,0 +1,44 @@
+/* batch_relocs_test_2.c -- test --no-batch-relocs.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   This file defines the symbols used by batch_relocs_test_1.c, and
+   checks the result of calling its functions.  */
+
+extern int batch_relocs_sum (void);
+
+int batch_relocs_data = 10;
+__thread int batch_relocs_tls = 20;
+__thread int batch_relocs_tls_ie = 30;
+
+int
+batch_relocs_value (int n)
+{
+  return n;
+}
+
+/* Each of the 16 functions returns its number, plus 72, plus an
+   element of {1, 2, 3, 4}.  The functions are called twice.  */
+
+int
+main (void)
+{
+  return batch_relocs_sum () == 2 * (120 + 16 * 72 + 4 * 10) ? 0 : 1;
+}
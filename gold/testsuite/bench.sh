@@ -0,0 +1,244 @@
+#!/bin/sh
+
+# bench.sh -- time gold on large synthetic links.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# This is run by "make bench"; it is not part of "make check".  It
+# generates a synthetic C++ program, links it with gold in several
+# configurations, and writes one JSON object per link to the results
+# file, using the times and memory use reported by --stats.  These
+# environment variables control the link:
+#
+#   BENCH_OBJECTS    number of objects (default 200)
+#   BENCH_GLOBALS    global functions in each object (default 100)
+#   BENCH_COMDAT     percentage of functions which call a COMDAT
+#                    inline function (default 25)
+#   BENCH_RELOCS     calls from each function to functions in other
+#                    objects, each needing a relocation (default 4)
+#   BENCH_DEBUG      debug information level, 0 to 3 (default 2)
+#   BENCH_ARCHIVE    objects in each archive, or 0 to link the
+#                    objects directly (default 0)
+#   BENCH_CONFIGS    configurations to time; any of base, gc-sections,
+#                    icf, gdb-index and compress-debug-sections
+#                    (default all)
+#   BENCH_THREADS    whether to use --threads; any of no and yes
+#                    (default both)
+#   BENCH_REPEAT     number of links in each configuration (default 3)
+#   BENCH_DIR        directory for the generated files (bench.dir)
+#   BENCH_OUTPUT     results file (bench.json)
+#   BENCH_BASELINE   results of an earlier run to compare with
+#   BENCH_THRESHOLD  slowdown, in percent, reported as a regression
+#                    (default 10)
+#
+# The generated files are kept in BENCH_DIR and reused if the
+# parameters have not changed.  If BENCH_BASELINE is set, the fastest
+# wall time of each configuration is compared with the baseline, and
+# the script fails if any is slower by more than BENCH_THRESHOLD.
+
+objects=${BENCH_OBJECTS:-200}
+globals=${BENCH_GLOBALS:-100}
+comdat=${BENCH_COMDAT:-25}
+relocs=${BENCH_RELOCS:-4}
+debug=${BENCH_DEBUG:-2}
+archive=${BENCH_ARCHIVE:-0}
+configs=${BENCH_CONFIGS:-"base gc-sections icf gdb-index compress-debug-sections"}
+threads_list=${BENCH_THREADS:-"no yes"}
+repeat=${BENCH_REPEAT:-3}
+dir=${BENCH_DIR:-bench.dir}
+output=${BENCH_OUTPUT:-bench.json}
+threshold=${BENCH_THRESHOLD:-10}
+cxx=${CXX:-g++}
+ar=${AR:-ar}
+lddir=${BENCH_LDDIR:-gcctestdir/}
+jobs=`getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1`
+
+params="objects=$objects globals=$globals comdat=$comdat relocs=$relocs debug=$debug archive=$archive cxx=$cxx"
+
+# Generate and compile the program.  Each object defines BENCH_GLOBALS
+# functions, each of which calls BENCH_RELOCS functions chosen at
+# random from other objects, and possibly one of the COMDAT inline
+# functions in bench_comdat.h.  Every eighth function is a leaf with
+# the same body in every object, for --icf to fold.  Each object also
+# has a table of pointers to its functions.  main refers to the tables
+# of the even numbered objects only, so that --gc-sections has some
+# work to do.
+
+if test "`cat $dir/params 2>/dev/null`" != "$params"; then
+  rm -rf $dir
+  mkdir -p $dir || exit 1
+  awk -v objects=$objects -v globals=$globals -v comdat=$comdat \
+      -v relocs=$relocs -v dir=$dir '
+    BEGIN {
+      srand(1);
+      h = dir "/bench_comdat.h";
+      for (p = 0; p < globals; ++p)
+        printf("inline int bench_comdat_%d(int x) { return x * %d + 1; }\n",
+               p, p + 2) > h;
+      close(h);
+      for (i = 0; i < objects; ++i) {
+        f = sprintf("%s/bench_%d.cc", dir, i);
+        printf("#include \"bench_comdat.h\"\n\n") > f;
+        for (j = 0; j < globals; ++j) {
+          if (j % 8 == 7) {
+            printf("int bench_%d_%d(int x) { return x ^ 0x5a; }\n\n",
+                   i, j) > f;
+            continue;
+          }
+          body = "";
+          for (k = 0; k < relocs; ++k) {
+            a = int(rand() * objects);
+            b = int(rand() * globals);
+            printf("int bench_%d_%d(int);\n", a, b) > f;
+            body = body sprintf("  r += bench_%d_%d(r + %d);\n", a, b, k);
+          }
+          if (rand() * 100 < comdat)
+            body = body sprintf("  r += bench_comdat_%d(r);\n",
+                                int(rand() * globals));
+          printf("int bench_%d_%d(int x)\n{\n  int r = x;\n%s  return r;\n}\n\n",
+                 i, j, body) > f;
+        }
+        printf("int (*bench_table_%d[])(int) = {\n", i) > f;
+        for (j = 0; j < globals; ++j)
+          printf("  bench_%d_%d,\n", i, j) > f;
+        printf("};\n") > f;
+        close(f);
+      }
+      m = dir "/bench_main.cc";
+      for (i = 0; i < objects; i += 2)
+        printf("extern int (*bench_table_%d[])(int);\n", i) > m;
+      printf("\nint\nmain()\n{\n  int r = 0;\n") > m;
+      for (i = 0; i < objects; i += 2)
+        printf("  r += bench_table_%d[0] != 0;\n", i) > m;
+      printf("  return r == 0;\n}\n") > m;
+      close(m);
+    }' || exit 1
+
+  # -O0 keeps the inline functions out of line, as COMDAT sections.
+  (cd $dir && ls bench_*.cc | xargs -P $jobs -n 8 \
+     $cxx -c -O0 -g$debug -ffunction-sections -fdata-sections) || exit 1
+
+  if test "$archive" -gt 0; then
+    i=0
+    while test $i -lt $objects; do
+      members=
+      j=$i
+      while test $j -lt `expr $i + $archive` && test $j -lt $objects; do
+	members="$members bench_$j.o"
+	j=`expr $j + 1`
+      done
+      (cd $dir && $ar rc libbench_$i.a $members) || exit 1
+      i=$j
+    done
+  fi
+
+  echo "$params" > $dir/params
+fi
+
+if test "$archive" -gt 0; then
+  inputs="$dir/bench_main.o -Wl,--start-group `ls $dir/libbench_*.a` -Wl,--end-group"
+else
+  inputs="$dir/bench_main.o `ls $dir/bench_*.o | grep -v bench_main.o`"
+fi
+
+# Extract the times from a line of --stats output such as
+#   ld: total run time: (user: 0.1 sys: 0.2 wall: 0.3)
+# and print them as JSON fields with PREFIX.
+
+stats_times()
+{
+  sed -n "s/.*$2: (user: \([0-9.]*\) sys: \([0-9.]*\) wall: \([0-9.]*\)).*/\"${3}user\": \1, \"${3}sys\": \2, \"${3}wall\": \3/p" $1
+}
+
+: > $output
+for config in $configs; do
+  case $config in
+  base) opts= ;;
+  gc-sections) opts=-Wl,--gc-sections ;;
+  icf) opts=-Wl,--icf=all ;;
+  gdb-index) opts=-Wl,--gdb-index ;;
+  compress-debug-sections) opts=-Wl,--compress-debug-sections=zlib ;;
+  *) echo "unknown configuration $config" 1>&2; exit 1 ;;
+  esac
+  for threads in $threads_list; do
+    case $threads in
+    yes) topts=-Wl,--threads; tjson=true ;;
+    *) topts=; tjson=false ;;
+    esac
+    run=1
+    while test $run -le $repeat; do
+      rm -f $dir/bench.out
+      if ! $cxx -B$lddir -o $dir/bench.out $inputs -Wl,--stats $opts $topts \
+	   2> $dir/bench.stats; then
+	cat $dir/bench.stats 1>&2
+	exit 1
+      fi
+      rss=`sed -n 's/.*maximum resident set size: \([0-9]*\) kB.*/\1/p' $dir/bench.stats`
+      size=`sed -n 's/.*output file size: \([0-9]*\) bytes.*/\1/p' $dir/bench.stats`
+      echo "{\"config\": \"$config\", \"threads\": $tjson, \"run\": $run," \
+	   "\"objects\": $objects, \"globals\": $globals," \
+	   "\"comdat\": $comdat, \"relocs\": $relocs, \"debug\": $debug," \
+	   "\"archive\": $archive," \
+	   "`stats_times $dir/bench.stats 'total run time' ''`," \
+	   "`stats_times $dir/bench.stats 'initial tasks run time' 'initial_'`," \
+	   "`stats_times $dir/bench.stats 'middle tasks run time' 'middle_'`," \
+	   "`stats_times $dir/bench.stats 'final tasks run time' 'final_'`," \
+	   "\"max_rss_kb\": ${rss:-0}, \"output_size\": ${size:-0}}" \
+	   >> $output
+      run=`expr $run + 1`
+    done
+  done
+done
+
+# Print the fastest wall time of each configuration, and compare with
+# the baseline.
+
+summary()
+{
+  sed -n 's/.*"config": "\([^"]*\)", "threads": \([a-z]*\),.* "wall": \([0-9.]*\), "initial_user".*/\1 \2 \3/p' $1 |
+    awk '{ k = $1 " threads=" $2;
+	   if (!(k in best) || $3 < best[k]) best[k] = $3 }
+	 END { for (k in best) print k, best[k] }' | sort
+}
+
+summary $output > $dir/bench.summary
+if test -z "$BENCH_BASELINE"; then
+  awk '{ printf("%-40s %8.3fs\n", $1 " " $2, $3) }' $dir/bench.summary
+  exit 0
+fi
+
+summary $BENCH_BASELINE > $dir/bench.baseline
+awk -v threshold=$threshold '
+  FNR == NR { base[$1 " " $2] = $3; next }
+  {
+    k = $1 " " $2;
+    if (!(k in base)) {
+      printf("%-40s %8.3fs\n", k, $3);
+      next;
+    }
+    change = base[k] > 0 ? ($3 - base[k]) * 100 / base[k] : 0;
+    printf("%-40s %8.3fs %8.3fs %+6.1f%%", k, base[k], $3, change);
+    if (change > threshold) {
+      printf("  REGRESSION");
+      ++regressions;
+    }
+    printf("\n");
+  }
+  END { exit regressions > 0 }' $dir/bench.baseline $dir/bench.summary
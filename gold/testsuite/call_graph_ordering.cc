@@ -0,0 +1,56 @@
+// call_graph_ordering.cc -- a test case for gold
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+// The goal of this program is to verify that --call-graph-ordering-file
+// places functions which call each other often next to each other,
+// ahead of the functions which are not in the profile.
+
+int cold_1()
+{
+  return 1;
+}
+
+static int hot_c();
+
+int hot_b()
+{
+  return 2;
+}
+
+int cold_2()
+{
+  return 3;
+}
+
+int hot_a()
+{
+  return hot_c();
+}
+
+static int hot_c()
+{
+  return hot_b();
+}
+
+int main()
+{
+  return hot_a() + cold_1() + cold_2() - 6;
+}
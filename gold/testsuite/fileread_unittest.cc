@@ -0,0 +1,186 @@
+// fileread_unittest.cc -- test and time File_read views
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "parameters.h"
+#include "errors.h"
+#include "options.h"
+#include "fileread.h"
+#include "timer.h"
+
+#include "test.h"
+
+namespace gold_testsuite
+{
+
+using namespace gold;
+
+// The file we read.
+
+static const char fileread_test_name[] = "fileread_unittest.dat";
+static const off_t fileread_test_size = 1024 * 1024 + 123;
+
+// The byte at offset I of the file.
+
+static unsigned char
+fileread_test_byte(off_t i)
+{
+  return static_cast<unsigned char>(i * 7 + (i >> 8));
+}
+
+// Write out the file.
+
+static bool
+write_test_file()
+{
+  std::vector<unsigned char> buf(fileread_test_size);
+  for (off_t i = 0; i < fileread_test_size; ++i)
+    buf[i] = fileread_test_byte(i);
+  int o = ::open(fileread_test_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (o < 0)
+    return false;
+  bool ok = (::write(o, &buf[0], buf.size())
+	     == static_cast<ssize_t>(buf.size()));
+  return ::close(o) == 0 && ok;
+}
+
+// Return whether P holds LEN bytes of the file starting at START.
+
+static bool
+check_data(const unsigned char* p, off_t start, off_t len)
+{
+  for (off_t i = 0; i < len; ++i)
+    if (p[i] != fileread_test_byte(start + i))
+      return false;
+  return true;
+}
+
+// Get the views which reading the symbols of a small object would,
+// and check their contents.  OFFSET is as for an archive member.
+
+static bool
+get_views(File_read* file, off_t offset, bool aligned)
+{
+  off_t size = fileread_test_size - offset;
+  for (off_t start = 0; start + 4096 < size; start += 3001)
+    {
+      off_t len = 16 + start % 200;
+      const unsigned char* p = file->get_view(offset, start, len, aligned,
+					      false);
+      if (!check_data(p, offset + start, len))
+	return false;
+      // The start of the member must be aligned.
+      if (aligned && ((reinterpret_cast<uintptr_t>(p) - start) & 7) != 0)
+	return false;
+
+      // A larger view starting on the same page.
+      p = file->get_view(offset, start, 4096, aligned, start % 5 == 0);
+      if (!check_data(p, offset + start, 4096))
+	return false;
+
+      unsigned char buf[64];
+      file->read(offset + start + 100, sizeof buf, buf);
+      if (!check_data(buf, offset + start + 100, sizeof buf))
+	return false;
+    }
+  return true;
+}
+
+bool
+File_read_test(Test_report*)
+{
+  Errors errors(gold::program_name);
+  set_parameters_errors(&errors);
+
+  // Map only the parts of the file which are asked for.
+  Command_line command_line;
+  const char* args[] = { "--no-map-whole-files" };
+  bool no_more_options;
+  command_line.process_one_option(1, args, 0, &no_more_options);
+  set_parameters_options(&command_line.options());
+  CHECK(!parameters->options().map_whole_files());
+
+  // We need a pretend Task.
+  const Task* task = reinterpret_cast<const Task*>(-1);
+
+  CHECK(write_test_file());
+
+  File_read file;
+  CHECK(file.open(task, fileread_test_name));
+  CHECK(file.filesize() == fileread_test_size);
+
+  // Read the file as a single object, then as an archive with two
+  // members, one of them misaligned.
+  CHECK(get_views(&file, 0, false));
+  CHECK(get_views(&file, 0, true));
+  file.unlock(task);
+
+  file.add_object();
+  file.add_object();
+  file.lock(task);
+  CHECK(get_views(&file, 0, true));
+  CHECK(get_views(&file, 1001, true));
+  CHECK(get_views(&file, 1001, false));
+
+  // A lasting view must survive clearing the views.
+  File_view* lasting = file.get_lasting_view(1001, 5000, 100, true, false);
+  file.clear_uncached_views();
+  CHECK(get_views(&file, 0, false));
+  CHECK(check_data(lasting->data(), 6001, 100));
+  delete lasting;
+  file.unlock(task);
+
+  // Time many small views from the same few pages, as happens when
+  // reading an object's symbols and section headers.
+  static const int rounds = 20;
+  static const int lookups = 100000;
+  Timer timer;
+  timer.start();
+  unsigned int sum = 0;
+  for (int r = 0; r < rounds; ++r)
+    {
+      file.lock(task);
+      for (int i = 0; i < lookups; ++i)
+	{
+	  off_t start = (static_cast<off_t>(i) * 4099) % (256 * 1024);
+	  sum += *file.get_view(1001, start, 24, true, false);
+	}
+      file.unlock(task);
+    }
+  Timer::TimeStats elapsed = timer.get_elapsed_time();
+  printf("File_read::get_view: %d views in %ld ms (%u)\n",
+	 rounds * lookups, elapsed.user + elapsed.sys, sum & 0xff);
+
+  file.remove_object();
+  file.remove_object();
+  ::unlink(fileread_test_name);
+  return true;
+}
+
+Register_test fileread_register("File_read", File_read_test);
+
+} // End namespace gold_testsuite.
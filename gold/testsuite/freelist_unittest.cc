@@ -0,0 +1,142 @@
+// freelist_unittest.cc -- test Free_list size classes
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include "layout.h"
+
+#include "test.h"
+
+namespace gold_testsuite
+{
+
+using namespace gold;
+
+// Return the number of free chunks in LIST.
+
+static unsigned int
+chunk_count(const Free_list& list)
+{
+  unsigned int count = 0;
+  for (Free_list::Const_iterator p = list.begin(); p != list.end(); ++p)
+    ++count;
+  return count;
+}
+
+// Return whether LIST has a free chunk from START to END.
+
+static bool
+has_chunk(const Free_list& list, off_t start, off_t end)
+{
+  for (Free_list::Const_iterator p = list.begin(); p != list.end(); ++p)
+    if (p->start_ == start && p->end_ == end)
+      return true;
+  return false;
+}
+
+// A section of 5000 bytes with free chunks of 1024 bytes at 1000,
+// 256 bytes at 3000 and 64 bytes at 4000.
+
+static void
+make_holes(Free_list* list, bool extend)
+{
+  list->init(5000, extend);
+  list->remove(0, 1000);
+  list->remove(2024, 3000);
+  list->remove(3256, 4000);
+  list->remove(4064, 5000);
+}
+
+// Test allocating from the size classes.
+
+bool
+Free_list_test(Test_report*)
+{
+  Free_list list;
+  make_holes(&list, false);
+  CHECK(chunk_count(list) == 3);
+  CHECK(has_chunk(list, 1000, 2024));
+  CHECK(has_chunk(list, 3000, 3256));
+  CHECK(has_chunk(list, 4000, 4064));
+
+  // An exact fit comes from the 256 byte chunk, although the 1024
+  // byte chunk has a lower address, and removes it.
+  CHECK(list.allocate(256, 1, 0) == 3000);
+  CHECK(chunk_count(list) == 2);
+  CHECK(!has_chunk(list, 3000, 3256));
+
+  // Too big for the 64 byte chunk, so the 1024 byte chunk is split.
+  CHECK(list.allocate(100, 1, 0) == 1000);
+  CHECK(chunk_count(list) == 2);
+  CHECK(has_chunk(list, 1100, 2024));
+
+  // The rest of the split chunk moves down to smaller classes as it
+  // is used up.
+  CHECK(list.allocate(600, 1, 0) == 1100);
+  CHECK(has_chunk(list, 1700, 2024));
+  CHECK(list.allocate(300, 1, 0) == 1700);
+  CHECK(has_chunk(list, 2000, 2024));
+
+  // The 24 byte chunk is too small for 40 bytes, so they come from
+  // the 64 byte chunk.  Both leftovers are then in the same class,
+  // and the one with the lower address is used first.
+  CHECK(list.allocate(40, 1, 0) == 4000);
+  CHECK(has_chunk(list, 4040, 4064));
+  CHECK(list.allocate(20, 1, 0) == 2000);
+  CHECK(list.allocate(20, 1, 0) == 4040);
+
+  // Only two chunks of 4 bytes are left.
+  CHECK(list.allocate(8, 1, 0) == -1);
+  CHECK(list.allocate(4, 1, 0) == 2020);
+  CHECK(chunk_count(list) == 1);
+
+  // With first fit, the lowest address which fits is used.
+  Free_list first;
+  make_holes(&first, false);
+  first.set_first_fit();
+  CHECK(first.allocate(256, 1, 0) == 1000);
+  CHECK(has_chunk(first, 1256, 2024));
+  CHECK(has_chunk(first, 3000, 3256));
+
+  // When the region may be extended and nothing fits, the free
+  // chunk at the end grows into a larger class and is used.
+  Free_list tail;
+  tail.init(100, true);
+  tail.remove(0, 90);
+  CHECK(has_chunk(tail, 90, 100));
+  CHECK(tail.allocate(50, 1, 0) == 90);
+  CHECK(chunk_count(tail) == 0);
+  CHECK(tail.allocate(16, 16, 0) == 144);
+
+  // A chunk in a lower class which is not at the end is still used
+  // before extending.
+  Free_list middle;
+  make_holes(&middle, true);
+  CHECK(middle.allocate(2000, 1, 0) == 5000);
+  CHECK(middle.allocate(64, 1, 0) == 4000);
+  CHECK(chunk_count(middle) == 2);
+
+  return true;
+}
+
+Register_test freelist_register("Free_list", Free_list_test);
+
+} // End namespace gold_testsuite.
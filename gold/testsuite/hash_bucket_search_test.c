@@ -0,0 +1,47 @@
+/* hash_bucket_search_test.c -- test --hash-bucket-search.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   This defines 256 functions, and calls each of them through the
+   PLT, so that the dynamic linker looks up each of them in the hash
+   table of the shared library.  */
+
+#define F(n) int hash_bucket_search_##n (void) { return 1; }
+#define F4(n) F(n##0) F(n##1) F(n##2) F(n##3)
+#define F16(n) F4(n##0) F4(n##1) F4(n##2) F4(n##3)
+#define F64(n) F16(n##0) F16(n##1) F16(n##2) F16(n##3)
+
+F64(a)
+F64(b)
+F64(c)
+F64(d)
+
+#define C(n) + hash_bucket_search_##n ()
+#define C4(n) C(n##0) C(n##1) C(n##2) C(n##3)
+#define C16(n) C4(n##0) C4(n##1) C4(n##2) C4(n##3)
+#define C64(n) C16(n##0) C16(n##1) C16(n##2) C16(n##3)
+
+int hash_bucket_search_sum (void);
+
+int
+hash_bucket_search_sum (void)
+{
+  return 0 C64(a) C64(b) C64(c) C64(d);
+}
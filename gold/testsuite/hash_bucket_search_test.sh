@@ -0,0 +1,65 @@
+#!/bin/sh
+
+# hash_bucket_search_test.sh -- test --hash-bucket-search.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# hash_bucket_search_sysv and hash_bucket_search_gnu use shared
+# libraries linked with --hash-bucket-search, with each hash style.
+# They look up every function in the library through its hash table.
+# hash_bucket_search_threads.so was linked like
+# hash_bucket_search_gnu.so, but with several threads.
+# hash_bucket_search_default.so was linked without the option, and
+# should use a different number of buckets.
+
+check_cmp()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$1 and $2 differ"
+	exit 1
+    fi
+}
+
+buckets()
+{
+    sed -n -e 's/.*(total of \([0-9]*\) buckets).*/\1/p' "$1"
+}
+
+./hash_bucket_search_sysv || exit 1
+./hash_bucket_search_gnu || exit 1
+
+check_cmp hash_bucket_search_gnu.so hash_bucket_search_threads.so
+
+searched=`buckets hash_bucket_search_test.stdout`
+default=`buckets hash_bucket_search_default.stdout`
+if test -z "$searched" || test -z "$default"
+then
+    echo "Did not find the number of buckets in readelf output"
+    exit 1
+fi
+if test "$searched" = "$default"
+then
+    echo "--hash-bucket-search did not change the number of buckets"
+    echo "   $searched"
+    exit 1
+fi
+
+exit 0
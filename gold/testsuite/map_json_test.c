@@ -0,0 +1,43 @@
+/* map_json_test.c -- test --map-format=json.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   This is linked with -ffunction-sections and --gc-sections, so that
+   the map lists both kept and discarded input sections.  */
+
+int map_json_data = 1;
+
+int
+map_json_unused (void)
+{
+  return 2;
+}
+
+int
+map_json_func (void)
+{
+  return map_json_data;
+}
+
+int
+main (void)
+{
+  return map_json_func () - 1;
+}
@@ -0,0 +1,56 @@
+#!/bin/sh
+
+# map_json_test.sh -- test --map-format=json.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# map_json_test is linked with --gc-sections, --cref and a JSON map
+# file.  Check that the map lists the output sections, the kept and
+# the discarded input sections, the symbols, and the cross references,
+# and that nothing is written to standard output.
+
+check()
+{
+    if ! grep -q -- "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check map_json_test.map '^{.*}$'
+check map_json_test.map '"discarded_sections":\[.*{"name":".text.map_json_unused","file":"map_json_test.o","address":0,'
+check map_json_test.map '"memory_map":\[.*{"name":".text","address":[0-9]*,"size":[0-9]*,"inputs":\['
+check map_json_test.map '{"name":".text.map_json_func","file":"map_json_test.o","address":[0-9]*,"size":[0-9]*,"symbols":\[{"name":"map_json_func","value":[0-9]*}\]}'
+check map_json_test.map '{"name":".data.map_json_data","file":"map_json_test.o","address":[0-9]*,"size":4,"symbols":\[{"name":"map_json_data","value":[0-9]*}\]}'
+check map_json_test.map '"cross_references":\[{"symbol":.*{"symbol":"map_json_func","files":\["map_json_test.o"\]}.*\]}$'
+
+if test -s map_json_test.stdout
+then
+    echo "Unexpected output on standard output:"
+    cat map_json_test.stdout
+    exit 1
+fi
+
+exit 0
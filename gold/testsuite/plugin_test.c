@@ -68,6 +68,20 @@ static ld_plugin_get_input_section_name get_input_section_name = NULL;
 static ld_plugin_get_input_section_contents get_input_section_contents = NULL;
 static ld_plugin_update_section_order update_section_order = NULL;
 static ld_plugin_allow_section_ordering allow_section_ordering = NULL;
+static ld_plugin_set_claim_file_thread_safe set_claim_file_thread_safe = NULL;
+static ld_plugin_reserve_input_files reserve_input_files = NULL;
+static ld_plugin_add_reserved_input_file add_reserved_input_file = NULL;
+
+/* With the "thread_safe" option, the claim file hook may be called
+   from several threads at once.  This protects the list of claimed
+   files.  */
+static volatile int claimed_files_lock = 0;
+static int thread_safe = 0;
+
+/* With the "reserve_input_files" option, the all symbols read hook
+   reserves positions for the new input files and then adds them in
+   reverse order.  */
+static int reserve = 0;
 
 #define MAXOPTS 10
 
@@ -158,6 +172,15 @@ onload(struct ld_plugin_tv *tv)
 	case LDPT_ALLOW_SECTION_ORDERING:
 	  allow_section_ordering = *entry->tv_u.tv_allow_section_ordering;
 	  break;
+	case LDPT_SET_CLAIM_FILE_THREAD_SAFE:
+	  set_claim_file_thread_safe = *entry->tv_u.tv_set_claim_file_thread_safe;
+	  break;
+	case LDPT_RESERVE_INPUT_FILES:
+	  reserve_input_files = *entry->tv_u.tv_reserve_input_files;
+	  break;
+	case LDPT_ADD_RESERVED_INPUT_FILE:
+	  add_reserved_input_file = *entry->tv_u.tv_add_reserved_input_file;
+	  break;
         default:
           break;
         }
@@ -191,7 +214,13 @@ onload(struct ld_plugin_tv *tv)
   (*message)(LDPL_INFO, "gold version:  %d", gold_version);
 
   for (i = 0; i < nopts; ++i)
-    (*message)(LDPL_INFO, "option: %s", opts[i]);
+    {
+      (*message)(LDPL_INFO, "option: %s", opts[i]);
+      if (strcmp(opts[i], "thread_safe") == 0)
+	thread_safe = 1;
+      else if (strcmp(opts[i], "reserve_input_files") == 0)
+	reserve = 1;
+    }
 
   if ((*register_claim_file_hook)(claim_file_hook) != LDPS_OK)
     {
@@ -199,6 +228,21 @@ onload(struct ld_plugin_tv *tv)
       return LDPS_ERR;
     }
 
+  if (thread_safe)
+    {
+      if (set_claim_file_thread_safe == NULL)
+	{
+	  fprintf(stderr, "tv_set_claim_file_thread_safe interface missing\n");
+	  return LDPS_ERR;
+	}
+      if ((*set_claim_file_thread_safe)() != LDPS_OK)
+	{
+	  (*message)(LDPL_ERROR, "error setting claim file hook thread-safe");
+	  return LDPS_ERR;
+	}
+      (*message)(LDPL_INFO, "claim file hook is thread-safe");
+    }
+
   if ((*register_all_symbols_read_hook)(all_symbols_read_hook) != LDPS_OK)
     {
       (*message)(LDPL_ERROR, "error registering all symbols read hook");
@@ -389,11 +433,30 @@ claim_file_hook (const struct ld_plugin_input_file* file, int* claimed)
   claimed_file->nsyms = nsyms;
   claimed_file->syms = syms;
   claimed_file->next = NULL;
+  if (thread_safe)
+    while (__sync_lock_test_and_set(&claimed_files_lock, 1))
+      continue;
+  /* Keep the list in handle order, which is the order of the files on
+     the command line, rather than in the order in which they were
+     claimed.  */
   if (last_claimed_file == NULL)
-    first_claimed_file = claimed_file;
+    first_claimed_file = last_claimed_file = claimed_file;
+  else if ((uintptr_t) last_claimed_file->handle < (uintptr_t) file->handle)
+    {
+      last_claimed_file->next = claimed_file;
+      last_claimed_file = claimed_file;
+    }
   else
-    last_claimed_file->next = claimed_file;
-  last_claimed_file = claimed_file;
+    {
+      struct claimed_file** pp = &first_claimed_file;
+
+      while ((uintptr_t) (*pp)->handle < (uintptr_t) file->handle)
+	pp = &(*pp)->next;
+      claimed_file->next = *pp;
+      *pp = claimed_file;
+    }
+  if (thread_safe)
+    __sync_lock_release(&claimed_files_lock);
 
   (*message)(LDPL_INFO, "%s: claiming file, adding %d symbols",
              file->name, nsyms);
@@ -421,6 +484,9 @@ all_symbols_read_hook(void)
   char buf[160];
   char* p;
   const char* filename;
+  char** new_files = NULL;
+  unsigned int num_new_files = 0;
+  unsigned int first;
 
   (*message)(LDPL_INFO, "all symbols read hook called");
 
@@ -500,6 +566,12 @@ all_symbols_read_hook(void)
       fprintf(stderr, "tv_release_input_file interface missing\n");
       return LDPS_ERR;
     }
+  if (reserve
+      && (reserve_input_files == NULL || add_reserved_input_file == NULL))
+    {
+      fprintf(stderr, "tv_reserve_input_files interface missing\n");
+      return LDPS_ERR;
+    }
 
   for (claimed_file = first_claimed_file;
        claimed_file != NULL;
@@ -588,10 +660,40 @@ all_symbols_read_hook(void)
         }
       p[1] = 'o';
       p[2] = '\0';
+      if (reserve)
+	{
+	  new_files = realloc(new_files,
+			      (num_new_files + 1) * sizeof(*new_files));
+	  new_files[num_new_files++] = strdup(buf);
+	  continue;
+	}
       (*message)(LDPL_INFO, "%s: adding new input file", buf);
       (*add_input_file)(buf);
     }
 
+  if (reserve)
+    {
+      if ((*reserve_input_files)(num_new_files, &first) != LDPS_OK)
+	{
+	  (*message)(LDPL_ERROR, "error reserving input files");
+	  return LDPS_ERR;
+	}
+      while (num_new_files > 0)
+	{
+	  --num_new_files;
+	  (*message)(LDPL_INFO, "%s: adding reserved input file %u",
+		     new_files[num_new_files], first + num_new_files);
+	  if ((*add_reserved_input_file)(first + num_new_files,
+					 new_files[num_new_files]) != LDPS_OK)
+	    {
+	      (*message)(LDPL_ERROR, "error adding reserved input file");
+	      return LDPS_ERR;
+	    }
+	  free(new_files[num_new_files]);
+	}
+      free(new_files);
+    }
+
   return LDPS_OK;
 }
 
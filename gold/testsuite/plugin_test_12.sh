@@ -0,0 +1,59 @@
+#!/bin/sh
+
+# plugin_test_12.sh -- a test case for concurrent calls to the
+# claim-file handler of a plugin.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# This file goes with plugin_test.c, a simple plug-in library that
+# exercises the basic interfaces.  The test links with several
+# threads, and the plugin declares that its claim-file handler is
+# thread-safe.  The result should be the same as for plugin_test_1.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check plugin_test_12.err "option: thread_safe"
+check plugin_test_12.err "claim file hook is thread-safe"
+check plugin_test_12.err "two_file_test_main.o: claim file hook called"
+check plugin_test_12.err "two_file_test_1.o.syms: claim file hook called"
+check plugin_test_12.err "two_file_test_1b.o.syms: claim file hook called"
+check plugin_test_12.err "two_file_test_2.o.syms: claim file hook called"
+check plugin_test_12.err "two_file_test_1.o.syms: _Z4f13iv: PREVAILING_DEF_IRONLY"
+check plugin_test_12.err "two_file_test_1.o.syms: _Z2t2v: PREVAILING_DEF_REG"
+check plugin_test_12.err "two_file_test_1.o.syms: v2: RESOLVED_IR"
+check plugin_test_12.err "two_file_test_1.o.syms: t17data: RESOLVED_IR"
+check plugin_test_12.err "two_file_test_2.o.syms: _Z4f13iv: PREEMPTED_IR"
+check plugin_test_12.err "two_file_test_1.o: adding new input file"
+check plugin_test_12.err "two_file_test_1b.o: adding new input file"
+check plugin_test_12.err "two_file_test_2.o: adding new input file"
+check plugin_test_12.err "cleanup hook called"
+
+exit 0
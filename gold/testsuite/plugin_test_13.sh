@@ -0,0 +1,66 @@
+#!/bin/sh
+
+# plugin_test_13.sh -- a test case for input files added by a plugin
+# in reserved positions.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# This file goes with plugin_test.c, a simple plug-in library that
+# exercises the basic interfaces.  The plugin reserves positions for
+# the new input files and adds them in reverse order, and the link
+# uses several threads.  The files must still be linked in the order
+# of their positions, so the result should be the same as for
+# plugin_test_1.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check plugin_test_13.err "option: reserve_input_files"
+check plugin_test_13.err "two_file_test_main.o: claim file hook called"
+check plugin_test_13.err "two_file_test_1.o.syms: claim file hook called"
+check plugin_test_13.err "two_file_test_1b.o.syms: claim file hook called"
+check plugin_test_13.err "two_file_test_2.o.syms: claim file hook called"
+check plugin_test_13.err "two_file_test_1.o.syms: _Z4f13iv: PREVAILING_DEF_IRONLY"
+check plugin_test_13.err "two_file_test_1.o.syms: _Z2t2v: PREVAILING_DEF_REG"
+check plugin_test_13.err "two_file_test_1.o.syms: v2: RESOLVED_IR"
+check plugin_test_13.err "two_file_test_1.o.syms: t17data: RESOLVED_IR"
+check plugin_test_13.err "two_file_test_2.o.syms: _Z4f13iv: PREEMPTED_IR"
+check plugin_test_13.err "two_file_test_1.o: adding reserved input file"
+check plugin_test_13.err "two_file_test_1b.o: adding reserved input file"
+check plugin_test_13.err "two_file_test_2.o: adding reserved input file"
+check plugin_test_13.err "cleanup hook called"
+
+if ! cmp -s plugin_test_1 plugin_test_13
+then
+    echo "plugin_test_1 and plugin_test_13 differ"
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,62 @@
+#!/bin/sh
+
+# prefetch_inputs_test.sh -- test --prefetch-inputs.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# prefetch_inputs_test, prefetch_inputs_test_threads and
+# prefetch_inputs_test_budget were linked with --prefetch-inputs, the
+# second with threads and the third with a budget too small for all
+# the input files.  prefetch_inputs_test_none was linked
+# the same way without prefetching.  They must all be identical, and
+# the statistics must show that the input files were prefetched.
+
+check()
+{
+    if ! grep -q -- "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check_cmp()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$1 and $2 differ"
+	exit 1
+    fi
+}
+
+check_cmp prefetch_inputs_test_none prefetch_inputs_test
+check_cmp prefetch_inputs_test_none prefetch_inputs_test_threads
+check_cmp prefetch_inputs_test_none prefetch_inputs_test_budget
+
+check prefetch_inputs_test.stats "input files prefetched: 3$"
+check prefetch_inputs_test.stats "over budget: 0$"
+check prefetch_inputs_test_threads.stats "input files prefetched: 3$"
+check prefetch_inputs_test_budget.stats "over budget: [1-9]"
+
+exit 0
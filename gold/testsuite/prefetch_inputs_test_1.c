@@ -0,0 +1,32 @@
+/* prefetch_inputs_test_1.c -- test --prefetch-inputs.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   This is linked with an archive and a shared library, so that each
+   kind of input file is prefetched.  */
+
+extern int prefetch_inputs_archive (void);
+extern int prefetch_inputs_shared (void);
+
+int
+main (void)
+{
+  return prefetch_inputs_archive () + prefetch_inputs_shared () - 3;
+}
@@ -0,0 +1,45 @@
+/* reflink_test.c -- test --reflink-output.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   This is compiled with different values of REFLINK_VALUE, so that
+   most of the output stays the same from one link to the next.  With
+   REFLINK_UNDEF, it refers to an undefined function, so that the link
+   fails.  */
+
+#ifndef REFLINK_VALUE
+#define REFLINK_VALUE 1
+#endif
+
+int reflink_data[4096] = { REFLINK_VALUE };
+
+#ifdef REFLINK_UNDEF
+extern int reflink_undefined (void);
+#endif
+
+int
+main (void)
+{
+#ifdef REFLINK_UNDEF
+  return reflink_undefined ();
+#else
+  return reflink_data[0] == REFLINK_VALUE ? 0 : 1;
+#endif
+}
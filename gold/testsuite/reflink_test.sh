@@ -0,0 +1,77 @@
+#!/bin/sh
+
+# reflink_test.sh -- test --reflink-output.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# reflink_test was linked with --reflink-output over an older output
+# in the build directory.  Depending on the file system, the blocks
+# which did not change are shared, or the whole file is written.
+# reflink_test_shm was linked the same way on /dev/shm, a tmpfs, which
+# can't share blocks.  Both must be the same as reflink_test_full,
+# which was linked as usual.  reflink_test_fail was a failed link over
+# an older output, which must not leave a copy of the output behind.
+
+check_cmp()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$1 and $2 differ"
+	exit 1
+    fi
+}
+
+check()
+{
+    if ! grep -q -- "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check reflink_test.stats "output bytes written: "
+check reflink_test.stats "output bytes shared with previous output: "
+check_cmp reflink_test reflink_test_full
+
+if ! grep -q "no /dev/shm" reflink_test_shm.stats
+then
+    check reflink_test_shm.stats "output bytes shared with previous output: 0$"
+    check_cmp reflink_test_shm reflink_test_full
+fi
+
+check reflink_test.err "undefined reference to 'reflink_undefined'"
+if test -f reflink_test_fail
+then
+    echo "reflink_test_fail was not removed"
+    exit 1
+fi
+if ls reflink_test_fail.* > /dev/null 2>&1
+then
+    echo "A copy of reflink_test_fail was left behind:"
+    ls reflink_test_fail.*
+    exit 1
+fi
+
+exit 0
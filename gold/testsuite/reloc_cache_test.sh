@@ -0,0 +1,82 @@
+#!/bin/sh
+
+# reloc_cache_test.sh -- test --reloc-cache.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The reloc_cache_test links all used the cache in
+# reloc_cache_test.dir, in this order.  reloc_cache_test_cold filled
+# the cache, and reloc_cache_test_warm found every section in it.
+# reloc_cache_test_edit used a different reloc_cache_test_2.o, which
+# only changes one section.  reloc_cache_test_sym changed the value
+# of reloc_cache_address, which only one section refers to.
+# reloc_cache_test_prune added an entry with a size limit smaller
+# than the cache, and reloc_cache_test_prune.size is the size of the
+# cache afterward.  Each output must be the same as the output of
+# the same link without the cache.
+
+check_cmp()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$1 and $2 differ"
+	exit 1
+    fi
+}
+
+check()
+{
+    if ! grep -q -- "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check reloc_cache_test_cold.stats "relocation cache hits: 0 "
+check reloc_cache_test_cold.stats "relocation cache entries not added: 0$"
+check_cmp reloc_cache_test_cold reloc_cache_test_full
+
+check reloc_cache_test_warm.stats "relocation cache misses: 0$"
+check reloc_cache_test_warm.stats "relocation cache entries added: 0$"
+check_cmp reloc_cache_test_warm reloc_cache_test_full
+
+check reloc_cache_test_edit.stats "relocation cache misses: 1$"
+check reloc_cache_test_edit.stats "relocation cache entries added: 1$"
+check_cmp reloc_cache_test_edit reloc_cache_test_edit_full
+
+check reloc_cache_test_sym.stats "relocation cache misses: 1$"
+check reloc_cache_test_sym.stats "relocation cache entries added: 1$"
+check_cmp reloc_cache_test_sym reloc_cache_test_sym_full
+
+check reloc_cache_test_prune.stats "relocation cache entries removed: [1-9]"
+check_cmp reloc_cache_test_prune reloc_cache_test_prune_full
+size=`cat reloc_cache_test_prune.size`
+if test "$size" -gt 100
+then
+    echo "Relocation cache is $size bytes, more than the limit of 100"
+    exit 1
+fi
+
+exit 0
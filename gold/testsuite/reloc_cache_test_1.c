@@ -0,0 +1,44 @@
+/* reloc_cache_test_1.c -- test --reloc-cache.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   Each function and variable is in its own section, so that each
+   is a separate entry in the cache.  reloc_cache_address is defined
+   with --defsym, so that only the section of reloc_cache_pointer
+   depends on its value.  */
+
+extern int reloc_cache_address;
+extern int reloc_cache_value (void);
+
+int reloc_cache_data1 = 1;
+
+int *reloc_cache_pointer = &reloc_cache_address;
+
+int
+reloc_cache_f1 (void)
+{
+  return reloc_cache_data1 + reloc_cache_value ();
+}
+
+int
+main (void)
+{
+  return reloc_cache_f1 () == 0;
+}
@@ -0,0 +1,35 @@
+/* reloc_cache_test_2.c -- test --reloc-cache.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   This is compiled with different values of RELOC_CACHE_VALUE, which
+   change the contents of reloc_cache_value but not its size.  */
+
+#ifndef RELOC_CACHE_VALUE
+#define RELOC_CACHE_VALUE 1
+#endif
+
+int reloc_cache_data2 = 2;
+
+int
+reloc_cache_value (void)
+{
+  return reloc_cache_data2 + RELOC_CACHE_VALUE;
+}
@@ -0,0 +1,50 @@
+/* relr_test.c -- test -z pack-relative-relocs.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* The pointers to A need relative relocs in a shared library.  They
+   come in runs with gaps, so that .relr.dyn needs both address
+   entries and bitmaps.  */
+
+static int a[32];
+
+int *p1[] = { &a[0], &a[1], &a[2], &a[3], &a[4], &a[5], &a[6], &a[7] };
+int *p2[] = { &a[8], 0, &a[9], 0, 0, &a[10] };
+long gap[100] = { 1 };
+int *p3[] = { &a[11], &a[12], &a[13], &a[14], &a[15], &a[16], &a[17],
+	      &a[18], &a[19], &a[20], &a[21], &a[22], &a[23], &a[24],
+	      &a[25], &a[26], &a[27], &a[28], &a[29], &a[30], &a[31],
+	      &a[0], &a[1], &a[2], &a[3], &a[4], &a[5], &a[6], &a[7],
+	      &a[8], &a[9], &a[10], &a[11], &a[12], &a[13], &a[14],
+	      &a[15], &a[16], &a[17], &a[18], &a[19], &a[20], &a[21],
+	      &a[22], &a[23], &a[24], &a[25], &a[26], &a[27], &a[28],
+	      &a[29], &a[30], &a[31], &a[0], &a[1], &a[2], &a[3],
+	      &a[4], &a[5], &a[6], &a[7], &a[8], &a[9], &a[10] };
+
+/* A pointer which is not aligned can not be packed, and must use an
+   ordinary R_X86_64_RELATIVE reloc.  */
+
+struct s
+{
+  char c;
+  int *p;
+} __attribute__ ((packed));
+
+struct s unaligned __attribute__ ((section ("relr_unaligned"))) = { 0, &a[0] };
@@ -0,0 +1,52 @@
+#!/bin/sh
+
+# relr_test.sh -- test -z pack-relative-relocs.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# relr_test.so is linked with -z pack-relative-relocs.  All the
+# relative relocs except the unaligned one should be in .relr.dyn.
+
+check()
+{
+    if ! grep -q -- "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check relr_test.stdout "\.relr\.dyn *RELR "
+check relr_test.stdout "(RELR) "
+check relr_test.stdout "(RELRSZ) "
+check relr_test.stdout "(RELRENT) *8 (bytes)"
+
+count=`grep -c "R_X86_64_RELATIVE" relr_test.stdout`
+if test "$count" -ne 1; then
+    echo "Expected one R_X86_64_RELATIVE reloc, found $count:"
+    cat relr_test.stdout
+    exit 1
+fi
+
+exit 0
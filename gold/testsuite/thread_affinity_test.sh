@@ -0,0 +1,64 @@
+#!/bin/sh
+
+# thread_affinity_test.sh -- test --thread-affinity and the task statistics.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# thread_affinity_test_cpu and thread_affinity_test_node were linked
+# with several threads, each bound to a CPU or to the CPUs of a NUMA
+# node.  thread_affinity_test_none was linked the same way without
+# threads.  They must all be identical, and --stats must report the
+# tasks run in each pass.
+
+check()
+{
+    if ! grep -q -- "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check_cmp()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$1 and $2 differ"
+	exit 1
+    fi
+}
+
+check_cmp thread_affinity_test_none thread_affinity_test_cpu
+check_cmp thread_affinity_test_none thread_affinity_test_node
+
+for f in thread_affinity_test_cpu.stats thread_affinity_test_node.stats
+do
+    check $f "CPUs available: [1-9][0-9]* on [1-9][0-9]* NUMA nodes$"
+    for pass in initial middle final
+    do
+	check $f "$pass tasks: [1-9][0-9]* tasks on 4 threads, .* utilization [0-9]*%$"
+    done
+done
+
+exit 0
@@ -114,6 +114,8 @@ Workqueue_thread::thread_body(void* arg)
 {
   Workqueue_thread* pwt = reinterpret_cast<Workqueue_thread*>(arg);
 
+  Thread_placement::place_thread(pwt->thread_number_);
+
   pwt->threadpool_->process(pwt->thread_number_);
 
   // Delete the thread object as we exit.
@@ -134,6 +136,8 @@ Workqueue_threader_threadpool::Workqueue_threader_threadpool(
     desired_thread_count_(1),
     threads_(1)
 {
+  // The main thread is thread 0.
+  Thread_placement::place_thread(0);
 }
 
 // Destructor.
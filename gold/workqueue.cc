@@ -22,6 +22,10 @@
 
 #include "gold.h"
 
+#include <cstdio>
+#include <algorithm>
+#include <sys/time.h>
+
 #include "debug.h"
 #include "options.h"
 #include "timer.h"
@@ -114,6 +118,16 @@ class Workqueue_threader_single : public Workqueue_threader
   { return false; }
 };
 
+// Return the wall clock time in microseconds, for --stats.
+
+static uint64_t
+wall_time()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
 // Workqueue methods.
 
 Workqueue::Workqueue(const General_options& options)
@@ -123,17 +137,21 @@ Workqueue::Workqueue(const General_options& options)
     running_(0),
     waiting_(0),
     condvar_(this->lock_),
-    threader_(NULL)
+    threader_(NULL),
+    threads_(options.threads()),
+    collect_stats_(options.stats()),
+    pass_(-1)
 {
-  bool threads = options.threads();
+  memset(this->pass_stats_, 0, sizeof this->pass_stats_);
 #ifndef ENABLE_THREADS
-  threads = false;
+  this->threads_ = false;
 #endif
-  if (!threads)
+  if (!this->threads_)
     this->threader_ = new Workqueue_threader_single(this);
   else
     {
 #ifdef ENABLE_THREADS
+      Thread_placement::initialize();
       this->threader_ = new Workqueue_threader_threadpool(this);
 #else
       gold_unreachable();
@@ -304,7 +322,8 @@ Workqueue::find_and_run_task(int thread_number)
     // still holding the Workqueue lock.
     t->locks(&tl);
 
-    ++this->running_;
+    this->note_running();
+    Parallel_work::set_busy_threads(this->running_);
   }
 
   while (t != NULL)
@@ -316,8 +335,16 @@ Workqueue::find_and_run_task(int thread_number)
       if (is_debugging_enabled(DEBUG_TASK))
         timer.start();
 
+      uint64_t start_time = 0;
+      if (this->collect_stats_)
+	start_time = wall_time();
+
       t->run(this);
 
+      uint64_t end_time = 0;
+      if (this->collect_stats_)
+	end_time = wall_time();
+
       if (is_debugging_enabled(DEBUG_TASK))
         {
           Timer::TimeStats elapsed = timer.get_elapsed_time();
@@ -336,6 +363,8 @@ Workqueue::find_and_run_task(int thread_number)
 	Hold_lock hl(this->lock_);
 
 	--this->running_;
+	if (this->collect_stats_)
+	  this->note_task_time(start_time, end_time);
 
 	// Release the locks for the task.  This must be done with the
 	// workqueue lock held.  Get the next Task to run if any.
@@ -351,8 +380,10 @@ Workqueue::find_and_run_task(int thread_number)
 	    tl.clear();
 	    next->locks(&tl);
 
-	    ++this->running_;
+	    this->note_running();
 	  }
+
+	Parallel_work::set_busy_threads(this->running_);
       }
 
       // We are done with this task.
@@ -505,10 +536,91 @@ Workqueue::set_thread_count(int threads)
   Hold_lock hl(this->lock_);
 
   this->threader_->set_thread_count(threads);
+  Parallel_work::set_thread_count(threads);
   // Wake up all the threads, since something has changed.
   this->condvar_.broadcast();
 }
 
+// Record a task which ran from START to END.  A task may start a new
+// pass, as the Layout_task does, so we divide the time among the
+// passes, and count the task in the pass in which it started.  This
+// must be called with the Workqueue lock held.
+
+void
+Workqueue::note_task_time(uint64_t start, uint64_t end)
+{
+  for (int i = this->pass_; i >= 0; --i)
+    {
+      Pass_stats* ps = &this->pass_stats_[i];
+      uint64_t from = std::max(start, ps->start);
+      if (end > from)
+	ps->busy += end - from;
+      if (start >= ps->start)
+	{
+	  ++ps->tasks;
+	  break;
+	}
+      end = from;
+    }
+}
+
+// Start a pass of the link.
+
+void
+Workqueue::start_pass(int n, int thread_count)
+{
+  gold_assert(n >= 0 && n < 3);
+  this->set_thread_count(thread_count);
+
+  if (!this->collect_stats_)
+    return;
+
+  Hold_lock hl(this->lock_);
+  uint64_t now = wall_time();
+  if (this->pass_ >= 0)
+    this->pass_stats_[this->pass_].end = now;
+  this->pass_ = n;
+  Pass_stats* ps = &this->pass_stats_[n];
+  ps->thread_count = this->threads_ ? thread_count : 1;
+  ps->start = now;
+  ps->end = 0;
+  ps->max_running = this->running_;
+}
+
+// Print statistics.  For each pass, the utilization is the time spent
+// running tasks as a percentage of the time the threads were
+// available.
+
+void
+Workqueue::print_stats() const
+{
+  static const char* const pass_names[3] = { "initial", "middle", "final" };
+  uint64_t now = wall_time();
+
+  if (this->threads_)
+    fprintf(stderr, _("%s: CPUs available: %u on %u NUMA nodes\n"),
+	    program_name, Thread_placement::cpu_count(),
+	    Thread_placement::node_count());
+
+  for (int i = 0; i < 3; ++i)
+    {
+      const Pass_stats& ps(this->pass_stats_[i]);
+      if (ps.start == 0)
+	continue;
+      uint64_t wall = (ps.end != 0 ? ps.end : now) - ps.start;
+      uint64_t available = wall * std::max(ps.thread_count, 1);
+      unsigned int utilization =
+	available == 0 ? 0 : ps.busy * 100 / available;
+      fprintf(stderr,
+	      _("%s: %s tasks: %u tasks on %d threads, at most %d at once, "
+		"busy %ld.%06ld seconds, utilization %u%%\n"),
+	      program_name, pass_names[i], ps.tasks, ps.thread_count,
+	      ps.max_running,
+	      static_cast<long>(ps.busy / 1000000),
+	      static_cast<long>(ps.busy % 1000000), utilization);
+    }
+}
+
 // Add a new blocker to an existing Task_token.
 
 void
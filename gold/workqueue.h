@@ -227,6 +227,16 @@ class Workqueue
   void
   set_thread_count(int);
 
+  // Start pass N of the link (0 <= N <= 2), using THREAD_COUNT
+  // threads.  This sets the thread count, and with --stats starts
+  // collecting statistics for the pass.
+  void
+  start_pass(int n, int thread_count);
+
+  // Print statistics about the passes to stderr.
+  void
+  print_stats() const;
+
   // Add a new blocker to an existing Task_token. This must be done
   // with the workqueue lock held.  This should not be done routinely,
   // only in special circumstances.
@@ -270,6 +280,39 @@ class Workqueue
   bool
   should_cancel_thread(int thread_number);
 
+  // Note that a task has started running.  This must be called with
+  // the Workqueue lock held.
+  void
+  note_running()
+  {
+    ++this->running_;
+    if (this->pass_ >= 0
+	&& this->running_ > this->pass_stats_[this->pass_].max_running)
+      this->pass_stats_[this->pass_].max_running = this->running_;
+  }
+
+  // Record a task which ran from START to END, for --stats.
+  void
+  note_task_time(uint64_t start, uint64_t end);
+
+  // Statistics for a pass of the link, collected with --stats.
+  struct Pass_stats
+  {
+    // The number of threads used.
+    int thread_count;
+    // The number of tasks run.
+    unsigned int tasks;
+    // The largest number of tasks running at once.
+    int max_running;
+    // The total wall clock time spent running tasks, in
+    // microseconds.
+    uint64_t busy;
+    // The wall clock time at the start and the end of the pass, in
+    // microseconds.
+    uint64_t start;
+    uint64_t end;
+  };
+
   // Master Workqueue lock.  This controls access to the following
   // member variables.
   Lock lock_;
@@ -288,6 +331,14 @@ class Workqueue
   // The threading implementation.  This is set at construction time
   // and not changed thereafter.
   Workqueue_threader* threader_;
+  // Whether we are using threads.
+  bool threads_;
+  // Whether to collect statistics for --stats.
+  bool collect_stats_;
+  // The current pass, or -1 if we are not collecting statistics.
+  int pass_;
+  // Statistics for each pass.
+  Pass_stats pass_stats_[3];
 };
 
 } // End namespace gold.
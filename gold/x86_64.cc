@@ -42,6 +42,7 @@
 #include "nacl.h"
 #include "gc.h"
 #include "icf.h"
+#include "reloc-cache.h"
 
 namespace
 {
@@ -583,12 +584,15 @@ class Target_x86_64 : public Sized_target<size, false>
   // In the x86_64 ABI (p 68), it says "The AMD64 ABI architectures
   // uses only Elf64_Rela relocation entries with explicit addends."
   typedef Output_data_reloc<elfcpp::SHT_RELA, true, size, false> Reloc_section;
+  typedef Output_data_relr<size, false> Relr_section;
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
 
   Target_x86_64(const Target::Target_info* info = &x86_64_info)
     : Sized_target<size, false>(info),
       got_(NULL), plt_(NULL), got_plt_(NULL), got_irelative_(NULL),
       got_tlsdesc_(NULL), global_offset_table_(NULL), rela_dyn_(NULL),
-      rela_irelative_(NULL), copy_relocs_(elfcpp::R_X86_64_COPY),
+      rela_irelative_(NULL), relr_dyn_(NULL),
+      copy_relocs_(elfcpp::R_X86_64_COPY),
       got_mod_index_offset_(-1U), tlsdesc_reloc_info_(),
       tls_base_symbol_defined_(false)
   { }
@@ -647,6 +651,17 @@ class Target_x86_64 : public Sized_target<size, false>
 		   section_size_type view_size,
 		   const Reloc_symbol_changes*);
 
+  // Compute the --reloc-cache key for a section.
+  bool
+  relocation_cache_key(const Relocate_info<size, false>*,
+		       unsigned int sh_type,
+		       const unsigned char* prelocs,
+		       size_t reloc_count,
+		       const unsigned char* view,
+		       typename elfcpp::Elf_types<size>::Elf_Addr view_address,
+		       section_size_type view_size,
+		       Reloc_cache_key*);
+
   // Scan the relocs during a relocatable link.
   void
   scan_relocatable_relocs(Symbol_table* symtab,
@@ -746,6 +761,27 @@ class Target_x86_64 : public Sized_target<size, false>
 		     unsigned char* view, section_size_type view_size,
 		     std::string* from, std::string* to) const;
 
+  // We relax to compute the size of .relr.dyn.
+  bool
+  do_may_relax() const
+  {
+    return (parameters->options().relax()
+	    || this->do_packs_relative_relocs());
+  }
+
+  bool
+  do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*)
+  { return this->relr_dyn_ != NULL && this->relr_dyn_->update_entries(); }
+
+  // Return whether relative relocs are packed into .relr.dyn.
+  bool
+  do_packs_relative_relocs() const
+  {
+    return (parameters->options().pack_relative_relocs()
+	    && parameters->options().output_is_position_independent()
+	    && !parameters->incremental());
+  }
+
   // Return the size of the GOT section.
   section_size_type
   got_size() const
@@ -1029,6 +1065,51 @@ class Target_x86_64 : public Sized_target<size, false>
     bool skip_call_tls_get_addr_;
   };
 
+  // The kinds of relocation handled by relocate_section_batched.
+  enum Batched_reloc_kind
+  {
+    // Passed to the general relocation code.
+    BATCHED_GENERAL,
+    // R_X86_64_PC32 or R_X86_64_PLT32.
+    BATCHED_PC32,
+    // R_X86_64_64.
+    BATCHED_64
+  };
+
+  // A relocation whose symbol value has been resolved by
+  // relocate_section_batched.
+  struct Batched_reloc
+  {
+    // The value to store, before subtracting the address of the
+    // relocation for BATCHED_PC32.
+    typename elfcpp::Elf_types<64>::Elf_Addr value;
+    // The offset of the relocation in the view.
+    section_size_type offset;
+    // A Batched_reloc_kind.
+    unsigned int kind;
+  };
+
+  // Resolve the symbol values of the relocations of a section for
+  // relocate_section_batched, setting (*BATCH)[I] for relocation I.
+  void
+  resolve_batched_relocs(const Relocate_info<size, false>*,
+			 const unsigned char* prelocs,
+			 size_t reloc_count,
+			 section_size_type view_size,
+			 std::vector<Batched_reloc>* batch);
+
+  // Relocate a section in which no relocation needs special offset
+  // handling.  The common absolute and PC relative relocations
+  // against symbols with known values are applied directly.
+  void
+  relocate_section_batched(const Relocate_info<size, false>*,
+			   const unsigned char* prelocs,
+			   size_t reloc_count,
+			   Output_section* output_section,
+			   unsigned char* view,
+			   typename elfcpp::Elf_types<size>::Elf_Addr view_address,
+			   section_size_type view_size);
+
   // Check if relocation against this symbol is a candidate for
   // conversion from
   // mov foo@GOTPCREL(%rip), %reg
@@ -1163,6 +1244,24 @@ class Target_x86_64 : public Sized_target<size, false>
   Reloc_section*
   rela_irelative_section(Layout*);
 
+  // Get the section for packed relative relocs, creating it if
+  // necessary.
+  Relr_section*
+  relr_dyn_section(Layout*);
+
+  // If relative relocs are packed, and an R_X86_64_RELATIVE reloc
+  // for the word at ADDRESS in OD can be, add it to .relr.dyn and
+  // return true.  Otherwise the caller must add it to .rela.dyn.
+  bool
+  add_packed_relative(Layout*, Output_data* od, Address address);
+
+  // Likewise for the word at ADDRESS in section SHNDX of OBJECT.  OD
+  // is the output section.
+  bool
+  add_packed_relative(Layout*, Output_data* od,
+		      Sized_relobj_file<size, false>* object,
+		      unsigned int shndx, Address address);
+
   // Add a potential copy relocation.
   void
   copy_reloc(Symbol_table* symtab, Layout* layout,
@@ -1226,6 +1325,8 @@ class Target_x86_64 : public Sized_target<size, false>
   Reloc_section* rela_dyn_;
   // The section to use for IRELATIVE relocs.
   Reloc_section* rela_irelative_;
+  // The section for packed relative relocs.
+  Relr_section* relr_dyn_;
   // Relocs saved to avoid a COPY reloc.
   Copy_relocs<elfcpp::SHT_RELA, size, false> copy_relocs_;
   // Offset of the GOT entry for the TLS module index.
@@ -1398,6 +1499,54 @@ Target_x86_64<size>::rela_dyn_section(Layout* layout)
   return this->rela_dyn_;
 }
 
+// Get the section for packed relative relocs, creating it if
+// necessary.
+
+template<int size>
+typename Target_x86_64<size>::Relr_section*
+Target_x86_64<size>::relr_dyn_section(Layout* layout)
+{
+  if (this->relr_dyn_ == NULL)
+    {
+      gold_assert(layout != NULL);
+      this->relr_dyn_ = new Relr_section();
+      layout->add_output_section_data(".relr.dyn", elfcpp::SHT_RELR,
+				      elfcpp::SHF_ALLOC, this->relr_dyn_,
+				      ORDER_DYNAMIC_RELOCS, false);
+    }
+  return this->relr_dyn_;
+}
+
+// Add an R_X86_64_RELATIVE reloc to .relr.dyn if we can.
+
+template<int size>
+bool
+Target_x86_64<size>::add_packed_relative(Layout* layout, Output_data* od,
+					 Address address)
+{
+  if (!this->do_packs_relative_relocs()
+      || !Relr_section::can_pack(od, address))
+    return false;
+  this->relr_dyn_section(layout)->add(od, address);
+  return true;
+}
+
+template<int size>
+bool
+Target_x86_64<size>::add_packed_relative(
+    Layout* layout,
+    Output_data* od,
+    Sized_relobj_file<size, false>* object,
+    unsigned int shndx,
+    Address address)
+{
+  if (!this->do_packs_relative_relocs()
+      || !Relr_section::can_pack(object, shndx, address))
+    return false;
+  this->relr_dyn_section(layout)->add(od, object, shndx, address);
+  return true;
+}
+
 // Get the section to use for IRELATIVE relocs, creating it if
 // necessary.  These go in .rela.dyn, but only after all other dynamic
 // relocations.  They need to follow the other dynamic relocations so
@@ -2956,6 +3105,11 @@ Target_x86_64<size>::Scan::local(Symbol_table* symtab,
       // relocate it easily.
       if (parameters->options().output_is_position_independent())
 	{
+	  if (size == 64
+	      && !is_ifunc
+	      && target->add_packed_relative(layout, output_section, object,
+					     data_shndx, reloc.get_r_offset()))
+	    break;
 	  unsigned int r_sym = elfcpp::elf_r_sym<size>(reloc.get_r_info());
 	  Reloc_section* rela_dyn = target->rela_dyn_section(layout);
 	  rela_dyn->add_local_relative(object, r_sym,
@@ -2981,6 +3135,11 @@ Target_x86_64<size>::Scan::local(Symbol_table* symtab,
 	  // Use R_X86_64_RELATIVE relocation for R_X86_64_32 under x32.
 	  if (size == 32 && r_type == elfcpp::R_X86_64_32)
 	    {
+	      if (!is_ifunc
+		  && target->add_packed_relative(layout, output_section,
+						 object, data_shndx,
+						 reloc.get_r_offset()))
+		break;
 	      unsigned int r_sym = elfcpp::elf_r_sym<size>(reloc.get_r_info());
 	      Reloc_section* rela_dyn = target->rela_dyn_section(layout);
 	      rela_dyn->add_local_relative(object, r_sym,
@@ -3094,9 +3253,13 @@ Target_x86_64<size>::Scan::local(Symbol_table* symtab,
 		  {
 		    unsigned int got_offset =
 		      object->local_got_offset(r_sym, GOT_TYPE_STANDARD);
-		    rela_dyn->add_local_relative(object, r_sym,
-						 elfcpp::R_X86_64_RELATIVE,
-						 got, got_offset, 0, is_ifunc);
+		    if (is_ifunc
+			|| !target->add_packed_relative(layout, got,
+							got_offset))
+		      rela_dyn->add_local_relative(object, r_sym,
+						   elfcpp::R_X86_64_RELATIVE,
+						   got, got_offset, 0,
+						   is_ifunc);
 		  }
 		else
 		  {
@@ -3424,12 +3587,19 @@ Target_x86_64<size>::Scan::global(Symbol_table* symtab,
 		      || (size == 32 && r_type == elfcpp::R_X86_64_32))
 		     && gsym->can_use_relative_reloc(false))
 	      {
-		Reloc_section* rela_dyn = target->rela_dyn_section(layout);
-		rela_dyn->add_global_relative(gsym, elfcpp::R_X86_64_RELATIVE,
-					      output_section, object,
-					      data_shndx,
-					      reloc.get_r_offset(),
-					      reloc.get_r_addend(), false);
+		if (gsym->type() == elfcpp::STT_GNU_IFUNC
+		    || !target->add_packed_relative(layout, output_section,
+						    object, data_shndx,
+						    reloc.get_r_offset()))
+		  {
+		    Reloc_section* rela_dyn = target->rela_dyn_section(layout);
+		    rela_dyn->add_global_relative(gsym,
+						  elfcpp::R_X86_64_RELATIVE,
+						  output_section, object,
+						  data_shndx,
+						  reloc.get_r_offset(),
+						  reloc.get_r_addend(), false);
+		  }
 	      }
 	    else
 	      {
@@ -3561,9 +3731,11 @@ Target_x86_64<size>::Scan::global(Symbol_table* symtab,
 		if (is_new)
 		  {
 		    unsigned int got_off = gsym->got_offset(GOT_TYPE_STANDARD);
-		    rela_dyn->add_global_relative(gsym,
-						  elfcpp::R_X86_64_RELATIVE,
-						  got, got_off, 0, false);
+		    if (gsym->type() == elfcpp::STT_GNU_IFUNC
+			|| !target->add_packed_relative(layout, got, got_off))
+		      rela_dyn->add_global_relative(gsym,
+						    elfcpp::R_X86_64_RELATIVE,
+						    got, got_off, 0, false);
 		  }
 	      }
 	  }
@@ -3833,6 +4005,7 @@ Target_x86_64<size>::do_finalize_sections(
 				  : this->plt_->rela_plt());
   layout->add_target_dynamic_tags(false, this->got_plt_, rel_plt,
 				  this->rela_dyn_, true, false);
+  layout->add_relr_dynamic_tags(this->relr_dyn_);
 
   // Fill in some more dynamic tags.
   Output_data_dynamic* const odyn = layout->dynamic_data();
@@ -4986,6 +5159,19 @@ Target_x86_64<size>::relocate_section(
 
   gold_assert(sh_type == elfcpp::SHT_RELA);
 
+  // Sections with only a few relocations are not worth the setup
+  // cost of the batched code.
+  if (!needs_special_offset_handling
+      && reloc_symbol_changes == NULL
+      && reloc_count >= 16
+      && parameters->options().batch_relocs())
+    {
+      this->relocate_section_batched(relinfo, prelocs, reloc_count,
+				     output_section, view, address,
+				     view_size);
+      return;
+    }
+
   gold::relocate_section<size, false, Target_x86_64<size>, Relocate,
 			 gold::Default_comdat_behavior, Classify_reloc>(
     relinfo,
@@ -5000,6 +5186,290 @@ Target_x86_64<size>::relocate_section(
     reloc_symbol_changes);
 }
 
+// Compute the --reloc-cache key for a section.  We only cache
+// sections in which every relocation can take the batched fast path
+// described below and does not overflow.  Then the relocated
+// contents depend only on the contents of the section, its address,
+// and the offset, kind and resolved value of each relocation.
+
+template<int size>
+bool
+Target_x86_64<size>::relocation_cache_key(
+    const Relocate_info<size, false>* relinfo,
+    unsigned int sh_type,
+    const unsigned char* prelocs,
+    size_t reloc_count,
+    const unsigned char* view,
+    typename elfcpp::Elf_types<size>::Elf_Addr view_address,
+    section_size_type view_size,
+    Reloc_cache_key* key)
+{
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+  typedef typename elfcpp::Elf_types<64>::Elf_Addr Address64;
+
+  gold_assert(sh_type == elfcpp::SHT_RELA);
+
+  std::vector<Batched_reloc> batch;
+  this->resolve_batched_relocs(relinfo, prelocs, reloc_count, view_size,
+			       &batch);
+  for (typename std::vector<Batched_reloc>::const_iterator p = batch.begin();
+       p != batch.end();
+       ++p)
+    {
+      if (p->kind == BATCHED_GENERAL)
+	return false;
+      if (p->kind == BATCHED_PC32)
+	{
+	  Address64 value = p->value;
+	  value -= static_cast<Address>(view_address + p->offset);
+	  if (Bits<32>::has_overflow(value))
+	    return false;
+	}
+    }
+
+  key->add_uint64(view_address);
+  key->add_uint64(view_size);
+  key->add(view, view_size);
+  for (typename std::vector<Batched_reloc>::const_iterator p = batch.begin();
+       p != batch.end();
+       ++p)
+    {
+      key->add_uint64(p->offset);
+      key->add_uint64(p->kind);
+      key->add_uint64(p->value);
+    }
+  return true;
+}
+
+// Relocate a section using a fast path for the relocations which
+// make up most of a typical executable: R_X86_64_PC32 and
+// R_X86_64_PLT32 in code, and R_X86_64_64 in data.  This is done in
+// three passes.  The first pass resolves the value of the symbol of
+// each relocation into a dense array, and decides which relocations
+// can take the fast path.  The second pass applies runs of fast
+// relocations of the same kind in a tight loop, and passes the other
+// relocations to the general code, in order.  The third pass checks
+// the PC relative relocations for overflow, and hands any which
+// overflowed to the general code to report the error.
+
+// A relocation can take the fast path only if the general code would
+// do nothing but store the value.  So we exclude relocations against
+// TLS and IFUNC symbols, undefined symbols, symbols with warnings,
+// symbols in discarded sections, local symbols in merged sections,
+// and relocations whose offset is out of range.  The relocation
+// following a TLSGD or TLSLD relocation is always passed to the
+// general code along with it, as the TLS optimizations may rewrite
+// or skip the call to __tls_get_addr.
+
+template<int size>
+void
+Target_x86_64<size>::resolve_batched_relocs(
+    const Relocate_info<size, false>* relinfo,
+    const unsigned char* prelocs,
+    size_t reloc_count,
+    section_size_type view_size,
+    std::vector<Batched_reloc>* batch)
+{
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+  typedef typename elfcpp::Elf_types<64>::Elf_Addr Address64;
+  const int reloc_size = elfcpp::Elf_sizes<size>::rela_size;
+
+  Sized_relobj_file<size, false>* object = relinfo->object;
+  const unsigned int local_count = object->local_symbol_count();
+
+  batch->resize(reloc_count);
+  bool follows_tls_call = false;
+  const unsigned char* preloc = prelocs;
+  for (size_t i = 0; i < reloc_count; ++i, preloc += reloc_size)
+    {
+      const elfcpp::Rela<size, false> rela(preloc);
+      const unsigned int r_type = elfcpp::elf_r_type<size>(rela.get_r_info());
+      const unsigned int r_sym = elfcpp::elf_r_sym<size>(rela.get_r_info());
+      Batched_reloc* b = &(*batch)[i];
+      b->kind = BATCHED_GENERAL;
+
+      bool after_tls_call = follows_tls_call;
+      follows_tls_call = (r_type == elfcpp::R_X86_64_TLSGD
+			  || r_type == elfcpp::R_X86_64_TLSLD);
+      if (after_tls_call)
+	continue;
+
+      unsigned int kind;
+      section_size_type width;
+      if (r_type == elfcpp::R_X86_64_PC32 || r_type == elfcpp::R_X86_64_PLT32)
+	{
+	  kind = BATCHED_PC32;
+	  width = 4;
+	}
+      else if (r_type == elfcpp::R_X86_64_64)
+	{
+	  kind = BATCHED_64;
+	  width = 8;
+	}
+      else
+	continue;
+
+      section_offset_type offset =
+	convert_to_section_size_type(rela.get_r_offset());
+      if (offset < 0
+	  || view_size < width
+	  || static_cast<section_size_type>(offset) > view_size - width)
+	continue;
+
+      Address value;
+      if (r_sym < local_count)
+	{
+	  const Symbol_value<size>* psymval = object->local_symbol(r_sym);
+	  if (!psymval->has_output_value()
+	      || psymval->is_tls_symbol()
+	      || psymval->is_ifunc_symbol())
+	    continue;
+	  bool is_ordinary;
+	  unsigned int shndx = psymval->input_shndx(&is_ordinary);
+	  if (is_ordinary
+	      && shndx != elfcpp::SHN_UNDEF
+	      && !object->is_section_included(shndx)
+	      && !relinfo->symtab->is_section_folded(object, shndx))
+	    continue;
+	  value = psymval->value(object, 0);
+	}
+      else
+	{
+	  const Symbol* gsym = object->global_symbol(r_sym);
+	  gold_assert(gsym != NULL);
+	  if (gsym->is_forwarder())
+	    gsym = relinfo->symtab->resolve_forwards(gsym);
+	  if (gsym->is_undefined()
+	      || gsym->is_placeholder()
+	      || gsym->has_warning()
+	      || gsym->type() == elfcpp::STT_TLS
+	      || gsym->type() == elfcpp::STT_GNU_IFUNC
+	      || (gsym->visibility() != elfcpp::STV_DEFAULT
+		  && gsym->is_from_dynobj()))
+	    continue;
+	  if (gsym->use_plt_offset(Scan::get_reference_flags(r_type)))
+	    value = this->plt_address_for_global(gsym);
+	  else if (r_type != elfcpp::R_X86_64_PLT32
+		   || gsym->has_plt_offset()
+		   || gsym->final_value_is_known()
+		   || (gsym->is_defined()
+		       && !gsym->is_from_dynobj()
+		       && !gsym->is_preemptible()))
+	    value = static_cast<const Sized_symbol<size>*>(gsym)->value();
+	  else
+	    continue;
+	}
+
+      // This matches the arithmetic done by Relocate::relocate.
+      const typename elfcpp::Elf_types<64>::Elf_Swxword addend =
+	rela.get_r_addend();
+      if (kind == BATCHED_PC32 && addend < 0)
+	b->value = static_cast<Address64>(value) + addend;
+      else
+	b->value = static_cast<Address>(value + addend);
+      b->offset = offset;
+      b->kind = kind;
+    }
+}
+
+// Relocate a section using the fast path described above.
+
+template<int size>
+void
+Target_x86_64<size>::relocate_section_batched(
+    const Relocate_info<size, false>* relinfo,
+    const unsigned char* prelocs,
+    size_t reloc_count,
+    Output_section* output_section,
+    unsigned char* view,
+    typename elfcpp::Elf_types<size>::Elf_Addr view_address,
+    section_size_type view_size)
+{
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, size, false>
+      Classify_reloc;
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+  typedef elfcpp::Swap<32, false>::Valtype Valtype32;
+  typedef elfcpp::Swap<64, false>::Valtype Valtype64;
+  const int reloc_size = elfcpp::Elf_sizes<size>::rela_size;
+
+  std::vector<Batched_reloc> batch;
+  this->resolve_batched_relocs(relinfo, prelocs, reloc_count, view_size,
+			       &batch);
+
+  // Apply the relocations.
+  bool any_pc32 = false;
+  size_t i = 0;
+  while (i < reloc_count)
+    {
+      const unsigned int kind = batch[i].kind;
+      size_t end = i + 1;
+      while (end < reloc_count && batch[end].kind == kind)
+	++end;
+
+      switch (kind)
+	{
+	case BATCHED_PC32:
+	  any_pc32 = true;
+	  for (size_t j = i; j < end; ++j)
+	    {
+	      Batched_reloc* b = &batch[j];
+	      b->value -= static_cast<Address>(view_address + b->offset);
+	      elfcpp::Swap<32, false>::writeval(
+		  reinterpret_cast<Valtype32*>(view + b->offset), b->value);
+	    }
+	  break;
+
+	case BATCHED_64:
+	  for (size_t j = i; j < end; ++j)
+	    elfcpp::Swap<64, false>::writeval(
+		reinterpret_cast<Valtype64*>(view + batch[j].offset),
+		batch[j].value);
+	  break;
+
+	default:
+	  gold::relocate_section<size, false, Target_x86_64<size>, Relocate,
+				 gold::Default_comdat_behavior,
+				 Classify_reloc>(
+	    relinfo,
+	    this,
+	    prelocs + i * reloc_size,
+	    end - i,
+	    output_section,
+	    false,
+	    view,
+	    view_address,
+	    view_size,
+	    NULL);
+	  break;
+	}
+
+      i = end;
+    }
+
+  // Check for overflow.  Relocating the offending relocation again
+  // with the general code reports the error.
+  if (!any_pc32)
+    return;
+  for (size_t j = 0; j < reloc_count; ++j)
+    {
+      if (batch[j].kind == BATCHED_PC32
+	  && Bits<32>::has_overflow(batch[j].value))
+	gold::relocate_section<size, false, Target_x86_64<size>, Relocate,
+			       gold::Default_comdat_behavior,
+			       Classify_reloc>(
+	  relinfo,
+	  this,
+	  prelocs + j * reloc_size,
+	  1,
+	  output_section,
+	  false,
+	  view,
+	  view_address,
+	  view_size,
+	  NULL);
+    }
+}
+
 // Apply an incremental relocation.  Incremental relocations always refer
 // to global symbols.
 
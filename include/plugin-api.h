@@ -365,6 +365,40 @@ enum ld_plugin_status
 (*ld_plugin_get_input_section_size) (const struct ld_plugin_section section,
                                      uint64_t *secsize);
 
+/* The linker's interface for declaring that the claim-file handler of
+   the plugin may be called from several threads at once, for different
+   input files.  The handler may then also call the linker's interfaces
+   concurrently.  This interface should only be invoked in the onload
+   handler, after the claim-file handler has been registered.  */
+
+typedef
+enum ld_plugin_status
+(*ld_plugin_set_claim_file_thread_safe) (void);
+
+/* The linker's interface for reserving COUNT consecutive positions in
+   the list of input files, for files which the plugin will add later
+   with add_reserved_input_file.  The index of the first position is
+   stored in *FIRST.  The reserved files are placed after any files
+   already added, in the order of their positions, whatever order they
+   are added in.  This interface should only be invoked in the
+   all-symbols-read handler.  */
+
+typedef
+enum ld_plugin_status
+(*ld_plugin_reserve_input_files) (unsigned int count, unsigned int *first);
+
+/* The linker's interface for adding the input file at position INDEX,
+   which was reserved by reserve_input_files.  The linker starts
+   reading the file at once, while the plugin goes on to produce the
+   other files.  This may be called from any thread, but every
+   reserved file must be added before the all-symbols-read handler
+   returns.  */
+
+typedef
+enum ld_plugin_status
+(*ld_plugin_add_reserved_input_file) (unsigned int index,
+                                      const char *pathname);
+
 enum ld_plugin_level
 {
   LDPL_INFO,
@@ -407,7 +441,10 @@ enum ld_plugin_tag
   LDPT_UNIQUE_SEGMENT_FOR_SECTIONS = 27,
   LDPT_GET_SYMBOLS_V3 = 28,
   LDPT_GET_INPUT_SECTION_ALIGNMENT = 29,
-  LDPT_GET_INPUT_SECTION_SIZE = 30
+  LDPT_GET_INPUT_SECTION_SIZE = 30,
+  LDPT_SET_CLAIM_FILE_THREAD_SAFE = 31,
+  LDPT_RESERVE_INPUT_FILES = 32,
+  LDPT_ADD_RESERVED_INPUT_FILE = 33
 };
 
 /* The plugin transfer vector.  */
@@ -441,6 +478,9 @@ struct ld_plugin_tv
     ld_plugin_unique_segment_for_sections tv_unique_segment_for_sections;
     ld_plugin_get_input_section_alignment tv_get_input_section_alignment;
     ld_plugin_get_input_section_size tv_get_input_section_size;
+    ld_plugin_set_claim_file_thread_safe tv_set_claim_file_thread_safe;
+    ld_plugin_reserve_input_files tv_reserve_input_files;
+    ld_plugin_add_reserved_input_file tv_add_reserved_input_file;
   } tv_u;
 };
 